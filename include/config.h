@@ -19,6 +19,20 @@
 #define RADAR_RX_PIN             4       // GPIO4 ← TX sensore (OT1/J2P3)
 #define RADAR_TX_PIN             5       // GPIO5 → RX sensore (OT2/J2P4)
 #define RADAR_BAUD               115200
+#define RADAR_UART               1
+
+// Sensori aggiuntivi (furgoni, veicoli grandi): uno per lato,
+// ognuno su una UART propria. UART0 è libera con USB CDC on boot.
+// Serve una UART HP per sensore: l'ESP32-C6 ne ha 2 (0 e 1), con
+// RADAR_COUNT 3 la build si ferma (#error in hal_esp32.cpp); il
+// terzo sensore richiede un chip con 3 UART HP
+#define RADAR_COUNT              1       // sensori LD2420 (1-3)
+#define RADAR2_UART              0
+#define RADAR2_RX_PIN            6       // GPIO6 ← TX sensore 2
+#define RADAR2_TX_PIN            7       // GPIO7 → RX sensore 2
+#define RADAR3_UART              2       // solo chip con 3 UART HP (non C6)
+#define RADAR3_RX_PIN            2       // GPIO2 ← TX sensore 3
+#define RADAR3_TX_PIN            3       // GPIO3 → RX sensore 3
 
 // ------------------------------------------------------------
 // PIN LED DI STATO
@@ -37,7 +51,10 @@
 // ------------------------------------------------------------
 #define WIFI_SSID                "TuriMesh"
 #define WIFI_PASSWORD            "C1p0ll1na.Rav10la"
-#define WIFI_TIMEOUT_MS          30000
+#define WIFI_TIMEOUT_MS          30000   // durata massima di un tentativo
+#define WIFI_BACKOFF_MIN_MS      1000    // attesa dopo il primo fallimento
+#define WIFI_BACKOFF_MAX_MS      60000   // tetto backoff esponenziale (prima del jitter)
+#define WIFI_BACKOFF_JITTER_PCT  25      // jitter casuale +/- %
 #define WIFI_HOSTNAME            "autoguard"
 
 // ------------------------------------------------------------
@@ -48,14 +65,45 @@
 #define MQTT_USER                "mqtt_user"
 #define MQTT_PASS                "salvo"
 #define MQTT_CLIENT_ID           "autoguard-001"
-#define MQTT_RECONNECT_MS        5000
-#define MQTT_PUBLISH_MS          10000   // Publish radar ogni 10s
+#define MQTT_KEEPALIVE_S         30
+#define MQTT_CONNECT_TIMEOUT_MS  10000   // TCP + CONNACK, per tentativo
+#define MQTT_BACKOFF_MIN_MS      2000    // attesa dopo il primo fallimento
+#define MQTT_BACKOFF_MAX_MS      120000  // tetto backoff esponenziale (prima del jitter)
+#define MQTT_BACKOFF_JITTER_PCT  25      // jitter casuale +/- %
+#define MQTT_TX_QUEUE_SIZE       8192    // coda messaggi in uscita (potenza di 2)
+#define MQTT_RX_RING_SIZE        1024    // byte in arrivo in attesa del loop (potenza di 2)
+#define MQTT_RX_MAX_PACKET       512     // pacchetto in arrivo più grande gestito
+#define MQTT_METRICS_MS          60000   // Publish metriche loop ogni 60s
+
+// Telemetria radar (MQTT_TOPIC_SENSOR): inviata ai cambiamenti di
+// presenza, zona o distanza oltre la banda morta, con heartbeat
+// se non cambia nulla. Politica per stato dell'allarme:
+//                               banda cm, intervallo min ms, heartbeat ms
+#define TELEM_POLICY_DISARMED    {  50,  5000, 600000 }
+#define TELEM_POLICY_ARMING      {  30,  2000,  60000 }
+#define TELEM_POLICY_ARMED       {  20,  1000,  60000 }
+#define TELEM_POLICY_ALERT       {  10,   250,   2000 }
+#define TELEM_POLICY_ALARM       {  10,   250,   2000 }
+#define TELEM_POLICY_COOLDOWN    {  20,  1000,  10000 }
+#define TELEM_BUCKET_BURST       5       // invii consecutivi massimi (token bucket)
+#define TELEM_BUCKET_REFILL_MS   500     // un token ogni ... (2 msg/s a regime)
+
+// Outbox alert: eventi consegnati QoS 1, anche dopo link perso o riavvio
+#define OUTBOX_CAPACITY          32      // eventi in RAM (potenza di 2)
+#define OUTBOX_INFLIGHT          8       // publish senza PUBACK per volta
+#define OUTBOX_JSON_MAX          256     // payload alert massimo
+#define OUTBOX_PERSIST           1       // 1 = log eventi su LittleFS
+#define OUTBOX_LOG_MAX           4096    // oltre: file riscritto con i soli pendenti
+#define OUTBOX_FILE_PATH         "/outbox.log"
 
 // Topics publish (ESP32 → broker)
 #define MQTT_TOPIC_STATUS        "autoguard/status"
 #define MQTT_TOPIC_SENSOR        "autoguard/sensor"
 #define MQTT_TOPIC_ALERT         "autoguard/alert"
 #define MQTT_TOPIC_LOG           "autoguard/log"
+#define MQTT_TOPIC_ENERGY        "autoguard/sensor/energy"   // batch binari
+#define MQTT_TOPIC_BATCH         "autoguard/sensor/batch"    // storico radar binario
+#define MQTT_TOPIC_METRICS       "autoguard/metrics"
 
 // Topics subscribe (broker → ESP32)
 #define MQTT_TOPIC_CMD           "autoguard/command"
@@ -69,6 +117,7 @@
 #define MQTT_DEVICE_ID           "autoguard_001"
 #define MQTT_DEVICE_MODEL        "ESP32-C6 + HLK-LD2420"
 #define MQTT_DEVICE_MANUFACTURER "AutoGuard"
+#define MQTT_TOPIC_HA_STATUS     MQTT_DISCOVERY_PREFIX "/status"   // birth di Home Assistant ("online")
 
 // ------------------------------------------------------------
 // RADAR HLK-LD2420
@@ -77,10 +126,69 @@
 #define RADAR_MAX_DIST_CM        400
 #define RADAR_UPDATE_MS          50      // 20Hz
 
+// Task FreeRTOS acquisizione radar
+#define RADAR_TASK_STACK         4096
+#define RADAR_TASK_PRIORITY      5       // sopra loop() (priorità 1)
+#define RADAR_TASK_CORE          0       // ESP32-C6: single core
+#define RADAR_RING_SIZE          64      // campioni in coda (potenza di 2, ~3s a 20Hz)
+#define RADAR_RX_CHUNK           64      // byte letti dalla UART per blocco
+#define RADAR_ACK_TIMEOUT_MS     500     // attesa risposta comandi sensore
+#define RADAR_ENERGY_RING_SIZE   16      // frame engineering in coda (potenza di 2)
+#define RADAR_ENGINEERING_MODE   0       // 1 = energie per gate all'avvio
+#define RADAR_UART_RX_BUFFER     1024    // buffer RX driver UART (acquisizione a intervalli)
+#define RADAR_IDLE_POLL_MS       250     // da disarmato: UART svuotata ogni 250ms
+#define ENERGY_BATCH_FRAMES      10      // frame engineering per batch binario
+#define FUSION_ALIGN_MS          40      // finestra di allineamento tra sensori (< RADAR_UPDATE_MS)
+
+// Filtro distanza (vedi FilterMode in radar_filter.h)
+// Media: ritardo e costo minimi (--bench-filter); la mediana
+// (1) regge meglio i riflessi isolati a un ritardo simile
+#define FILTER_MODE              0       // 0=media 1=mediana 2=esp 3=kalman 4=med+esp 5=med+kalman
+#define FILTER_AVG_SIZE          5       // campioni media mobile
+#define FILTER_MEDIAN_SIZE       5       // campioni mediana (dispari)
+#define FILTER_EMA_ALPHA         30      // % peso nuovo campione (1-100)
+#define FILTER_KALMAN_Q          4       // rumore di processo (cm^2)
+#define FILTER_KALMAN_R          100     // rumore di misura (cm^2)
+#define FILTER_KALMAN_MAX        10000   // q e r massimi (covarianza Q8 in int32)
+
+// Tracker radiale (radar_tracker.h): alfa-beta-gamma sulla distanza grezza
+#define TRACKER_ALPHA            200     // guadagno posizione (millesimi)
+#define TRACKER_BETA             30      // guadagno velocità (millesimi)
+#define TRACKER_GAMMA            2       // guadagno accelerazione (millesimi)
+#define TRACKER_GATE_CM          80      // salto oltre: nuovo bersaglio
+#define TRACKER_GAP_MS           1000    // assenza oltre: traccia persa
+#define TRACKER_SPEED_MAX_CMS    500     // velocità stimata saturata
+#define TRACKER_ACCEL_MAX_CMS2   1000    // accelerazione stimata saturata
+#define TRACKER_MIN_TRACK_MS     500     // traccia più breve: non classificata
+#define TRACKER_APPROACH_CMS     40      // avvicinamento: sotto -40cm/s...
+#define TRACKER_APPROACH_MS      1000    // ...per almeno 1s
+#define TRACKER_LOITER_CM        30      // sosta: entro +/-30cm...
+#define TRACKER_LOITER_MS        2000    // ...per almeno 2s
+#define TRACKER_MOVE_CMS         25      // transito: |velocità| sopra 25cm/s...
+#define TRACKER_PASS_MS          1500    // ...per almeno 1.5s
+
+// Calibrazione rumore di fondo (richiede modalità engineering)
+#define NOISE_LEARN_FRAMES       1200    // frame da apprendere (~60s a 20Hz)
+#define NOISE_SIGMA_X10          30      // soglia = media + 3.0 * dev.std
+#define NOISE_MIN_MARGIN         100     // margine minimo sopra la media
+
+// Trace campioni radar (analisi falsi allarmi, replay su host)
+#define TRACE_BLOCK_SIZE         512     // byte per blocco (~120 campioni)
+#define TRACE_RAM_BLOCKS         32      // ring RAM: 16KB, ~3 minuti a 20Hz
+#define TRACE_SAVE_ON_ALARM      1       // 1 = salva la trace su LittleFS allo scatto
+#define TRACE_FILE_PATH          "/trace_alarm.agt"
+
+// Storico radar via MQTT (MQTT_TOPIC_BATCH): ogni campione da
+// ARMED/ALERT/ALARM in batch binari compatti (radar_batch.h)
+#define RADAR_BATCH_SAMPLES      40      // campioni per batch (2s a 20Hz)
+#define RADAR_BATCH_QUEUE        8       // batch in attesa di invio (offline: persi i più vecchi)
+
 // Zone rilevamento
 #define ZONE_CRITICAL_MAX        100     // 0-100cm:   dentro/sopra auto
 #define ZONE_MEDIUM_MAX          250     // 100-250cm: intorno auto
 #define ZONE_FAR_MAX             400     // 250-400cm: nei pressi auto
+#define ZONE_HYST_ENTER_CM       10      // ingresso: cm oltre il confine della nuova zona
+#define ZONE_HYST_EXIT_CM        15      // uscita: cm oltre il bordo della zona corrente
 
 // ------------------------------------------------------------
 // ALARM LOGIC
@@ -89,14 +197,56 @@
 #define PRE_ALARM_MS             3000    // warning pre-allarme (3s)
 #define ALARM_DURATION_MS        30000   // durata allarme (30s)
 #define COOLDOWN_MS              10000   // pausa tra allarmi (10s)
-#define DETECTIONS_TO_ALERT      5       // rilevamenti consecutivi per alert
+#define DETECTIONS_TO_ALERT      5       // rilevamenti per alert (rilevatore a contatori)
+#define ALARM_TIMING_MAX_MS      3600000 // tempi massimi accettati da /api/config (1h)
+
+// Rilevatore intrusione (presence_detector.h)
+#define DETECTOR_MODE            1       // 0 = contatori storici, 1 = evidenza con decadimento
+#define EVIDENCE_THRESHOLD       100     // punti per alert
+#define EVIDENCE_HALF_LIFE_MS    3000    // dimezzamento del punteggio
+#define EVIDENCE_HALF_LIFE_MIN_MS 100
+#define EVIDENCE_WEIGHT_CRITICAL 100     // punti per campione (= soglia: alert immediato)
+#define EVIDENCE_WEIGHT_MEDIUM   20      // punti per campione
+#define EVIDENCE_WEIGHT_FAR      12      // punti per campione
+#define EVIDENCE_DWELL_MS        2000    // presenza continua che raddoppia il peso
+#define EVIDENCE_GAP_MS          500     // buco che interrompe la presenza continua
+#define EVIDENCE_APPROACH_PCT    50      // peso +/-50% a piena velocità radiale
+#define EVIDENCE_APPROACH_FULL_CMS 100   // velocità di piena scala (cm/s)
+#define APPROACH_ESCALATE        1       // 1 = avvicinamento sostenuto trattato come zona CRITICA
+#define APPROACH_LEAD_MS         1000    // ...se la zona critica è prevista entro questo tempo
+#define ALARM_EVENT_QUEUE_SIZE   32      // transizioni in memoria (potenza di 2)
+#define ALARM_CMD_QUEUE_SIZE     8       // comandi web in attesa del loop (potenza di 2)
 
 // ------------------------------------------------------------
 // WEB SERVER
 // ------------------------------------------------------------
 #define WEB_SERVER_PORT          80
+#define WEB_EVENTS_MAX           16      // transizioni per risposta /api/events
+#define WEB_JSON_BUFFER          1536    // buffer iniziale delle risposte JSON (cresce se serve)
+#define WEB_CONFIG_BODY_MAX      2048    // corpo massimo POST /api/config
 #define OTA_PASSWORD             "autoguard"
 
+// ------------------------------------------------------------
+// RISPARMIO ENERGETICO (power_manager.h)
+// ------------------------------------------------------------
+#define POWER_SAVE               1       // 0 = loop sempre attivo alla frequenza massima
+#define POWER_LIGHT_SLEEP        1       // light sleep automatico da disarmato
+#define POWER_CPU_MAX_MHZ        160
+#define POWER_CPU_MIN_MHZ        40      // XTAL: CPU inattiva
+#define POWER_IDLE_MAX_MS        10      // attesa massima del loop ad allarme inserito
+#define POWER_IDLE_DISARMED_MS   200     // attesa massima del loop da disarmato
+
+// ------------------------------------------------------------
+// PERSISTENZA STATO (state_journal.h)
+// ------------------------------------------------------------
+#define JOURNAL_ENABLE           1       // 1 = stato ripristinato dopo un riavvio
+#define JOURNAL_PARTITION        "journal"   // partizione dati (partitions.csv)
+
+// ------------------------------------------------------------
+// DIAGNOSTICA
+// ------------------------------------------------------------
+#define LOOP_METRICS             1       // 0 = rimuove la strumentazione di loop()
+
 // ------------------------------------------------------------
 // NVS
 // ------------------------------------------------------------
@@ -0,0 +1,145 @@
+# ============================================================
+# AutoGuard - Asset web compressi (pre-script PlatformIO)
+# ============================================================
+# Minifica le pagine di web/ (HTML con CSS e JS inline), le
+# comprime con gzip e genera src/web_assets.h: array costanti in
+# flash serviti così come sono (Content-Encoding: gzip) con un
+# ETag forte = hash del contenuto compresso.
+#
+# Minificazione prudente: CSS compattato; per HTML e JS solo
+# rientri, righe vuote, commenti HTML e commenti JS a riga intera.
+# Gli a capo restano (spazi tra elementi inline, inserimento
+# automatico dei ';'): il grosso lo fa gzip.
+#
+# Uso: automatico da platformio.ini (extra_scripts), oppure
+#   python3 scripts/build_web.py
+# Il file viene riscritto solo se cambia (niente ricompilazioni
+# inutili). gzip con mtime 0: stesso input, stessi byte, stesso
+# ETag.
+# ============================================================
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+# (nome C, file sorgente, route, content type)
+ASSETS = [
+    ("DASHBOARD", "dashboard.html", "/",       "text/html"),
+    ("CONFIG",    "config.html",    "/config", "text/html"),
+]
+
+OUT_NAME = "web_assets.h"
+
+
+def minify_css(css):
+    css = re.sub(r"/\*.*?\*/", "", css, flags=re.S)
+    css = re.sub(r"\s+", " ", css)
+    css = re.sub(r"\s*([{};:,>])\s*", r"\1", css)
+    return css.replace(";}", "}").strip()
+
+
+def minify_js(js):
+    out = []
+    for line in js.splitlines():
+        line = line.strip()
+        if not line or line.startswith("//"):
+            continue
+        out.append(line)
+    return "\n".join(out)
+
+
+def minify_html(html):
+    html = re.sub(r"<!--.*?-->", "", html, flags=re.S)
+    html = re.sub(r"(<style>)(.*?)(</style>)",
+                  lambda m: m.group(1) + minify_css(m.group(2)) + m.group(3), html, flags=re.S)
+
+    # Script a parte: righe preservate
+    scripts = []
+
+    def keep_script(m):
+        scripts.append(minify_js(m.group(2)))
+        return m.group(1) + "\0%d\0" % (len(scripts) - 1) + m.group(3)
+
+    html = re.sub(r"(<script>)(.*?)(</script>)", keep_script, html, flags=re.S)
+    html = "\n".join(line.strip() for line in html.splitlines() if line.strip())
+    return re.sub(r"\0(\d+)\0", lambda m: scripts[int(m.group(1))], html)
+
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def generate(root):
+    web_dir = os.path.join(root, "web")
+    out_path = os.path.join(root, "src", OUT_NAME)
+
+    parts = [
+        "// ============================================================",
+        "// AutoGuard - Asset web compressi",
+        "// ============================================================",
+        "// GENERATO da scripts/build_web.py a partire da web/: non",
+        "// modificare a mano, si rigenera a ogni build.",
+        "// ============================================================",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <stdint.h>",
+        "#include <stddef.h>",
+        "#include <pgmspace.h>",
+        "",
+        "struct WebAsset {",
+        "    const char*    path;       // route",
+        "    const char*    type;       // content type",
+        "    const uint8_t* data;       // gzip",
+        "    size_t         len;",
+        "    const char*    etag;       // forte, tra virgolette",
+        "    size_t         rawLen;     // dopo la minificazione",
+        "};",
+        "",
+    ]
+    report = []
+    for name, src, route, ctype in ASSETS:
+        with open(os.path.join(web_dir, src), encoding="utf-8") as f:
+            raw = f.read()
+        mini = minify_html(raw).encode("utf-8")
+        gz = gzip.compress(mini, compresslevel=9, mtime=0)
+        etag = hashlib.sha256(gz).hexdigest()[:16]
+        report.append("%s: %d -> %d -> %d byte gzip, ETag \"%s\""
+                      % (src, len(raw.encode("utf-8")), len(mini), len(gz), etag))
+        parts += [
+            "// %s: %d byte, minificato %d, gzip %d" % (src, len(raw.encode("utf-8")), len(mini), len(gz)),
+            "static const uint8_t WEB_%s_GZ[] PROGMEM = {" % name,
+            c_array(gz),
+            "};",
+            "",
+            "static const WebAsset WEB_ASSET_%s = {" % name,
+            '    "%s", "%s", WEB_%s_GZ, sizeof(WEB_%s_GZ), "\\"%s\\"", %d' % (
+                route, ctype, name, name, etag, len(mini)),
+            "};",
+            "",
+        ]
+    parts += ["#endif // WEB_ASSETS_H", ""]
+    text = "\n".join(parts)
+
+    old = None
+    if os.path.exists(out_path):
+        with open(out_path, encoding="utf-8") as f:
+            old = f.read()
+    if old != text:
+        with open(out_path, "w", encoding="utf-8") as f:
+            f.write(text)
+    for line in report:
+        print("[WEB] " + line)
+
+
+try:
+    Import("env")  # noqa: F821 (definito da PlatformIO)
+    generate(env["PROJECT_DIR"])  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        generate(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+        sys.exit(0)
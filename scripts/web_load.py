@@ -0,0 +1,115 @@
+# ============================================================
+# AutoGuard - Test di carico pagine web
+# ============================================================
+# Richieste GET in parallelo verso il dispositivo per una durata
+# fissa: req/s, byte per risposta, codici HTTP e heap
+# (free_heap / heap_min da /api/status) prima e dopo.
+#
+# Uso:
+#   python3 scripts/web_load.py 192.168.1.50
+#   python3 scripts/web_load.py 192.168.1.50 --paths / /config \
+#       --clients 4 --seconds 30 --etag
+# Con --etag ogni client rimanda l'ETag ricevuto (If-None-Match)
+# come un browser con la pagina in cache: risposte 304.
+# Per il confronto prima/dopo eseguire lo stesso comando sul
+# firmware precedente (senza --etag).
+# Solo libreria standard.
+# ============================================================
+import argparse
+import http.client
+import json
+import threading
+import time
+
+
+def status(host, port):
+    conn = http.client.HTTPConnection(host, port, timeout=5)
+    try:
+        conn.request("GET", "/api/status")
+        d = json.loads(conn.getresponse().read())
+        return d.get("free_heap"), d.get("heap_min")
+    except (OSError, ValueError):
+        return None, None
+    finally:
+        conn.close()
+
+
+def client(host, port, paths, deadline, use_etag, res, lock):
+    etags = {}
+    n, nbytes, codes, errors, worst = 0, 0, {}, 0, 0.0
+    i = 0
+    while time.monotonic() < deadline:
+        path = paths[i % len(paths)]
+        i += 1
+        headers = {"Accept-Encoding": "gzip"}
+        if use_etag and path in etags:
+            headers["If-None-Match"] = etags[path]
+        t0 = time.monotonic()
+        try:
+            # Connessione nuova a ogni richiesta, come il server
+            # (niente keep-alive con AsyncWebServer)
+            conn = http.client.HTTPConnection(host, port, timeout=5)
+            conn.request("GET", path, headers=headers)
+            r = conn.getresponse()
+            body = r.read()
+            conn.close()
+        except OSError:
+            errors += 1
+            time.sleep(0.05)
+            continue
+        worst = max(worst, time.monotonic() - t0)
+        n += 1
+        nbytes += len(body)
+        codes[r.status] = codes.get(r.status, 0) + 1
+        etag = r.getheader("ETag")
+        if etag:
+            etags[path] = etag
+    with lock:
+        res["n"] += n
+        res["bytes"] += nbytes
+        res["errors"] += errors
+        res["worst"] = max(res["worst"], worst)
+        for k, v in codes.items():
+            res["codes"][k] = res["codes"].get(k, 0) + v
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Test di carico pagine AutoGuard")
+    ap.add_argument("host")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--paths", nargs="+", default=["/", "/config"])
+    ap.add_argument("--clients", type=int, default=4)
+    ap.add_argument("--seconds", type=float, default=20)
+    ap.add_argument("--etag", action="store_true", help="rivalida con If-None-Match")
+    a = ap.parse_args()
+
+    heap0, min0 = status(a.host, a.port)
+
+    res = {"n": 0, "bytes": 0, "errors": 0, "worst": 0.0, "codes": {}}
+    lock = threading.Lock()
+    deadline = time.monotonic() + a.seconds
+    t0 = time.monotonic()
+    threads = [threading.Thread(target=client,
+                                args=(a.host, a.port, a.paths, deadline, a.etag, res, lock))
+               for _ in range(a.clients)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.monotonic() - t0
+
+    heap1, min1 = status(a.host, a.port)
+
+    n = res["n"]
+    print("Pagine:     %s  (%d client, %.0f s%s)"
+          % (" ".join(a.paths), a.clients, elapsed, ", If-None-Match" if a.etag else ""))
+    print("Richieste:  %d  (%.1f req/s), errori %d" % (n, n / elapsed, res["errors"]))
+    print("Risposte:   %s" % ", ".join("%d x%d" % (k, v) for k, v in sorted(res["codes"].items())))
+    print("Byte/resp:  %.0f  (peggior tempo %.0f ms)"
+          % (res["bytes"] / n if n else 0, res["worst"] * 1000))
+    print("free_heap:  %s -> %s" % (heap0, heap1))
+    print("heap_min:   %s -> %s" % (min0, min1))
+
+
+if __name__ == "__main__":
+    main()
@@ -2,6 +2,127 @@
 // AutoGuard - Alarm Logic - Implementazione
 // ============================================================
 #include "alarm_logic.h"
+#include "state_journal.h"
+
+// Pre-allarme: presenza persa dopo questo silenzio del radar
+#define ALERT_PRESENCE_LOST_MS  2000
+
+// ============================================================
+// Tabella transizioni
+// ============================================================
+// Per ogni evento vince la prima riga con stato e guardia
+// soddisfatti; le righe ANY_STATE vanno in fondo. La guardia di
+// ARMED alimenta anche il rilevatore (presence_detector.h).
+typedef AlarmLogic AL;
+
+constexpr AL::Transition AlarmLogic::table[] = {
+    // DISARMED
+    { STATE_DISARMED, AIN_CMD_ARM,    nullptr,               nullptr,               STATE_ARMING,   false,
+      "[ALARM] Comando ARM ricevuto" },
+
+    // ARMING
+    { STATE_ARMING,   AIN_TIMER,      nullptr,               nullptr,               STATE_ARMED,    false,
+      "[ALARM] Sistema ARMATO!" },
+
+    // ARMED
+    { STATE_ARMED,    AIN_SAMPLE,     &AL::_intrusion,       nullptr,               STATE_ALERT,    true,
+      nullptr },
+
+    // ALERT
+    { STATE_ALERT,    AIN_SAMPLE,     &AL::_presenceGone,    nullptr,               STATE_ARMED,    false,
+      "[ALARM] Presenza scomparsa - torno ad ARMED" },
+    { STATE_ALERT,    AIN_SAMPLE,     &AL::_detected,        &AL::_refreshDetection, AL::KEEP_STATE, false,
+      nullptr },
+    { STATE_ALERT,    AIN_TIMER,      &AL::_presenceTimeout, nullptr,               STATE_ARMED,    false,
+      "[ALARM] Presenza scomparsa - torno ad ARMED" },
+    { STATE_ALERT,    AIN_TIMER,      &AL::_preAlarmElapsed, &AL::_activateAlarm,   STATE_ALARM,    true,
+      "[ALARM] 🚨 ALLARME ATTIVATO!" },
+
+    // ALARM
+    { STATE_ALARM,    AIN_TIMER,      nullptr,               &AL::_deactivateAlarm, STATE_COOLDOWN, false,
+      "[ALARM] Timeout allarme - COOLDOWN" },
+    { STATE_ALARM,    AIN_CMD_RESET,  nullptr,               &AL::_deactivateAlarm, STATE_ARMED,    false,
+      "[ALARM] Comando RESET ricevuto" },
+
+    // COOLDOWN
+    { STATE_COOLDOWN, AIN_TIMER,      nullptr,               nullptr,               STATE_ARMED,    false,
+      "[ALARM] Cooldown terminato - torno ad ARMED" },
+    { STATE_COOLDOWN, AIN_CMD_RESET,  nullptr,               &AL::_deactivateAlarm, STATE_ARMED,    false,
+      "[ALARM] Comando RESET ricevuto" },
+
+    // Qualsiasi stato
+    { AL::ANY_STATE,  AIN_CMD_DISARM, &AL::_notDisarmed,     &AL::_deactivateAlarm, STATE_DISARMED, false,
+      "[ALARM] Comando DISARM ricevuto" },
+};
+
+// ------------------------------------------------------------
+// Indice a compile time: righe candidate per (stato, evento),
+// in ordine di tabella. Un campione in DISARMED non tocca righe
+// ------------------------------------------------------------
+#define TABLE_ROWS          (sizeof(AlarmLogic::table) / sizeof(AlarmLogic::table[0]))
+#define TABLE_MAX_CAND      4
+
+struct TableIndex {
+    uint8_t count[STATE_COOLDOWN + 1][AIN_COUNT];
+    uint8_t rows[STATE_COOLDOWN + 1][AIN_COUNT][TABLE_MAX_CAND];
+};
+
+static constexpr TableIndex buildIndex(const AL::Transition* t, size_t n) {
+    TableIndex idx = {};
+    for (uint8_t st = 0; st <= STATE_COOLDOWN; st++) {
+        for (size_t i = 0; i < n; i++) {
+            if (t[i].from != st && t[i].from != AL::ANY_STATE) continue;
+            uint8_t& c = idx.count[st][t[i].input];
+            if (c < TABLE_MAX_CAND) idx.rows[st][t[i].input][c] = (uint8_t)i;
+            c++;
+        }
+    }
+    return idx;
+}
+
+static constexpr TableIndex tableIndex = buildIndex(AlarmLogic::table, TABLE_ROWS);
+
+// ------------------------------------------------------------
+// Verifiche a compile time
+// ------------------------------------------------------------
+static constexpr bool tableRowsValid(const AL::Transition* t, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (t[i].from > STATE_COOLDOWN && t[i].from != AL::ANY_STATE) return false;
+        if (t[i].to > STATE_COOLDOWN && t[i].to != AL::KEEP_STATE)    return false;
+        if (t[i].input >= AIN_COUNT)                                  return false;
+        // Dopo una riga ANY_STATE le righe specifiche non verrebbero mai scelte
+        if (i > 0 && t[i - 1].from == AL::ANY_STATE && t[i].from != AL::ANY_STATE) return false;
+    }
+    return true;
+}
+
+static constexpr bool tableIndexFits(const TableIndex& idx) {
+    for (uint8_t st = 0; st <= STATE_COOLDOWN; st++) {
+        for (uint8_t in = 0; in < AIN_COUNT; in++) {
+            if (idx.count[st][in] > TABLE_MAX_CAND) return false;
+        }
+    }
+    return true;
+}
+
+// Gli stati temporizzati (e solo quelli) gestiscono AIN_TIMER
+static constexpr bool tableHandlesTimer(const AL::Transition* t, size_t n, uint8_t state) {
+    for (size_t i = 0; i < n; i++) {
+        if (t[i].from == state && t[i].input == AIN_TIMER) return true;
+    }
+    return false;
+}
+
+static_assert(tableRowsValid(AlarmLogic::table, TABLE_ROWS), "Tabella transizioni allarme non valida");
+static_assert(tableIndexFits(tableIndex), "Troppe righe per (stato, evento): aumentare TABLE_MAX_CAND");
+static_assert(tableHandlesTimer(AlarmLogic::table, TABLE_ROWS, STATE_ARMING) &&
+              tableHandlesTimer(AlarmLogic::table, TABLE_ROWS, STATE_ALERT)  &&
+              tableHandlesTimer(AlarmLogic::table, TABLE_ROWS, STATE_ALARM)  &&
+              tableHandlesTimer(AlarmLogic::table, TABLE_ROWS, STATE_COOLDOWN),
+              "Stato temporizzato senza riga AIN_TIMER");
+static_assert(!tableHandlesTimer(AlarmLogic::table, TABLE_ROWS, STATE_DISARMED) &&
+              !tableHandlesTimer(AlarmLogic::table, TABLE_ROWS, STATE_ARMED),
+              "Riga AIN_TIMER in uno stato senza scadenza");
 
 // ============================================================
 // Costruttore
@@ -9,271 +130,328 @@
 AlarmLogic::AlarmLogic() :
     _state(STATE_DISARMED),
     _prevState(STATE_DISARMED),
+    _consumer(nullptr),
+    _reload(false),
+    _params(),
+    _sample(nullptr),
+    _sampleZone(ZONE_NONE),
+    _sampleDist(0),
     _stateStartMs(0),
-    _lastDetectionMs(0)
-{
-    _lastEvent.state       = STATE_DISARMED;
-    _lastEvent.prevState   = STATE_DISARMED;
-    _lastEvent.zone        = ZONE_NONE;
-    _lastEvent.distance_cm = 0;
-    _lastEvent.timestamp   = 0;
-    _lastEvent.isNew       = false;
-}
+    _lastDetectionMs(0),
+    _deadlineMs(0),
+    _hasDeadline(false)
+{}
 
 // ============================================================
 // begin()
 // ============================================================
 void AlarmLogic::begin() {
+    _loadParams();
     _state        = STATE_DISARMED;
-    _stateStartMs = millis();
-    Serial.println("[ALARM] State machine inizializzata - DISARMED");
+    _stateStartMs = halMillis();
+    _hasDeadline  = false;
+
+    // Riavvio (brownout, watchdog) con l'allarme inserito
+    AlarmState saved;
+    if (stateJournal.lastState(saved) && saved != STATE_DISARMED) {
+        _restore(saved);
+        return;
+    }
+    halLog.println("[ALARM] State machine inizializzata - DISARMED");
 }
 
 // ============================================================
-// update() - Chiamare nel loop()
+// _restore() - Stato registrato prima del riavvio
 // ============================================================
-void AlarmLogic::update(RadarData& radarData) {
-    switch (_state) {
-        case STATE_DISARMED: _handleDisarmed(radarData); break;
-        case STATE_ARMING:   _handleArming(radarData);   break;
-        case STATE_ARMED:    _handleArmed(radarData);    break;
-        case STATE_ALERT:    _handleAlert(radarData);    break;
-        case STATE_ALARM:    _handleAlarm(radarData);    break;
-        case STATE_COOLDOWN: _handleCooldown(radarData); break;
+// Scadenze piene dall'avvio, uscite riattivate se in ALARM.
+// Nessun evento: il journal e l'outbox hanno già la transizione
+void AlarmLogic::_restore(AlarmState state) {
+    _state           = state;
+    _prevState       = state;
+    _lastDetectionMs = _stateStartMs;
+    if (_state == STATE_ALARM) _activateAlarm();
+    _armDeadline();
+    halLog.printf("[ALARM] State machine ripristinata - %s\n", getStateName());
+}
+
+// ============================================================
+// onSample() / tick() - Chiamare nel loop()
+// ============================================================
+void AlarmLogic::onSample(const RadarData& radarData) {
+    // Comandi e config solo in tick(), chiamato dopo i campioni
+    // dello stesso giro. Le guardie leggono il campione del
+    // chiamante (nessuna copia); stati senza righe AIN_SAMPLE non
+    // passano da _dispatch()
+    _sampleZone = radarData.zone;
+    _sampleDist = radarData.distance_cm;
+    AlarmState before = _state;
+    if (tableIndex.count[_state][AIN_SAMPLE]) {
+        _sample = &radarData;
+        _dispatch(AIN_SAMPLE);
+        _sample = nullptr;
+    }
+
+    // Scadenza nello stesso giro, come se il campione fosse
+    // arrivato subito dopo il tick
+    if (_state == before && _deadlineDue()) _dispatch(AIN_TIMER);
+}
+
+void AlarmLogic::tick() {
+    _drainCommands();
+    if (_deadlineDue()) _dispatch(AIN_TIMER);
+}
+
+void AlarmLogic::_drainCommands() {
+    // Config salvata (da qualsiasi task): nuovo snapshot
+    if (_reload.load(std::memory_order_relaxed) &&
+        _reload.exchange(false, std::memory_order_acquire)) {
+        _loadParams();
+        _armDeadline();
+        halLog.println("[ALARM] Configurazione aggiornata");
+    }
+
+    uint8_t cmd;
+    while (_cmds.pop(cmd)) {
+        switch (cmd) {
+            case ALARM_CMD_ARM:    arm();    break;
+            case ALARM_CMD_DISARM: disarm(); break;
+            case ALARM_CMD_RESET:  reset();  break;
+            default: break;
+        }
     }
 }
 
+// ============================================================
+// _dispatch() - Prima riga che corrisponde
+// ============================================================
+bool AlarmLogic::_dispatch(AlarmInput input) {
+    uint8_t n = tableIndex.count[_state][input];
+    for (uint8_t i = 0; i < n; i++) {
+        const Transition& t = table[tableIndex.rows[_state][input][i]];
+        if (t.guard && !(this->*t.guard)()) continue;
+
+        if (t.note) halLog.println(t.note);
+        if (t.action) (this->*t.action)();
+        if (t.to == KEEP_STATE) _armDeadline();
+        else _setState((AlarmState)t.to, t.withSample);
+        return true;
+    }
+
+    // Scadenza senza transizione: ricalcola, non ripetere a ogni tick
+    if (input == AIN_TIMER) _armDeadline();
+    return false;
+}
+
 // ============================================================
 // Comandi esterni
 // ============================================================
+void AlarmLogic::configChanged() {
+    _reload.store(true, std::memory_order_release);
+    if (_consumer) halTaskNotify(_consumer);
+}
+
+bool AlarmLogic::post(AlarmCommand cmd) {
+    if (!_cmds.push((uint8_t)cmd)) return false;
+    if (_consumer) halTaskNotify(_consumer);    // il loop può essere in attesa
+    return true;
+}
+
 void AlarmLogic::arm() {
-    if (_state == STATE_DISARMED) {
-        Serial.println("[ALARM] Comando ARM ricevuto");
-        _setState(STATE_ARMING);
-    } else {
-        Serial.printf("[ALARM] Comando ARM ignorato (stato: %s)\n",
+    if (!_dispatch(AIN_CMD_ARM)) {
+        halLog.printf("[ALARM] Comando ARM ignorato (stato: %s)\n",
             getStateName());
     }
 }
 
 void AlarmLogic::disarm() {
-    if (_state != STATE_DISARMED) {
-        Serial.println("[ALARM] Comando DISARM ricevuto");
-        _deactivateAlarm();
-        _setState(STATE_DISARMED);
-    } else {
-        Serial.println("[ALARM] Già disarmato");
+    if (!_dispatch(AIN_CMD_DISARM)) {
+        halLog.println("[ALARM] Già disarmato");
     }
 }
 
 void AlarmLogic::reset() {
-    if (_state == STATE_ALARM || _state == STATE_COOLDOWN) {
-        Serial.println("[ALARM] Comando RESET ricevuto");
-        _deactivateAlarm();
-        _setState(STATE_ARMED);
-    } else {
-        Serial.printf("[ALARM] Comando RESET ignorato (stato: %s)\n",
+    if (!_dispatch(AIN_CMD_RESET)) {
+        halLog.printf("[ALARM] Comando RESET ignorato (stato: %s)\n",
             getStateName());
     }
 }
 
 // ============================================================
-// Handler DISARMED
+// Guardie
 // ============================================================
-void AlarmLogic::_handleDisarmed(RadarData& data) {
-    // Niente da fare - attende comando arm()
+bool AlarmLogic::_notDisarmed() {
+    return _state != STATE_DISARMED;
 }
 
-// ============================================================
-// Handler ARMING - countdown prima di armarsi
-// ============================================================
-void AlarmLogic::_handleArming(RadarData& data) {
-    uint32_t elapsed = millis() - _stateStartMs;
-
-    // Stampa countdown ogni secondo
-    static uint32_t lastPrint = 0;
-    if (millis() - lastPrint > 1000) {
-        lastPrint = millis();
-        uint32_t remaining = (elapsed < configMgr.get().armingDelayMs) ? (configMgr.get().armingDelayMs - elapsed) / 1000 : 0;
-        Serial.printf("[ALARM] Armamento in %lu secondi...\n", remaining);
-    }
-
-    // Countdown terminato -> passa ad ARMED
-    if (elapsed >= configMgr.get().armingDelayMs) {
-        Serial.println("[ALARM] Sistema ARMATO!");
-        _setState(STATE_ARMED);
-    }
-}
+// ARMED: presenza confermata sopra la distanza minima, poi decide
+// il rilevatore (contatori o evidenza)
+bool AlarmLogic::_intrusion() {
+    if (!_sample->detected) return false;
 
-// ============================================================
-// Handler ARMED - monitora rilevamenti
-// ============================================================
-void AlarmLogic::_handleArmed(RadarData& data) {
-    if (!data.detected) return;
+    // Soglie adattive: scarta detection sotto il rumore di fondo appreso
+    if (!noiseProfile.confirms(*_sample)) return false;
 
     // Presenza rilevata - aggiorna timestamp
-    _lastDetectionMs = millis();
-
-    // Controlla zona e rilevamenti consecutivi
-    // Zona CRITICA: scatta subito alert
-    // Zona MEDIA/FAR: richiede N rilevamenti consecutivi
-    bool triggerAlert = false;
-    AutoGuardConfig cfg = configMgr.get();
+    _lastDetectionMs = halMillis();
 
     // Ignora se sotto distanza minima configurata
-    if (data.distance_cm < cfg.alarmMinDist) {
-        return;
+    if (_sample->distance_cm < _params.alarmMinDist) return false;
+
+    // Avvicinamento sostenuto verso la zona critica: pesa come la
+    // zona critica, senza attendere l'ingresso (copia solo in quel caso)
+    const RadarData* s = _sample;
+    RadarData escalated;
+    bool esc = _params.approachEscalate && s->zone != ZONE_CRITICAL &&
+               RadarTracker::reaches(*s, _params.zoneCriticalMax, _params.approachLeadMs);
+    if (esc) {
+        escalated      = *s;
+        escalated.zone = ZONE_CRITICAL;
+        s = &escalated;
     }
 
-    if (data.zone == ZONE_CRITICAL && cfg.alarmZoneCritical) {
-        Serial.printf("[ALARM] ZONA CRITICA! Dist:%dcm\n", data.distance_cm);
-        triggerAlert = true;
-    } else if (data.zone == ZONE_MEDIUM && cfg.alarmZoneMedium) {
-        static int consecCount = 0;
-        consecCount++;
-        if (consecCount >= cfg.detectionsToAlert) {
-            Serial.printf("[ALARM] Presenza! Zona:MEDIUM Dist:%dcm\n", data.distance_cm);
-            triggerAlert = true;
-            consecCount = 0;
-        }
-    } else if (data.zone == ZONE_FAR && cfg.alarmZoneFar) {
-        static int consecCountFar = 0;
-        consecCountFar++;
-        if (consecCountFar >= cfg.detectionsToAlert) {
-            Serial.printf("[ALARM] Presenza! Zona:FAR Dist:%dcm\n", data.distance_cm);
-            triggerAlert = true;
-            consecCountFar = 0;
-        }
-    }
+    if (!_detector.feed(*s, _lastDetectionMs)) return false;
 
-    if (triggerAlert) {
-        _setState(STATE_ALERT, &data);
-    }
+    static const char* zoneNames[] = {"NONE", "CRITICAL", "MEDIUM", "FAR"};
+    halLog.printf("[ALARM] Presenza! Zona:%s Dist:%dcm%s\n",
+        zoneNames[_sample->zone & 3], _sample->distance_cm,
+        esc ? " (avvicinamento)" : "");
+    return true;
 }
 
-// ============================================================
-// Handler ALERT - pre-allarme, attende conferma
-// ============================================================
-void AlarmLogic::_handleAlert(RadarData& data) {
-    uint32_t elapsed = millis() - _stateStartMs;
-
-    // Stampa warning ogni 500ms
-    static uint32_t lastWarn = 0;
-    if (millis() - lastWarn > 500) {
-        lastWarn = millis();
-        Serial.printf("[ALARM] ⚠ PRE-ALLARME! Scatto in %lums\n",
-            elapsed < configMgr.get().preAlarmMs ? configMgr.get().preAlarmMs - elapsed : 0);
-    }
+// ALERT: campione vuoto dopo ALERT_PRESENCE_LOST_MS senza rilevamenti
+bool AlarmLogic::_presenceGone() {
+    return !_sample->detected && _presenceTimeout();
+}
 
-    // Se la presenza scompare durante pre-allarme -> torna ARMED
-    if (!data.detected) {
-        uint32_t noDetectTime = millis() - _lastDetectionMs;
-        if (noDetectTime > 2000) {  // 2s senza rilevamento
-            Serial.println("[ALARM] Presenza scomparsa - torno ad ARMED");
-            _setState(STATE_ARMED);
-            return;
-        }
-    } else {
-        _lastDetectionMs = millis();
-    }
+// ALERT: nessun campione con presenza da ALERT_PRESENCE_LOST_MS
+bool AlarmLogic::_presenceTimeout() {
+    return halMillis() - _lastDetectionMs > ALERT_PRESENCE_LOST_MS;
+}
 
-    // Timeout pre-allarme -> scatta allarme
-    if (elapsed >= configMgr.get().preAlarmMs) {
-        Serial.println("[ALARM] 🚨 ALLARME ATTIVATO!");
-        _activateAlarm();
-        _setState(STATE_ALARM, &data);
-    }
+bool AlarmLogic::_detected() {
+    return _sample->detected;
+}
+
+bool AlarmLogic::_preAlarmElapsed() {
+    return halMillis() - _stateStartMs >= _params.preAlarmMs;
 }
 
 // ============================================================
-// Handler ALARM - allarme attivo
+// _refreshDetection() - Presenza confermata in ALERT
 // ============================================================
-void AlarmLogic::_handleAlarm(RadarData& data) {
-    uint32_t elapsed = millis() - _stateStartMs;
-
-    // Stampa stato ogni 5s
-    static uint32_t lastPrint = 0;
-    if (millis() - lastPrint > 5000) {
-        lastPrint = millis();
-        Serial.printf("[ALARM] 🚨 ALLARME ATTIVO da %lus\n", elapsed / 1000);
-    }
-
-    // Timeout allarme -> passa a COOLDOWN
-    if (elapsed >= configMgr.get().alarmDurationMs) {
-        Serial.println("[ALARM] Timeout allarme - COOLDOWN");
-        _deactivateAlarm();
-        _setState(STATE_COOLDOWN);
-    }
+void AlarmLogic::_refreshDetection() {
+    _lastDetectionMs = halMillis();
 }
 
 // ============================================================
-// Handler COOLDOWN - pausa post-allarme
+// Scadenze
 // ============================================================
-void AlarmLogic::_handleCooldown(RadarData& data) {
-    uint32_t elapsed = millis() - _stateStartMs;
-
-    // Stampa stato ogni 5s
-    static uint32_t lastPrint = 0;
-    if (millis() - lastPrint > 5000) {
-        lastPrint = millis();
-        uint32_t remaining = (elapsed < configMgr.get().cooldownMs) ? (configMgr.get().cooldownMs - elapsed) / 1000 : 0;
-        Serial.printf("[ALARM] Cooldown: %lus rimanenti\n", remaining);
-    }
+void AlarmLogic::_loadParams() {
+    const AutoGuardConfig& cfg = configMgr.get();
+    _params.armingDelayMs     = cfg.armingDelayMs;
+    _params.preAlarmMs        = cfg.preAlarmMs;
+    _params.alarmDurationMs   = cfg.alarmDurationMs;
+    _params.cooldownMs        = cfg.cooldownMs;
+    _params.alarmMinDist      = cfg.alarmMinDist;
+    _params.approachEscalate  = cfg.approachEscalate;
+    _params.approachLeadMs    = cfg.approachLeadMs > 0 ? cfg.approachLeadMs : 0;
+    _params.zoneCriticalMax   = cfg.zoneCriticalMax;
+    _detector.configure(DetectorParams::fromConfig(cfg));
+}
 
-    // Cooldown terminato -> torna ARMED
-    if (elapsed >= configMgr.get().cooldownMs) {
-        Serial.println("[ALARM] Cooldown terminato - torno ad ARMED");
-        _setState(STATE_ARMED);
+// Una sola scadenza per stato, relativa all'ingresso
+void AlarmLogic::_armDeadline() {
+    uint32_t after;
+    switch (_state) {
+        case STATE_ARMING:
+            after = _params.armingDelayMs;
+            break;
+        case STATE_ALERT: {
+            // La prima tra fine pre-allarme e presenza persa
+            uint32_t lost = _lastDetectionMs + ALERT_PRESENCE_LOST_MS + 1 - _stateStartMs;
+            after = lost < _params.preAlarmMs ? lost : _params.preAlarmMs;
+            break;
+        }
+        case STATE_ALARM:
+            after = _params.alarmDurationMs;
+            break;
+        case STATE_COOLDOWN:
+            after = _params.cooldownMs;
+            break;
+        default:
+            _hasDeadline = false;
+            return;
     }
+    _deadlineMs  = _stateStartMs + after;
+    _hasDeadline = true;
 }
 
 // ============================================================
 // _setState() - Transizione di stato
 // ============================================================
-void AlarmLogic::_setState(AlarmState newState, RadarData* data) {
+void AlarmLogic::_setState(AlarmState newState, bool withSample) {
     _prevState    = _state;
     _state        = newState;
-    _stateStartMs = millis();
+    _stateStartMs = halMillis();
+    _armDeadline();
 
-    Serial.printf("[ALARM] Transizione: %s -> %s\n",
+    halLog.printf("[ALARM] Transizione: %s -> %s\n",
         getStateName(_prevState),
         getStateName(_state));
 
-    // Registra evento
-    _lastEvent.state       = _state;
-    _lastEvent.prevState   = _prevState;
-    _lastEvent.zone        = data ? data->zone : ZONE_NONE;
-    _lastEvent.distance_cm = data ? data->distance_cm : 0;
-    _lastEvent.timestamp   = millis();
-    _lastEvent.isNew       = true;
+    switch (_state) {
+        case STATE_ARMING:
+            halLog.printf("[ALARM] Armamento in %lu secondi...\n",
+                (unsigned long)(_params.armingDelayMs / 1000));
+            break;
+        case STATE_ALERT:
+            halLog.printf("[ALARM] ⚠ PRE-ALLARME! Scatto in %lums\n",
+                (unsigned long)_params.preAlarmMs);
+            break;
+        case STATE_COOLDOWN:
+            halLog.printf("[ALARM] Cooldown: %lus\n",
+                (unsigned long)(_params.cooldownMs / 1000));
+            break;
+        default:
+            break;
+    }
+
+    // Registra evento (letto da MQTT, web, log...)
+    AlarmEvent ev;
+    ev.seq         = _events.nextSeq();
+    ev.state       = _state;
+    ev.prevState   = _prevState;
+    ev.zone        = withSample ? _sampleZone : ZONE_NONE;
+    ev.distance_cm = withSample ? _sampleDist : 0;
+    ev.timestamp   = _stateStartMs;
+    _events.push(ev);
 }
 
 // ============================================================
 // _activateAlarm() - Attiva uscite allarme
 // ============================================================
 void AlarmLogic::_activateAlarm() {
-    digitalWrite(LED_STATUS_PIN, HIGH);
+    halGpioWrite(LED_STATUS_PIN, true);
 
 #if ENABLE_BUZZER
     // PWM buzzer
-    ledcAttach(BUZZER_PIN, 2000, 8);
-    ledcWrite(BUZZER_PIN, 128);
+    halPwmStart(BUZZER_PIN, 2000, 128);
 #endif
 
-    Serial.println("[ALARM] Uscite allarme ATTIVATE");
+    halLog.println("[ALARM] Uscite allarme ATTIVATE");
 }
 
 // ============================================================
 // _deactivateAlarm() - Disattiva uscite allarme
 // ============================================================
 void AlarmLogic::_deactivateAlarm() {
-    digitalWrite(LED_STATUS_PIN, LOW);
+    halGpioWrite(LED_STATUS_PIN, false);
 
 #if ENABLE_BUZZER
-    ledcDetach(BUZZER_PIN);
+    halPwmStop(BUZZER_PIN);
 #endif
 
-    Serial.println("[ALARM] Uscite allarme DISATTIVATE");
+    halLog.println("[ALARM] Uscite allarme DISATTIVATE");
 }
 
 // ============================================================
@@ -283,6 +461,12 @@ AlarmState AlarmLogic::getState() {
     return _state;
 }
 
+uint32_t AlarmLogic::msToDeadline() const {
+    if (!_hasDeadline) return UINT32_MAX;
+    int32_t left = (int32_t)(_deadlineMs - halMillis());
+    return left > 0 ? (uint32_t)left : 0;
+}
+
 const char* AlarmLogic::getStateName() {
     return getStateName(_state);
 }
@@ -299,36 +483,21 @@ const char* AlarmLogic::getStateName(AlarmState state) {
     }
 }
 
-AlarmEvent AlarmLogic::getLastEvent() {
-    return _lastEvent;
-}
-
 uint32_t AlarmLogic::getStateElapsedMs() {
-    return millis() - _stateStartMs;
+    return halMillis() - _stateStartMs;
 }
 
 uint32_t AlarmLogic::getArmingCountdown() {
     if (_state != STATE_ARMING) return 0;
-    uint32_t elapsed = millis() - _stateStartMs;
-    return elapsed < configMgr.get().armingDelayMs ? (configMgr.get().armingDelayMs - elapsed) : 0;
-}
-
-uint32_t AlarmLogic::getAlarmElapsedMs() {
-    if (_state != STATE_ALARM) return 0;
-    return millis() - _stateStartMs;
+    uint32_t elapsed = halMillis() - _stateStartMs;
+    return elapsed < _params.armingDelayMs ? (_params.armingDelayMs - elapsed) : 0;
 }
 
-bool AlarmLogic::hasNewEvent() {
-    return _lastEvent.isNew;
+uint32_t AlarmLogic::getEvidence() {
+    return _detector.score();
 }
 
-void AlarmLogic::clearNewEvent() {
-    _lastEvent.isNew = false;
-}
-
-// ============================================================
-// updateConfig() - Ricarica config da NVS
-// ============================================================
-void AlarmLogic::updateConfig() {
-    Serial.println("[ALARM] Configurazione aggiornata da NVS");
+uint32_t AlarmLogic::getAlarmElapsedMs() {
+    if (_state != STATE_ALARM) return 0;
+    return halMillis() - _stateStartMs;
 }
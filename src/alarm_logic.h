@@ -4,10 +4,15 @@
 #ifndef ALARM_LOGIC_H
 #define ALARM_LOGIC_H
 
-#include <Arduino.h>
+#include <atomic>
+#include "hal.h"
 #include "config.h"
 #include "config_manager.h"
 #include "sensor_ld2420.h"
+#include "noise_profile.h"
+#include "presence_detector.h"
+#include "radar_tracker.h"
+#include "event_ring.h"
 
 // ------------------------------------------------------------
 // Stati del sistema
@@ -25,65 +30,162 @@ enum AlarmState {
 // Evento allarme (per log e MQTT)
 // ------------------------------------------------------------
 struct AlarmEvent {
+    uint32_t    seq;            // sequenza monotona (da 1)
     AlarmState  state;          // stato corrente
     AlarmState  prevState;      // stato precedente
     RadarZone   zone;           // zona rilevamento
     int         distance_cm;    // distanza rilevata
-    uint32_t    timestamp;      // millis() evento
-    bool        isNew;          // true = evento nuovo da inviare
+    uint32_t    timestamp;      // halMillis() evento
+};
+
+typedef EventRing<AlarmEvent, ALARM_EVENT_QUEUE_SIZE> AlarmEventRing;
+
+// ------------------------------------------------------------
+// Comandi da altri task (web), eseguiti nel loop
+// ------------------------------------------------------------
+enum AlarmCommand {
+    ALARM_CMD_NONE = 0,
+    ALARM_CMD_ARM,
+    ALARM_CMD_DISARM,
+    ALARM_CMD_RESET
+};
+
+// ------------------------------------------------------------
+// Eventi della state machine
+// ------------------------------------------------------------
+enum AlarmInput : uint8_t {
+    AIN_SAMPLE = 0,     // nuovo campione radar
+    AIN_TIMER,          // scadenza dello stato corrente
+    AIN_CMD_ARM,
+    AIN_CMD_DISARM,
+    AIN_CMD_RESET,
+    AIN_COUNT
+};
+
+// Parametri della config usati dalla state machine, copiati
+// all'avvio e a ogni nuova versione della config (controllata nel
+// tick: un confronto)
+struct AlarmParams {
+    uint32_t armingDelayMs;
+    uint32_t preAlarmMs;
+    uint32_t alarmDurationMs;
+    uint32_t cooldownMs;
+    int      alarmMinDist;
+    bool     approachEscalate;
+    uint32_t approachLeadMs;
+    int      zoneCriticalMax;
 };
 
 // ------------------------------------------------------------
 // Classe AlarmLogic
 // ------------------------------------------------------------
+// Le transizioni sono una tabella constexpr (stato, evento,
+// guardia, azione, destinazione): vince la prima riga che
+// corrisponde. Ogni stato temporizzato arma una sola scadenza;
+// tra un campione e l'altro tick() costa un confronto.
 class AlarmLogic {
 public:
     AlarmLogic();
 
-    // Inizializza
+    // Inizializza; riparte dallo stato registrato nel journal
+    // prima del riavvio (stateJournal.begin() va chiamato prima)
     void begin();
 
-    // Aggiorna state machine (chiamare nel loop)
-    void update(RadarData& radarData);
+    // Nuovo campione radar (chiamare per ogni campione, nel loop)
+    void onSample(const RadarData& radarData);
+
+    // Comandi in attesa e scadenze (chiamare a ogni giro del loop)
+    void tick();
 
-    // Comandi esterni (web/MQTT)
+    // Comandi esterni dal loop (MQTT, seriale)
     void arm();
     void disarm();
     void reset();
-    void updateConfig();
+
+    // Comando da un altro task (web, unico produttore): accodato e
+    // eseguito al prossimo tick(), in ordine. false se la coda è piena
+    bool post(AlarmCommand cmd);
+
+    // Config salvata (listener di configMgr, da qualsiasi task):
+    // parametri ricaricati al prossimo tick()
+    void configChanged();
+
+    // Task del loop, svegliato da post() (nullptr = nessuna notifica)
+    void setConsumer(HalTaskHandle task) { _consumer = task; }
+    uint32_t droppedCommands() const { return _cmds.overruns(); }
 
     // Getters
     AlarmState  getState();
     const char* getStateName();
-    const char* getStateName(AlarmState state);
-    AlarmEvent  getLastEvent();
+    static const char* getStateName(AlarmState state);
     uint32_t    getStateElapsedMs();    // ms trascorsi nello stato corrente
     uint32_t    getArmingCountdown();   // secondi al termine armamento
     uint32_t    getAlarmElapsedMs();    // ms dall'inizio allarme
+    uint32_t    getEvidence();          // punteggio del rilevatore (ultimo campione)
+    uint32_t    msToDeadline() const;   // ms alla prossima scadenza (UINT32_MAX = nessuna)
+
+    // Transizioni: ogni consumatore legge con il proprio cursore
+    // (da qualsiasi task); false se non ci sono eventi nuovi
+    bool readEvent(EventCursor& cursor, AlarmEvent& out) const { return _events.read(cursor, out); }
+    uint32_t lastEventSeq() const { return _events.lastSeq(); }
 
-    // true se c'è un evento nuovo da processare
-    bool hasNewEvent();
-    void clearNewEvent();
+    // Riga della tabella transizioni
+    typedef bool (AlarmLogic::*Guard)();
+    typedef void (AlarmLogic::*Action)();
+    struct Transition {
+        uint8_t from;       // AlarmState o ANY_STATE
+        AlarmInput input;
+        Guard   guard;      // nullptr = sempre
+        Action  action;     // nullptr = nessuna
+        uint8_t to;         // AlarmState o KEEP_STATE
+        bool    withSample; // evento con zona/distanza del campione
+        const char* note;   // log della transizione (o nullptr)
+    };
+    static constexpr uint8_t ANY_STATE  = 0xFF;
+    static constexpr uint8_t KEEP_STATE = 0xFE;
+
+    // Tabella transizioni (alarm_logic.cpp)
+    static const Transition table[];
 
 private:
     AlarmState  _state;
     AlarmState  _prevState;
-    AlarmEvent  _lastEvent;
-    uint32_t    _stateStartMs;      // millis() ingresso stato corrente
-    uint32_t    _lastDetectionMs;   // millis() ultimo rilevamento
+    AlarmEventRing _events;         // scrittore: solo loop
+    SpscRing<uint8_t, ALARM_CMD_QUEUE_SIZE> _cmds;  // web -> loop
+    HalTaskHandle _consumer;        // loop, svegliato a comando in coda
+    std::atomic<bool> _reload;      // config salvata, _params da ricaricare
+    AlarmParams _params;
+    const RadarData* _sample;       // campione in esame (solo dentro onSample)
+    RadarZone   _sampleZone;        // zona e distanza dell'ultimo campione,
+    int         _sampleDist;        // per gli eventi (anche da scadenza)
+    uint32_t    _stateStartMs;      // halMillis() ingresso stato corrente
+    uint32_t    _lastDetectionMs;   // halMillis() ultimo rilevamento
+    uint32_t    _deadlineMs;        // prossima scadenza (se _hasDeadline)
+    bool        _hasDeadline;
+    PresenceDetector _detector;     // campioni ARMED -> alert
+
+    bool _dispatch(AlarmInput input);
+    void _drainCommands();
+    void _loadParams();
+    void _armDeadline();
+    bool _deadlineDue() const {
+        return _hasDeadline && (int32_t)(halMillis() - _deadlineMs) >= 0;
+    }
 
     // Transizioni stati
-    void _setState(AlarmState newState, RadarData* data = nullptr);
+    void _setState(AlarmState newState, bool withSample = false);
+    void _restore(AlarmState state);
 
-    // Handler per ogni stato
-    void _handleDisarmed(RadarData& data);
-    void _handleArming(RadarData& data);
-    void _handleArmed(RadarData& data);
-    void _handleAlert(RadarData& data);
-    void _handleAlarm(RadarData& data);
-    void _handleCooldown(RadarData& data);
+    // Guardie
+    bool _notDisarmed();
+    bool _intrusion();
+    bool _presenceGone();
+    bool _presenceTimeout();
+    bool _detected();
+    bool _preAlarmElapsed();
 
     // Azioni
+    void _refreshDetection();
     void _activateAlarm();
     void _deactivateAlarm();
 };
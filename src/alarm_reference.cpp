@@ -0,0 +1,153 @@
+// ============================================================
+// AutoGuard - State machine allarme di riferimento (host)
+// ============================================================
+// Stessa logica degli handler per stato precedenti: config letta
+// a ogni giro, tempi ricalcolati in ogni handler. I contatori di
+// zona sono membri (erano static) per poter affiancare due
+// istanze; le uscite GPIO non vengono toccate.
+// ============================================================
+#ifndef ARDUINO
+
+#include "alarm_reference.h"
+
+void AlarmReference::begin() {
+    _state        = STATE_DISARMED;
+    _stateStartMs = halMillis();
+}
+
+void AlarmReference::arm() {
+    if (_state == STATE_DISARMED) _setState(STATE_ARMING);
+}
+
+void AlarmReference::update(RadarData& data) {
+    switch (_state) {
+        case STATE_DISARMED:                        break;
+        case STATE_ARMING:   _handleArming(data);   break;
+        case STATE_ARMED:    _handleArmed(data);    break;
+        case STATE_ALERT:    _handleAlert(data);    break;
+        case STATE_ALARM:    _handleAlarm(data);    break;
+        case STATE_COOLDOWN: _handleCooldown(data); break;
+    }
+}
+
+void AlarmReference::_handleArming(RadarData& data) {
+    (void)data;
+    uint32_t elapsed = halMillis() - _stateStartMs;
+    uint32_t delayMs = (uint32_t)configMgr.get().armingDelayMs;
+
+    if (halMillis() - _lastPrint > 1000) {
+        _lastPrint = halMillis();
+        uint32_t remaining = (elapsed < delayMs) ? (delayMs - elapsed) / 1000 : 0;
+        halLog.printf("[REF] Armamento in %lu secondi...\n", (unsigned long)remaining);
+    }
+
+    if (elapsed >= delayMs) {
+        _setState(STATE_ARMED);
+    }
+}
+
+void AlarmReference::_handleArmed(RadarData& data) {
+    if (!data.detected) return;
+    if (!noiseProfile.confirms(data)) return;
+
+    _lastDetectionMs = halMillis();
+
+    bool triggerAlert = false;
+    AutoGuardConfig cfg = configMgr.get();
+
+    if (data.distance_cm < cfg.alarmMinDist) {
+        return;
+    }
+
+    if (data.zone == ZONE_CRITICAL && cfg.alarmZoneCritical) {
+        triggerAlert = true;
+    } else if (data.zone == ZONE_MEDIUM && cfg.alarmZoneMedium) {
+        _consecCount++;
+        if (_consecCount >= cfg.detectionsToAlert) {
+            triggerAlert = true;
+            _consecCount = 0;
+        }
+    } else if (data.zone == ZONE_FAR && cfg.alarmZoneFar) {
+        _consecCountFar++;
+        if (_consecCountFar >= cfg.detectionsToAlert) {
+            triggerAlert = true;
+            _consecCountFar = 0;
+        }
+    }
+
+    if (triggerAlert) {
+        _setState(STATE_ALERT, &data);
+    }
+}
+
+void AlarmReference::_handleAlert(RadarData& data) {
+    uint32_t elapsed = halMillis() - _stateStartMs;
+    uint32_t preMs   = (uint32_t)configMgr.get().preAlarmMs;
+
+    if (halMillis() - _lastPrint > 500) {
+        _lastPrint = halMillis();
+        halLog.printf("[REF] Pre-allarme, scatto in %lums\n",
+            (unsigned long)(elapsed < preMs ? preMs - elapsed : 0));
+    }
+
+    if (!data.detected) {
+        uint32_t noDetectTime = halMillis() - _lastDetectionMs;
+        if (noDetectTime > 2000) {
+            _setState(STATE_ARMED);
+            return;
+        }
+    } else {
+        _lastDetectionMs = halMillis();
+    }
+
+    if (elapsed >= preMs) {
+        _setState(STATE_ALARM, &data);
+    }
+}
+
+void AlarmReference::_handleAlarm(RadarData& data) {
+    (void)data;
+    uint32_t elapsed = halMillis() - _stateStartMs;
+
+    if (halMillis() - _lastPrint > 5000) {
+        _lastPrint = halMillis();
+        halLog.printf("[REF] Allarme attivo da %lus\n", (unsigned long)(elapsed / 1000));
+    }
+
+    if (elapsed >= (uint32_t)configMgr.get().alarmDurationMs) {
+        _setState(STATE_COOLDOWN);
+    }
+}
+
+void AlarmReference::_handleCooldown(RadarData& data) {
+    (void)data;
+    uint32_t elapsed    = halMillis() - _stateStartMs;
+    uint32_t cooldownMs = (uint32_t)configMgr.get().cooldownMs;
+
+    if (halMillis() - _lastPrint > 5000) {
+        _lastPrint = halMillis();
+        uint32_t remaining = (elapsed < cooldownMs) ? (cooldownMs - elapsed) / 1000 : 0;
+        halLog.printf("[REF] Cooldown: %lus rimanenti\n", (unsigned long)remaining);
+    }
+
+    if (elapsed >= cooldownMs) {
+        _setState(STATE_ARMED);
+    }
+}
+
+void AlarmReference::_setState(AlarmState newState, RadarData* data) {
+    _prevState    = _state;
+    _state        = newState;
+    _stateStartMs = halMillis();
+
+    AlarmEvent ev;
+    ev.seq         = (uint32_t)_events.size() + 1;
+    ev.state       = _state;
+    ev.prevState   = _prevState;
+    ev.zone        = data ? data->zone : ZONE_NONE;
+    ev.distance_cm = data ? data->distance_cm : 0;
+    ev.timestamp   = _stateStartMs;
+    _events.push_back(ev);
+}
+
+#endif // ARDUINO
@@ -0,0 +1,46 @@
+// ============================================================
+// AutoGuard - State machine allarme di riferimento (host)
+// ============================================================
+// Solo per [env:native]: la versione a switch con handler per
+// stato, rivalutata a ogni campione, conservata per verificare
+// che AlarmLogic (tabella + scadenze) produca le stesse
+// transizioni sulle trace registrate. Non usare dal firmware.
+// ============================================================
+#ifndef ALARM_REFERENCE_H
+#define ALARM_REFERENCE_H
+
+#ifndef ARDUINO
+
+#include <vector>
+#include "alarm_logic.h"
+
+class AlarmReference {
+public:
+    void begin();
+    void update(RadarData& data);
+    void arm();
+
+    AlarmState getState() const { return _state; }
+    const std::vector<AlarmEvent>& events() const { return _events; }
+
+private:
+    AlarmState  _state           = STATE_DISARMED;
+    AlarmState  _prevState       = STATE_DISARMED;
+    uint32_t    _stateStartMs    = 0;
+    uint32_t    _lastDetectionMs = 0;
+    int         _consecCount     = 0;
+    int         _consecCountFar  = 0;
+    uint32_t    _lastPrint       = 0;
+    std::vector<AlarmEvent> _events;
+
+    void _setState(AlarmState newState, RadarData* data = nullptr);
+    void _handleArming(RadarData& data);
+    void _handleArmed(RadarData& data);
+    void _handleAlert(RadarData& data);
+    void _handleAlarm(RadarData& data);
+    void _handleCooldown(RadarData& data);
+};
+
+#endif // ARDUINO
+
+#endif // ALARM_REFERENCE_H
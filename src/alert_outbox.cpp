@@ -0,0 +1,239 @@
+// ============================================================
+// AutoGuard - Outbox alert MQTT - Implementazione
+// ============================================================
+#include "alert_outbox.h"
+#include <stdio.h>
+#include <string.h>
+
+#define ENTRY_EVENT     'E'
+#define ENTRY_ACK       'A'
+#define ENTRY_SEED      0xA5
+
+static_assert((OUTBOX_CAPACITY & (OUTBOX_CAPACITY - 1)) == 0,
+              "OUTBOX_CAPACITY deve essere potenza di 2");
+static_assert(OUTBOX_INFLIGHT <= OUTBOX_CAPACITY, "OUTBOX_INFLIGHT oltre la capacità");
+
+static inline void put32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static inline uint32_t get32(const uint8_t* p) {
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Tutta la voce tranne il checksum stesso (tipo incluso)
+static uint8_t entryChecksum(const uint8_t* e) {
+    uint8_t x = ENTRY_SEED ^ e[0];
+    for (int i = 2; i < OUTBOX_ENTRY_LEN; i++) x ^= e[i];
+    return x;
+}
+
+// ============================================================
+// Costruttore
+// ============================================================
+AlertOutbox::AlertOutbox() :
+    _head(0),
+    _send(0),
+    _tail(0),
+    _nextId(1),
+    _ackedId(0),
+    _delivered(0),
+    _dropped(0),
+    _logBytes(0),
+    _sink(nullptr),
+    _sinkCtx(nullptr)
+{
+    memset(_pktIds, 0, sizeof(_pktIds));
+    memset(_pktEvt, 0, sizeof(_pktEvt));
+}
+
+void AlertOutbox::setLogSink(OutboxLogSink sink, void* ctx) {
+    _sink    = sink;
+    _sinkCtx = ctx;
+}
+
+// ============================================================
+// restore() - Coda dal log dell'avvio precedente
+// ============================================================
+uint32_t AlertOutbox::restore(const uint8_t* log, size_t len) {
+    uint32_t maxId = 0;
+    size_t   pos   = 0;
+
+    for (; pos + OUTBOX_ENTRY_LEN <= len; pos += OUTBOX_ENTRY_LEN) {
+        const uint8_t* e = log + pos;
+        if (e[1] != entryChecksum(e)) break;     // scrittura interrotta
+
+        uint32_t id = get32(e + 4);
+        if (id > maxId) maxId = id;
+
+        if (e[0] == ENTRY_EVENT) {
+            OutboxRecord rec;
+            rec.id          = id;
+            rec.distance_cm = (int16_t)(e[2] | ((uint16_t)e[3] << 8));
+            rec.timestamp   = get32(e + 8);
+            rec.state       = e[12];
+            rec.prevState   = e[13];
+            rec.zone        = e[14];
+            rec.restored    = true;
+            if (id > _ackedId) _enqueue(rec);
+        } else if (e[0] == ENTRY_ACK) {
+            if (id > _ackedId) _ackedId = id;
+            while (_tail != _head && _at(_tail).id <= _ackedId) _tail++;
+        } else {
+            break;
+        }
+    }
+
+    _send     = _tail;
+    _nextId   = maxId + 1;
+    _logBytes = pos;
+
+    if (pending()) {
+        halLog.printf("[OUTBOX] %lu eventi da consegnare dal log (id %lu..%lu)\n",
+            (unsigned long)pending(), (unsigned long)_at(_tail).id, (unsigned long)maxId);
+    }
+    return pending();
+}
+
+// ============================================================
+// push() - Nuovo cambio di stato
+// ============================================================
+uint32_t AlertOutbox::push(const AlarmEvent& ev) {
+    OutboxRecord rec;
+    rec.id          = _nextId++;
+    rec.timestamp   = ev.timestamp;
+    rec.distance_cm = (int16_t)(ev.distance_cm > INT16_MAX ? INT16_MAX : ev.distance_cm);
+    rec.state       = (uint8_t)ev.state;
+    rec.prevState   = (uint8_t)ev.prevState;
+    rec.zone        = (uint8_t)ev.zone;
+    rec.restored    = false;
+
+    _enqueue(rec);
+    _logEvent(rec);
+    return rec.id;
+}
+
+void AlertOutbox::_enqueue(const OutboxRecord& rec) {
+    if (pending() >= OUTBOX_CAPACITY) {
+        // Coda piena: si perde il più vecchio
+        if (_send == _tail) _send++;
+        _tail++;
+        _dropped++;
+        halLog.println("[OUTBOX] Coda piena, evento più vecchio scartato");
+    }
+    _at(_head++) = rec;
+}
+
+// ============================================================
+// drain() - Publish QoS 1 in ordine, finestra OUTBOX_INFLIGHT
+// ============================================================
+void AlertOutbox::drain(AsyncMqtt& mqtt, const char* topic) {
+    char json[OUTBOX_JSON_MAX];
+
+    while (mqtt.connected() && _send != _head && inflight() < OUTBOX_INFLIGHT) {
+        const OutboxRecord& rec = _at(_send);
+        size_t len = formatJson(rec, json, sizeof(json));
+        if (len == 0) {
+            _send++;        // non rappresentabile: non blocca la coda
+            continue;
+        }
+
+        uint16_t pid = mqtt.publishQos1(topic, (const uint8_t*)json, len, false);
+        if (pid == 0) break;    // coda TX piena: riprova al prossimo giro
+
+        uint32_t slot = _send % OUTBOX_INFLIGHT;
+        _pktIds[slot] = pid;
+        _pktEvt[slot] = rec.id;
+        _send++;
+    }
+}
+
+// ============================================================
+// Conferme
+// ============================================================
+void AlertOutbox::onAck(uint16_t packetId) {
+    for (uint32_t i = _tail; i != _send; i++) {
+        uint32_t slot = i % OUTBOX_INFLIGHT;
+        if (_pktIds[slot] == packetId) {
+            _pktIds[slot] = 0;
+            _ackUpTo(_pktEvt[slot]);
+            return;
+        }
+    }
+}
+
+void AlertOutbox::_ackUpTo(uint32_t id) {
+    while (_tail != _send && _at(_tail).id <= id) {
+        _tail++;
+        _delivered++;
+    }
+    if (id > _ackedId) {
+        _ackedId = id;
+        _logAck(id);
+    }
+}
+
+void AlertOutbox::rewind() {
+    if (_send != _tail) {
+        halLog.printf("[OUTBOX] %lu eventi non confermati, reinvio\n",
+            (unsigned long)inflight());
+    }
+    _send = _tail;
+    memset(_pktIds, 0, sizeof(_pktIds));
+}
+
+// ============================================================
+// Log su flash
+// ============================================================
+void AlertOutbox::compact() {
+    _logBytes = 0;
+
+    // Conferma fino al primo pendente: conserva anche il contatore id
+    _logAck(pending() ? _at(_tail).id - 1 : _nextId - 1);
+    for (uint32_t i = _tail; i != _head; i++) _logEvent(_at(i));
+}
+
+void AlertOutbox::_logEvent(const OutboxRecord& rec) {
+    uint8_t e[OUTBOX_ENTRY_LEN] = {0};
+    e[0]  = ENTRY_EVENT;
+    e[2]  = (uint16_t)rec.distance_cm & 0xFF;
+    e[3]  = (uint16_t)rec.distance_cm >> 8;
+    put32(e + 4, rec.id);
+    put32(e + 8, rec.timestamp);
+    e[12] = rec.state;
+    e[13] = rec.prevState;
+    e[14] = rec.zone;
+    _emit(e);
+}
+
+void AlertOutbox::_logAck(uint32_t id) {
+    uint8_t e[OUTBOX_ENTRY_LEN] = {0};
+    e[0] = ENTRY_ACK;
+    put32(e + 4, id);
+    _emit(e);
+}
+
+void AlertOutbox::_emit(uint8_t* entry) {
+    if (!_sink) return;
+    entry[1] = entryChecksum(entry);
+    _sink(entry, OUTBOX_ENTRY_LEN, _sinkCtx);
+    _logBytes += OUTBOX_ENTRY_LEN;
+}
+
+// ============================================================
+// formatJson() - Payload su MQTT_TOPIC_ALERT
+// ============================================================
+size_t AlertOutbox::formatJson(const OutboxRecord& rec, char* buf, size_t cap) {
+    int n = snprintf(buf, cap,
+        "{\"event\":\"state_change\",\"id\":%lu,\"state\":\"%s\",\"prev_state\":%u,"
+        "\"zone\":%u,\"distance\":%d,\"timestamp\":%lu,\"uptime_s\":%lu%s}",
+        (unsigned long)rec.id,
+        AlarmLogic::getStateName((AlarmState)rec.state),
+        (unsigned)rec.prevState, (unsigned)rec.zone, (int)rec.distance_cm,
+        (unsigned long)rec.timestamp, (unsigned long)(halMillis() / 1000),
+        rec.restored ? ",\"restored\":true" : "");
+    return (n < 0 || (size_t)n >= cap) ? 0 : (size_t)n;
+}
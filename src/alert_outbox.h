@@ -0,0 +1,116 @@
+// ============================================================
+// AutoGuard - Outbox alert MQTT (consegna QoS 1 con replay)
+// ============================================================
+// Ogni cambio di stato dell'allarme entra in una coda circolare
+// RAM con id monotono (dedup lato consumatore) e timestamp
+// originale. Con broker raggiungibile gli eventi partono in
+// ordine come publish QoS 1, fino a OUTBOX_INFLIGHT senza
+// attendere i PUBACK; a link perso i non confermati ripartono
+// dal primo alla sessione successiva (stesso id).
+// Coda piena: si scarta l'evento più vecchio (contato).
+//
+// Log opzionale su flash (append-only, voci da 16 byte):
+//   [0]      tipo: 'E' evento, 'A' conferma
+//   [1]      checksum (xor byte 0 e 2..15, 0xA5)
+//   'E':  [2..3] distanza cm (i16)  [4..7] id  [8..11] timestamp
+//         [12] stato  [13] stato precedente  [14] zona  [15] 0
+//   'A':  [4..7] id confermato (valgono anche tutti i precedenti)
+// All'avvio restore() ricostruisce la coda; una voce troncata o
+// corrotta in coda al file viene ignorata (logBytes() < file: il
+// file va riscritto prima di accodare). La compattazione scrive
+// un file nuovo da sostituire al log solo a scrittura completata.
+// Non dipende da Arduino: compilabile anche su host.
+// ============================================================
+#ifndef ALERT_OUTBOX_H
+#define ALERT_OUTBOX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+#include "alarm_logic.h"
+#include "mqtt_async.h"
+
+#define OUTBOX_ENTRY_LEN    16
+
+struct OutboxRecord {
+    uint32_t id;            // id dedup, monotono anche tra riavvii
+    uint32_t timestamp;     // halMillis() dell'evento originale
+    int16_t  distance_cm;
+    uint8_t  state;
+    uint8_t  prevState;
+    uint8_t  zone;
+    bool     restored;      // recuperato dal log (avvio precedente)
+};
+
+// Voce di log da accodare al file (OUTBOX_ENTRY_LEN byte)
+typedef void (*OutboxLogSink)(const uint8_t* entry, size_t len, void* ctx);
+
+class AlertOutbox {
+public:
+    AlertOutbox();
+
+    // Log su flash (opzionale); impostare prima di restore()
+    void setLogSink(OutboxLogSink sink, void* ctx);
+
+    // Ricostruisce la coda dal log letto all'avvio; restituisce
+    // gli eventi non confermati recuperati
+    uint32_t restore(const uint8_t* log, size_t len);
+
+    // Accoda un cambio di stato (solo dal loop); restituisce l'id
+    uint32_t push(const AlarmEvent& ev);
+
+    // Pubblica i prossimi eventi (finestra OUTBOX_INFLIGHT)
+    void drain(AsyncMqtt& mqtt, const char* topic);
+
+    // PUBACK dal broker (callback AsyncMqtt::onAck)
+    void onAck(uint16_t packetId);
+
+    // Nuova sessione: i non confermati vanno ripubblicati
+    void rewind();
+
+    // Log oltre OUTBOX_LOG_MAX: compact() verso un file nuovo
+    bool needsCompact() const { return _logBytes >= OUTBOX_LOG_MAX; }
+
+    // Scrive nel sink conferma + eventi pendenti (log completo)
+    void compact();
+
+    // Byte di log validi (dopo restore(): voci integre lette)
+    uint32_t logBytes() const { return _logBytes; }
+
+    // Payload JSON dell'alert; restituisce la lunghezza (0 se cap insufficiente)
+    static size_t formatJson(const OutboxRecord& rec, char* buf, size_t cap);
+
+    // Statistiche
+    uint32_t pending()   const { return _head - _tail; }
+    uint32_t inflight()  const { return _send - _tail; }
+    uint32_t delivered() const { return _delivered; }
+    uint32_t dropped()   const { return _dropped; }
+    uint32_t lastId()    const { return _nextId - 1; }
+
+private:
+    OutboxRecord  _ring[OUTBOX_CAPACITY];
+    uint32_t      _head;        // prossimo slot libero
+    uint32_t      _send;        // prossimo da pubblicare
+    uint32_t      _tail;        // più vecchio non confermato
+    uint32_t      _nextId;
+    uint32_t      _ackedId;     // ultimo id confermato
+    uint32_t      _delivered;
+    uint32_t      _dropped;
+    uint32_t      _logBytes;
+
+    // Publish in volo: packet id MQTT -> id evento
+    uint16_t      _pktIds[OUTBOX_INFLIGHT];
+    uint32_t      _pktEvt[OUTBOX_INFLIGHT];
+
+    OutboxLogSink _sink;
+    void*         _sinkCtx;
+
+    OutboxRecord& _at(uint32_t idx) { return _ring[idx % OUTBOX_CAPACITY]; }
+    void _enqueue(const OutboxRecord& rec);
+    void _ackUpTo(uint32_t id);
+    void _logEvent(const OutboxRecord& rec);
+    void _logAck(uint32_t id);
+    void _emit(uint8_t* entry);
+};
+
+#endif // ALERT_OUTBOX_H
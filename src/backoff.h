@@ -0,0 +1,51 @@
+// ============================================================
+// AutoGuard - Backoff esponenziale con jitter
+// ============================================================
+// Ritardo tra tentativi di connessione (WiFi, MQTT): raddoppia
+// a ogni fallimento fino al tetto, con jitter casuale +/- pct
+// per non sincronizzare i tentativi di più dispositivi.
+// Non dipende da Arduino: compilabile anche su host.
+// ============================================================
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <stdint.h>
+
+class ExpBackoff {
+public:
+    ExpBackoff(uint32_t minMs, uint32_t maxMs, uint8_t jitterPct) :
+        _min(minMs), _max(maxMs), _jitter(jitterPct), _base(minMs), _rng(1) {}
+
+    void seed(uint32_t s) { _rng = s ? s : 1; }
+
+    // Ritardo per il prossimo tentativo, poi raddoppia la base
+    uint32_t next() {
+        uint32_t span  = _base * _jitter / 100;
+        uint32_t delay = _base - span + (span ? _random() % (2 * span + 1) : 0);
+
+        _base = (_base > _max / 2) ? _max : _base * 2;
+        return delay;
+    }
+
+    // Connessione riuscita: si riparte dal minimo
+    void reset() { _base = _min; }
+
+    uint32_t base() const { return _base; }
+
+private:
+    uint32_t _min;
+    uint32_t _max;
+    uint32_t _jitter;
+    uint32_t _base;
+    uint32_t _rng;
+
+    uint32_t _random() {
+        // xorshift32
+        _rng ^= _rng << 13;
+        _rng ^= _rng >> 17;
+        _rng ^= _rng << 5;
+        return _rng;
+    }
+};
+
+#endif // BACKOFF_H
@@ -10,6 +10,8 @@ ConfigManager configMgr;
 #define KEY_ZONE_CRIT    "zone_crit"
 #define KEY_ZONE_MED     "zone_med"
 #define KEY_ZONE_FAR     "zone_far"
+#define KEY_ZONE_H_IN    "zone_h_in"
+#define KEY_ZONE_H_OUT   "zone_h_out"
 #define KEY_ARM_DELAY    "arm_delay"
 #define KEY_PRE_ALARM    "pre_alarm"
 #define KEY_ALARM_DUR    "alarm_dur"
@@ -17,60 +19,126 @@ ConfigManager configMgr;
 #define KEY_DETECTIONS   "detections"
 #define KEY_RADAR_MIN    "radar_min"
 #define KEY_RADAR_MAX    "radar_max"
+#define KEY_FILT_MODE    "filt_mode"
+#define KEY_FILT_ALPHA   "filt_alpha"
+#define KEY_KALMAN_Q     "kalman_q"
+#define KEY_KALMAN_R     "kalman_r"
+#define KEY_ENG_MODE     "eng_mode"
+#define KEY_NOISE_SIGMA  "noise_sigma"
+#define KEY_DET_MODE     "det_mode"
+#define KEY_EV_THRESH    "ev_thresh"
+#define KEY_EV_HALF      "ev_half"
+#define KEY_EV_W_CRIT    "ev_w_crit"
+#define KEY_EV_W_MED     "ev_w_med"
+#define KEY_EV_W_FAR     "ev_w_far"
+#define KEY_EV_DWELL     "ev_dwell"
+#define KEY_EV_APPROACH  "ev_approach"
+#define KEY_APPR_ESC     "appr_esc"
+#define KEY_APPR_LEAD    "appr_lead"
 
-ConfigManager::ConfigManager() {
-    _loadDefaults();
+ConfigManager::ConfigManager() :
+    _current(&_slots[0]),
+    _writing(false),
+    _listenerCount(0)
+{
+    loadDefaults(_slots[0].cfg);
+    _slots[0].version = 1;
 }
 
-void ConfigManager::_loadDefaults() {
-    _cfg.zoneCriticalMax   = ZONE_CRITICAL_MAX;
-    _cfg.zoneMediumMax     = ZONE_MEDIUM_MAX;
-    _cfg.zoneFarMax        = ZONE_FAR_MAX;
-    _cfg.armingDelayMs     = ARMING_DELAY_MS;
-    _cfg.preAlarmMs        = PRE_ALARM_MS;
-    _cfg.alarmDurationMs   = ALARM_DURATION_MS;
-    _cfg.cooldownMs        = COOLDOWN_MS;
-    _cfg.detectionsToAlert = DETECTIONS_TO_ALERT;
-    _cfg.radarMinDist      = RADAR_MIN_DIST_CM;
-    _cfg.radarMaxDist      = RADAR_MAX_DIST_CM;
-    _cfg.alarmMinDist      = 30;    // ignora sotto 30cm
-    _cfg.alarmZoneCritical = true;
-    _cfg.alarmZoneMedium   = true;
-    _cfg.alarmZoneFar      = false;
+void ConfigManager::loadDefaults(AutoGuardConfig& cfg) {
+    cfg.zoneCriticalMax   = ZONE_CRITICAL_MAX;
+    cfg.zoneMediumMax     = ZONE_MEDIUM_MAX;
+    cfg.zoneFarMax        = ZONE_FAR_MAX;
+    cfg.zoneHystEnterCm   = ZONE_HYST_ENTER_CM;
+    cfg.zoneHystExitCm    = ZONE_HYST_EXIT_CM;
+    cfg.armingDelayMs     = ARMING_DELAY_MS;
+    cfg.preAlarmMs        = PRE_ALARM_MS;
+    cfg.alarmDurationMs   = ALARM_DURATION_MS;
+    cfg.cooldownMs        = COOLDOWN_MS;
+    cfg.detectionsToAlert = DETECTIONS_TO_ALERT;
+    cfg.radarMinDist      = RADAR_MIN_DIST_CM;
+    cfg.radarMaxDist      = RADAR_MAX_DIST_CM;
+    cfg.alarmMinDist      = 30;    // ignora sotto 30cm
+    cfg.alarmZoneCritical = true;
+    cfg.alarmZoneMedium   = true;
+    cfg.alarmZoneFar      = false;
+    cfg.filterMode        = FILTER_MODE;
+    cfg.filterEmaAlpha    = FILTER_EMA_ALPHA;
+    cfg.filterKalmanQ     = FILTER_KALMAN_Q;
+    cfg.filterKalmanR     = FILTER_KALMAN_R;
+    cfg.engineeringMode   = RADAR_ENGINEERING_MODE;
+    cfg.noiseSigmaX10     = NOISE_SIGMA_X10;
+    cfg.detectorMode           = DETECTOR_MODE;
+    cfg.evidenceThreshold      = EVIDENCE_THRESHOLD;
+    cfg.evidenceHalfLifeMs     = EVIDENCE_HALF_LIFE_MS;
+    cfg.evidenceWeightCritical = EVIDENCE_WEIGHT_CRITICAL;
+    cfg.evidenceWeightMedium   = EVIDENCE_WEIGHT_MEDIUM;
+    cfg.evidenceWeightFar      = EVIDENCE_WEIGHT_FAR;
+    cfg.evidenceDwellMs        = EVIDENCE_DWELL_MS;
+    cfg.evidenceApproachPct    = EVIDENCE_APPROACH_PCT;
+    cfg.approachEscalate       = APPROACH_ESCALATE;
+    cfg.approachLeadMs         = APPROACH_LEAD_MS;
 }
 
 void ConfigManager::begin() {
+    AutoGuardConfig c = get();
+
     _prefs.begin(NVS_NAMESPACE, false);
 
     // Carica da NVS, usa default se non trovato
-    _cfg.zoneCriticalMax   = _prefs.getInt(KEY_ZONE_CRIT,  _cfg.zoneCriticalMax);
-    _cfg.zoneMediumMax     = _prefs.getInt(KEY_ZONE_MED,   _cfg.zoneMediumMax);
-    _cfg.zoneFarMax        = _prefs.getInt(KEY_ZONE_FAR,   _cfg.zoneFarMax);
-    _cfg.armingDelayMs     = _prefs.getInt(KEY_ARM_DELAY,  _cfg.armingDelayMs);
-    _cfg.preAlarmMs        = _prefs.getInt(KEY_PRE_ALARM,  _cfg.preAlarmMs);
-    _cfg.alarmDurationMs   = _prefs.getInt(KEY_ALARM_DUR,  _cfg.alarmDurationMs);
-    _cfg.cooldownMs        = _prefs.getInt(KEY_COOLDOWN,   _cfg.cooldownMs);
-    _cfg.detectionsToAlert = _prefs.getInt(KEY_DETECTIONS, _cfg.detectionsToAlert);
-    _cfg.radarMinDist      = _prefs.getInt(KEY_RADAR_MIN,  _cfg.radarMinDist);
-    _cfg.radarMaxDist      = _prefs.getInt(KEY_RADAR_MAX,  _cfg.radarMaxDist);
-    _cfg.alarmMinDist      = _prefs.getInt("alarm_min",    _cfg.alarmMinDist);
-    _cfg.alarmZoneCritical = _prefs.getBool("alarm_crit",  _cfg.alarmZoneCritical);
-    _cfg.alarmZoneMedium   = _prefs.getBool("alarm_med",   _cfg.alarmZoneMedium);
-    _cfg.alarmZoneFar      = _prefs.getBool("alarm_far",   _cfg.alarmZoneFar);
+    c.zoneCriticalMax   = _prefs.getInt(KEY_ZONE_CRIT,  c.zoneCriticalMax);
+    c.zoneMediumMax     = _prefs.getInt(KEY_ZONE_MED,   c.zoneMediumMax);
+    c.zoneFarMax        = _prefs.getInt(KEY_ZONE_FAR,   c.zoneFarMax);
+    c.zoneHystEnterCm   = _prefs.getInt(KEY_ZONE_H_IN,  c.zoneHystEnterCm);
+    c.zoneHystExitCm    = _prefs.getInt(KEY_ZONE_H_OUT, c.zoneHystExitCm);
+    c.armingDelayMs     = _prefs.getInt(KEY_ARM_DELAY,  c.armingDelayMs);
+    c.preAlarmMs        = _prefs.getInt(KEY_PRE_ALARM,  c.preAlarmMs);
+    c.alarmDurationMs   = _prefs.getInt(KEY_ALARM_DUR,  c.alarmDurationMs);
+    c.cooldownMs        = _prefs.getInt(KEY_COOLDOWN,   c.cooldownMs);
+    c.detectionsToAlert = _prefs.getInt(KEY_DETECTIONS, c.detectionsToAlert);
+    c.radarMinDist      = _prefs.getInt(KEY_RADAR_MIN,  c.radarMinDist);
+    c.radarMaxDist      = _prefs.getInt(KEY_RADAR_MAX,  c.radarMaxDist);
+    c.alarmMinDist      = _prefs.getInt("alarm_min",    c.alarmMinDist);
+    c.alarmZoneCritical = _prefs.getBool("alarm_crit",  c.alarmZoneCritical);
+    c.alarmZoneMedium   = _prefs.getBool("alarm_med",   c.alarmZoneMedium);
+    c.alarmZoneFar      = _prefs.getBool("alarm_far",   c.alarmZoneFar);
+    c.filterMode        = _prefs.getInt(KEY_FILT_MODE,  c.filterMode);
+    c.filterEmaAlpha    = _prefs.getInt(KEY_FILT_ALPHA, c.filterEmaAlpha);
+    c.filterKalmanQ     = _prefs.getInt(KEY_KALMAN_Q,   c.filterKalmanQ);
+    c.filterKalmanR     = _prefs.getInt(KEY_KALMAN_R,   c.filterKalmanR);
+    c.engineeringMode   = _prefs.getBool(KEY_ENG_MODE,  c.engineeringMode);
+    c.noiseSigmaX10     = _prefs.getInt(KEY_NOISE_SIGMA, c.noiseSigmaX10);
+    c.detectorMode           = _prefs.getInt(KEY_DET_MODE,    c.detectorMode);
+    c.evidenceThreshold      = _prefs.getInt(KEY_EV_THRESH,   c.evidenceThreshold);
+    c.evidenceHalfLifeMs     = _prefs.getInt(KEY_EV_HALF,     c.evidenceHalfLifeMs);
+    c.evidenceWeightCritical = _prefs.getInt(KEY_EV_W_CRIT,   c.evidenceWeightCritical);
+    c.evidenceWeightMedium   = _prefs.getInt(KEY_EV_W_MED,    c.evidenceWeightMedium);
+    c.evidenceWeightFar      = _prefs.getInt(KEY_EV_W_FAR,    c.evidenceWeightFar);
+    c.evidenceDwellMs        = _prefs.getInt(KEY_EV_DWELL,    c.evidenceDwellMs);
+    c.evidenceApproachPct    = _prefs.getInt(KEY_EV_APPROACH, c.evidenceApproachPct);
+    c.approachEscalate       = _prefs.getBool(KEY_APPR_ESC,   c.approachEscalate);
+    c.approachLeadMs         = _prefs.getInt(KEY_APPR_LEAD,   c.approachLeadMs);
 
     _prefs.end();
 
-    Serial.println("[CFG] Configurazione caricata da NVS");
+    _lock();
+    _publish(c);
+    _unlock();
+
+    halLog.println("[CFG] Configurazione caricata da NVS");
     print();
 }
 
 bool ConfigManager::save(const AutoGuardConfig& cfg) {
-    _cfg = cfg;
+    _lock();
+    _publish(cfg);
 
     _prefs.begin(NVS_NAMESPACE, false);
     _prefs.putInt(KEY_ZONE_CRIT,  cfg.zoneCriticalMax);
     _prefs.putInt(KEY_ZONE_MED,   cfg.zoneMediumMax);
     _prefs.putInt(KEY_ZONE_FAR,   cfg.zoneFarMax);
+    _prefs.putInt(KEY_ZONE_H_IN,  cfg.zoneHystEnterCm);
+    _prefs.putInt(KEY_ZONE_H_OUT, cfg.zoneHystExitCm);
     _prefs.putInt(KEY_ARM_DELAY,  cfg.armingDelayMs);
     _prefs.putInt(KEY_PRE_ALARM,  cfg.preAlarmMs);
     _prefs.putInt(KEY_ALARM_DUR,  cfg.alarmDurationMs);
@@ -82,34 +150,87 @@ bool ConfigManager::save(const AutoGuardConfig& cfg) {
     _prefs.putBool("alarm_crit",  cfg.alarmZoneCritical);
     _prefs.putBool("alarm_med",   cfg.alarmZoneMedium);
     _prefs.putBool("alarm_far",   cfg.alarmZoneFar);
+    _prefs.putInt(KEY_FILT_MODE,  cfg.filterMode);
+    _prefs.putInt(KEY_FILT_ALPHA, cfg.filterEmaAlpha);
+    _prefs.putInt(KEY_KALMAN_Q,   cfg.filterKalmanQ);
+    _prefs.putInt(KEY_KALMAN_R,   cfg.filterKalmanR);
+    _prefs.putBool(KEY_ENG_MODE,  cfg.engineeringMode);
+    _prefs.putInt(KEY_NOISE_SIGMA, cfg.noiseSigmaX10);
+    _prefs.putInt(KEY_DET_MODE,    cfg.detectorMode);
+    _prefs.putInt(KEY_EV_THRESH,   cfg.evidenceThreshold);
+    _prefs.putInt(KEY_EV_HALF,     cfg.evidenceHalfLifeMs);
+    _prefs.putInt(KEY_EV_W_CRIT,   cfg.evidenceWeightCritical);
+    _prefs.putInt(KEY_EV_W_MED,    cfg.evidenceWeightMedium);
+    _prefs.putInt(KEY_EV_W_FAR,    cfg.evidenceWeightFar);
+    _prefs.putInt(KEY_EV_DWELL,    cfg.evidenceDwellMs);
+    _prefs.putInt(KEY_EV_APPROACH, cfg.evidenceApproachPct);
+    _prefs.putBool(KEY_APPR_ESC,   cfg.approachEscalate);
+    _prefs.putInt(KEY_APPR_LEAD,   cfg.approachLeadMs);
     _prefs.end();
+    _unlock();
 
-    Serial.println("[CFG] Configurazione salvata in NVS");
+    halLog.println("[CFG] Configurazione salvata in NVS");
     print();
+
+    const AutoGuardConfig& now = get();
+    for (uint8_t i = 0; i < _listenerCount; i++) _listeners[i](now, _listenerCtx[i]);
     return true;
 }
 
-AutoGuardConfig ConfigManager::get() {
-    return _cfg;
+void ConfigManager::resetDefaults() {
+    AutoGuardConfig cfg;
+    loadDefaults(cfg);
+    save(cfg);
+    halLog.println("[CFG] Reset ai valori di default");
 }
 
-void ConfigManager::resetDefaults() {
-    _loadDefaults();
-    save(_cfg);
-    Serial.println("[CFG] Reset ai valori di default");
+// ============================================================
+// Snapshot: pubblicazione e listener
+// ============================================================
+// Slot successivo a quello corrente: il più vecchio dei tre
+void ConfigManager::_publish(const AutoGuardConfig& cfg) {
+    const Snapshot* cur  = _current.load(std::memory_order_relaxed);
+    Snapshot&       next = _slots[(cur - _slots + 1) % CONFIG_SNAPSHOTS];
+    next.cfg     = cfg;
+    next.version = cur->version + 1;
+    _current.store(&next, std::memory_order_release);
+}
+
+void ConfigManager::_lock() {
+    while (_writing.exchange(true, std::memory_order_acquire)) halDelay(1);
+}
+
+bool ConfigManager::subscribe(ConfigListener fn, void* ctx) {
+    if (!fn || _listenerCount >= CONFIG_LISTENERS) return false;
+    _listeners[_listenerCount]   = fn;
+    _listenerCtx[_listenerCount] = ctx;
+    _listenerCount++;
+    return true;
 }
 
 void ConfigManager::print() {
-    Serial.println("[CFG] ---- Configurazione corrente ----");
-    Serial.printf("[CFG] Zone: CRITICAL<%dcm MEDIUM<%dcm FAR<%dcm\n",
-        _cfg.zoneCriticalMax, _cfg.zoneMediumMax, _cfg.zoneFarMax);
-    Serial.printf("[CFG] Timing: ARM=%ds PRE=%ds ALARM=%ds COOL=%ds\n",
-        _cfg.armingDelayMs/1000, _cfg.preAlarmMs/1000,
-        _cfg.alarmDurationMs/1000, _cfg.cooldownMs/1000);
-    Serial.printf("[CFG] Allarme: minDist=%dcm crit=%d med=%d far=%d\n",
-        _cfg.alarmMinDist, _cfg.alarmZoneCritical,
-        _cfg.alarmZoneMedium, _cfg.alarmZoneFar);
-    Serial.printf("[CFG] Sensibilita: detect=%d radarMin=%dcm radarMax=%dcm\n",
-        _cfg.detectionsToAlert, _cfg.radarMinDist, _cfg.radarMaxDist);
-    Serial.println("[CFG] ------------------------------------");
+    const AutoGuardConfig& c = get();
+    halLog.println("[CFG] ---- Configurazione corrente ----");
+    halLog.printf("[CFG] Zone: CRITICAL<%dcm MEDIUM<%dcm FAR<%dcm isteresi +%d/-%dcm\n",
+        c.zoneCriticalMax, c.zoneMediumMax, c.zoneFarMax,
+        c.zoneHystEnterCm, c.zoneHystExitCm);
+    halLog.printf("[CFG] Timing: ARM=%ds PRE=%ds ALARM=%ds COOL=%ds\n",
+        c.armingDelayMs/1000, c.preAlarmMs/1000,
+        c.alarmDurationMs/1000, c.cooldownMs/1000);
+    halLog.printf("[CFG] Allarme: minDist=%dcm crit=%d med=%d far=%d\n",
+        c.alarmMinDist, c.alarmZoneCritical,
+        c.alarmZoneMedium, c.alarmZoneFar);
+    halLog.printf("[CFG] Sensibilita: detect=%d radarMin=%dcm radarMax=%dcm\n",
+        c.detectionsToAlert, c.radarMinDist, c.radarMaxDist);
+    halLog.printf("[CFG] Filtro: mode=%d alpha=%d%% kalmanQ=%d kalmanR=%d\n",
+        c.filterMode, c.filterEmaAlpha, c.filterKalmanQ, c.filterKalmanR);
+    halLog.printf("[CFG] Radar: engineering=%d noiseSigma=%d.%d\n",
+        c.engineeringMode, c.noiseSigmaX10 / 10, c.noiseSigmaX10 % 10);
+    halLog.printf("[CFG] Rilevatore: mode=%d soglia=%d half=%dms pesi=%d/%d/%d dwell=%dms approach=%d%%\n",
+        c.detectorMode, c.evidenceThreshold, c.evidenceHalfLifeMs,
+        c.evidenceWeightCritical, c.evidenceWeightMedium, c.evidenceWeightFar,
+        c.evidenceDwellMs, c.evidenceApproachPct);
+    halLog.printf("[CFG] Avvicinamento: escalation=%d anticipo=%dms\n",
+        c.approachEscalate, c.approachLeadMs);
+    halLog.println("[CFG] ------------------------------------");
 }
@@ -4,14 +4,16 @@
 #ifndef CONFIG_MANAGER_H
 #define CONFIG_MANAGER_H
 
-#include <Arduino.h>
-#include <Preferences.h>
+#include <atomic>
+#include "hal.h"
 #include "config.h"
 
 struct AutoGuardConfig {
     int zoneCriticalMax;
     int zoneMediumMax;
     int zoneFarMax;
+    int zoneHystEnterCm;    // isteresi ingresso zona (cm)
+    int zoneHystExitCm;     // isteresi uscita zona (cm)
     int armingDelayMs;
     int preAlarmMs;
     int alarmDurationMs;
@@ -24,21 +26,89 @@ struct AutoGuardConfig {
     bool alarmZoneCritical; // abilita zona critica
     bool alarmZoneMedium;   // abilita zona media
     bool alarmZoneFar;      // abilita zona lontana
+    // Filtro distanza
+    int filterMode;         // FilterMode (radar_filter.h)
+    int filterEmaAlpha;     // % filtro esponenziale
+    int filterKalmanQ;      // rumore di processo Kalman
+    int filterKalmanR;      // rumore di misura Kalman
+    // Radar
+    bool engineeringMode;   // energie per gate (LD2420 engineering)
+    int  noiseSigmaX10;     // soglia adattiva rumore (sigma x10)
+    // Rilevatore intrusione
+    int  detectorMode;           // DetectorMode (presence_detector.h)
+    int  evidenceThreshold;      // punti per alert
+    int  evidenceHalfLifeMs;     // dimezzamento del punteggio
+    int  evidenceWeightCritical; // punti per campione, per zona
+    int  evidenceWeightMedium;
+    int  evidenceWeightFar;
+    int  evidenceDwellMs;        // presenza continua che raddoppia il peso
+    int  evidenceApproachPct;    // +/- peso in avvicinamento/allontanamento
+    bool approachEscalate;       // avvicinamento sostenuto -> zona critica
+    int  approachLeadMs;         // anticipo sulla zona critica prevista
+    // Nuovi campi: aggiungerli in coda anche a TRACE_CONFIG_FIELDS
+    // (radar_trace.h)
 };
 
+// ------------------------------------------------------------
+// Snapshot immutabili con versione (stile RCU)
+// ------------------------------------------------------------
+// I lettori (loop, task radar, web) ottengono un riferimento
+// const all'ultima config pubblicata: un load atomico, nessuna
+// copia. Lo scrittore prepara la nuova config in uno slot libero
+// e la pubblica scambiando il puntatore; gli snapshot pubblicati
+// non cambiano più. Un riferimento resta valido per
+// CONFIG_SNAPSHOTS - 1 salvataggi successivi: non conservarlo
+// oltre la funzione che lo usa.
+// Gli stati derivati (soglie, filtri, parametri) si ricostruiscono
+// quando version() cambia; i listener sono chiamati nel task che
+// salva, dopo la pubblicazione (solo richieste verso i propri
+// task, niente lavoro pesante).
+#define CONFIG_SNAPSHOTS    3
+#define CONFIG_LISTENERS    4
+
+typedef void (*ConfigListener)(const AutoGuardConfig& cfg, void* ctx);
+
 class ConfigManager {
 public:
     ConfigManager();
     void begin();
     bool save(const AutoGuardConfig& cfg);
-    AutoGuardConfig get();
     void resetDefaults();
     void print();
 
+    // Valori di config.h
+    static void loadDefaults(AutoGuardConfig& cfg);
+
+    // Ultimo snapshot pubblicato (da qualsiasi task)
+    const AutoGuardConfig& get() const {
+        return _current.load(std::memory_order_acquire)->cfg;
+    }
+
+    // Versione dell'ultimo snapshot (cresce a ogni pubblicazione, da 1)
+    uint32_t version() const {
+        return _current.load(std::memory_order_acquire)->version;
+    }
+
+    // Notifica a ogni pubblicazione; false oltre CONFIG_LISTENERS
+    bool subscribe(ConfigListener fn, void* ctx);
+
 private:
-    Preferences     _prefs;
-    AutoGuardConfig _cfg;
-    void _loadDefaults();
+    struct Snapshot {
+        AutoGuardConfig cfg;
+        uint32_t        version;
+    };
+
+    HalKvStore      _prefs;
+    Snapshot        _slots[CONFIG_SNAPSHOTS];
+    std::atomic<const Snapshot*> _current;
+    std::atomic<bool> _writing;     // scrittori in fila (web, loop)
+    ConfigListener  _listeners[CONFIG_LISTENERS];
+    void*           _listenerCtx[CONFIG_LISTENERS];
+    uint8_t         _listenerCount;
+
+    void _publish(const AutoGuardConfig& cfg);
+    void _lock();
+    void _unlock() { _writing.store(false, std::memory_order_release); }
 };
 
 extern ConfigManager configMgr;
@@ -0,0 +1,109 @@
+// ============================================================
+// AutoGuard - Batch binari energie per gate - Implementazione
+// ============================================================
+#include "energy_batch.h"
+#include <string.h>
+
+static inline void put16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static inline void put32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+// ============================================================
+// Costruttore
+// ============================================================
+EnergyBatcher::EnergyBatcher() :
+    _active(0),
+    _ready(1),
+    _frames(0),
+    _seq(0),
+    _baseMs(0),
+    _gen(0),
+    _lastSeq(0)
+{
+    _len[0] = 0;
+    _len[1] = 0;
+}
+
+// ============================================================
+// add() - Accoda un frame nel batch corrente
+// ============================================================
+bool EnergyBatcher::add(const RadarGateEnergy& e) {
+    if (_frames == 0) _baseMs = e.timestamp;
+
+    uint8_t* f  = _buf[_active] + ENERGY_BATCH_HEADER_LEN + _frames * ENERGY_BATCH_FRAME_LEN;
+    uint32_t dt = e.timestamp - _baseMs;
+
+    put16(f, dt > 0xFFFF ? 0xFFFF : (uint16_t)dt);
+    put16(f + 2, (e.distance_cm & 0x7FFF) | (e.presence ? 0x8000 : 0));
+    for (int g = 0; g < LD2420_GATE_COUNT; g++) {
+        put16(f + 4 + 2 * g, e.energy[g]);
+    }
+
+    // Batch chiuso a numero frame fisso o se il delta satura
+    if (++_frames >= ENERGY_BATCH_FRAMES || dt >= 0xFFFF) {
+        _finalize();
+        return true;
+    }
+    return false;
+}
+
+void EnergyBatcher::clear() {
+    _frames = 0;
+}
+
+// ============================================================
+// _finalize() - Scrive l'header e pubblica il buffer
+// ============================================================
+void EnergyBatcher::_finalize() {
+    uint8_t* h = _buf[_active];
+
+    if (++_seq == 0) _seq = 1;     // 0 riservato a "nessun batch"
+    h[0] = ENERGY_BATCH_MAGIC0;
+    h[1] = ENERGY_BATCH_MAGIC1;
+    h[2] = ENERGY_BATCH_VERSION;
+    h[3] = LD2420_GATE_COUNT;
+    put16(h + 4, _seq);
+    h[6] = _frames;
+    h[7] = 0;
+    put32(h + 8, _baseMs);
+    _len[_active] = ENERGY_BATCH_HEADER_LEN + _frames * ENERGY_BATCH_FRAME_LEN;
+
+    // Swap sotto seqlock
+    _gen.fetch_add(1, std::memory_order_acq_rel);
+    _ready  = _active;
+    _active ^= 1;
+    _gen.fetch_add(1, std::memory_order_acq_rel);
+
+    _lastSeq.store(_seq, std::memory_order_release);
+    _frames = 0;
+}
+
+// ============================================================
+// copyLast() - Lettura consistente dell'ultimo batch
+// ============================================================
+size_t EnergyBatcher::copyLast(uint8_t* dst, size_t cap, uint16_t* seq) {
+    for (int attempt = 0; attempt < 4; attempt++) {
+        uint32_t g1 = _gen.load(std::memory_order_acquire);
+        if (g1 & 1) continue;
+
+        uint8_t idx = _ready;
+        size_t  len = _len[idx];
+        if (len == 0 || len > cap) return 0;
+        memcpy(dst, _buf[idx], len);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_gen.load(std::memory_order_relaxed) == g1) {
+            if (seq) *seq = (uint16_t)(dst[4] | (dst[5] << 8));
+            return len;
+        }
+    }
+    return 0;
+}
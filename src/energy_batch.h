@@ -0,0 +1,70 @@
+// ============================================================
+// AutoGuard - Batch binari energie per gate
+// ============================================================
+// Formato (little-endian), versione 1:
+//   header 12 byte:
+//     [0..1]  magic 'A' 'E'
+//     [2]     versione (1)
+//     [3]     numero gate per frame
+//     [4..5]  sequenza batch (u16)
+//     [6]     numero frame nel batch
+//     [7]     riservato
+//     [8..11] timestamp base (ms, u32)
+//   frame (4 + 2*gate byte):
+//     [0..1]  delta ms dal timestamp base (u16, saturato)
+//     [2..3]  distanza cm (bit 15 = presenza)
+//     [4..]   energia gate 0..N-1 (u16)
+//
+// Doppio buffer: il loop scrive il batch corrente, web/MQTT
+// leggono l'ultimo batch completo tramite seqlock.
+// Non dipende da Arduino: compilabile anche su host.
+// ============================================================
+#ifndef ENERGY_BATCH_H
+#define ENERGY_BATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "config.h"
+#include "radar_types.h"
+
+#define ENERGY_BATCH_MAGIC0      'A'
+#define ENERGY_BATCH_MAGIC1      'E'
+#define ENERGY_BATCH_VERSION     1
+#define ENERGY_BATCH_HEADER_LEN  12
+#define ENERGY_BATCH_FRAME_LEN   (4 + 2 * LD2420_GATE_COUNT)
+#define ENERGY_BATCH_MAX_LEN     (ENERGY_BATCH_HEADER_LEN + ENERGY_BATCH_FRAMES * ENERGY_BATCH_FRAME_LEN)
+
+class EnergyBatcher {
+public:
+    EnergyBatcher();
+
+    // Aggiunge un frame (solo dal loop); true se ha completato un batch
+    bool add(const RadarGateEnergy& e);
+
+    // Scarta il batch parziale in corso
+    void clear();
+
+    // Copia l'ultimo batch completo in dst (da qualsiasi task).
+    // Restituisce la lunghezza, 0 se nessun batch o cap insufficiente.
+    size_t copyLast(uint8_t* dst, size_t cap, uint16_t* seq = nullptr);
+
+    // Sequenza dell'ultimo batch completo (0 = nessuno)
+    uint16_t lastSeq() const { return _lastSeq.load(std::memory_order_acquire); }
+
+private:
+    uint8_t   _buf[2][ENERGY_BATCH_MAX_LEN];
+    size_t    _len[2];
+    uint8_t   _active;          // buffer in scrittura
+    uint8_t   _ready;           // ultimo buffer completo
+    uint8_t   _frames;          // frame nel batch corrente
+    uint16_t  _seq;
+    uint32_t  _baseMs;
+
+    std::atomic<uint32_t> _gen;      // seqlock (dispari = swap in corso)
+    std::atomic<uint16_t> _lastSeq;
+
+    void _finalize();
+};
+
+#endif // ENERGY_BATCH_H
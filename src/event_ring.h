@@ -0,0 +1,102 @@
+// ============================================================
+// AutoGuard - Ring eventi multi-consumatore
+// ============================================================
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Posizione di lettura di un consumatore (MQTT, web, log...).
+// Ogni consumatore possiede il proprio cursore: nessuno consuma
+// gli eventi degli altri.
+struct EventCursor {
+    uint32_t next      = 1;     // prossima sequenza da leggere
+    uint32_t overflows = 0;     // eventi persi perché sovrascritti
+};
+
+// Coda a capacità fissa per UN produttore e più lettori.
+// Ogni evento riceve una sequenza monotona (da 1); il produttore
+// non aspetta mai: un lettore troppo lento salta gli eventi
+// sovrascritti e li conta nel proprio cursore.
+// Ogni slot è protetto da un seqlock: i lettori possono girare
+// in qualsiasi task. N deve essere una potenza di 2.
+template <typename T, uint32_t N>
+class EventRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "EventRing: N deve essere potenza di 2");
+
+public:
+    EventRing() : _head(0) {
+        for (uint32_t i = 0; i < N; i++) _slots[i].seq.store(0, std::memory_order_relaxed);
+    }
+
+    // Sequenza che riceverà il prossimo push()
+    uint32_t nextSeq() const { return _head.load(std::memory_order_relaxed) + 1; }
+
+    // Ultima sequenza pubblicata (0 = nessuna)
+    uint32_t lastSeq() const { return _head.load(std::memory_order_acquire); }
+
+    // Produttore - restituisce la sequenza assegnata
+    uint32_t push(const T& item) {
+        uint32_t seq  = _head.load(std::memory_order_relaxed) + 1;
+        Slot&    slot = _slots[seq & (N - 1)];
+
+        slot.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.item = item;
+        slot.seq.store(seq, std::memory_order_release);
+        _head.store(seq, std::memory_order_release);
+        return seq;
+    }
+
+    // Lettore - false se il cursore è in pari
+    bool read(EventCursor& c, T& out) const {
+        while (true) {
+            uint32_t head = _head.load(std::memory_order_acquire);
+            if (c.next > head) return false;
+
+            // Sovrascritti: si riparte dal più vecchio disponibile
+            if (head - c.next >= N) {
+                c.overflows += head - c.next - N + 1;
+                c.next       = head - N + 1;
+            }
+
+            const Slot& slot = _slots[c.next & (N - 1)];
+            uint32_t s1 = slot.seq.load(std::memory_order_acquire);
+            T        tmp = slot.item;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t s2 = slot.seq.load(std::memory_order_relaxed);
+
+            if (s1 == c.next && s2 == s1) {
+                out = tmp;
+                c.next++;
+                return true;
+            }
+
+            // Slot riscritto durante la copia: l'evento è perso.
+            // Mai attendere il produttore (può avere priorità minore)
+            c.overflows++;
+            c.next++;
+        }
+    }
+
+    // Cursore che vedrà solo gli eventi successivi
+    EventCursor tail() const {
+        EventCursor c;
+        c.next = lastSeq() + 1;
+        return c;
+    }
+
+    static constexpr uint32_t capacity() { return N; }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq;      // 0 = in scrittura
+        T                     item;
+    };
+
+    Slot                  _slots[N];
+    std::atomic<uint32_t> _head;        // ultima sequenza pubblicata
+};
+
+#endif // EVENT_RING_H
@@ -0,0 +1,208 @@
+// ============================================================
+// AutoGuard - Hardware Abstraction Layer
+// ============================================================
+// Strato sottile tra la logica (allarme, sensore, config) e la
+// piattaforma: orologio, log, UART, key-value store, flash,
+// GPIO, task.
+//   - hal_esp32.cpp  : backend Arduino/ESP-IDF (ARDUINO definito)
+//   - hal_native.cpp : backend Linux per [env:native]
+// ============================================================
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef ARDUINO
+  #include <Arduino.h>
+  #include <Preferences.h>
+  class AsyncClient;
+#endif
+
+// ------------------------------------------------------------
+// Orologio
+// ------------------------------------------------------------
+uint32_t halMillis();
+uint64_t halMicros();
+void     halDelay(uint32_t ms);
+
+// Contatore cicli CPU (wrap a 32 bit) per misure a basso costo
+uint32_t halCycleCount();
+uint32_t halCyclesPerUs();
+
+// ------------------------------------------------------------
+// Log (console seriale su ESP32, stdout su host)
+// ------------------------------------------------------------
+class HalLog {
+public:
+    void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    void println(const char* s = "");
+    void print(const char* s);
+};
+
+extern HalLog halLog;
+
+// ------------------------------------------------------------
+// GPIO / PWM
+// ------------------------------------------------------------
+void halPinOutput(uint8_t pin);
+void halGpioWrite(uint8_t pin, bool high);
+void halPwmStart(uint8_t pin, uint32_t freq, uint8_t duty);
+void halPwmStop(uint8_t pin);
+
+// ------------------------------------------------------------
+// Task (FreeRTOS su ESP32; su host non disponibili -> polling)
+// ------------------------------------------------------------
+typedef void* HalTaskHandle;
+
+bool halTaskCreate(void (*fn)(void*), const char* name, uint32_t stack,
+                   void* arg, int priority, int core, HalTaskHandle* out);
+void halTaskNotify(HalTaskHandle task);     // sveglia il task
+void halTaskWait(uint32_t timeoutMs);       // attende notifica o timeout
+HalTaskHandle halTaskCurrent();             // task chiamante (nullptr su host)
+
+// ------------------------------------------------------------
+// Risparmio energetico (esp_pm su ESP32, no-op su host)
+// ------------------------------------------------------------
+enum HalPowerMode {
+    HAL_POWER_NONE       = 0,   // CPU sempre alla frequenza massima
+    HAL_POWER_DFS        = 1,   // frequenza dinamica: minima quando inattiva
+    HAL_POWER_LIGHT_SLEEP = 2   // DFS + light sleep automatico quando inattiva
+};
+
+// Frequenza dinamica tra minMhz e maxMhz, light sleep se richiesto
+// e supportato dal core (tickless idle)
+HalPowerMode halPowerInit(uint32_t maxMhz, uint32_t minMhz, bool lightSleep);
+void halPowerHoldCpu(bool hold);        // true = frequenza massima (loop attivo)
+void halPowerAllowSleep(bool allow);    // false = light sleep vietato
+
+// ------------------------------------------------------------
+// UART
+// ------------------------------------------------------------
+class HalUart {
+public:
+    explicit HalUart(uint8_t port);
+
+    // rxBuffer = byte del buffer RX del driver (0 = default)
+    void   begin(uint32_t baud, int8_t rxPin, int8_t txPin, size_t rxBuffer = 0);
+    int    available();
+    size_t read(uint8_t* buf, size_t len);
+    size_t write(const uint8_t* buf, size_t len);
+
+    // Callback su byte ricevuti (contesto del driver UART)
+    void   onReceive(void (*cb)(void*), void* ctx);
+
+    // Attività RX sveglia dal light sleep (i primi byte vanno persi)
+    void   wakeOnRx(bool enable);
+
+private:
+    uint8_t         _port;
+#ifdef ARDUINO
+    HardwareSerial  _serial;
+#endif
+};
+
+// ------------------------------------------------------------
+// WiFi station (non bloccante, eventi dal driver)
+// ------------------------------------------------------------
+enum HalWifiEvent {
+    HAL_WIFI_EVT_CONNECTED,       // associato e IP ottenuto
+    HAL_WIFI_EVT_DISCONNECTED     // link perso o tentativo fallito
+};
+
+// Callback nel contesto del driver WiFi (non nel loop)
+typedef void (*HalWifiEventCb)(HalWifiEvent evt, void* ctx);
+
+void halWifiInit(const char* hostname, HalWifiEventCb cb, void* ctx);
+void halWifiConnect(const char* ssid, const char* pass);   // avvia e ritorna
+void halWifiDisconnect();
+bool halWifiIsConnected();
+int  halWifiRssi();
+
+// ------------------------------------------------------------
+// Client TCP asincrono (AsyncTCP su ESP32)
+// ------------------------------------------------------------
+enum HalTcpEvent {
+    HAL_TCP_EVT_CONNECTED,
+    HAL_TCP_EVT_DISCONNECTED      // chiuso, rifiutato o errore
+};
+
+// Callback nel contesto dello stack TCP (non nel loop)
+typedef void (*HalTcpEventCb)(HalTcpEvent evt, void* ctx);
+typedef void (*HalTcpDataCb)(const uint8_t* data, size_t len, void* ctx);
+
+class HalTcpClient {
+public:
+    HalTcpClient();
+
+    void   onEvent(HalTcpEventCb cb, void* ctx);
+    void   onData(HalTcpDataCb cb, void* ctx);
+
+    bool   connect(const char* host, uint16_t port);   // avvia e ritorna
+    void   close();
+    size_t space();                                    // byte accodabili ora
+    size_t write(const uint8_t* buf, size_t len);      // copia e invia
+
+private:
+    HalTcpEventCb  _evtCb;
+    void*          _evtCtx;
+    HalTcpDataCb   _dataCb;
+    void*          _dataCtx;
+#ifdef ARDUINO
+    AsyncClient*   _client;
+#else
+    friend void halNativeTcpDeliver(const uint8_t* data, size_t len);
+    friend void halNativeTcpTick();
+#endif
+};
+
+// ------------------------------------------------------------
+// Key-value store persistente (NVS su ESP32, RAM su host)
+// ------------------------------------------------------------
+class HalKvStore {
+public:
+    bool   begin(const char* ns, bool readOnly = false);
+    void   end();
+
+    int32_t getInt(const char* key, int32_t def);
+    bool    getBool(const char* key, bool def);
+    size_t  getBytes(const char* key, void* buf, size_t len);
+
+    size_t  putInt(const char* key, int32_t value);
+    size_t  putBool(const char* key, bool value);
+    size_t  putBytes(const char* key, const void* buf, size_t len);
+
+    bool    remove(const char* key);
+
+private:
+#ifdef ARDUINO
+    Preferences _prefs;
+#else
+    char        _ns[16];
+#endif
+};
+
+// ------------------------------------------------------------
+// Partizione flash grezza (esp_partition su ESP32, RAM su host)
+// ------------------------------------------------------------
+// Come la NOR flash: write() porta solo bit da 1 a 0, erase()
+// riporta a 0xFF settori interi (HAL_FLASH_SECTOR)
+#define HAL_FLASH_SECTOR    4096
+
+class HalFlashPartition {
+public:
+    HalFlashPartition();
+
+    bool     begin(const char* label);      // false se la partizione manca
+    uint32_t size() const { return _size; }
+
+    bool     read(uint32_t offset, void* buf, size_t len);
+    bool     write(uint32_t offset, const void* buf, size_t len);
+    bool     erase(uint32_t offset, size_t len);
+
+private:
+    const void* _part;      // esp_partition_t su ESP32, buffer su host
+    uint32_t    _size;
+};
+
+#endif // HAL_H
@@ -0,0 +1,380 @@
+// ============================================================
+// AutoGuard - HAL backend ESP32 (Arduino + FreeRTOS)
+// ============================================================
+#ifdef ARDUINO
+
+#include "hal.h"
+#include "config.h"
+#include <stdarg.h>
+#include <esp_timer.h>
+#include <esp_cpu.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/uart.h>
+#include <soc/soc_caps.h>
+#include <esp_partition.h>
+#include <WiFi.h>
+#include <AsyncTCP.h>
+
+HalLog halLog;
+
+// ============================================================
+// Orologio
+// ============================================================
+uint32_t halMillis() {
+    return millis();
+}
+
+uint64_t halMicros() {
+    return (uint64_t)esp_timer_get_time();
+}
+
+void halDelay(uint32_t ms) {
+    delay(ms);
+}
+
+uint32_t halCycleCount() {
+    return esp_cpu_get_cycle_count();
+}
+
+uint32_t halCyclesPerUs() {
+    return getCpuFrequencyMhz();
+}
+
+// ============================================================
+// Log -> Serial
+// ============================================================
+void HalLog::printf(const char* fmt, ...) {
+    char    buf[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    Serial.print(buf);
+}
+
+void HalLog::println(const char* s) {
+    Serial.println(s);
+}
+
+void HalLog::print(const char* s) {
+    Serial.print(s);
+}
+
+// ============================================================
+// GPIO / PWM
+// ============================================================
+void halPinOutput(uint8_t pin) {
+    pinMode(pin, OUTPUT);
+}
+
+void halGpioWrite(uint8_t pin, bool high) {
+    digitalWrite(pin, high ? HIGH : LOW);
+}
+
+void halPwmStart(uint8_t pin, uint32_t freq, uint8_t duty) {
+    ledcAttach(pin, freq, 8);
+    ledcWrite(pin, duty);
+}
+
+void halPwmStop(uint8_t pin) {
+    ledcDetach(pin);
+}
+
+// ============================================================
+// Task FreeRTOS
+// ============================================================
+bool halTaskCreate(void (*fn)(void*), const char* name, uint32_t stack,
+                   void* arg, int priority, int core, HalTaskHandle* out) {
+    TaskHandle_t handle = nullptr;
+    BaseType_t   ok     = xTaskCreatePinnedToCore(fn, name, stack, arg,
+                                                  priority, &handle, core);
+    if (ok != pdPASS) return false;
+    if (out) *out = handle;
+    return true;
+}
+
+void halTaskNotify(HalTaskHandle task) {
+    if (task) xTaskNotifyGive((TaskHandle_t)task);
+}
+
+void halTaskWait(uint32_t timeoutMs) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs));
+}
+
+HalTaskHandle halTaskCurrent() {
+    return xTaskGetCurrentTaskHandle();
+}
+
+// ============================================================
+// Risparmio energetico -> esp_pm (lock contati: stato tenuto qui)
+// ============================================================
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t s_cpuLock   = nullptr;
+static esp_pm_lock_handle_t s_sleepLock = nullptr;
+static bool                 s_cpuHeld   = false;
+static bool                 s_sleepHeld = false;
+#endif
+
+HalPowerMode halPowerInit(uint32_t maxMhz, uint32_t minMhz, bool lightSleep) {
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t cfg = {};
+    cfg.max_freq_mhz       = (int)maxMhz;
+    cfg.min_freq_mhz       = (int)minMhz;
+    cfg.light_sleep_enable = lightSleep;
+
+    HalPowerMode mode = lightSleep ? HAL_POWER_LIGHT_SLEEP : HAL_POWER_DFS;
+    esp_err_t    err  = esp_pm_configure(&cfg);
+    if (err == ESP_ERR_NOT_SUPPORTED && lightSleep) {
+        // Core senza tickless idle: solo frequenza dinamica
+        cfg.light_sleep_enable = false;
+        mode = HAL_POWER_DFS;
+        err  = esp_pm_configure(&cfg);
+    }
+    if (err != ESP_OK) return HAL_POWER_NONE;
+
+    esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "loop", &s_cpuLock);
+    esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "radar", &s_sleepLock);
+    halPowerHoldCpu(true);
+    halPowerAllowSleep(false);
+    return mode;
+#else
+    (void)maxMhz; (void)minMhz; (void)lightSleep;
+    return HAL_POWER_NONE;
+#endif
+}
+
+void halPowerHoldCpu(bool hold) {
+#if CONFIG_PM_ENABLE
+    if (!s_cpuLock || hold == s_cpuHeld) return;
+    if (hold) esp_pm_lock_acquire(s_cpuLock);
+    else      esp_pm_lock_release(s_cpuLock);
+    s_cpuHeld = hold;
+#else
+    (void)hold;
+#endif
+}
+
+void halPowerAllowSleep(bool allow) {
+#if CONFIG_PM_ENABLE
+    if (!s_sleepLock || s_sleepHeld == !allow) return;
+    if (allow) esp_pm_lock_release(s_sleepLock);
+    else       esp_pm_lock_acquire(s_sleepLock);
+    s_sleepHeld = !allow;
+#else
+    (void)allow;
+#endif
+}
+
+// ============================================================
+// UART -> HardwareSerial
+// ============================================================
+// HardwareSerial gestisce solo le UART HP: sull'ESP32-C6 la
+// LP UART (numero 2) non è raggiungibile con HardwareSerial(2)
+#ifdef SOC_UART_HP_NUM
+#define HAL_UART_HP_NUM  SOC_UART_HP_NUM
+#else
+#define HAL_UART_HP_NUM  SOC_UART_NUM
+#endif
+#if RADAR_UART >= HAL_UART_HP_NUM
+#error "RADAR_UART: UART non gestita da HardwareSerial su questo chip"
+#endif
+#if RADAR_COUNT > 1 && RADAR2_UART >= HAL_UART_HP_NUM
+#error "RADAR2_UART: UART non gestita da HardwareSerial su questo chip"
+#endif
+#if RADAR_COUNT > 2 && RADAR3_UART >= HAL_UART_HP_NUM
+#error "RADAR3_UART: UART non gestita da HardwareSerial su questo chip (ESP32-C6: solo 0 e 1, RADAR_COUNT max 2)"
+#endif
+
+HalUart::HalUart(uint8_t port) :
+    _port(port),
+    _serial(port)
+{}
+
+void HalUart::begin(uint32_t baud, int8_t rxPin, int8_t txPin, size_t rxBuffer) {
+    if (rxBuffer) _serial.setRxBufferSize(rxBuffer);
+    _serial.begin(baud, SERIAL_8N1, rxPin, txPin);
+}
+
+int HalUart::available() {
+    return _serial.available();
+}
+
+size_t HalUart::read(uint8_t* buf, size_t len) {
+    return _serial.read(buf, len);
+}
+
+size_t HalUart::write(const uint8_t* buf, size_t len) {
+    return _serial.write(buf, len);
+}
+
+void HalUart::onReceive(void (*cb)(void*), void* ctx) {
+    _serial.onReceive([cb, ctx]() { cb(ctx); });
+}
+
+void HalUart::wakeOnRx(bool enable) {
+    if (enable) {
+        uart_set_wakeup_threshold((uart_port_t)_port, 3);   // fronti RX minimi
+        esp_sleep_enable_uart_wakeup(_port);
+    } else {
+        esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_UART);
+    }
+}
+
+// ============================================================
+// WiFi -> WiFiClass + eventi Arduino
+// ============================================================
+void halWifiInit(const char* hostname, HalWifiEventCb cb, void* ctx) {
+    WiFi.mode(WIFI_STA);
+    WiFi.setHostname(hostname);
+    WiFi.setAutoReconnect(false);     // riconnessione gestita da WifiLink
+    WiFi.onEvent([cb, ctx](arduino_event_id_t event, arduino_event_info_t info) {
+        (void)info;
+        if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+            cb(HAL_WIFI_EVT_CONNECTED, ctx);
+        } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+            cb(HAL_WIFI_EVT_DISCONNECTED, ctx);
+        }
+    });
+}
+
+void halWifiConnect(const char* ssid, const char* pass) {
+    WiFi.begin(ssid, pass);
+}
+
+void halWifiDisconnect() {
+    WiFi.disconnect(false, false);
+}
+
+bool halWifiIsConnected() {
+    return WiFi.status() == WL_CONNECTED;
+}
+
+int halWifiRssi() {
+    return WiFi.RSSI();
+}
+
+// ============================================================
+// Client TCP -> AsyncClient (callback nel task async_tcp)
+// ============================================================
+HalTcpClient::HalTcpClient() :
+    _evtCb(nullptr),
+    _evtCtx(nullptr),
+    _dataCb(nullptr),
+    _dataCtx(nullptr),
+    _client(new AsyncClient())
+{
+    _client->onConnect([](void* arg, AsyncClient*) {
+        HalTcpClient* self = static_cast<HalTcpClient*>(arg);
+        if (self->_evtCb) self->_evtCb(HAL_TCP_EVT_CONNECTED, self->_evtCtx);
+    }, this);
+    _client->onDisconnect([](void* arg, AsyncClient*) {
+        HalTcpClient* self = static_cast<HalTcpClient*>(arg);
+        if (self->_evtCb) self->_evtCb(HAL_TCP_EVT_DISCONNECTED, self->_evtCtx);
+    }, this);
+    _client->onError([](void* arg, AsyncClient*, int8_t) {
+        HalTcpClient* self = static_cast<HalTcpClient*>(arg);
+        if (self->_evtCb) self->_evtCb(HAL_TCP_EVT_DISCONNECTED, self->_evtCtx);
+    }, this);
+    _client->onData([](void* arg, AsyncClient*, void* data, size_t len) {
+        HalTcpClient* self = static_cast<HalTcpClient*>(arg);
+        if (self->_dataCb) self->_dataCb((const uint8_t*)data, len, self->_dataCtx);
+    }, this);
+}
+
+void HalTcpClient::onEvent(HalTcpEventCb cb, void* ctx) {
+    _evtCb  = cb;
+    _evtCtx = ctx;
+}
+
+void HalTcpClient::onData(HalTcpDataCb cb, void* ctx) {
+    _dataCb  = cb;
+    _dataCtx = ctx;
+}
+
+bool HalTcpClient::connect(const char* host, uint16_t port) {
+    return _client->connect(host, port);
+}
+
+void HalTcpClient::close() {
+    _client->close(true);
+}
+
+size_t HalTcpClient::space() {
+    return _client->connected() ? _client->space() : 0;
+}
+
+size_t HalTcpClient::write(const uint8_t* buf, size_t len) {
+    size_t n = _client->add((const char*)buf, len);
+    if (n) _client->send();
+    return n;
+}
+
+// ============================================================
+// Key-value store -> Preferences (NVS)
+// ============================================================
+bool HalKvStore::begin(const char* ns, bool readOnly) {
+    return _prefs.begin(ns, readOnly);
+}
+
+void HalKvStore::end() {
+    _prefs.end();
+}
+
+int32_t HalKvStore::getInt(const char* key, int32_t def) {
+    return _prefs.getInt(key, def);
+}
+
+bool HalKvStore::getBool(const char* key, bool def) {
+    return _prefs.getBool(key, def);
+}
+
+size_t HalKvStore::getBytes(const char* key, void* buf, size_t len) {
+    return _prefs.getBytes(key, buf, len);
+}
+
+size_t HalKvStore::putInt(const char* key, int32_t value) {
+    return _prefs.putInt(key, value);
+}
+
+size_t HalKvStore::putBool(const char* key, bool value) {
+    return _prefs.putBool(key, value);
+}
+
+size_t HalKvStore::putBytes(const char* key, const void* buf, size_t len) {
+    return _prefs.putBytes(key, buf, len);
+}
+
+bool HalKvStore::remove(const char* key) {
+    return _prefs.remove(key);
+}
+
+// ============================================================
+// Partizione flash -> esp_partition
+// ============================================================
+HalFlashPartition::HalFlashPartition() : _part(nullptr), _size(0) {}
+
+bool HalFlashPartition::begin(const char* label) {
+    const esp_partition_t* p = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    _part = p;
+    _size = p ? p->size : 0;
+    return p != nullptr;
+}
+
+bool HalFlashPartition::read(uint32_t offset, void* buf, size_t len) {
+    if (!_part) return false;
+    return esp_partition_read((const esp_partition_t*)_part, offset, buf, len) == ESP_OK;
+}
+
+bool HalFlashPartition::write(uint32_t offset, const void* buf, size_t len) {
+    if (!_part) return false;
+    return esp_partition_write((const esp_partition_t*)_part, offset, buf, len) == ESP_OK;
+}
+
+bool HalFlashPartition::erase(uint32_t offset, size_t len) {
+    if (!_part) return false;
+    return esp_partition_erase_range((const esp_partition_t*)_part, offset, len) == ESP_OK;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,571 @@
+// ============================================================
+// AutoGuard - HAL backend host (Linux)
+// ============================================================
+#ifndef ARDUINO
+
+#include "hal.h"
+#include "hal_native.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define HAL_NATIVE_UARTS    4
+#define HAL_NATIVE_GPIOS    64
+
+HalLog halLog;
+
+static bool     s_virtualClock = false;
+static uint64_t s_virtualUs    = 0;
+static bool     s_logEnabled   = true;
+static bool     s_gpio[HAL_NATIVE_GPIOS];
+
+static const std::chrono::steady_clock::time_point s_start =
+    std::chrono::steady_clock::now();
+
+// ============================================================
+// Orologio (reale o virtuale)
+// ============================================================
+uint64_t halMicros() {
+    if (s_virtualClock) return s_virtualUs;
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - s_start).count();
+}
+
+uint32_t halMillis() {
+    return (uint32_t)(halMicros() / 1000);
+}
+
+void halDelay(uint32_t ms) {
+    if (s_virtualClock) {
+        s_virtualUs += (uint64_t)ms * 1000;
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+}
+
+// Su host un "ciclo" è un nanosecondo di tempo reale: le misure
+// di latenza restano significative anche con l'orologio virtuale
+uint32_t halCycleCount() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - s_start).count();
+}
+
+uint32_t halCyclesPerUs() {
+    return 1000;
+}
+
+void halNativeUseVirtualClock(bool enable) {
+    if (enable && !s_virtualClock) s_virtualUs = halMicros();
+    s_virtualClock = enable;
+}
+
+void halNativeSetMillis(uint32_t ms) {
+    s_virtualUs = (uint64_t)ms * 1000;
+}
+
+void halNativeAdvanceUs(uint64_t us) {
+    s_virtualUs += us;
+}
+
+// ============================================================
+// Log -> stdout
+// ============================================================
+void HalLog::printf(const char* fmt, ...) {
+    if (!s_logEnabled) return;
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stdout, fmt, args);
+    va_end(args);
+}
+
+void HalLog::println(const char* s) {
+    if (!s_logEnabled) return;
+    fputs(s, stdout);
+    fputc('\n', stdout);
+}
+
+void HalLog::print(const char* s) {
+    if (!s_logEnabled) return;
+    fputs(s, stdout);
+}
+
+void halNativeSetLogEnabled(bool enable) {
+    s_logEnabled = enable;
+}
+
+// ============================================================
+// GPIO / PWM (solo stato in memoria)
+// ============================================================
+void halPinOutput(uint8_t pin) {
+    (void)pin;
+}
+
+void halGpioWrite(uint8_t pin, bool high) {
+    if (pin < HAL_NATIVE_GPIOS) s_gpio[pin] = high;
+}
+
+void halPwmStart(uint8_t pin, uint32_t freq, uint8_t duty) {
+    (void)freq;
+    if (pin < HAL_NATIVE_GPIOS) s_gpio[pin] = duty > 0;
+}
+
+void halPwmStop(uint8_t pin) {
+    if (pin < HAL_NATIVE_GPIOS) s_gpio[pin] = false;
+}
+
+bool halNativeGpioState(uint8_t pin) {
+    return pin < HAL_NATIVE_GPIOS ? s_gpio[pin] : false;
+}
+
+// ============================================================
+// Task: non disponibili su host, i moduli ripiegano sul polling
+// ============================================================
+bool halTaskCreate(void (*fn)(void*), const char* name, uint32_t stack,
+                   void* arg, int priority, int core, HalTaskHandle* out) {
+    (void)fn; (void)name; (void)stack; (void)arg; (void)priority; (void)core;
+    if (out) *out = nullptr;
+    return false;
+}
+
+// Un solo "task" su host (il loop): notifica pendente come il
+// contatore di FreeRTOS, più una sveglia programmata dal simulatore
+static bool     s_notifyPending = false;
+static uint64_t s_wakeUs        = 0;
+
+void halTaskNotify(HalTaskHandle task) {
+    (void)task;
+    s_notifyPending = true;
+}
+
+void halTaskWait(uint32_t timeoutMs) {
+    if (s_notifyPending) {
+        s_notifyPending = false;
+        return;
+    }
+    if (s_virtualClock && s_wakeUs) {
+        uint64_t end = s_virtualUs + (uint64_t)timeoutMs * 1000;
+        if (s_wakeUs < end) {
+            s_virtualUs = std::max(s_virtualUs, s_wakeUs);
+            s_wakeUs    = 0;
+            return;
+        }
+    }
+    halDelay(timeoutMs);
+}
+
+void halNativeScheduleWake(uint64_t atUs) {
+    s_wakeUs = atUs;
+}
+
+HalTaskHandle halTaskCurrent() {
+    return nullptr;
+}
+
+// ============================================================
+// Risparmio energetico: nessuno su host
+// ============================================================
+HalPowerMode halPowerInit(uint32_t maxMhz, uint32_t minMhz, bool lightSleep) {
+    (void)maxMhz; (void)minMhz; (void)lightSleep;
+    return HAL_POWER_NONE;
+}
+
+void halPowerHoldCpu(bool hold) {
+    (void)hold;
+}
+
+void halPowerAllowSleep(bool allow) {
+    (void)allow;
+}
+
+// ============================================================
+// UART: code RX in memoria + risponditore opzionale
+// ============================================================
+struct NativeUart {
+    std::deque<uint8_t>    rx;
+    HalNativeUartResponder responder = nullptr;
+    void (*rxCb)(void*)              = nullptr;
+    void*                  rxCtx     = nullptr;
+};
+
+static NativeUart s_uarts[HAL_NATIVE_UARTS];
+
+HalUart::HalUart(uint8_t port) :
+    _port(port < HAL_NATIVE_UARTS ? port : HAL_NATIVE_UARTS - 1)
+{}
+
+void HalUart::begin(uint32_t baud, int8_t rxPin, int8_t txPin, size_t rxBuffer) {
+    (void)baud; (void)rxPin; (void)txPin; (void)rxBuffer;
+    s_uarts[_port].rx.clear();
+}
+
+int HalUart::available() {
+    return (int)s_uarts[_port].rx.size();
+}
+
+size_t HalUart::read(uint8_t* buf, size_t len) {
+    std::deque<uint8_t>& rx = s_uarts[_port].rx;
+    size_t n = len < rx.size() ? len : rx.size();
+    std::copy(rx.begin(), rx.begin() + n, buf);
+    rx.erase(rx.begin(), rx.begin() + n);
+    return n;
+}
+
+size_t HalUart::write(const uint8_t* buf, size_t len) {
+    if (s_uarts[_port].responder) s_uarts[_port].responder(_port, buf, len);
+    return len;
+}
+
+void HalUart::onReceive(void (*cb)(void*), void* ctx) {
+    s_uarts[_port].rxCb  = cb;
+    s_uarts[_port].rxCtx = ctx;
+}
+
+void HalUart::wakeOnRx(bool enable) {
+    (void)enable;
+}
+
+void halNativeUartFeed(uint8_t port, const uint8_t* data, size_t len) {
+    if (port >= HAL_NATIVE_UARTS) return;
+    NativeUart& u = s_uarts[port];
+    u.rx.insert(u.rx.end(), data, data + len);
+    if (u.rxCb) u.rxCb(u.rxCtx);
+}
+
+void halNativeUartSetResponder(uint8_t port, HalNativeUartResponder fn) {
+    if (port < HAL_NATIVE_UARTS) s_uarts[port].responder = fn;
+}
+
+// ============================================================
+// WiFi simulato: rete disponibile/assente, connessione con
+// ritardo in tempo virtuale. Eventi consegnati da halNativeWifiTick()
+// ============================================================
+static HalWifiEventCb s_wifiCb        = nullptr;
+static void*          s_wifiCtx       = nullptr;
+static bool           s_wifiAvailable = true;
+static bool           s_wifiConnected = false;
+static bool           s_wifiPending   = false;
+static uint32_t       s_wifiStartMs   = 0;
+static uint32_t       s_wifiDelayMs   = 2000;
+static uint32_t       s_wifiAttempts  = 0;
+
+#define HAL_NATIVE_WIFI_FAIL_MS   5000    // tempo prima di "rete non trovata"
+
+void halWifiInit(const char* hostname, HalWifiEventCb cb, void* ctx) {
+    (void)hostname;
+    s_wifiCb  = cb;
+    s_wifiCtx = ctx;
+}
+
+void halWifiConnect(const char* ssid, const char* pass) {
+    (void)ssid; (void)pass;
+    s_wifiPending = true;
+    s_wifiStartMs = halMillis();
+    s_wifiAttempts++;
+}
+
+void halWifiDisconnect() {
+    s_wifiPending   = false;
+    s_wifiConnected = false;
+}
+
+bool halWifiIsConnected() {
+    return s_wifiConnected;
+}
+
+int halWifiRssi() {
+    return s_wifiConnected ? -60 : 0;
+}
+
+void halNativeWifiSetAvailable(bool available) {
+    s_wifiAvailable = available;
+}
+
+void halNativeWifiSetConnectDelay(uint32_t ms) {
+    s_wifiDelayMs = ms;
+}
+
+uint32_t halNativeWifiAttempts() {
+    return s_wifiAttempts;
+}
+
+void halNativeWifiTick() {
+    if (s_wifiConnected && !s_wifiAvailable) {
+        s_wifiConnected = false;
+        if (s_wifiCb) s_wifiCb(HAL_WIFI_EVT_DISCONNECTED, s_wifiCtx);
+        return;
+    }
+    if (!s_wifiPending) return;
+
+    uint32_t elapsed = halMillis() - s_wifiStartMs;
+    if (s_wifiAvailable && elapsed >= s_wifiDelayMs) {
+        s_wifiPending   = false;
+        s_wifiConnected = true;
+        if (s_wifiCb) s_wifiCb(HAL_WIFI_EVT_CONNECTED, s_wifiCtx);
+    } else if (!s_wifiAvailable && elapsed >= HAL_NATIVE_WIFI_FAIL_MS) {
+        s_wifiPending = false;
+        if (s_wifiCb) s_wifiCb(HAL_WIFI_EVT_DISCONNECTED, s_wifiCtx);
+    }
+}
+
+// ============================================================
+// TCP simulato: un solo client collegato a un server in-process
+// (es. broker MQTT finto). Eventi consegnati da halNativeTcpTick()
+// ============================================================
+static HalTcpClient*      s_tcpClient     = nullptr;
+static HalNativeTcpServer s_tcpServer     = nullptr;
+static bool               s_tcpReachable  = true;
+static bool               s_tcpConnected  = false;
+static bool               s_tcpPending    = false;
+static bool               s_tcpDropped    = false;
+static uint32_t           s_tcpStartMs    = 0;
+static uint32_t           s_tcpDelayMs    = 50;
+static size_t             s_tcpWindow     = 5744;   // 4 x MSS lwIP
+
+HalTcpClient::HalTcpClient() :
+    _evtCb(nullptr),
+    _evtCtx(nullptr),
+    _dataCb(nullptr),
+    _dataCtx(nullptr)
+{}
+
+void HalTcpClient::onEvent(HalTcpEventCb cb, void* ctx) {
+    _evtCb  = cb;
+    _evtCtx = ctx;
+}
+
+void HalTcpClient::onData(HalTcpDataCb cb, void* ctx) {
+    _dataCb  = cb;
+    _dataCtx = ctx;
+}
+
+bool HalTcpClient::connect(const char* host, uint16_t port) {
+    (void)host; (void)port;
+    s_tcpClient    = this;
+    s_tcpPending   = true;
+    s_tcpConnected = false;
+    s_tcpStartMs   = halMillis();
+    return true;
+}
+
+void HalTcpClient::close() {
+    bool was = s_tcpConnected || s_tcpPending;
+    s_tcpConnected = false;
+    s_tcpPending   = false;
+    if (was && _evtCb) _evtCb(HAL_TCP_EVT_DISCONNECTED, _evtCtx);
+}
+
+size_t HalTcpClient::space() {
+    return s_tcpConnected ? s_tcpWindow : 0;
+}
+
+size_t HalTcpClient::write(const uint8_t* buf, size_t len) {
+    if (!s_tcpConnected) return 0;
+    size_t n = len < s_tcpWindow ? len : s_tcpWindow;
+    if (s_tcpServer) s_tcpServer(buf, n);
+    return n;
+}
+
+void halNativeTcpSetServer(HalNativeTcpServer fn) {
+    s_tcpServer = fn;
+}
+
+void halNativeTcpSetReachable(bool reachable) {
+    s_tcpReachable = reachable;
+}
+
+void halNativeTcpSetConnectDelay(uint32_t ms) {
+    s_tcpDelayMs = ms;
+}
+
+void halNativeTcpDrop() {
+    if (s_tcpConnected) s_tcpDropped = true;
+}
+
+void halNativeTcpDeliver(const uint8_t* data, size_t len) {
+    HalTcpClient* c = s_tcpClient;
+    if (s_tcpConnected && c && c->_dataCb) c->_dataCb(data, len, c->_dataCtx);
+}
+
+void halNativeTcpTick() {
+    HalTcpClient* c = s_tcpClient;
+    if (!c) return;
+
+    if (s_tcpDropped) {
+        s_tcpDropped   = false;
+        s_tcpConnected = false;
+        if (c->_evtCb) c->_evtCb(HAL_TCP_EVT_DISCONNECTED, c->_evtCtx);
+        return;
+    }
+    if (s_tcpPending && halMillis() - s_tcpStartMs >= s_tcpDelayMs) {
+        s_tcpPending   = false;
+        s_tcpConnected = s_tcpReachable;
+        if (c->_evtCb) {
+            c->_evtCb(s_tcpReachable ? HAL_TCP_EVT_CONNECTED : HAL_TCP_EVT_DISCONNECTED,
+                      c->_evtCtx);
+        }
+    }
+}
+
+// ============================================================
+// Key-value store in RAM (chiave = namespace/chiave)
+// ============================================================
+static std::map<std::string, std::vector<uint8_t>> s_kv;
+
+static std::string kvKey(const char* ns, const char* key) {
+    return std::string(ns) + "/" + key;
+}
+
+bool HalKvStore::begin(const char* ns, bool readOnly) {
+    (void)readOnly;
+    strncpy(_ns, ns, sizeof(_ns) - 1);
+    _ns[sizeof(_ns) - 1] = '\0';
+    return true;
+}
+
+void HalKvStore::end() {}
+
+size_t HalKvStore::getBytes(const char* key, void* buf, size_t len) {
+    auto it = s_kv.find(kvKey(_ns, key));
+    if (it == s_kv.end() || it->second.size() > len) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t HalKvStore::putBytes(const char* key, const void* buf, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(buf);
+    s_kv[kvKey(_ns, key)].assign(p, p + len);
+    return len;
+}
+
+int32_t HalKvStore::getInt(const char* key, int32_t def) {
+    int32_t v;
+    return getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : def;
+}
+
+bool HalKvStore::getBool(const char* key, bool def) {
+    uint8_t v;
+    return getBytes(key, &v, sizeof(v)) == sizeof(v) ? v != 0 : def;
+}
+
+size_t HalKvStore::putInt(const char* key, int32_t value) {
+    return putBytes(key, &value, sizeof(value));
+}
+
+size_t HalKvStore::putBool(const char* key, bool value) {
+    uint8_t v = value ? 1 : 0;
+    return putBytes(key, &v, sizeof(v));
+}
+
+bool HalKvStore::remove(const char* key) {
+    return s_kv.erase(kvKey(_ns, key)) > 0;
+}
+
+// ============================================================
+// Partizione flash: buffer in RAM con taglio di alimentazione
+// ============================================================
+static std::map<std::string, std::vector<uint8_t>> s_flash;
+static int64_t  s_flashBudget = -1;     // byte prima del taglio (-1 = nessun taglio)
+static bool     s_flashCut    = false;
+static uint64_t s_flashBytes  = 0;
+
+void halNativeFlashCreate(const char* label, uint32_t size) {
+    s_flash[label].assign(size, 0xFF);
+}
+
+uint8_t* halNativeFlashData(const char* label, uint32_t* size) {
+    auto it = s_flash.find(label);
+    if (it == s_flash.end()) return nullptr;
+    if (size) *size = (uint32_t)it->second.size();
+    return it->second.data();
+}
+
+void halNativeFlashCutAfter(int64_t bytes) {
+    s_flashBudget = bytes;
+    s_flashCut    = false;
+}
+
+bool halNativeFlashCut() {
+    return s_flashCut;
+}
+
+uint64_t halNativeFlashBytes() {
+    return s_flashBytes;
+}
+
+// Byte che l'operazione può toccare prima del taglio
+static size_t flashAllow(size_t len) {
+    if (s_flashCut) return 0;
+    if (s_flashBudget >= 0 && (int64_t)len > s_flashBudget) {
+        len        = (size_t)s_flashBudget;
+        s_flashCut = true;
+    }
+    if (s_flashBudget >= 0) s_flashBudget -= len;
+    s_flashBytes += len;
+    return len;
+}
+
+HalFlashPartition::HalFlashPartition() : _part(nullptr), _size(0) {}
+
+bool HalFlashPartition::begin(const char* label) {
+    auto it = s_flash.find(label);
+    _part = it != s_flash.end() ? &it->second : nullptr;
+    _size = _part ? (uint32_t)it->second.size() : 0;
+    return _part != nullptr;
+}
+
+bool HalFlashPartition::read(uint32_t offset, void* buf, size_t len) {
+    if (!_part || offset + len > _size) return false;
+    const std::vector<uint8_t>& f = *static_cast<const std::vector<uint8_t>*>(_part);
+    memcpy(buf, f.data() + offset, len);
+    return true;
+}
+
+bool HalFlashPartition::write(uint32_t offset, const void* buf, size_t len) {
+    if (!_part || offset + len > _size) return false;
+    std::vector<uint8_t>& f = *const_cast<std::vector<uint8_t>*>(
+        static_cast<const std::vector<uint8_t>*>(_part));
+    const uint8_t* p = static_cast<const uint8_t*>(buf);
+    size_t n = flashAllow(len);
+    for (size_t i = 0; i < n; i++) f[offset + i] &= p[i];     // solo 1 -> 0
+    return n == len;
+}
+
+bool HalFlashPartition::erase(uint32_t offset, size_t len) {
+    if (!_part || offset % HAL_FLASH_SECTOR || len % HAL_FLASH_SECTOR ||
+        offset + len > _size) return false;
+    std::vector<uint8_t>& f = *const_cast<std::vector<uint8_t>*>(
+        static_cast<const std::vector<uint8_t>*>(_part));
+    size_t n = flashAllow(len);
+    memset(f.data() + offset, 0xFF, n);
+    return n == len;
+}
+
+// ============================================================
+// Contatore allocazioni (sostituisce operator new globale)
+// ============================================================
+static uint64_t s_allocs = 0;
+
+void* operator new(size_t n) {
+    s_allocs++;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+uint64_t halNativeAllocs() {
+    return s_allocs;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,71 @@
+// ============================================================
+// AutoGuard - HAL backend host: controlli di simulazione
+// ============================================================
+// Solo per [env:native]: tempo virtuale, iniezione byte UART,
+// lettura stato GPIO. Non usare dal codice firmware.
+// ============================================================
+#ifndef HAL_NATIVE_H
+#define HAL_NATIVE_H
+
+#ifndef ARDUINO
+
+#include "hal.h"
+
+// Tempo virtuale: halMillis()/halMicros()/halDelay() avanzano solo
+// su richiesta (simulazioni deterministiche e più veloci del reale)
+void halNativeUseVirtualClock(bool enable);
+void halNativeSetMillis(uint32_t ms);
+void halNativeAdvanceUs(uint64_t us);
+
+// Con il tempo virtuale halTaskWait() ritorna all'istante atUs
+// (µs) se cade entro il timeout: evento esterno simulato (0 = nessuno)
+void halNativeScheduleWake(uint64_t atUs);
+
+// Abilita/disabilita l'uscita del log su stdout
+void halNativeSetLogEnabled(bool enable);
+
+// Inietta byte nella coda RX di una UART
+void halNativeUartFeed(uint8_t port, const uint8_t* data, size_t len);
+
+// Risponditore per i byte scritti su una UART (es. sensore simulato)
+typedef void (*HalNativeUartResponder)(uint8_t port, const uint8_t* data, size_t len);
+void halNativeUartSetResponder(uint8_t port, HalNativeUartResponder fn);
+
+// WiFi simulato: disponibilità rete, ritardo di associazione,
+// tentativi avviati; Tick() consegna gli eventi al callback
+void     halNativeWifiSetAvailable(bool available);
+void     halNativeWifiSetConnectDelay(uint32_t ms);
+uint32_t halNativeWifiAttempts();
+void     halNativeWifiTick();
+
+// TCP simulato (un client): il server riceve i byte scritti dal
+// client e risponde con Deliver(); Drop() chiude il link lato
+// server; Tick() consegna connessione/chiusura al callback
+typedef void (*HalNativeTcpServer)(const uint8_t* data, size_t len);
+void halNativeTcpSetServer(HalNativeTcpServer fn);
+void halNativeTcpSetReachable(bool reachable);
+void halNativeTcpSetConnectDelay(uint32_t ms);
+void halNativeTcpDrop();
+void halNativeTcpDeliver(const uint8_t* data, size_t len);
+void halNativeTcpTick();
+
+// Ultimo livello scritto su un GPIO
+bool halNativeGpioState(uint8_t pin);
+
+// Partizioni flash in RAM (cancellate: 0xFF). CutAfter(n): dopo
+// altri n byte scritti o cancellati l'alimentazione "manca":
+// l'operazione in corso resta a metà, le successive falliscono
+// (-1 = ripristina). Bytes(): byte toccati dall'avvio
+void     halNativeFlashCreate(const char* label, uint32_t size);
+uint8_t* halNativeFlashData(const char* label, uint32_t* size);
+void     halNativeFlashCutAfter(int64_t bytes);
+bool     halNativeFlashCut();
+uint64_t halNativeFlashBytes();
+
+// Allocazioni (operator new) dall'avvio: verifica dei percorsi
+// che non devono allocare
+uint64_t halNativeAllocs();
+
+#endif // ARDUINO
+
+#endif // HAL_NATIVE_H
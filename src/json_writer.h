@@ -0,0 +1,165 @@
+// ============================================================
+// AutoGuard - Serializzazione JSON a flusso
+// ============================================================
+// Scrive il JSON direttamente nella destinazione (coda TX MQTT,
+// risposta HTTP, buffer fisso) mentre lo si costruisce: nessun
+// documento intermedio, nessuna String, nessuna allocazione.
+// Senza destinazione conta soltanto i byte: i trasporti che
+// vogliono la lunghezza in testa (MQTT) chiamano due volte la
+// stessa funzione di rendering, la prima per misurare.
+// La funzione di rendering deve quindi produrre gli stessi byte
+// a ogni chiamata: i valori che cambiano vanno letti prima.
+//
+//   JsonWriter j(&sink);
+//   j.beginObject().field("state", name).beginArray("hist");
+//   for (...) j.item(v);
+//   j.endArray().endObject();
+//
+// Annidamento fino a JSON_WRITER_DEPTH livelli. Non dipende da
+// Arduino: compilabile anche su host.
+// ============================================================
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#define JSON_WRITER_DEPTH   8
+
+// Destinazione dei byte serializzati
+class JsonSink {
+public:
+    virtual void write(const char* data, size_t len) = 0;
+};
+
+// Destinazione su buffer fisso (troncamento segnalato)
+class JsonBufferSink : public JsonSink {
+public:
+    JsonBufferSink(char* buf, size_t cap) : _buf(buf), _cap(cap), _len(0), _overflow(false) {}
+
+    void write(const char* data, size_t len) override {
+        if (_len + len >= _cap) { _overflow = true; return; }
+        memcpy(_buf + _len, data, len);
+        _len += len;
+        _buf[_len] = '\0';
+    }
+
+    size_t length() const   { return _overflow ? 0 : _len; }
+    bool   overflow() const { return _overflow; }
+
+private:
+    char*  _buf;
+    size_t _cap;
+    size_t _len;
+    bool   _overflow;
+};
+
+class JsonWriter {
+public:
+    // sink = nullptr: solo conteggio dei byte
+    explicit JsonWriter(JsonSink* sink = nullptr) : _sink(sink), _len(0), _depth(0), _first(1) {}
+
+    // Contenitori: key = nullptr per la radice e dentro un array
+    JsonWriter& beginObject(const char* key = nullptr) { _key(key); _raw("{", 1); return _push(); }
+    JsonWriter& endObject() { _pop(); _raw("}", 1); return *this; }
+    JsonWriter& beginArray(const char* key = nullptr)  { _key(key); _raw("[", 1); return _push(); }
+    JsonWriter& endArray()  { _pop(); _raw("]", 1); return *this; }
+
+    // Campi di un oggetto
+    JsonWriter& field(const char* key, const char* v)        { _key(key); _string(v); return *this; }
+    JsonWriter& field(const char* key, bool v)               { _key(key); _bool(v); return *this; }
+    JsonWriter& field(const char* key, int v)                { _key(key); _int(v); return *this; }
+    JsonWriter& field(const char* key, long v)               { _key(key); _int(v); return *this; }
+    JsonWriter& field(const char* key, long long v)          { _key(key); _int(v); return *this; }
+    JsonWriter& field(const char* key, unsigned v)           { _key(key); _uint(v); return *this; }
+    JsonWriter& field(const char* key, unsigned long v)      { _key(key); _uint(v); return *this; }
+    JsonWriter& field(const char* key, unsigned long long v) { _key(key); _uint(v); return *this; }
+    JsonWriter& field(const char* key, double v, uint8_t decimals = 2) { _key(key); _float(v, decimals); return *this; }
+
+    // Elementi di un array
+    template <typename T>
+    JsonWriter& item(T v) { return field(nullptr, v); }
+    JsonWriter& item(double v, uint8_t decimals) { return field(nullptr, v, decimals); }
+
+    // Byte scritti (o contati) finora
+    size_t length() const { return _len; }
+
+private:
+    JsonSink* _sink;
+    size_t    _len;
+    uint8_t   _depth;
+    uint32_t  _first;           // bit d = livello d senza elementi
+
+    void _raw(const char* s, size_t n) {
+        if (_sink) _sink->write(s, n);
+        _len += n;
+    }
+
+    JsonWriter& _push() {
+        if (_depth + 1 < JSON_WRITER_DEPTH) _depth++;
+        _first |= 1u << _depth;
+        return *this;
+    }
+
+    void _pop() { if (_depth) _depth--; }
+
+    // Virgola se non è il primo elemento, poi la chiave
+    void _key(const char* key) {
+        if (!(_first & (1u << _depth))) _raw(",", 1);
+        _first &= ~(1u << _depth);
+        if (key) { _string(key); _raw(":", 1); }
+    }
+
+    void _string(const char* s) {
+        if (!s) { _raw("null", 4); return; }
+        _raw("\"", 1);
+        const char* run = s;
+        for (; *s; s++) {
+            uint8_t c = (uint8_t)*s;
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            _raw(run, s - run);
+            char esc[7];
+            if (c == '"' || c == '\\') { esc[0] = '\\'; esc[1] = c; _raw(esc, 2); }
+            else if (c == '\n') _raw("\\n", 2);
+            else if (c == '\r') _raw("\\r", 2);
+            else if (c == '\t') _raw("\\t", 2);
+            else { snprintf(esc, sizeof(esc), "\\u%04x", c); _raw(esc, 6); }
+            run = s + 1;
+        }
+        _raw(run, s - run);
+        _raw("\"", 1);
+    }
+
+    void _bool(bool v) { if (v) _raw("true", 4); else _raw("false", 5); }
+
+    void _int(long long v) {
+        char b[24];
+        _raw(b, snprintf(b, sizeof(b), "%lld", v));
+    }
+
+    void _uint(unsigned long long v) {
+        char b[24];
+        _raw(b, snprintf(b, sizeof(b), "%llu", v));
+    }
+
+    // Virgola fissa: niente printf("%f") (la conversione di newlib
+    // alloca i propri buffer)
+    void _float(double v, uint8_t decimals) {
+        if (isnan(v) || isinf(v) || fabs(v) > 1e12) { _raw("null", 4); return; }
+        if (decimals > 6) decimals = 6;
+        uint32_t scale = 1;
+        for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+        long long q = llround(v * scale);
+        if (q < 0) { _raw("-", 1); q = -q; }
+        _uint((unsigned long long)q / scale);
+        if (!decimals) return;
+        char b[8];
+        b[0] = '.';
+        _raw(b, snprintf(b + 1, sizeof(b) - 1, "%0*lu", decimals, (unsigned long)(q % scale)) + 1);
+    }
+};
+
+#endif // JSON_WRITER_H
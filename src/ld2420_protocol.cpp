@@ -0,0 +1,322 @@
+// ============================================================
+// AutoGuard - Protocollo UART HLK-LD2420 - Implementazione
+// ============================================================
+#include "ld2420_protocol.h"
+#include <string.h>
+
+// Tipi di frame binario
+#define KIND_ENGINEERING   0
+#define KIND_ACK           1
+
+// Header/footer per tipo di frame binario
+static const uint8_t HEADERS[2][4] = {
+    {0xF4, 0xF3, 0xF2, 0xF1},   // engineering
+    {0xFD, 0xFC, 0xFB, 0xFA}    // ACK comandi
+};
+static const uint8_t FOOTERS[2][4] = {
+    {0xF8, 0xF7, 0xF6, 0xF5},
+    {0x04, 0x03, 0x02, 0x01}
+};
+
+// Lunghezza payload engineering: presenza + distanza + energie
+#define ENG_PAYLOAD_LEN    (1 + 2 + 2 * LD2420_GATE_COUNT)
+#define ACK_PAYLOAD_MIN    4
+#define ACK_PAYLOAD_MAX    64
+#define TEXT_MAX_DIGITS    5
+
+static_assert(4 + 2 + ACK_PAYLOAD_MAX + 4 <= LD2420_FRAME_MAX_LEN &&
+              ENG_PAYLOAD_LEN <= ACK_PAYLOAD_MAX, "LD2420_FRAME_MAX_LEN");
+
+static const char KW_ON[]    = "ON";
+static const char KW_OFF[]   = "OFF";
+static const char KW_RANGE[] = "Range ";
+
+// ============================================================
+// Costruttore
+// ============================================================
+LD2420Parser::LD2420Parser() {
+    memset(&_stats, 0, sizeof(_stats));
+    reset();
+}
+
+void LD2420Parser::reset() {
+    _state    = S_IDLE;
+    _kind     = 0;
+    _matchIdx = 0;
+    _keyword  = nullptr;
+    _len      = 0;
+    _pos      = 0;
+    _word     = 0;
+    _number   = 0;
+    _histLen   = 0;
+    _replayPos = 0;
+    _replayLen = 0;
+}
+
+// ============================================================
+// feed() - Consuma byte fino al primo frame completo
+// ============================================================
+size_t LD2420Parser::feed(const uint8_t* buf, size_t len, LD2420Frame& out) {
+    out.type = LD2420_FRAME_NONE;
+    if (_drain(out)) return 0;
+
+    for (size_t i = 0; i < len; i++) {
+        if (_step(buf[i], out) || _drain(out)) {
+            _stats.bytesIn += i + 1;
+            return i + 1;
+        }
+    }
+    _stats.bytesIn += len;
+    return len;
+}
+
+// ============================================================
+// _drain() - Riesamina i byte di un frame scartato
+// ============================================================
+bool LD2420Parser::_drain(LD2420Frame& out) {
+    while (_replayPos < _replayLen) {
+        if (_step(_replay[_replayPos++], out)) return true;
+    }
+    return false;
+}
+
+// ============================================================
+// _step() - Macchina a stati, true se frame completato
+// ============================================================
+bool LD2420Parser::_step(uint8_t b, LD2420Frame& out) {
+    if (_state >= S_BIN_HEADER && _state <= S_BIN_FOOTER) _hist[_histLen++] = b;
+
+    switch (_state) {
+        case S_IDLE:
+            _resync(b);
+            return false;
+
+        case S_BIN_HEADER:
+            if (b == HEADERS[_kind][_matchIdx]) {
+                if (++_matchIdx == 4) {
+                    _state = S_BIN_LEN;
+                    _pos   = 0;
+                }
+            } else {
+                // Header parziale scartato, riprova dal byte corrente
+                _stats.resyncBytes += _matchIdx;
+                _state = S_IDLE;
+                _resync(b);
+            }
+            return false;
+
+        case S_BIN_LEN:
+            if (_pos == 0) {
+                _len = b;
+                _pos = 1;
+                return false;
+            }
+            _len |= (uint16_t)b << 8;
+            if ((_kind == KIND_ENGINEERING && _len != ENG_PAYLOAD_LEN) ||
+                (_kind == KIND_ACK && (_len < ACK_PAYLOAD_MIN || _len > ACK_PAYLOAD_MAX))) {
+                _framingError();
+                return false;
+            }
+            _pos   = 0;
+            _state = S_BIN_BODY;
+            return false;
+
+        case S_BIN_BODY:
+            _bodyByte(b, out);
+            if (++_pos == _len) {
+                _state    = S_BIN_FOOTER;
+                _matchIdx = 0;
+            }
+            return false;
+
+        case S_BIN_FOOTER:
+            if (b != FOOTERS[_kind][_matchIdx]) {
+                _framingError();
+                return false;
+            }
+            if (++_matchIdx < 4) return false;
+
+            _state = S_IDLE;
+            if (_kind == KIND_ENGINEERING) {
+                out.type = LD2420_FRAME_ENGINEERING;
+                _stats.engineeringFrames++;
+            } else {
+                uint16_t dataLen = _len - ACK_PAYLOAD_MIN;
+                out.ackLen = dataLen < LD2420_ACK_MAX_DATA ? dataLen : LD2420_ACK_MAX_DATA;
+                out.type   = LD2420_FRAME_ACK;
+                _stats.ackFrames++;
+            }
+            return true;
+
+        case S_TEXT_KEYWORD:
+            // "O" può proseguire come "ON" o "OFF"
+            if (_keyword == KW_ON && _matchIdx == 1 && b == 'F') {
+                _keyword = KW_OFF;
+            }
+            if (b != (uint8_t)_keyword[_matchIdx]) {
+                _framingError();
+                _resync(b);
+                return false;
+            }
+            if (_keyword[++_matchIdx] == '\0') {
+                _number = 0;
+                _pos    = 0;
+                _state  = (_keyword == KW_RANGE) ? S_TEXT_NUMBER : S_TEXT_EOL;
+            }
+            return false;
+
+        case S_TEXT_NUMBER:
+            if (b >= '0' && b <= '9' && _pos < TEXT_MAX_DIGITS) {
+                _number = _number * 10 + (b - '0');
+                _pos++;
+                return false;
+            }
+            if ((b == '\r' || b == '\n') && _pos > 0) {
+                _state = S_TEXT_EOL;
+                return _step(b, out);
+            }
+            _framingError();
+            _resync(b);
+            return false;
+
+        case S_TEXT_EOL:
+            if (b == '\r') return false;
+            if (b != '\n') {
+                _framingError();
+                _resync(b);
+                return false;
+            }
+            _state = S_IDLE;
+            if (_keyword == KW_ON) {
+                // Presenza: la distanza arriva nella riga "Range"
+                return false;
+            }
+            if (_keyword == KW_OFF) {
+                out.presence    = false;
+                out.distance_cm = 0;
+            } else {
+                out.presence    = true;
+                out.distance_cm = _number > 0xFFFF ? 0xFFFF : (uint16_t)_number;
+            }
+            out.type = LD2420_FRAME_REPORT;
+            _stats.reportFrames++;
+            return true;
+    }
+    return false;
+}
+
+// ============================================================
+// _bodyByte() - Decodifica un byte di payload in out
+// ============================================================
+void LD2420Parser::_bodyByte(uint8_t b, LD2420Frame& out) {
+    if (_kind == KIND_ENGINEERING) {
+        // [0] presenza | [1..2] distanza | [3..] energie u16 LE
+        if (_pos == 0) {
+            out.presence = (b != 0);
+        } else if (_pos == 1) {
+            _word = b;
+        } else if (_pos == 2) {
+            out.distance_cm = _word | ((uint16_t)b << 8);
+        } else {
+            uint16_t off = _pos - 3;
+            if (off & 1) {
+                out.energy[off >> 1] = _word | ((uint16_t)b << 8);
+            } else {
+                _word = b;
+            }
+        }
+        return;
+    }
+
+    // ACK: [0..1] comando | [2..3] stato | [4..] dati
+    switch (_pos) {
+        case 0: _word = b; break;
+        case 1: out.ackCmd = _word | ((uint16_t)b << 8); break;
+        case 2: _word = b; break;
+        case 3: out.ackStatus = _word | ((uint16_t)b << 8); break;
+        default:
+            if (_pos - 4 < LD2420_ACK_MAX_DATA) out.ackData[_pos - 4] = b;
+            break;
+    }
+}
+
+// ============================================================
+// _resync() - Cerca l'inizio di un frame dal byte corrente
+// ============================================================
+void LD2420Parser::_resync(uint8_t b) {
+    _state    = S_IDLE;
+    _matchIdx = 1;
+    _histLen  = 0;
+
+    if (b == HEADERS[KIND_ENGINEERING][0]) {
+        _kind  = KIND_ENGINEERING;
+        _state = S_BIN_HEADER;
+    } else if (b == HEADERS[KIND_ACK][0]) {
+        _kind  = KIND_ACK;
+        _state = S_BIN_HEADER;
+    }
+    if (_state == S_BIN_HEADER) _hist[_histLen++] = b; else if (b == 'O') {
+        _keyword = KW_ON;
+        _state   = S_TEXT_KEYWORD;
+    } else if (b == 'R') {
+        _keyword = KW_RANGE;
+        _state   = S_TEXT_KEYWORD;
+    } else if (b != '\r' && b != '\n') {
+        _stats.resyncBytes++;
+    }
+}
+
+// ============================================================
+// _framingError() - Lunghezza o footer non validi
+// ============================================================
+// Il frame viene scartato ma i suoi byte dopo il primo dell'header
+// (fino al corrente compreso) possono contenere un header vero:
+// si riesaminano tutti. Dopo _drain() i byte da riesaminare sono
+// o tutti nuovi (_hist) o l'ultima parte di _replay.
+void LD2420Parser::_framingError() {
+    _stats.framingErrors++;
+    _state = S_IDLE;
+    if (_histLen > 1) {
+        if (_replayPos < _replayLen) {
+            _replayPos -= _histLen - 1;
+        } else {
+            memcpy(_replay, _hist + 1, _histLen - 1);
+            _replayPos = 0;
+            _replayLen = _histLen - 1;
+        }
+    }
+    _histLen = 0;
+}
+
+// ============================================================
+// ld2420BuildCommand() - Frame comando FD FC FB FA ... 04 03 02 01
+// ============================================================
+size_t ld2420BuildCommand(uint8_t* buf, uint16_t cmd,
+                          const uint8_t* data, uint16_t dataLen) {
+    if (12 + (size_t)dataLen > LD2420_CMD_MAX_LEN) return 0;
+
+    size_t   n   = 0;
+    uint16_t len = 2 + dataLen;
+
+    memcpy(buf, HEADERS[KIND_ACK], 4);        n += 4;
+    buf[n++] = len & 0xFF;
+    buf[n++] = len >> 8;
+    buf[n++] = cmd & 0xFF;
+    buf[n++] = cmd >> 8;
+    if (dataLen) {
+        memcpy(buf + n, data, dataLen);
+        n += dataLen;
+    }
+    memcpy(buf + n, FOOTERS[KIND_ACK], 4);    n += 4;
+    return n;
+}
+
+size_t ld2420BuildWriteReg(uint8_t* buf, uint16_t cmd,
+                           uint16_t reg, uint32_t value) {
+    uint8_t data[6] = {
+        (uint8_t)(reg & 0xFF),   (uint8_t)(reg >> 8),
+        (uint8_t)(value & 0xFF), (uint8_t)(value >> 8),
+        (uint8_t)(value >> 16),  (uint8_t)(value >> 24)
+    };
+    return ld2420BuildCommand(buf, cmd, data, sizeof(data));
+}
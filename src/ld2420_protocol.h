@@ -0,0 +1,139 @@
+// ============================================================
+// AutoGuard - Protocollo UART HLK-LD2420
+// ============================================================
+// Parser incrementale byte-a-byte, senza allocazioni né copie
+// intermedie: i campi vengono decodificati direttamente dal
+// buffer RX nella struttura di uscita mentre arrivano.
+//
+// Frame riconosciuti:
+//   - Report (modalità normale, testo):  "ON\r\n" "OFF\r\n" "Range 123\r\n"
+//   - Engineering (energia per gate):    F4 F3 F2 F1 | len | pres | dist | 16x energia | F8 F7 F6 F5
+//   - ACK comandi:                        FD FC FB FA | len | cmd | status | dati | 04 03 02 01
+//
+// Il protocollo LD2420 non prevede CRC: l'integrità è verificata
+// tramite lunghezza dichiarata e footer (errori di framing).
+// Non dipende da Arduino: compilabile anche su host.
+// ============================================================
+#ifndef LD2420_PROTOCOL_H
+#define LD2420_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LD2420_GATE_COUNT        16
+#define LD2420_GATE_CM           70      // risoluzione di un range gate
+#define LD2420_ACK_MAX_DATA      32      // byte dati ACK conservati
+
+// Comandi (modalità configurazione)
+#define LD2420_CMD_ENABLE_CONF   0x00FF
+#define LD2420_CMD_DISABLE_CONF  0x00FE
+#define LD2420_CMD_WRITE_ABD     0x0007  // parametri rilevamento
+#define LD2420_CMD_WRITE_SYS     0x0012  // parametri di sistema
+#define LD2420_REG_MIN_GATE      0x0000
+#define LD2420_REG_MAX_GATE      0x0001
+#define LD2420_REG_SYS_MODE      0x0000
+#define LD2420_MODE_ENGINEERING  0x0004
+#define LD2420_MODE_NORMAL       0x0064
+#define LD2420_PROTOCOL_VER      0x0002
+
+// Dimensione massima di un frame comando
+#define LD2420_CMD_MAX_LEN       24
+
+// Frame binario più lungo accettato: header + lunghezza + payload
+// ACK massimo + footer
+#define LD2420_FRAME_MAX_LEN     (4 + 2 + 64 + 4)
+
+enum LD2420FrameType {
+    LD2420_FRAME_NONE        = 0,   // nessun frame completo
+    LD2420_FRAME_REPORT      = 1,   // report testo (presenza + distanza)
+    LD2420_FRAME_ENGINEERING = 2,   // presenza + distanza + energie per gate
+    LD2420_FRAME_ACK         = 3    // risposta a un comando
+};
+
+// Frame decodificato
+struct LD2420Frame {
+    LD2420FrameType type;
+    bool      presence;
+    uint16_t  distance_cm;
+    uint16_t  energy[LD2420_GATE_COUNT];   // solo ENGINEERING
+    uint16_t  ackCmd;                      // solo ACK (cmd | 0x0100)
+    uint16_t  ackStatus;                   // solo ACK (0 = OK)
+    uint8_t   ackData[LD2420_ACK_MAX_DATA];
+    uint8_t   ackLen;
+};
+
+// Statistiche parser
+struct LD2420ParserStats {
+    uint32_t reportFrames;
+    uint32_t engineeringFrames;
+    uint32_t ackFrames;
+    uint32_t framingErrors;   // lunghezza o footer non validi
+    uint32_t resyncBytes;     // byte scartati cercando un header
+    uint32_t bytesIn;
+};
+
+class LD2420Parser {
+public:
+    LD2420Parser();
+
+    // Consuma byte da buf finché non completa un frame.
+    // Restituisce i byte consumati; out.type != NONE se un frame
+    // è stato completato (in tal caso possono restare byte da
+    // passare alla chiamata successiva). Dopo un frame binario
+    // scartato i suoi byte successivi all'header vengono
+    // riesaminati: un frame emesso da questi restituisce 0 byte
+    // consumati, il resto riparte alla chiamata successiva.
+    size_t feed(const uint8_t* buf, size_t len, LD2420Frame& out);
+
+    // Riporta il parser allo stato iniziale (mantiene statistiche)
+    void reset();
+
+    const LD2420ParserStats& stats() const { return _stats; }
+
+private:
+    enum State : uint8_t {
+        S_IDLE,
+        S_BIN_HEADER,     // match header binario
+        S_BIN_LEN,        // 2 byte lunghezza LE
+        S_BIN_BODY,       // payload
+        S_BIN_FOOTER,     // match footer
+        S_TEXT_KEYWORD,   // match "ON" / "OFF" / "Range "
+        S_TEXT_NUMBER,    // cifre distanza
+        S_TEXT_EOL        // attende '\n'
+    };
+
+    State     _state;
+    uint8_t   _kind;          // tipo frame binario in corso
+    uint8_t   _matchIdx;      // indice nel pattern header/footer/keyword
+    const char* _keyword;     // keyword testo in corso
+    uint16_t  _len;           // lunghezza payload dichiarata
+    uint16_t  _pos;           // offset nel payload
+    uint16_t  _word;          // accumulatore 16 bit LE
+    uint32_t  _number;        // accumulatore distanza testo
+    LD2420ParserStats _stats;
+
+    // Byte del frame binario in corso (dall'header) e byte da
+    // riesaminare dopo un errore di framing
+    uint8_t   _hist[LD2420_FRAME_MAX_LEN];
+    uint8_t   _histLen;
+    uint8_t   _replay[LD2420_FRAME_MAX_LEN];
+    uint8_t   _replayPos;
+    uint8_t   _replayLen;
+
+    bool _step(uint8_t b, LD2420Frame& out);
+    void _bodyByte(uint8_t b, LD2420Frame& out);
+    bool _drain(LD2420Frame& out);
+    void _resync(uint8_t b);
+    void _framingError();
+};
+
+// Costruisce un frame comando in buf (>= LD2420_CMD_MAX_LEN).
+// Restituisce la lunghezza totale del frame.
+size_t ld2420BuildCommand(uint8_t* buf, uint16_t cmd,
+                          const uint8_t* data, uint16_t dataLen);
+
+// Helper per comandi con (registro u16, valore u32)
+size_t ld2420BuildWriteReg(uint8_t* buf, uint16_t cmd,
+                           uint16_t reg, uint32_t value);
+
+#endif // LD2420_PROTOCOL_H
@@ -0,0 +1,172 @@
+// ============================================================
+// AutoGuard - Metriche latenza loop() - Implementazione
+// ============================================================
+#include "loop_metrics.h"
+
+#if LOOP_METRICS
+
+#include <string.h>
+
+#define MARK_CALIBRATION_RUNS   64
+
+LoopMetrics loopMetrics;
+
+static const char* const STAGE_NAMES[STAGE_COUNT] = {
+    "radar", "alarm", "noise", "led", "web", "mqtt", "serial", "idle", "loop"
+};
+
+// ============================================================
+// Costruttore
+// ============================================================
+LoopMetrics::LoopMetrics() :
+    _cyclesPerUs(1),
+    _last(0),
+    _loopStart(0),
+    _idle(0),
+    _started(false),
+    _markCycles(0),
+    _resetRequest(false)
+{
+    _clear();
+}
+
+void LoopMetrics::_clear() {
+    memset(_stats, 0, sizeof(_stats));
+    _windowLoops  = 0;
+    _windowCycles = 0;
+    _loopHz       = 0;
+}
+
+// ============================================================
+// begin() - Frequenza CPU + costo di una marcatura
+// ============================================================
+void LoopMetrics::begin() {
+    _cyclesPerUs = halCyclesPerUs();
+    if (_cyclesPerUs == 0) _cyclesPerUs = 1;
+
+    _last = halCycleCount();
+    uint32_t start = _last;
+    for (int i = 0; i < MARK_CALIBRATION_RUNS; i++) {
+        mark(STAGE_SERIAL);
+    }
+    _markCycles = (halCycleCount() - start) / MARK_CALIBRATION_RUNS;
+
+    _clear();
+    _started = false;
+
+    halLog.printf("[METRICS] CPU %luMHz, costo marcatura %lu cicli\n",
+        (unsigned long)_cyclesPerUs, (unsigned long)_markCycles);
+}
+
+// ============================================================
+// startLoop() - Chiude l'iterazione precedente
+// ============================================================
+void LoopMetrics::startLoop() {
+    uint32_t now = halCycleCount();
+
+    if (_resetRequest.load(std::memory_order_relaxed) &&
+        _resetRequest.exchange(false, std::memory_order_acq_rel)) {
+        _clear();
+        _started = false;
+    }
+
+    if (_started) {
+        uint32_t period = now - _loopStart;
+        _record(STAGE_LOOP, period - _idle);
+
+        // Frequenza loop su finestra di ~1s (in cicli, senza orologio)
+        _windowLoops++;
+        _windowCycles += period;
+        if (_windowCycles >= (uint64_t)_cyclesPerUs * 1000000) {
+            _loopHz = (uint32_t)((uint64_t)_windowLoops * _cyclesPerUs * 1000000 / _windowCycles);
+            _windowLoops  = 0;
+            _windowCycles = 0;
+        }
+    }
+
+    _started   = true;
+    _loopStart = now;
+    _last      = now;
+    _idle      = 0;
+}
+
+// ============================================================
+// _record() - Aggiorna contatori e istogramma
+// ============================================================
+void LoopMetrics::_record(LoopStage stage, uint32_t cycles) {
+    StageStats& st = _stats[stage];
+    uint32_t    us = cycles / _cyclesPerUs;
+
+    st.count++;
+    st.totalCycles += cycles;
+    if (us > st.maxUs) st.maxUs = us;
+
+    uint32_t bucket = us < 2 ? 0 : 31 - __builtin_clz(us);
+    if (bucket >= METRICS_BUCKETS) bucket = METRICS_BUCKETS - 1;
+    st.hist[bucket]++;
+}
+
+// ============================================================
+// Statistiche derivate
+// ============================================================
+uint32_t LoopMetrics::meanUs(LoopStage s) const {
+    const StageStats& st = _stats[s];
+    if (st.count == 0) return 0;
+    return (uint32_t)(st.totalCycles / st.count / _cyclesPerUs);
+}
+
+uint32_t LoopMetrics::overheadPpm() const {
+    const StageStats& loop = _stats[STAGE_LOOP];
+    if (loop.totalCycles == 0) return 0;
+
+    // STAGE_COUNT letture del contatore per iterazione
+    uint64_t cost = (uint64_t)STAGE_COUNT * _markCycles * loop.count;
+    return (uint32_t)(cost * 1000000 / loop.totalCycles);
+}
+
+uint32_t LoopMetrics::percentileUs(LoopStage s, uint8_t pct) const {
+    const StageStats& st = _stats[s];
+    if (st.count == 0) return 0;
+
+    uint32_t target = (uint32_t)(((uint64_t)st.count * pct + 99) / 100);
+    uint32_t seen   = 0;
+    for (int b = 0; b < METRICS_BUCKETS; b++) {
+        seen += st.hist[b];
+        if (seen >= target) {
+            uint32_t upper = (uint32_t)2 << b;
+            return (b == METRICS_BUCKETS - 1 || upper > st.maxUs) ? st.maxUs : upper;
+        }
+    }
+    return st.maxUs;
+}
+
+const char* LoopMetrics::stageName(LoopStage s) {
+    return (s < STAGE_COUNT) ? STAGE_NAMES[s] : "?";
+}
+
+// ============================================================
+// toJson() - Serializzazione senza allocazioni
+// ============================================================
+void LoopMetrics::toJson(JsonWriter& out) const {
+    out.beginObject()
+       .field("loop_hz", _loopHz)
+       .field("loops", loops())
+       .field("overhead_ppm", overheadPpm())
+       .beginObject("stages");
+
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        const StageStats& st = _stats[s];
+        out.beginObject(STAGE_NAMES[s])
+           .field("count", st.count)
+           .field("mean_us", meanUs((LoopStage)s))
+           .field("max_us", st.maxUs)
+           .field("p50_us", percentileUs((LoopStage)s, 50))
+           .field("p99_us", percentileUs((LoopStage)s, 99))
+           .beginArray("hist");
+        for (int b = 0; b < METRICS_BUCKETS; b++) out.item(st.hist[b]);
+        out.endArray().endObject();
+    }
+    out.endObject().endObject();
+}
+
+#endif // LOOP_METRICS
@@ -0,0 +1,123 @@
+// ============================================================
+// AutoGuard - Metriche latenza loop()
+// ============================================================
+// Ogni stadio di loop() viene misurato con il contatore cicli
+// CPU (una lettura per stadio) e accumulato in un istogramma
+// a bucket logaritmici:
+//   bucket 0      : < 2us
+//   bucket i      : [2^i, 2^(i+1)) us
+//   ultimo bucket : >= 2^(METRICS_BUCKETS-1) us
+// più massimo, media e frequenza del loop (finestra ~1s).
+// STAGE_LOOP esclude l'attesa del power manager (STAGE_IDLE): è
+// il tempo di lavoro dell'iterazione; la frequenza la include.
+//
+// Scrittore: solo loop(). I lettori (web, MQTT) leggono i
+// contatori senza lock: valori statistici, una lettura può
+// mescolare due iterazioni consecutive.
+// LOOP_METRICS=0 rimuove completamente la strumentazione.
+// ============================================================
+#ifndef LOOP_METRICS_H
+#define LOOP_METRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "hal.h"
+#include "config.h"
+#include "json_writer.h"
+
+#if LOOP_METRICS
+
+#define METRICS_BUCKETS   16
+
+// Stadi di loop() nell'ordine di esecuzione
+enum LoopStage {
+    STAGE_RADAR = 0,    // radar.update()
+    STAGE_ALARM,        // campioni -> trace + state machine
+    STAGE_NOISE,        // frame energie -> profilo rumore
+    STAGE_LED,
+    STAGE_WEB,
+    STAGE_MQTT,
+    STAGE_SERIAL,
+    STAGE_IDLE,         // attesa del power manager (CPU libera)
+    STAGE_LOOP,         // iterazione completa, attesa esclusa
+    STAGE_COUNT
+};
+
+struct StageStats {
+    uint32_t count;
+    uint32_t maxUs;
+    uint64_t totalCycles;   // somma esatta (media senza arrotondamenti)
+    uint32_t hist[METRICS_BUCKETS];
+};
+
+class LoopMetrics {
+public:
+    LoopMetrics();
+
+    // Misura il costo di una marcatura (stima overhead)
+    void begin();
+
+    // Inizio iterazione: chiude la precedente (STAGE_LOOP)
+    void startLoop();
+
+    // Fine stadio: tempo dall'ultima marcatura
+    inline void mark(LoopStage stage) {
+        uint32_t now = halCycleCount();
+        _record(stage, now - _last);
+        if (stage == STAGE_IDLE) _idle += now - _last;
+        _last = now;
+    }
+
+    // Azzera le statistiche (applicato al prossimo startLoop)
+    void reset() { _resetRequest.store(true, std::memory_order_release); }
+
+    uint32_t loopHz() const { return _loopHz; }
+    uint32_t loops() const { return _stats[STAGE_LOOP].count; }
+    const StageStats& stage(LoopStage s) const { return _stats[s]; }
+
+    // Media in microsecondi
+    uint32_t meanUs(LoopStage s) const;
+
+    // Overhead stimato della strumentazione (parti per milione)
+    uint32_t overheadPpm() const;
+
+    // Percentile (0-100) approssimato al limite superiore del bucket
+    uint32_t percentileUs(LoopStage s, uint8_t pct) const;
+
+    // Serializza in JSON nella destinazione del writer
+    void toJson(JsonWriter& out) const;
+
+    static const char* stageName(LoopStage s);
+
+private:
+    StageStats _stats[STAGE_COUNT];
+    uint32_t   _cyclesPerUs;
+    uint32_t   _last;           // ultima marcatura (cicli)
+    uint32_t   _loopStart;      // inizio iterazione corrente
+    uint32_t   _idle;           // attesa nell'iterazione corrente
+    bool       _started;
+    uint32_t   _markCycles;     // costo di una marcatura
+    uint32_t   _windowLoops;
+    uint64_t   _windowCycles;
+    uint32_t   _loopHz;
+
+    std::atomic<bool> _resetRequest;
+
+    void _record(LoopStage stage, uint32_t cycles);
+    void _clear();
+};
+
+extern LoopMetrics loopMetrics;
+
+#define METRICS_LOOP_START()   loopMetrics.startLoop()
+#define METRICS_MARK(stage)    loopMetrics.mark(stage)
+
+#else
+
+#define METRICS_LOOP_START()
+#define METRICS_MARK(stage)
+
+#endif // LOOP_METRICS
+
+#endif // LOOP_METRICS_H
@@ -4,15 +4,35 @@
 #include <Arduino.h>
 #include "config.h"
 #include "sensor_ld2420.h"
+#include "radar_fusion.h"
 #include "alarm_logic.h"
 #include "web_server.h"
 #include "mqtt_client.h"
 #include "config_manager.h"
+#include "noise_profile.h"
+#include "radar_trace.h"
+#include "radar_batch.h"
+#include "loop_metrics.h"
+#include "power_manager.h"
+#include "state_journal.h"
+#if TRACE_SAVE_ON_ALARM || OUTBOX_PERSIST
+  #include <LittleFS.h>
+#endif
 
 // ============================================================
 // Oggetti semplici (sicuri come globali)
 // ============================================================
-SensorLD2420  radar;
+SensorLD2420  radars[RADAR_COUNT] = {
+    SensorLD2420(0),
+#if RADAR_COUNT > 1
+    SensorLD2420(1),
+#endif
+#if RADAR_COUNT > 2
+    SensorLD2420(2),
+#endif
+};
+SensorLD2420& radar = radars[0];    // principale: energie, profilo rumore
+RadarFusion   radarFusion;          // flusso fuso verso la state machine
 AlarmLogic    alarmSys;
 
 // ============================================================
@@ -61,6 +81,43 @@ void updateLED() {
     }
 }
 
+// ============================================================
+// Trace radar: copia su LittleFS allo scatto dell'allarme
+// ============================================================
+#if TRACE_SAVE_ON_ALARM || OUTBOX_PERSIST
+static bool fsReady = false;
+#endif
+
+#if TRACE_SAVE_ON_ALARM
+void saveAlarmTrace() {
+    if (!fsReady) return;
+
+    uint8_t* buf = (uint8_t*)malloc(TRACE_MAX_LEN);
+    if (!buf) return;
+
+    size_t len = traceRecorder.copy(buf, TRACE_MAX_LEN);
+    File   f   = len ? LittleFS.open(TRACE_FILE_PATH, "w") : File();
+    if (f) {
+        f.write(buf, len);
+        f.close();
+        Serial.printf("[TRACE] Salvata %s (%u byte)\n", TRACE_FILE_PATH, (unsigned)len);
+    }
+    free(buf);
+}
+#endif
+
+// ============================================================
+// Config salvata (web): richieste ai moduli con stato esterno.
+// Gira nel task che salva: la state machine ricarica i parametri
+// al prossimo tick(); filtri radar e trace leggono da soli la
+// nuova versione
+// ============================================================
+static void onConfigSaved(const AutoGuardConfig& cfg, void* ctx) {
+    (void)ctx;
+    radar.setEngineeringMode(cfg.engineeringMode);
+    alarmSys.configChanged();
+}
+
 // ============================================================
 // Comandi seriali (debug)
 // ============================================================
@@ -86,9 +143,40 @@ void handleSerial() {
         case 's':
             Serial.printf("[STATUS] Stato: %s | Radar: %dcm | WiFi: %s | MQTT: %s\n",
                 alarmSys.getStateName(),
-                radar.getData().filtered_dist,
+                radarFusion.getData().filtered_dist,
                 (webServer && webServer->isConnected()) ? webServer->getIP().c_str() : "NO",
                 (mqttClient && mqttClient->isConnected()) ? "OK" : "OFFLINE");
+            for (SensorLD2420& r : radars) {
+                Serial.printf("[STATUS] Coda radar #%u: %lu/%d (max %lu) overrun=%lu\n",
+                    r.id(), r.getQueueDepth(), RADAR_RING_SIZE,
+                    r.getQueueHighWater(), r.getOverruns());
+            }
+#if RADAR_COUNT > 1
+            Serial.printf("[STATUS] Fusione: %lu frame, %lu incompleti\n",
+                (unsigned long)radarFusion.frames(), (unsigned long)radarFusion.partial());
+#endif
+            Serial.printf("[STATUS] Trace: %lu campioni, %lu/%u byte\n",
+                (unsigned long)traceRecorder.samples(),
+                (unsigned long)traceRecorder.bytesUsed(),
+                (unsigned)(TRACE_RAM_BLOCKS * TRACE_BLOCK_SIZE));
+            Serial.printf("[STATUS] Storico: %lu campioni, %lu byte, %u batch in coda, %lu persi\n",
+                (unsigned long)radarBatcher.samples(), (unsigned long)radarBatcher.bytes(),
+                radarBatcher.queued(), (unsigned long)radarBatcher.dropped());
+            Serial.printf("[STATUS] Power: %s, in attesa %u%% (stato corrente)\n",
+                powerMgr.modeName(), powerMgr.sleepPct(alarmSys.getState()));
+            if (mqttClient) {
+                const TelemetryStats& ts = mqttClient->telemetryStats();
+                Serial.printf("[STATUS] Telemetria: %lu inviati (%lu heartbeat), %lu soppressi (%lu banda, %lu accorpati)\n",
+                    (unsigned long)ts.sent, (unsigned long)ts.heartbeats,
+                    (unsigned long)(ts.filtered + ts.coalesced),
+                    (unsigned long)ts.filtered, (unsigned long)ts.coalesced);
+            }
+#if LOOP_METRICS
+            Serial.printf("[STATUS] Loop: %luHz max %luus p99 %luus\n",
+                (unsigned long)loopMetrics.loopHz(),
+                (unsigned long)loopMetrics.stage(STAGE_LOOP).maxUs,
+                (unsigned long)loopMetrics.percentileUs(STAGE_LOOP, 99));
+#endif
             break;
         default: break;
     }
@@ -113,35 +201,56 @@ void setup() {
     // Config Manager (NVS)
     Serial.println("[SETUP] Caricamento configurazione...");
     configMgr.begin();
+    noiseProfile.begin();
+    traceRecorder.syncConfig();
+    configMgr.subscribe(onConfigSaved, nullptr);
+#if TRACE_SAVE_ON_ALARM || OUTBOX_PERSIST
+    // LittleFS: trace allarme e log outbox MQTT
+    fsReady = LittleFS.begin(true);
+    if (!fsReady) Serial.println("[SETUP] WARN: LittleFS non disponibile");
+#endif
     delay(500); // Anti-brownout: stabilizza alimentazione
 
-    // Radar
-    Serial.println("[SETUP] Inizializzazione radar...");
-    if (radar.begin()) {
-        Serial.println("[SETUP] Radar OK");
-    } else {
-        Serial.println("[SETUP] WARN: Radar non risponde");
-    }
+    // State machine: dopo un riavvio riparte dall'ultimo stato
+    // registrato nel journal (partizione flash dedicata)
+    stateJournal.begin();
+    alarmSys.begin();
 
-    // Web Server
-    Serial.println("[SETUP] Avvio Web Server...");
-    webServer = new AutoGuardWeb(alarmSys, radar);
-    if (webServer->begin()) {
-        Serial.printf("[SETUP] Web server: http://%s\n",
-            webServer->getIP().c_str());
-
-        // MQTT (solo se WiFi ok)
-        Serial.println("[SETUP] Avvio MQTT...");
-        mqttClient = new AutoGuardMQTT(alarmSys, radar);
-        if (mqttClient->begin()) {
-            Serial.println("[SETUP] MQTT OK");
+    // Power management: setup() gira nel task del loop, che i task
+    // radar svegliano a ogni campione (registrato prima dei task)
+    for (SensorLD2420& r : radars) powerMgr.attach(r);
+    powerMgr.begin();
+    alarmSys.setConsumer(halTaskCurrent());     // comandi web: sveglia il loop
+
+    // Radar: un task per sensore, tutti nella fusione (i sensori
+    // che non rispondono sono esclusi dai frame)
+    Serial.printf("[SETUP] Inizializzazione radar (%d)...\n", RADAR_COUNT);
+    for (SensorLD2420& r : radars) {
+        if (r.begin()) {
+            Serial.printf("[SETUP] Radar #%u OK\n", r.id());
+            if (!r.startTask()) {
+                Serial.printf("[SETUP] WARN: task radar #%u non avviato, polling nel loop\n", r.id());
+            }
         } else {
-            Serial.println("[SETUP] WARN: MQTT non disponibile");
+            Serial.printf("[SETUP] WARN: Radar #%u non risponde\n", r.id());
         }
-    } else {
-        Serial.println("[SETUP] WARN: WiFi non disponibile");
+        radarFusion.addSource(&r);
     }
 
+    // Web Server
+    Serial.println("[SETUP] Avvio Web Server...");
+    webServer = new AutoGuardWeb(alarmSys, radar, radarFusion);
+    webServer->begin();
+
+    // MQTT: si connette in background appena il WiFi è disponibile
+    Serial.println("[SETUP] Avvio MQTT...");
+    mqttClient = new AutoGuardMQTT(alarmSys, radar, radarFusion);
+    mqttClient->begin();
+
+#if LOOP_METRICS
+    loopMetrics.begin();
+#endif
+
     Serial.println("[SETUP] Completato!");
     Serial.println("Comandi: a=arm  d=disarm  r=reset  s=status");
     Serial.println("============================================");
@@ -151,15 +260,63 @@ void setup() {
 // loop()
 // ============================================================
 void loop() {
-    radar.update();
+    METRICS_LOOP_START();
 
-    RadarData data = radar.getData();
-    alarmSys.update(data);
+    radarFusion.update();   // no-op per i sensori con task attivo
+    METRICS_MARK(STAGE_RADAR);
+
+    // Consuma i campioni accodati dai task radar, fusi per frame
+    RadarData data;
+    while (radarFusion.readSample(data)) {
+        traceRecorder.record(data);
+        alarmSys.onSample(data);
+
+        // Storico completo via MQTT solo da armato (analisi a posteriori)
+        AlarmState st = alarmSys.getState();
+        if (st == STATE_ARMED || st == STATE_ALERT || st == STATE_ALARM) radarBatcher.add(data);
+        else radarBatcher.flush();
+    }
+
+    // Comandi dal web e scadenza dello stato corrente (un confronto
+    // se non c'è nulla da fare)
+    alarmSys.tick();
+
+#if TRACE_SAVE_ON_ALARM
+    // Scatto allarme: conserva i campioni che lo hanno causato
+    static EventCursor traceCursor;
+    AlarmEvent ev;
+    while (alarmSys.readEvent(traceCursor, ev)) {
+        if (ev.state == STATE_ALARM) saveAlarmTrace();
+    }
+#endif
+
+    // Ogni transizione nel journal (cursore proprio)
+    stateJournal.drain(alarmSys);
+    METRICS_MARK(STAGE_ALARM);
+
+    // Frame engineering (energie per gate): apprendimento rumore
+    // solo da ARMED senza alert. readEnergy() alimenta anche i batch
+    RadarGateEnergy energy;
+    bool learnNoise = (alarmSys.getState() == STATE_ARMED);
+    while (radar.readEnergy(energy)) {
+        noiseProfile.observe(energy, learnNoise);
+    }
+    METRICS_MARK(STAGE_NOISE);
 
     updateLED();
+    METRICS_MARK(STAGE_LED);
 
     if (webServer)  webServer->update();
+    METRICS_MARK(STAGE_WEB);
+
     if (mqttClient) mqttClient->update();
+    METRICS_MARK(STAGE_MQTT);
 
     handleSerial();
+    METRICS_MARK(STAGE_SERIAL);
+
+    // Attesa del prossimo campione o della prossima scadenza: CPU
+    // a frequenza minima o in light sleep (da disarmato)
+    powerMgr.idle(alarmSys.getState(), alarmSys.msToDeadline());
+    METRICS_MARK(STAGE_IDLE);
 }
@@ -0,0 +1,1811 @@
+// ============================================================
+// AutoGuard - Entry point host ([env:native])
+// ============================================================
+// Esegue driver LD2420 + state machine su Linux, alimentando la
+// UART1 simulata con un flusso di byte catturato dal sensore.
+//
+// Uso: autoguard [opzioni] [file]
+//   --arm           arma il sistema all'avvio
+//   --quiet         disabilita il log dei moduli
+//   --record out    registra i campioni in una trace (.agt)
+//   --replay        file è una trace (.agt) invece di byte UART
+//   --bench-parser  parser LD2420 su flussi puliti, casuali e corrotti:
+//                   costo per frame e riallineamento (file: cattura
+//                   UART, opzionale)
+//   --bench-filter  filtri distanza a confronto: ritardo sul gradino,
+//                   rumore, spike e costo per campione
+//   --bench-alarm   costo per campione della state machine ed equivalenza
+//                   con gli handler per stato (file: trace .agt, opzionale)
+//   --bench-detector falsi allarmi e intrusioni mancate per rilevatore
+//                   (file: corpus di trace .agt, opzionale)
+//   --bench-tracker velocità, traiettorie ed escalation su scenari sintetici
+//   --bench-fusion  fusione di più radar su trace sintetiche
+//   --bench-zones   cambi di zona sui confini e costo della tabella zone
+//   --bench-telemetry messaggi e ritardo della telemetria radar rispetto
+//                   al timer fisso di 10s
+//   --bench-batch   storico radar in batch binari: andata e ritorno e
+//                   byte per campione contro il JSON (file: trace .agt,
+//                   opzionale)
+// Senza file legge da stdin. Il tempo è virtuale: avanza al
+// ritmo dei byte a RADAR_BAUD, o dei timestamp in replay.
+// L'esecuzione è deterministica.
+//
+// Qui restano solo replay e benchmark (misure, confronti). Le
+// verifiche con esito dei moduli sono i test Unity in test/:
+//   pio test -e native
+// ============================================================
+#if !defined(ARDUINO) && !defined(PIO_UNIT_TESTING)
+
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "hal.h"
+#include "hal_native.h"
+#include "config.h"
+#include "config_manager.h"
+#include "noise_profile.h"
+#include "sensor_ld2420.h"
+#include "ld2420_protocol.h"
+#include "alarm_logic.h"
+#include "alarm_reference.h"
+#include "radar_trace.h"
+#include "radar_tracker.h"
+#include "radar_filter.h"
+#include "radar_fusion.h"
+#include "mqtt_payloads.h"
+#include "zone_map.h"
+#include "telemetry_scheduler.h"
+#include "radar_batch.h"
+
+static SensorLD2420 radar;
+static RadarFusion  radarFusion;
+static AlarmLogic   alarmSys;
+
+// ============================================================
+// LD2420 simulato: risponde OK a ogni comando ricevuto
+// ============================================================
+static void ld2420Responder(uint8_t port, const uint8_t* data, size_t len) {
+    // Il driver scrive un frame comando completo per chiamata:
+    // FD FC FB FA | len | cmd | dati | 04 03 02 01
+    if (len < 12 || data[0] != 0xFD || data[1] != 0xFC) return;
+
+    uint16_t cmd = data[6] | ((uint16_t)data[7] << 8);
+    uint8_t  status[2] = {0, 0};
+    uint8_t  ack[LD2420_CMD_MAX_LEN];
+    size_t   n = ld2420BuildCommand(ack, cmd | 0x0100, status, sizeof(status));
+    halNativeUartFeed(port, ack, n);
+}
+
+// ============================================================
+// Trace: blocchi completati scritti su file
+// ============================================================
+static void traceFileSink(const uint8_t* block, size_t len, void* ctx) {
+    fwrite(block, 1, len, (FILE*)ctx);
+}
+
+// ============================================================
+// runCapture() - Flusso UART -> driver -> state machine
+// ============================================================
+static int runCapture(FILE* in, bool arm, FILE* rec) {
+    halNativeUartSetResponder(RADAR_UART, ld2420Responder);
+
+    noiseProfile.begin();
+    if (!radar.begin()) {
+        fprintf(stderr, "Inizializzazione radar fallita\n");
+        return 1;
+    }
+    radarFusion.addSource(&radar);
+    alarmSys.begin();
+    if (arm) alarmSys.arm();
+
+    if (rec) {
+        uint8_t header[TRACE_HEADER_LEN + TRACE_CONFIG_LEN];
+        traceRecorder.syncConfig();
+        fwrite(header, 1, traceRecorder.writeHeader(header, sizeof(header)), rec);
+        traceRecorder.setBlockSink(traceFileSink, rec);
+    }
+
+    uint8_t  chunk[RADAR_RX_CHUNK];
+    size_t   n;
+    uint32_t samples     = 0;
+    uint32_t transitions = 0;
+    EventCursor events;
+
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+        // Tempo di trasmissione del blocco: 10 bit per byte
+        halNativeAdvanceUs((uint64_t)n * 10 * 1000000 / RADAR_BAUD);
+        halNativeUartFeed(RADAR_UART, chunk, n);
+        radarFusion.update();
+
+        RadarData data;
+        while (radarFusion.readSample(data)) {
+            if (rec) traceRecorder.record(data);
+            alarmSys.onSample(data);
+            samples++;
+        }
+        alarmSys.tick();
+
+        RadarGateEnergy energy;
+        bool learnNoise = (alarmSys.getState() == STATE_ARMED);
+        while (radar.readEnergy(energy)) {
+            noiseProfile.observe(energy, learnNoise);
+        }
+
+        AlarmEvent ev;
+        while (alarmSys.readEvent(events, ev)) transitions++;
+    }
+    if (rec) traceRecorder.flush();
+
+    const LD2420ParserStats& ps = radar.getParserStats();
+    printf("---- AutoGuard native ----\n");
+    printf("Byte:          %u\n", ps.bytesIn);
+    printf("Frame report:  %u\n", ps.reportFrames);
+    printf("Frame eng.:    %u\n", ps.engineeringFrames);
+    printf("Errori frame:  %u\n", ps.framingErrors);
+    printf("Byte resync:   %u\n", ps.resyncBytes);
+    printf("Campioni:      %u (overrun %u)\n", samples, radar.getOverruns());
+    printf("Transizioni:   %u\n", transitions);
+    printf("Stato finale:  %s\n", alarmSys.getStateName());
+    printf("Tempo sim.:    %u ms\n", halMillis());
+    return 0;
+}
+
+// ============================================================
+// runReplay() - Trace registrata -> state machine
+// ============================================================
+// Il tempo virtuale segue i timestamp dei campioni: nessuna
+// attesa reale, risultato identico a ogni esecuzione.
+static int runReplay(FILE* in, bool arm) {
+    std::vector<uint8_t> buf;
+    uint8_t chunk[4096];
+    size_t  n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+        buf.insert(buf.end(), chunk, chunk + n);
+    }
+
+    TraceReplay replay;
+    if (!replay.open(buf.data(), buf.size())) {
+        fprintf(stderr, "Trace non valida\n");
+        return 1;
+    }
+    if (replay.config()) {
+        configMgr.save(*replay.config());
+    } else {
+        fprintf(stderr, "Trace versione 1: config non registrata, uso i default\n");
+    }
+
+    RadarData data;
+    uint32_t  samples     = 0;
+    uint32_t  transitions = 0;
+    EventCursor events;
+    uint32_t  firstTs     = 0;
+    bool      started     = false;
+
+    auto t0 = std::chrono::steady_clock::now();
+    while (replay.readSample(data)) {
+        halNativeSetMillis(data.timestamp);
+        if (!started) {
+            // Stato iniziale allineato al primo campione
+            firstTs = data.timestamp;
+            alarmSys.begin();
+            if (arm) alarmSys.arm();
+            started = true;
+        }
+        alarmSys.onSample(data);
+        samples++;
+
+        AlarmEvent ev;
+        while (alarmSys.readEvent(events, ev)) transitions++;
+    }
+    double wallMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - t0).count();
+    uint32_t traceMs = started ? data.timestamp - firstTs : 0;
+
+    printf("---- AutoGuard replay ----\n");
+    printf("Campioni:      %u\n", samples);
+    printf("Transizioni:   %u\n", transitions);
+    printf("Stato finale:  %s\n", alarmSys.getStateName());
+    printf("Durata trace:  %u ms\n", traceMs);
+    printf("Tempo reale:   %.1f ms (x%.0f)\n", wallMs,
+        wallMs > 0 ? traceMs / wallMs : 0.0);
+    return 0;
+}
+
+// ============================================================
+// runBenchAlarm() - Tabella + scadenze contro handler per stato
+// ============================================================
+// Stessi campioni alla state machine attuale (rilevatore a
+// contatori) e a quella di riferimento (alarm_reference): le
+// transizioni devono coincidere una per una (stato, precedente,
+// zona, distanza, timestamp).
+// Senza file si usa una trace sintetica deterministica: presenze
+// intermittenti in tutte le zone e silenzi del sensore.
+// Esito != 0 alla prima differenza.
+#define BENCH_SAMPLES       (2UL * 3600 * 1000 / RADAR_UPDATE_MS)
+#define BENCH_TICKS         1000000UL
+
+static std::vector<RadarData> benchSynthTrace() {
+    std::vector<RadarData> out;
+    out.reserve(BENCH_SAMPLES);
+
+    uint32_t rng = 0x2420A5A5;
+    auto next = [&rng]() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    };
+
+    uint32_t ts = 1000;
+    while (out.size() < BENCH_SAMPLES) {
+        // Segmento: vuoto, presenza o silenzio del sensore
+        uint32_t kind = next() % 8;
+        uint32_t len  = 10 + next() % 400;
+        int      base = 30 + next() % 380;
+
+        if (kind == 0) {
+            ts += 500 + next() % 4000;      // nessun report
+            continue;
+        }
+        for (uint32_t i = 0; i < len && out.size() < BENCH_SAMPLES; i++) {
+            RadarData d = {};
+            ts += RADAR_UPDATE_MS;
+            d.timestamp = ts;
+            if (kind >= 4 && next() % 10 < 7) {
+                int dist = base + (int)(next() % 41) - 20;
+                if (dist < 0) dist = 0;
+                d.detected      = true;
+                d.distance_cm   = dist;
+                d.filtered_dist = dist;
+                d.zone = dist <= ZONE_CRITICAL_MAX ? ZONE_CRITICAL :
+                         dist <= ZONE_MEDIUM_MAX   ? ZONE_MEDIUM   :
+                         dist <= ZONE_FAR_MAX      ? ZONE_FAR      : ZONE_NONE;
+            }
+            out.push_back(d);
+        }
+    }
+    return out;
+}
+
+static bool benchSameEvent(const AlarmEvent& a, const AlarmEvent& b) {
+    return a.state == b.state && a.prevState == b.prevState && a.zone == b.zone &&
+           a.distance_cm == b.distance_cm && a.timestamp == b.timestamp;
+}
+
+// Campioni di una trace .agt; cfg = snapshot config se compatibile
+static bool benchLoadTrace(FILE* in, std::vector<RadarData>& samples, AutoGuardConfig& cfg) {
+    std::vector<uint8_t> buf;
+    uint8_t chunk[4096];
+    size_t  n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+        buf.insert(buf.end(), chunk, chunk + n);
+    }
+    TraceReplay replay;
+    if (!replay.open(buf.data(), buf.size())) return false;
+    if (replay.config()) cfg = *replay.config();
+    RadarData d;
+    while (replay.readSample(d)) samples.push_back(d);
+    return true;
+}
+
+static int runBenchAlarm(FILE* in) {
+    std::vector<RadarData> samples;
+    AutoGuardConfig cfg = configMgr.get();
+    if (in) {
+        if (!benchLoadTrace(in, samples, cfg)) {
+            fprintf(stderr, "Trace non valida\n");
+            return 1;
+        }
+    } else {
+        samples = benchSynthTrace();
+    }
+    if (samples.empty()) {
+        fprintf(stderr, "Trace vuota\n");
+        return 1;
+    }
+
+    // Il riferimento conosce solo i contatori per zona
+    cfg.detectorMode     = DETECTOR_COUNTER;
+    cfg.approachEscalate = false;
+    configMgr.save(cfg);
+
+    // Riferimento: handler per stato a ogni campione
+    AlarmReference* ref = new AlarmReference();
+    halNativeSetMillis(samples[0].timestamp);
+    ref->begin();
+    ref->arm();
+    auto t0 = std::chrono::steady_clock::now();
+    for (RadarData& d : samples) {
+        halNativeSetMillis(d.timestamp);
+        ref->update(d);
+    }
+    double refNs = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - t0).count();
+    std::vector<AlarmEvent> want = ref->events();
+
+    // Prima: handler rivalutato a ogni giro del loop, anche senza campioni
+    RadarData idle = {};
+    t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_TICKS; i++) ref->update(idle);
+    double refIdleNs = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - t0).count();
+
+    // Tabella: raccolta eventi per il confronto
+    AlarmLogic* sm = new AlarmLogic();
+    std::vector<AlarmEvent> got;
+    EventCursor cursor;
+    AlarmEvent  ev;
+    halNativeSetMillis(samples[0].timestamp);
+    sm->begin();
+    sm->arm();
+    for (const RadarData& d : samples) {
+        halNativeSetMillis(d.timestamp);
+        sm->onSample(d);
+        while (sm->readEvent(cursor, ev)) got.push_back(ev);
+    }
+    while (sm->readEvent(cursor, ev)) got.push_back(ev);
+
+    // Tabella: solo tempo, istanza nuova
+    delete sm;
+    sm = new AlarmLogic();
+    halNativeSetMillis(samples[0].timestamp);
+    sm->begin();
+    sm->arm();
+    t0 = std::chrono::steady_clock::now();
+    for (const RadarData& d : samples) {
+        halNativeSetMillis(d.timestamp);
+        sm->onSample(d);
+    }
+    double smNs = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - t0).count();
+
+    // tick() senza scadenze dovute (tra un campione e l'altro)
+    t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_TICKS; i++) sm->tick();
+    double tickNs = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - t0).count();
+
+    size_t mismatch = SIZE_MAX;
+    size_t common   = want.size() < got.size() ? want.size() : got.size();
+    for (size_t i = 0; i < common; i++) {
+        if (!benchSameEvent(want[i], got[i])) { mismatch = i; break; }
+    }
+    if (mismatch == SIZE_MAX && want.size() != got.size()) mismatch = common;
+
+    uint32_t perState[STATE_COOLDOWN + 1] = {0};
+    for (const AlarmEvent& e : want) perState[e.state]++;
+
+    printf("---- AutoGuard bench alarm ----\n");
+    printf("Campioni:      %u (%s)\n", (unsigned)samples.size(), in ? "trace" : "sintetici");
+    printf("Transizioni:   %u / %u (riferimento / tabella)\n",
+        (unsigned)want.size(), (unsigned)got.size());
+    printf("Ingressi:      ALERT %u, ALARM %u, COOLDOWN %u\n",
+        perState[STATE_ALERT], perState[STATE_ALARM], perState[STATE_COOLDOWN]);
+    printf("Handler:       %.1f ns/campione\n", refNs / samples.size());
+    printf("Tabella:       %.1f ns/campione\n", smNs / samples.size());
+    printf("Giro vuoto:    %.1f ns handler, %.1f ns tick()\n",
+        refIdleNs / BENCH_TICKS, tickNs / BENCH_TICKS);
+
+    int rc = 0;
+    if (mismatch != SIZE_MAX) {
+        printf("DIFFERENZA alla transizione %u\n", (unsigned)mismatch + 1);
+        if (mismatch < want.size()) {
+            const AlarmEvent& e = want[mismatch];
+            printf("  riferimento: %s -> %s zona %d dist %d @%u\n",
+                AlarmLogic::getStateName(e.prevState), AlarmLogic::getStateName(e.state),
+                (int)e.zone, e.distance_cm, e.timestamp);
+        }
+        if (mismatch < got.size()) {
+            const AlarmEvent& e = got[mismatch];
+            printf("  tabella:     %s -> %s zona %d dist %d @%u\n",
+                AlarmLogic::getStateName(e.prevState), AlarmLogic::getStateName(e.state),
+                (int)e.zone, e.distance_cm, e.timestamp);
+        }
+        rc = 1;
+    } else {
+        printf("Equivalenza:   OK\n");
+    }
+
+    delete sm;
+    delete ref;
+    return rc;
+}
+
+// ============================================================
+// runBenchDetector() - Falsi allarmi e intrusioni mancate
+// ============================================================
+// Ogni trace del corpus passa alla state machine armata, una
+// volta per rilevatore (contatori, evidenza), senza e con
+// l'escalation degli avvicinamenti (tracker). Trace di disturbo:
+// ogni ALERT/ALARM è falso. Trace di intrusione: mancata se non
+// arriva ad ALARM; latenza = primo rilevamento -> ALERT.
+// Corpus: trace .agt (intrusione se il nome contiene "intrus"),
+// altrimenti scenari sintetici deterministici:
+//   disturbo:   colpi isolati sparsi, brevi raffiche in zona media
+//   intrusione: avvicinamento, sosta in zona media, zona critica
+// Esito != 0 se l'evidenza con escalation (default) manca
+// intrusioni o dà più falsi alert dei contatori.
+#define BENCH_NOISE_RUNS        4       // ore di disturbo per scenario
+#define BENCH_INTRUSION_RUNS    30      // intrusioni per scenario
+
+struct BenchTrace {
+    std::vector<RadarData> samples;
+    bool     intrusion;
+    uint32_t onsetMs;       // primo campione dell'intrusione
+};
+
+struct BenchScore {
+    uint32_t alerts;        // ingressi in ALERT
+    uint32_t alarms;        // ingressi in ALARM
+    uint32_t firstAlertMs;  // 0 = nessuno
+};
+
+static uint32_t benchRng = 0x51F15EED;
+static uint32_t benchNext() {
+    benchRng ^= benchRng << 13;
+    benchRng ^= benchRng >> 17;
+    benchRng ^= benchRng << 5;
+    return benchRng;
+}
+
+static RadarData benchSample(uint32_t ts, bool detected, int dist) {
+    RadarData d = {};
+    d.timestamp = ts;
+    if (detected) {
+        d.detected      = true;
+        d.distance_cm   = dist;
+        d.filtered_dist = dist;
+        d.zone = dist <= ZONE_CRITICAL_MAX ? ZONE_CRITICAL :
+                 dist <= ZONE_MEDIUM_MAX   ? ZONE_MEDIUM   :
+                 dist <= ZONE_FAR_MAX      ? ZONE_FAR      : ZONE_NONE;
+    }
+    return d;
+}
+
+// Velocità e traiettoria come nel driver
+static void benchTrack(std::vector<RadarData>& samples) {
+    RadarTracker tracker;
+    for (RadarData& d : samples) tracker.apply(d);
+}
+
+// Un'ora di campioni vuoti con colpi isolati o raffiche brevi
+static BenchTrace benchNoise(bool bursts) {
+    BenchTrace t;
+    t.intrusion = false;
+    t.onsetMs   = 0;
+    uint32_t end  = 3600UL * 1000;
+    uint32_t next = 5000;
+    int      left = 0;
+    int      dist = 0;
+    for (uint32_t ts = 1000; ts < end; ts += RADAR_UPDATE_MS) {
+        if (ts >= next) {
+            left = bursts ? 1 + benchNext() % 3 : 1;
+            dist = 110 + benchNext() % 140;
+            next = ts + (bursts ? 8000 + benchNext() % 32000 : 20000 + benchNext() % 100000);
+        }
+        t.samples.push_back(benchSample(ts, left > 0, dist));
+        if (left > 0) left--;
+    }
+    benchTrack(t.samples);
+    return t;
+}
+
+// 10s vuoti, intrusione (85% dei campioni rilevati), 60s vuoti
+static BenchTrace benchIntrusion(int kind) {
+    BenchTrace t;
+    t.intrusion = true;
+    uint32_t ts = 1000;
+    for (; ts < 11000; ts += RADAR_UPDATE_MS) t.samples.push_back(benchSample(ts, false, 0));
+    t.onsetMs = ts;
+
+    int      dist  = kind == 0 ? 390 : kind == 1 ? 150 + benchNext() % 90 : 40 + benchNext() % 50;
+    int      speed = 50 + benchNext() % 50;                 // cm/s (avvicinamento)
+    uint32_t stay  = kind == 0 ? 5000 + benchNext() % 5000 :
+                     kind == 1 ? 8000 + benchNext() % 7000 : 2000 + benchNext() % 2000;
+    uint32_t end   = 0;
+    while (true) {
+        if (kind == 0 && dist > 60) {
+            dist -= speed * RADAR_UPDATE_MS / 1000;
+        } else if (!end) {
+            end = ts + stay;
+        }
+        if (end && ts >= end) break;
+        int jitter = (int)(benchNext() % 11) - 5;
+        t.samples.push_back(benchSample(ts, benchNext() % 100 < 85, dist + jitter));
+        ts += RADAR_UPDATE_MS;
+    }
+    for (uint32_t stop = ts + 60000; ts < stop; ts += RADAR_UPDATE_MS) {
+        t.samples.push_back(benchSample(ts, false, 0));
+    }
+    benchTrack(t.samples);
+    return t;
+}
+
+static BenchScore benchRun(const BenchTrace& t, const AutoGuardConfig& cfg) {
+    BenchScore   sc = {0, 0, 0};
+    AlarmLogic*  sm = new AlarmLogic();
+    EventCursor  cursor;
+    AlarmEvent   ev;
+
+    configMgr.save(cfg);
+    uint32_t t0 = t.samples.front().timestamp;
+    halNativeSetMillis(t0 - cfg.armingDelayMs - 1);
+    sm->begin();
+    sm->arm();
+    halNativeSetMillis(t0 - 1);
+    sm->tick();
+
+    for (const RadarData& d : t.samples) {
+        halNativeSetMillis(d.timestamp);
+        sm->onSample(d);
+        while (sm->readEvent(cursor, ev)) {
+            if (ev.state == STATE_ALERT) {
+                sc.alerts++;
+                if (!sc.firstAlertMs) sc.firstAlertMs = ev.timestamp;
+            }
+            if (ev.state == STATE_ALARM) sc.alarms++;
+        }
+    }
+    delete sm;
+    return sc;
+}
+
+static int runBenchDetector(const std::vector<const char*>& paths) {
+    std::vector<BenchTrace> corpus;
+    AutoGuardConfig cfg = configMgr.get();
+
+    for (const char* path : paths) {
+        FILE* f = fopen(path, "rb");
+        BenchTrace t;
+        bool ok = f && benchLoadTrace(f, t.samples, cfg);
+        if (f) fclose(f);
+        if (!ok || t.samples.empty()) {
+            fprintf(stderr, "Trace non valida: %s\n", path);
+            return 1;
+        }
+        t.intrusion = strstr(path, "intrus") != nullptr;
+        t.onsetMs   = t.samples.front().timestamp;
+        for (const RadarData& d : t.samples) {
+            if (d.detected) { t.onsetMs = d.timestamp; break; }
+        }
+        corpus.push_back(t);
+    }
+    if (corpus.empty()) {
+        for (int i = 0; i < BENCH_NOISE_RUNS; i++) {
+            corpus.push_back(benchNoise(false));
+            corpus.push_back(benchNoise(true));
+        }
+        for (int i = 0; i < BENCH_INTRUSION_RUNS; i++) {
+            for (int kind = 0; kind < 3; kind++) corpus.push_back(benchIntrusion(kind));
+        }
+    }
+
+    uint32_t intrusions = 0;
+    double   noiseHours = 0;
+    for (const BenchTrace& t : corpus) {
+        if (t.intrusion) intrusions++;
+        else noiseHours += (t.samples.back().timestamp - t.samples.front().timestamp) / 3600000.0;
+    }
+
+    printf("---- AutoGuard bench detector ----\n");
+    printf("Corpus:        %u trace (%s): %u intrusioni, %.1f h di disturbo\n",
+        (unsigned)corpus.size(), paths.empty() ? "sintetiche" : "registrate",
+        intrusions, noiseHours);
+    printf("Rilevatore       alert/h  allarmi/h  mancate   latenza\n");
+
+    uint32_t falseAlerts[DETECTOR_MODE_COUNT][2] = {{0}};
+    uint32_t missed[DETECTOR_MODE_COUNT][2]      = {{0}};
+    static const char* names[DETECTOR_MODE_COUNT] = {"contatori", "evidenza"};
+
+    for (int mode = 0; mode < DETECTOR_MODE_COUNT; mode++) {
+        for (int esc = 0; esc < 2; esc++) {
+            AutoGuardConfig run = cfg;
+            run.detectorMode     = mode;
+            run.approachEscalate = esc;
+
+            uint32_t falseAlarms = 0;
+            uint64_t latencySum  = 0;
+            uint32_t latencyN    = 0;
+            for (const BenchTrace& t : corpus) {
+                BenchScore sc = benchRun(t, run);
+                if (!t.intrusion) {
+                    falseAlerts[mode][esc] += sc.alerts;
+                    falseAlarms            += sc.alarms;
+                } else if (sc.alarms == 0) {
+                    missed[mode][esc]++;
+                } else if (sc.firstAlertMs >= t.onsetMs) {
+                    latencySum += sc.firstAlertMs - t.onsetMs;
+                    latencyN++;
+                }
+            }
+            printf("%-10s %-4s %8.2f %10.2f %5u/%-4u %6.0f ms\n", names[mode],
+                esc ? "+avv" : "",
+                noiseHours > 0 ? falseAlerts[mode][esc] / noiseHours : 0.0,
+                noiseHours > 0 ? falseAlarms / noiseHours : 0.0,
+                missed[mode][esc], intrusions,
+                latencyN ? (double)latencySum / latencyN : 0.0);
+        }
+    }
+
+    bool ok = missed[DETECTOR_EVIDENCE][1] == 0 &&
+              falseAlerts[DETECTOR_EVIDENCE][1] <= falseAlerts[DETECTOR_COUNTER][0];
+    return ok ? 0 : 1;
+}
+
+// ============================================================
+// runBenchTracker() - Velocità, traiettorie ed escalation
+// ============================================================
+// Scenari sintetici con verità nota, campionati a RADAR_UPDATE_MS
+// con rumore di misura e campioni persi, passati per il filtro
+// distanza della config e per il tracker come nel driver:
+//   avvicinamento: in linea retta fino a 40-80cm, poi sosta
+//   sosta:         oscillazione lenta attorno a un punto
+//   transito:      passaggio laterale a 150-250cm dall'auto
+// Per scenario: traiettoria attesa (avvicinamento riconosciuto
+// prima dell'arrivo, sosta e transito a fine scenario) ed
+// escalation verso la zona critica (attesa solo in avvicinamento,
+// prima dell'ingresso reale). Esito != 0 sotto BENCH_TRACK_MIN_PCT.
+#define BENCH_TRACK_RUNS        100     // scenari per tipo
+#define BENCH_TRACK_JITTER_CM   8       // rumore di misura +/-
+#define BENCH_TRACK_LOSS_PCT    15      // campioni senza rilevamento
+#define BENCH_TRACK_MIN_PCT     90      // traiettorie ed escalation corrette
+
+struct BenchTrackPoint {
+    uint32_t ts;
+    double   dist;          // distanza vera (cm)
+    double   speed;         // velocità radiale vera (cm/s)
+};
+
+static std::vector<BenchTrackPoint> benchTrackScenario(int kind) {
+    std::vector<BenchTrackPoint> pts;
+    uint32_t ts = 1000;
+    if (kind == 0) {
+        double dist  = 380 + benchNext() % 15;
+        double stop  = 40 + benchNext() % 40;
+        double speed = 50 + benchNext() % 70;
+        while (dist > stop) {
+            pts.push_back({ts, dist, -speed});
+            dist -= speed * RADAR_UPDATE_MS / 1000.0;
+            ts   += RADAR_UPDATE_MS;
+        }
+        for (uint32_t end = ts + 3000; ts < end; ts += RADAR_UPDATE_MS) {
+            pts.push_back({ts, stop, 0});
+        }
+    } else if (kind == 1) {
+        double center = 120 + benchNext() % 230;
+        double period = 3000 + benchNext() % 2000;
+        for (uint32_t end = ts + 15000; ts < end; ts += RADAR_UPDATE_MS) {
+            double w = 2 * M_PI / period;
+            pts.push_back({ts, center + 10 * sin(w * ts), 10 * w * 1000 * cos(w * ts)});
+        }
+    } else {
+        double offset = 150 + benchNext() % 100;
+        double speed  = 80 + benchNext() % 70;
+        double xMax   = sqrt(395.0 * 395.0 - offset * offset);
+        for (double x = -xMax; x <= xMax; x += speed * RADAR_UPDATE_MS / 1000.0) {
+            double r = sqrt(offset * offset + x * x);
+            pts.push_back({ts, r, x * speed / r});
+            ts += RADAR_UPDATE_MS;
+        }
+    }
+    return pts;
+}
+
+static int runBenchTracker() {
+    AutoGuardConfig cfg = configMgr.get();
+    RadarFilter<FILTER_AVG_SIZE, FILTER_MEDIAN_SIZE> filter;
+    filter.configure(cfg.filterMode, cfg.filterEmaAlpha, cfg.filterKalmanQ, cfg.filterKalmanR);
+
+    static const char* kinds[3] = {"avvicinamento", "sosta", "transito"};
+
+    printf("---- AutoGuard bench tracker ----\n");
+    printf("Scenari:       %u per tipo, rumore +/-%dcm, %d%% campioni persi, filtro %d\n",
+        BENCH_TRACK_RUNS, BENCH_TRACK_JITTER_CM, BENCH_TRACK_LOSS_PCT, cfg.filterMode);
+    printf("Scenario       traiettoria  escalation  anticipo  err.vel.\n");
+
+    uint32_t correct[3]   = {0};
+    uint32_t escalated[3] = {0};
+    double   trackNs      = 0;
+    uint64_t trackCalls   = 0;
+
+    for (int kind = 0; kind < 3; kind++) {
+        double   sqErr   = 0;
+        uint32_t errN    = 0;
+        uint64_t leadSum = 0;
+
+        for (int run = 0; run < BENCH_TRACK_RUNS; run++) {
+            std::vector<BenchTrackPoint> pts = benchTrackScenario(kind);
+            std::vector<RadarData>       samples;
+            samples.reserve(pts.size());
+
+            filter.reset();
+            for (const BenchTrackPoint& p : pts) {
+                bool detected = benchNext() % 100 >= BENCH_TRACK_LOSS_PCT;
+                int  jitter   = (int)(benchNext() % (2 * BENCH_TRACK_JITTER_CM + 1)) - BENCH_TRACK_JITTER_CM;
+                int  dist     = (int)lround(p.dist) + jitter;
+                RadarData d   = benchSample(p.ts, detected, dist);
+                if (detected) {
+                    d.filtered_dist = filter.apply(dist);
+                } else {
+                    filter.reset();
+                }
+                samples.push_back(d);
+            }
+
+            RadarTracker tracker;
+            auto t0 = std::chrono::steady_clock::now();
+            for (RadarData& d : samples) tracker.apply(d);
+            trackNs += std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - t0).count();
+            trackCalls += samples.size();
+
+            // Ingresso reale in zona critica / fine del movimento
+            uint32_t criticalMs = 0;
+            uint32_t arrivalMs  = pts.back().ts;
+            for (const BenchTrackPoint& p : pts) {
+                if (!criticalMs && p.dist <= cfg.zoneCriticalMax) criticalMs = p.ts;
+                if (kind == 0 && p.speed == 0) { arrivalMs = p.ts; break; }
+            }
+
+            bool     seenApproach = false;
+            uint32_t escalateMs   = 0;
+            RadarTrajectory last  = TRAJ_NONE;
+            for (size_t i = 0; i < samples.size(); i++) {
+                const RadarData& d = samples[i];
+                if (!d.detected) continue;
+                if (d.timestamp - pts.front().ts >= 1000) {
+                    double e = d.velocity - pts[i].speed;
+                    sqErr += e * e;
+                    errN++;
+                }
+                if (d.trajectory == TRAJ_APPROACHING && d.timestamp < arrivalMs) seenApproach = true;
+                if (!escalateMs && d.zone != ZONE_CRITICAL &&
+                    RadarTracker::reaches(d, cfg.zoneCriticalMax, cfg.approachLeadMs)) {
+                    escalateMs = d.timestamp;
+                }
+                last = d.trajectory;
+            }
+
+            bool ok = kind == 0 ? seenApproach :
+                      kind == 1 ? last == TRAJ_LOITERING && !seenApproach :
+                                  last == TRAJ_PASSING;
+            if (ok) correct[kind]++;
+            if (escalateMs && (!criticalMs || escalateMs < criticalMs)) {
+                escalated[kind]++;
+                if (criticalMs) leadSum += criticalMs - escalateMs;
+            }
+        }
+
+        printf("%-14s %9u%% %10u%% %7.0f ms %5.1f cm/s\n", kinds[kind],
+            correct[kind] * 100 / BENCH_TRACK_RUNS, escalated[kind] * 100 / BENCH_TRACK_RUNS,
+            escalated[kind] ? (double)leadSum / escalated[kind] : 0.0,
+            errN ? sqrt(sqErr / errN) : 0.0);
+    }
+    printf("Tracker:       %.1f ns/campione\n", trackNs / trackCalls);
+
+    bool ok = true;
+    for (int kind = 0; kind < 3; kind++) {
+        if (correct[kind] * 100 < BENCH_TRACK_MIN_PCT * BENCH_TRACK_RUNS) ok = false;
+    }
+    if (escalated[0] * 100 < BENCH_TRACK_MIN_PCT * BENCH_TRACK_RUNS) ok = false;
+    if ((escalated[1] + escalated[2]) * 100 > (100 - BENCH_TRACK_MIN_PCT) * 2 * BENCH_TRACK_RUNS) ok = false;
+    return ok ? 0 : 1;
+}
+
+// ============================================================
+// runBenchFusion() - Fusione multi-radar su trace sintetiche
+// ============================================================
+// Da 1 a FUSION_MAX_SENSORS sensori a RADAR_UPDATE_MS, con fase,
+// jitter dei timestamp e ritardo di consegna casuali e campioni
+// persi. L'intruso è visto da un solo sensore (avvicinamento,
+// poi sosta); gli altri vedono solo colpi isolati. In un
+// quarto degli scenari un sensore senza intruso tace per 3s
+// restando "pronto" (frame chiusi a fine finestra).
+// Il loop simulato gira a BENCH_FUSION_STEP_MS e passa il flusso
+// fuso alla state machine come nel firmware.
+// Verifiche: con un sensore il flusso fuso è identico a quello
+// del sensore; nessun campione con presenza perso (ogni
+// rilevamento compare in un campione fuso entro FUSION_ALIGN_MS);
+// timestamp mai all'indietro; ritmo indipendente dal numero di
+// sensori; nessuna intrusione mancata. Esito != 0 altrimenti.
+#define BENCH_FUSION_RUNS       100     // scenari per numero di sensori
+#define BENCH_FUSION_MS         20000   // durata scenario
+#define BENCH_FUSION_STEP_MS    5       // passo del loop simulato
+#define BENCH_FUSION_LOSS_PCT   5       // campioni persi per sensore
+#define BENCH_FUSION_DELAY_MS   15      // ritardo di consegna massimo
+
+class BenchSource : public RadarSource {
+public:
+    std::vector<RadarData> samples;
+    std::vector<uint32_t>  due;         // istante di consegna
+    size_t    pos   = 0;
+    RadarData last  = {};
+
+    void update() override {}
+    bool readSample(RadarData& out) override {
+        if (pos >= samples.size() || (int32_t)(halMillis() - due[pos]) < 0) return false;
+        out = last = samples[pos++];
+        return true;
+    }
+    RadarData getData() override { return last; }
+    bool isReady() override { return true; }
+};
+
+static bool benchSameSample(const RadarData& a, const RadarData& b) {
+    return a.detected == b.detected && a.distance_cm == b.distance_cm && a.zone == b.zone &&
+           a.filtered_dist == b.filtered_dist && a.timestamp == b.timestamp &&
+           a.velocity == b.velocity && a.trajectory == b.trajectory;
+}
+
+static int runBenchFusion() {
+    AutoGuardConfig cfg = configMgr.get();
+
+    printf("---- AutoGuard bench fusione ----\n");
+    printf("Scenari:       %u per configurazione, %d%% campioni persi, finestra %dms\n",
+        BENCH_FUSION_RUNS, BENCH_FUSION_LOSS_PCT, FUSION_ALIGN_MS);
+    printf("Sensori  campioni/s  incompleti  perse  ritardo  mancate  ns/campione\n");
+
+    bool ok = true;
+    for (int n = 1; n <= FUSION_MAX_SENSORS; n++) {
+        uint64_t fused = 0, partial = 0, frames = 0, lost = 0, inputs = 0;
+        uint64_t delaySum = 0;
+        uint32_t missed = 0, backwards = 0, mismatch = 0;
+        double   fuseNs = 0;
+
+        for (int run = 0; run < BENCH_FUSION_RUNS; run++) {
+            BenchSource src[FUSION_MAX_SENSORS];
+            int      side  = benchNext() % n;
+            bool     mute  = n > 1 && run % 4 == 0;
+            int      muted = (side + 1) % n;
+            uint32_t t0    = 1000;
+
+            for (int i = 0; i < n; i++) {
+                std::vector<RadarData>& s = src[i].samples;
+                int dist = 300 + benchNext() % 60;
+                for (uint32_t ts = t0 + benchNext() % RADAR_UPDATE_MS; ts < t0 + BENCH_FUSION_MS;
+                     ts += RADAR_UPDATE_MS) {
+                    uint32_t t = ts + benchNext() % 4;
+                    if (i == side && t >= t0 + 5000 && t < t0 + 12000) {
+                        // Intruso: avvicinamento a 80cm/s fino a 60cm, poi sosta
+                        if (dist > 60) dist -= 80 * RADAR_UPDATE_MS / 1000;
+                        int jitter = (int)(benchNext() % 11) - 5;
+                        s.push_back(benchSample(t, benchNext() % 100 < 85, dist + jitter));
+                    } else {
+                        s.push_back(benchSample(t, benchNext() % 100 == 0, 150 + benchNext() % 200));
+                    }
+                }
+                benchTrack(s);
+
+                // Persi e silenzio: il sensore non consegna nulla
+                std::vector<RadarData> kept;
+                for (RadarData& d : s) {
+                    bool silent = mute && i == muted &&
+                                  d.timestamp >= t0 + 8000 && d.timestamp < t0 + 11000;
+                    if (silent || benchNext() % 100 < BENCH_FUSION_LOSS_PCT) continue;
+                    d.sensor = i;
+                    kept.push_back(d);
+                    src[i].due.push_back(d.timestamp + benchNext() % BENCH_FUSION_DELAY_MS);
+                }
+                s.swap(kept);
+                inputs += s.size();
+            }
+
+            RadarFusion fusion;
+            for (int i = 0; i < n; i++) fusion.addSource(&src[i]);
+
+            BenchTrace t;
+            t.intrusion = true;
+            t.onsetMs   = t0 + 5000;
+            t.samples.reserve(BENCH_FUSION_MS / RADAR_UPDATE_MS * 2);
+            RadarData d;
+            auto c0 = std::chrono::steady_clock::now();
+            for (uint32_t now = t0; now < t0 + BENCH_FUSION_MS + 100; now += BENCH_FUSION_STEP_MS) {
+                halNativeSetMillis(now);
+                while (fusion.readSample(d)) {
+                    if (!t.samples.empty() && (int32_t)(d.timestamp - t.samples.back().timestamp) < 0) backwards++;
+                    delaySum += now - d.timestamp;
+                    t.samples.push_back(d);
+                }
+            }
+            fuseNs += std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - c0).count();
+            fused   += t.samples.size();
+            partial += fusion.partial();
+            frames  += fusion.frames();
+
+            // Un sensore: flusso identico
+            if (n == 1) {
+                const std::vector<RadarData>& in = src[0].samples;
+                if (in.size() != t.samples.size()) mismatch++;
+                else for (size_t k = 0; k < in.size(); k++) {
+                    if (!benchSameSample(in[k], t.samples[k])) { mismatch++; break; }
+                }
+            }
+
+            // Ogni rilevamento in un campione fuso con presenza entro la finestra
+            std::vector<uint32_t> hits;
+            for (const RadarData& f : t.samples) if (f.detected) hits.push_back(f.timestamp);
+            for (int i = 0; i < n; i++) {
+                for (const RadarData& s : src[i].samples) {
+                    if (!s.detected) continue;
+                    auto it = std::lower_bound(hits.begin(), hits.end(), s.timestamp);
+                    if (it == hits.end() || *it - s.timestamp > FUSION_ALIGN_MS) lost++;
+                }
+            }
+
+            // Stesso flusso alla state machine
+            halNativeSetMillis(0);
+            BenchScore sc = benchRun(t, cfg);
+            if (sc.alarms == 0) missed++;
+        }
+
+        double secs = (double)BENCH_FUSION_RUNS * BENCH_FUSION_MS / 1000.0;
+        double rate = fused / secs;
+        printf("%7d %11.1f %10.1f%% %6llu %6.1f ms %4u/%-4u %8.1f\n", n, rate,
+            frames ? partial * 100.0 / frames : 0.0, (unsigned long long)lost,
+            fused ? (double)delaySum / fused : 0.0, missed, BENCH_FUSION_RUNS,
+            inputs ? fuseNs / inputs : 0.0);
+
+        if (lost || missed || backwards || mismatch) ok = false;
+        if (rate < 0.9 * 1000 / RADAR_UPDATE_MS || rate > 1.1 * 1000 / RADAR_UPDATE_MS) ok = false;
+        if (backwards) printf("ERRORE: %u timestamp all'indietro\n", backwards);
+        if (mismatch)  printf("ERRORE: %u flussi diversi con un sensore\n", mismatch);
+    }
+    return ok ? 0 : 1;
+}
+
+// ============================================================
+// --bench-zones: tabella zone con isteresi
+// ============================================================
+// Bersaglio fermo sui confini CRITICAL/MEDIUM e MEDIUM/FAR con
+// rumore di misura, poi avvicinamento da 300 a 50cm: cambi di
+// zona della catena di confronti (prima della tabella) e della
+// mappa. Senza isteresi la mappa deve coincidere con la catena
+// su ogni distanza; la permanenza per zona deve sommare al tempo
+// con presenza.
+#define BENCH_ZONES_MS      60000
+#define BENCH_ZONES_JITTER  6       // +/- cm attorno al confine
+
+static RadarZone benchZoneChain(const AutoGuardConfig& cfg, int cm) {
+    if (cm <= 0) return ZONE_NONE;
+    if (cm <= cfg.zoneCriticalMax) return ZONE_CRITICAL;
+    if (cm <= cfg.zoneMediumMax) return ZONE_MEDIUM;
+    if (cm <= cfg.zoneFarMax) return ZONE_FAR;
+    return ZONE_NONE;
+}
+
+static bool benchZoneBuild(ZoneMap& map, const AutoGuardConfig& cfg, int enterCm, int exitCm) {
+    const ZoneDef zones[] = {
+        {cfg.zoneCriticalMax, ZONE_CRITICAL},
+        {cfg.zoneMediumMax,   ZONE_MEDIUM},
+        {cfg.zoneFarMax,      ZONE_FAR}
+    };
+    return map.build(zones, 3, enterCm, exitCm);
+}
+
+static int runBenchZones() {
+    const AutoGuardConfig& cfg = configMgr.get();
+    bool ok = true;
+
+    printf("---- AutoGuard bench zone ----\n");
+    printf("Zone:          %d/%d/%dcm, isteresi +%d/-%dcm, tabella %u voci\n",
+        cfg.zoneCriticalMax, cfg.zoneMediumMax, cfg.zoneFarMax,
+        cfg.zoneHystEnterCm, cfg.zoneHystExitCm, (unsigned)((ZONE_MAP_IDLE + 1) * (ZONE_MAP_CM + 2)));
+
+    // Senza isteresi: identica alla catena, anche a salti casuali
+    ZoneMap  plain;
+    uint32_t diff = 0;
+    benchZoneBuild(plain, cfg, 0, 0);
+    for (uint32_t i = 0; i < 200000; i++) {
+        RadarData d = benchSample(i * RADAR_UPDATE_MS, benchNext() % 10 != 0,
+                                  (int)(benchNext() % (ZONE_MAP_CM + 200)) - 20);
+        plain.apply(d);
+        if (d.zone != (d.detected ? benchZoneChain(cfg, d.filtered_dist) : ZONE_NONE)) diff++;
+    }
+    printf("Equivalenza:   %u differenze su 200000 campioni (isteresi 0)\n", diff);
+    if (diff) ok = false;
+
+    // Scenari: confine vicino, confine lontano, avvicinamento
+    printf("Scenario          cambi catena  cambi mappa  permanenza\n");
+    const int borders[] = {cfg.zoneCriticalMax, cfg.zoneMediumMax};
+    for (int sc = 0; sc < 3; sc++) {
+        ZoneMap map;
+        benchZoneBuild(map, cfg, cfg.zoneHystEnterCm, cfg.zoneHystExitCm);
+        RadarZone lastChain = ZONE_NONE, lastMap = ZONE_NONE;
+        uint32_t  chainChanges = 0, mapChanges = 0, present = 0, prevTs = 0;
+        bool      prevDet = false;
+
+        for (uint32_t ts = 0; ts < BENCH_ZONES_MS; ts += RADAR_UPDATE_MS) {
+            int cm;
+            if (sc < 2) cm = borders[sc];
+            else        cm = 300 - (int)(ts * 250 / BENCH_ZONES_MS);
+            cm += (int)(benchNext() % (2 * BENCH_ZONES_JITTER + 1)) - BENCH_ZONES_JITTER;
+
+            RadarData d = benchSample(ts, true, cm);
+            map.apply(d);
+            RadarZone chain = benchZoneChain(cfg, cm);
+            if (ts && chain != lastChain) chainChanges++;
+            if (ts && d.zone != lastMap) mapChanges++;
+            if (prevDet) present += ts - prevTs;
+            lastChain = chain;
+            lastMap   = d.zone;
+            prevDet   = d.detected;
+            prevTs    = ts;
+        }
+        uint32_t dwell = 0;
+        for (uint8_t z = 0; z <= map.count(); z++) dwell += map.dwellMs(z);
+
+        static const char* names[] = {"confine vicino", "confine medio", "avvicinamento"};
+        printf("%-16s %13u %12u  %s\n", names[sc], chainChanges, mapChanges,
+            dwell == present ? "ok" : "ERRORE");
+        if (dwell != present) ok = false;
+        // Fermo sul confine: al più un cambio; avvicinamento: FAR -> MEDIUM -> CRITICAL
+        if (sc < 2 && mapChanges > 1) ok = false;
+        if (sc == 2 && mapChanges != 2) ok = false;
+    }
+
+    // Costo per campione: distanze a caso e bersaglio che cammina
+    // (+-3cm per frame). La mappa aggiorna anche la permanenza
+    const uint32_t N = 2000000;
+    std::vector<int> jump(4096), walk(4096);
+    for (int& v : jump) v = 1 + benchNext() % ZONE_FAR_MAX;
+    int pos = ZONE_FAR_MAX / 2;
+    for (int& v : walk) {
+        pos += (int)(benchNext() % 7) - 3;
+        if (pos < 1) pos = 1;
+        if (pos > ZONE_FAR_MAX) pos = ZONE_FAR_MAX;
+        v = pos;
+    }
+
+    const char* const names[] = {"salti", "cammino"};
+    const std::vector<int>* sets[] = {&jump, &walk};
+    for (int k = 0; k < 2; k++) {
+        const std::vector<int>& dist = *sets[k];
+        ZoneMap map;
+        benchZoneBuild(map, cfg, cfg.zoneHystEnterCm, cfg.zoneHystExitCm);
+        RadarData d = benchSample(0, true, 0);
+        uint32_t  sink = 0;
+
+        auto c0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < N; i++) sink += benchZoneChain(cfg, dist[i & 4095]);
+        auto c1 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < N; i++) {
+            d.filtered_dist = dist[i & 4095];
+            d.timestamp     = i;
+            map.apply(d);
+            sink += d.zone;
+        }
+        auto c2 = std::chrono::steady_clock::now();
+        printf("Costo %-8s catena %.1f ns, mappa %.1f ns per campione (host, %u)\n", names[k],
+            std::chrono::duration<double, std::nano>(c1 - c0).count() / N,
+            std::chrono::duration<double, std::nano>(c2 - c1).count() / N, sink & 1);
+    }
+
+    if (!ok) printf("ERRORE: criteri non rispettati\n");
+    return ok ? 0 : 1;
+}
+
+// ============================================================
+// --bench-telemetry: telemetria ai cambiamenti vs timer fisso
+// ============================================================
+// Un'ora disarmato con colpi di rumore isolati (auto in garage),
+// poi armato con avvicinamento fino all'allarme. Loop a 1ms
+// virtuale: lo scheduler vede l'ultimo campione come in
+// AutoGuardMQTT::update(). Per stato: messaggi inviati e ritardo
+// massimo tra un cambio di presenza o zona e il primo invio
+// successivo, confrontati con il vecchio publish ogni 10s.
+// Criteri: meno messaggi del timer da disarmato, cambi in
+// ALERT/ALARM pubblicati entro BENCH_TELEM_MAX_DELAY_MS, mai
+// oltre il token bucket in una finestra di 1s.
+#define BENCH_TELEM_FIXED_MS      10000
+#define BENCH_TELEM_MAX_DELAY_MS  1000
+
+static int runBenchTelemetry() {
+    AutoGuardConfig cfg = configMgr.get();
+
+    // Garage (disarmato) + intrusione (armato), zone come nel driver
+    std::vector<RadarData> samples = benchNoise(false).samples;
+    uint32_t armAt = samples.back().timestamp + RADAR_UPDATE_MS;
+    for (RadarData d : benchIntrusion(0).samples) {
+        d.timestamp += armAt;
+        samples.push_back(d);
+    }
+    ZoneMap map;
+    benchZoneBuild(map, cfg, cfg.zoneHystEnterCm, cfg.zoneHystExitCm);
+    for (RadarData& d : samples) map.apply(d);
+
+    AlarmLogic*        sm = new AlarmLogic();
+    TelemetryScheduler sched;
+    uint32_t           t0 = samples.front().timestamp;
+    halNativeSetMillis(t0);
+    sm->begin();
+
+    uint32_t sent[STATE_COOLDOWN + 1]   = {0};
+    uint32_t fixed[STATE_COOLDOWN + 1]  = {0};
+    uint32_t delay[STATE_COOLDOWN + 1]  = {0};     // ritardo max scheduler
+    uint32_t fDelay[STATE_COOLDOWN + 1] = {0};     // ritardo max timer fisso
+    uint32_t stateMs[STATE_COOLDOWN + 1] = {0};
+    std::vector<uint32_t> sentAt;
+
+    size_t     next    = 0;
+    RadarData  cur     = {};
+    bool       waiting = false, fWaiting = false;
+    uint32_t   changeAt = 0;
+    AlarmState changeSt = STATE_DISARMED;
+    uint32_t   maxWindow = 0;
+    uint32_t   end = samples.back().timestamp;
+
+    for (uint32_t now = t0; now <= end; now++) {
+        halNativeSetMillis(now);
+        if (now == armAt) sm->arm();
+        sm->tick();
+        while (next < samples.size() && samples[next].timestamp <= now) {
+            const RadarData& d = samples[next++];
+            sm->onSample(d);
+            if (d.detected != cur.detected || d.zone_id != cur.zone_id) {
+                if (!waiting)  { changeAt = now; changeSt = sm->getState(); }
+                waiting = fWaiting = true;
+            }
+            cur = d;
+        }
+        AlarmState st = sm->getState();
+        stateMs[st]++;
+
+        // Vecchio comportamento: publish ogni 10s
+        if ((now - t0) % BENCH_TELEM_FIXED_MS == 0) {
+            fixed[st]++;
+            if (fWaiting && now - changeAt > fDelay[changeSt]) fDelay[changeSt] = now - changeAt;
+            fWaiting = false;
+        }
+
+        if (sched.due(cur, st, now)) {
+            sched.sent(cur, now);
+            sent[st]++;
+            sentAt.push_back(now);
+            if (waiting && now - changeAt > delay[changeSt]) delay[changeSt] = now - changeAt;
+            waiting = false;
+            while (sentAt.front() + 1000 <= now) sentAt.erase(sentAt.begin());
+            if (sentAt.size() > maxWindow) maxWindow = sentAt.size();
+        }
+    }
+    delete sm;
+
+    static const char* names[] = {"DISARMED", "ARMING", "ARMED", "ALERT", "ALARM", "COOLDOWN"};
+    printf("---- AutoGuard bench telemetria ----\n");
+    printf("Stato       durata s  timer 10s  scheduler  ritardo max timer/sched ms\n");
+    for (int st = 0; st <= STATE_COOLDOWN; st++) {
+        printf("%-10s %9lu %10u %10u  %10u / %u\n", names[st], (unsigned long)(stateMs[st] / 1000),
+            fixed[st], sent[st], fDelay[st], delay[st]);
+    }
+    const TelemetryStats& ts = sched.stats();
+    printf("Totale:        %u inviati (%u cambi, %u heartbeat), %u soppressi (%u banda, %u accorpati)\n",
+        ts.sent, ts.changes, ts.heartbeats, ts.filtered + ts.coalesced, ts.filtered, ts.coalesced);
+    printf("Raffica max:   %u messaggi in 1s (token bucket %d)\n", maxWindow, TELEM_BUCKET_BURST);
+
+    bool ok = sent[STATE_DISARMED] < fixed[STATE_DISARMED] &&
+              sent[STATE_ALERT] > 0 &&
+              delay[STATE_ALERT] <= BENCH_TELEM_MAX_DELAY_MS &&
+              delay[STATE_ALARM] <= BENCH_TELEM_MAX_DELAY_MS &&
+              maxWindow <= TELEM_BUCKET_BURST + 1000 / TELEM_BUCKET_REFILL_MS;
+    if (!ok) printf("ERRORE: criteri non rispettati\n");
+    return ok ? 0 : 1;
+}
+
+// ============================================================
+// --bench-batch: storico radar in batch binari
+// ============================================================
+// Campioni di una trace .agt o, senza file, intrusioni sintetiche
+// (avvicinamento, sosta, passaggio) e rumore, con velocità,
+// traiettoria, zona della mappa e sensore di origine. Ogni batch
+// è decodificato e confrontato campo per campo con l'originale.
+// Byte per campione contati come pacchetti MQTT (header fisso,
+// topic, payload) rispetto a un JSON MQTT_TOPIC_SENSOR per
+// campione. Esito != 0 alla prima differenza o sotto un fattore
+// BENCH_BATCH_MIN_RATIO su byte o publish.
+#define BENCH_BATCH_MIN_RATIO   10
+
+// Byte di un PUBLISH QoS 0 sul filo
+static size_t benchMqttPacket(const char* topic, size_t payload) {
+    size_t rem = 2 + strlen(topic) + payload;
+    size_t len = 1 + 1;
+    for (size_t r = rem; r >= 0x80; r >>= 7) len++;
+    return len + rem;
+}
+
+static bool benchSameBatched(const RadarData& a, const RadarData& b) {
+    return a.detected == b.detected && a.zone == b.zone && a.trajectory == b.trajectory &&
+           a.sensor == b.sensor && a.zone_id == b.zone_id && a.distance_cm == b.distance_cm &&
+           a.filtered_dist == b.filtered_dist && a.velocity == b.velocity &&
+           a.timestamp == b.timestamp;
+}
+
+static int runBenchBatch(FILE* in) {
+    std::vector<RadarData> samples;
+    AutoGuardConfig cfg = configMgr.get();
+    if (in) {
+        if (!benchLoadTrace(in, samples, cfg)) {
+            fprintf(stderr, "Trace non valida\n");
+            return 1;
+        }
+    } else {
+        uint32_t ts = 0;
+        for (int i = 0; i < 30; i++) {
+            BenchTrace t = (i % 4 == 3) ? benchNoise(true) : benchIntrusion(i % 3);
+            uint32_t   t0 = t.samples.front().timestamp;
+            for (RadarData d : t.samples) {
+                d.timestamp = ts + d.timestamp - t0;
+                d.sensor    = (uint8_t)(benchNext() % RADAR_COUNT);
+                samples.push_back(d);
+            }
+            ts = samples.back().timestamp + RADAR_UPDATE_MS;
+            if (samples.size() > 200000) break;
+        }
+    }
+    if (samples.empty()) {
+        fprintf(stderr, "Trace vuota\n");
+        return 1;
+    }
+    ZoneMap map;
+    benchZoneBuild(map, cfg, cfg.zoneHystEnterCm, cfg.zoneHystExitCm);
+    for (RadarData& d : samples) map.apply(d);
+
+    static RadarBatcher batcher;
+    RadarBatchReader    reader;
+    size_t   jsonBytes = 0, batchBytes = 0, batches = 0, decoded = 0, diff = 0;
+    uint16_t lastSeq = 0;
+    bool     seqOk   = true;
+
+    auto drain = [&]() {
+        size_t         len;
+        const uint8_t* b;
+        while ((b = batcher.front(&len)) != nullptr) {
+            batches++;
+            batchBytes += benchMqttPacket(MQTT_TOPIC_BATCH, len);
+            if (!reader.open(b, len) || reader.seq() != (uint16_t)(lastSeq + 1)) seqOk = false;
+            lastSeq = reader.seq();
+            RadarData d;
+            while (reader.next(d)) {
+                if (decoded >= samples.size() || !benchSameBatched(d, samples[decoded])) diff++;
+                decoded++;
+            }
+            batcher.pop();
+        }
+    };
+
+    for (const RadarData& d : samples) {
+        JsonWriter j;
+        mqttRadarJson(j, d);
+        jsonBytes += benchMqttPacket(MQTT_TOPIC_SENSOR, j.length());
+        if (batcher.add(d)) drain();
+    }
+    batcher.flush();
+    drain();
+
+    // Costo della codifica per campione
+    static RadarBatcher bench;
+    auto c0 = std::chrono::steady_clock::now();
+    for (const RadarData& d : samples) {
+        if (bench.add(d)) bench.pop();
+    }
+    auto c1 = std::chrono::steady_clock::now();
+
+    double byteRatio = (double)jsonBytes / batchBytes;
+    double pubRatio  = (double)samples.size() / batches;
+    printf("---- AutoGuard bench storico radar ----\n");
+    printf("Campioni:      %zu in %zu batch da %d (%s)\n", samples.size(), batches,
+        RADAR_BATCH_SAMPLES, in ? "trace" : "sintetici");
+    printf("Andata/ritorno:%zu decodificati, %zu differenze, sequenza %s\n",
+        decoded, diff, seqOk ? "ok" : "ERRORE");
+    printf("JSON:          %.1f byte/campione, 1 publish/campione\n",
+        (double)jsonBytes / samples.size());
+    printf("Batch:         %.2f byte/campione (%.2f payload), 1 publish ogni %.1f campioni\n",
+        (double)batchBytes / samples.size(), (double)batcher.bytes() / samples.size(), pubRatio);
+    printf("Riduzione:     %.1fx byte, %.1fx publish\n", byteRatio, pubRatio);
+    printf("Codifica:      %.1f ns per campione (host)\n",
+        std::chrono::duration<double, std::nano>(c1 - c0).count() / samples.size());
+
+    bool ok = diff == 0 && decoded == samples.size() && seqOk &&
+              byteRatio >= BENCH_BATCH_MIN_RATIO && pubRatio >= BENCH_BATCH_MIN_RATIO;
+    if (!ok) printf("ERRORE: criteri non rispettati\n");
+    return ok ? 0 : 1;
+}
+
+// ============================================================
+// --bench-filter: filtri distanza a confronto
+// ============================================================
+// Ogni modalità di RadarFilter con i parametri della config, a
+// RADAR_UPDATE_MS:
+//   gradino:     300 -> 150cm senza rumore, ritardo fino al 90%
+//   rumore:      bersaglio fermo a 200cm, rumore ~N(0, 10cm):
+//                errore RMS in uscita
+//   spike:       come sopra con il 5% di campioni a +/-100..300cm
+//                (riflessi): errore RMS e massimo
+//   avvicinamento: 300 -> 50cm a 1m/s con rumore: ritardo medio
+//                in cm rispetto alla distanza vera
+// più il costo per campione. Esito != 0 se una modalità non
+// restituisce invariato un ingresso costante, non arriva al 90%
+// del gradino entro BENCH_FILTER_STEP_MS o non riduce il rumore.
+#define BENCH_FILTER_SAMPLES   20000
+#define BENCH_FILTER_STEP_MS   1000
+#define BENCH_FILTER_SIGMA     10
+
+typedef RadarFilter<FILTER_AVG_SIZE, FILTER_MEDIAN_SIZE> BenchFilter;
+
+// Rumore circa gaussiano: somma di 4 uniformi, deviazione sigma
+static int benchGauss(int sigma) {
+    int32_t s = 0;
+    for (int i = 0; i < 4; i++) s += (int32_t)(benchNext() % 2001) - 1000;
+    return (int)(s * sigma / 1155);     // 4 uniformi +/-1000: sigma = 1155
+}
+
+static void benchFilterConfigure(BenchFilter& f, int mode, const AutoGuardConfig& cfg) {
+    f.configure(mode, cfg.filterEmaAlpha, cfg.filterKalmanQ, cfg.filterKalmanR);
+    f.reset();
+}
+
+// Errore RMS e massimo su un bersaglio fermo (dopo 1s di assestamento)
+static void benchFilterNoise(BenchFilter& f, int spikePct, double& rms, int& peak) {
+    const int target = 200;
+    double    sum = 0;
+    uint32_t  n = 0;
+    peak = 0;
+    for (uint32_t i = 0; i < BENCH_FILTER_SAMPLES; i++) {
+        int in = target + benchGauss(BENCH_FILTER_SIGMA);
+        if ((int)(benchNext() % 100) < spikePct) {
+            int spike = 100 + benchNext() % 201;
+            in += (benchNext() & 1) ? spike : -spike;
+        }
+        int err = f.apply(in) - target;
+        if (i * RADAR_UPDATE_MS < 1000) continue;
+        sum += (double)err * err;
+        n++;
+        if (abs(err) > peak) peak = abs(err);
+    }
+    rms = sqrt(sum / n);
+}
+
+static int runBenchFilter() {
+    const AutoGuardConfig& cfg = configMgr.get();
+    static const char* names[FILTER_MODE_COUNT] = {
+        "media", "mediana", "esponenziale", "kalman", "mediana+esp", "mediana+kalman"
+    };
+    bool ok = true;
+
+    printf("---- AutoGuard bench filtri ----\n");
+    printf("Parametri:     media %d, mediana %d, alpha %d%%, Kalman q=%d r=%d, %dms/campione\n",
+        FILTER_AVG_SIZE, FILTER_MEDIAN_SIZE, cfg.filterEmaAlpha,
+        cfg.filterKalmanQ, cfg.filterKalmanR, RADAR_UPDATE_MS);
+
+    // Riferimento senza filtro
+    BenchFilter f;
+    double   rawRms  = 0;
+    uint32_t rawPeak = 0;
+    for (uint32_t i = 0; i < BENCH_FILTER_SAMPLES; i++) {
+        int e = benchGauss(BENCH_FILTER_SIGMA);
+        rawRms += (double)e * e;
+        if ((uint32_t)abs(e) > rawPeak) rawPeak = abs(e);
+    }
+    rawRms = sqrt(rawRms / BENCH_FILTER_SAMPLES);
+    printf("Ingresso:      rumore RMS %.1fcm (max %ucm)\n", rawRms, rawPeak);
+
+    std::vector<int> costIn(4096);
+    for (int& v : costIn) v = 200 + benchGauss(BENCH_FILTER_SIGMA);
+
+    printf("Filtro           gradino90  rumore RMS  spike RMS/max  ritardo  costo\n");
+    for (int mode = 0; mode < FILTER_MODE_COUNT; mode++) {
+        bool modeOk = true;
+
+        // Ingresso costante: uscita identica
+        benchFilterConfigure(f, mode, cfg);
+        for (int i = 0; i < 50; i++) {
+            if (f.apply(250) != 250) modeOk = false;
+        }
+
+        // Gradino 300 -> 150cm
+        benchFilterConfigure(f, mode, cfg);
+        for (int i = 0; i < 50; i++) f.apply(300);
+        uint32_t stepMs = 0;
+        for (uint32_t ms = RADAR_UPDATE_MS; ; ms += RADAR_UPDATE_MS) {
+            if (f.apply(150) <= 300 - 150 * 9 / 10) { stepMs = ms; break; }
+            if (ms > 10 * BENCH_FILTER_STEP_MS) break;
+        }
+        if (!stepMs || stepMs > BENCH_FILTER_STEP_MS) modeOk = false;
+
+        // Rumore e spike
+        double noiseRms, spikeRms;
+        int    noisePeak, spikePeak;
+        benchFilterConfigure(f, mode, cfg);
+        benchFilterNoise(f, 0, noiseRms, noisePeak);
+        benchFilterConfigure(f, mode, cfg);
+        benchFilterNoise(f, 5, spikeRms, spikePeak);
+        if (noiseRms >= rawRms) modeOk = false;
+
+        // Avvicinamento a 1m/s (5cm per campione), media su 100 passaggi
+        double lag = 0;
+        int    n = 0;
+        for (int run = 0; run < 100; run++) {
+            benchFilterConfigure(f, mode, cfg);
+            for (int cm = 300; cm >= 50; cm -= 100 * RADAR_UPDATE_MS / 1000) {
+                int out = f.apply(cm + benchGauss(BENCH_FILTER_SIGMA));
+                if (cm > 250) continue;         // primo secondo: avvio del filtro
+                lag += out - cm;
+                n++;
+            }
+        }
+
+        // Costo per campione
+        const uint32_t N = 2000000;
+        benchFilterConfigure(f, mode, cfg);
+        uint32_t sink = 0;
+        auto c0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < N; i++) sink += f.apply(costIn[i & 4095]);
+        auto c1 = std::chrono::steady_clock::now();
+
+        printf("%-16s %7ums %9.1fcm %8.1f/%-4dcm %6.1fcm %5.1fns%s%s\n",
+            names[mode], stepMs, noiseRms, spikeRms, spikePeak, lag / n,
+            std::chrono::duration<double, std::nano>(c1 - c0).count() / N,
+            mode == cfg.filterMode ? "  (config)" : "",
+            modeOk ? "" : "  ERRORE");
+        if (sink == 0x7FFFFFFF) printf(" ");    // il costo non va ottimizzato via
+        if (!modeOk) ok = false;
+    }
+
+    if (!ok) printf("ERRORE: criteri non rispettati\n");
+    return ok ? 0 : 1;
+}
+
+// ============================================================
+// --bench-parser: parser LD2420 su flussi puliti, casuali e corrotti
+// ============================================================
+// Flusso pulito: cattura UART (file) o sintetico deterministico
+// (frame engineering, report testo, ACK). Una passata di
+// riferimento ne ricava frame e confini, poi sempre a pezzi
+// casuali come dal task radar:
+//   pulito:   stessi frame; costo per frame e per byte
+//   casuale:  BENCH_PARSER_NOISE byte casuali seguiti dal flusso
+//             pulito
+//   corrotto: un frame su 8 troncato o con un byte alterato
+// Riallineamento: ogni frame integro che inizia almeno
+// BENCH_PARSER_RESYNC byte dopo l'ultimo danno deve uscire
+// identico. Esito != 0 altrimenti (e, sul flusso sintetico, se la
+// passata pulita non restituisce esattamente i frame generati).
+#define BENCH_PARSER_FRAMES   100000
+#define BENCH_PARSER_NOISE    (4u << 20)
+#define BENCH_PARSER_CHUNK    64          // pezzo massimo letto dalla UART
+#define BENCH_PARSER_RESYNC   160         // due frame ACK di lunghezza massima
+
+// Impronta del contenuto di un frame (confronto tra passate)
+static uint64_t benchFrameKey(const LD2420Frame& f) {
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](uint32_t v) { h = (h ^ v) * 1099511628211ull; };
+    mix(f.type);
+    if (f.type == LD2420_FRAME_ACK) {
+        mix(f.ackCmd);
+        mix(f.ackStatus);
+        mix(f.ackLen);
+        for (uint8_t i = 0; i < f.ackLen; i++) mix(f.ackData[i]);
+        return h;
+    }
+    mix(f.presence);
+    mix(f.distance_cm);
+    if (f.type == LD2420_FRAME_ENGINEERING) {
+        for (int g = 0; g < LD2420_GATE_COUNT; g++) mix(f.energy[g]);
+    }
+    return h;
+}
+
+// Frame sintetici: 60% engineering, 30% report testo, 10% ACK
+static std::vector<uint8_t> benchParserStream() {
+    static const uint8_t ENG_HEAD[4] = {0xF4, 0xF3, 0xF2, 0xF1};
+    static const uint8_t ENG_FOOT[4] = {0xF8, 0xF7, 0xF6, 0xF5};
+    static const uint8_t ACK_HEAD[4] = {0xFD, 0xFC, 0xFB, 0xFA};
+    static const uint8_t ACK_FOOT[4] = {0x04, 0x03, 0x02, 0x01};
+    std::vector<uint8_t> s;
+    auto put   = [&s](const uint8_t* p, size_t n) { s.insert(s.end(), p, p + n); };
+    auto put16 = [&s](uint16_t v) { s.push_back(v & 0xFF); s.push_back(v >> 8); };
+
+    for (uint32_t i = 0; i < BENCH_PARSER_FRAMES; i++) {
+        uint32_t kind = benchNext() % 10;
+        if (kind < 6) {
+            put(ENG_HEAD, 4);
+            put16(1 + 2 + 2 * LD2420_GATE_COUNT);
+            s.push_back(benchNext() & 1);
+            put16(benchNext() % 800);
+            for (int g = 0; g < LD2420_GATE_COUNT; g++) put16(benchNext() % 40000);
+            put(ENG_FOOT, 4);
+        } else if (kind < 9) {
+            char line[24];
+            int  n = (benchNext() & 1) ? snprintf(line, sizeof(line), "ON\r\nRange %u\r\n", benchNext() % 800)
+                                       : snprintf(line, sizeof(line), "OFF\r\n");
+            put((const uint8_t*)line, n);
+        } else {
+            uint8_t dataLen = benchNext() % 9;
+            put(ACK_HEAD, 4);
+            put16(4 + dataLen);
+            put16(LD2420_CMD_WRITE_SYS | 0x0100);
+            put16(benchNext() % 4 == 0);
+            for (uint8_t k = 0; k < dataLen; k++) s.push_back(benchNext());
+            put(ACK_FOOT, 4);
+        }
+    }
+    return s;
+}
+
+struct BenchFrameAt {
+    size_t   end;               // offset dopo l'ultimo byte del frame
+    uint64_t key;
+};
+
+// Passa s al parser a pezzi casuali; out opzionale
+static uint32_t benchParse(LD2420Parser& p, const uint8_t* s, size_t n,
+                           std::vector<BenchFrameAt>* out) {
+    LD2420Frame f = {};
+    uint32_t    frames = 0;
+    size_t      off = 0;
+    while (off < n) {
+        size_t end = off + 1 + benchNext() % BENCH_PARSER_CHUNK;
+        if (end > n) end = n;
+        while (off < end) {
+            off += p.feed(s + off, end - off, f);
+            if (f.type == LD2420_FRAME_NONE) continue;
+            frames++;
+            if (out) out->push_back({off, benchFrameKey(f)});
+        }
+    }
+    return frames;
+}
+
+// Frame attesi usciti identici (stessa fine nel flusso, stessa
+// impronta); i frame spuri in got sono ignorati
+static uint32_t benchMatched(const std::vector<BenchFrameAt>& want, const std::vector<BenchFrameAt>& got) {
+    uint32_t n = 0;
+    size_t   g = 0;
+    for (const BenchFrameAt& w : want) {
+        while (g < got.size() && got[g].end < w.end) g++;
+        if (g < got.size() && got[g].end == w.end && got[g].key == w.key) n++;
+    }
+    return n;
+}
+
+static int runBenchParser(FILE* in) {
+    bool ok = true;
+
+    std::vector<uint8_t> clean;
+    if (in) {
+        uint8_t buf[4096];
+        size_t  n;
+        while ((n = fread(buf, 1, sizeof(buf), in)) > 0) clean.insert(clean.end(), buf, buf + n);
+    } else {
+        clean = benchParserStream();
+    }
+
+    // Riferimento: frame e confini del flusso pulito
+    std::vector<BenchFrameAt> ref;
+    LD2420Parser refParser;
+    benchParse(refParser, clean.data(), clean.size(), &ref);
+    const LD2420ParserStats& rs = refParser.stats();
+
+    printf("---- AutoGuard bench parser ----\n");
+    printf("Flusso:        %s, %.1f MB, %zu frame (%u engineering, %u report, %u ACK)\n",
+        in ? "cattura" : "sintetico", clean.size() / 1048576.0, ref.size(),
+        rs.engineeringFrames, rs.reportFrames, rs.ackFrames);
+    if (!in && (ref.size() != BENCH_PARSER_FRAMES || rs.framingErrors || rs.resyncBytes)) {
+        printf("ERRORE: attesi %u frame senza errori (errori %u, byte scartati %u)\n",
+            BENCH_PARSER_FRAMES, rs.framingErrors, rs.resyncBytes);
+        ok = false;
+    }
+
+    // Pulito: costo
+    LD2420Parser clk;
+    auto     c0     = std::chrono::steady_clock::now();
+    uint32_t frames = benchParse(clk, clean.data(), clean.size(), nullptr);
+    auto     c1     = std::chrono::steady_clock::now();
+    double   ns     = std::chrono::duration<double, std::nano>(c1 - c0).count();
+    printf("Pulito:        %u frame, %u errori di framing, %.1f ns/frame, %.2f ns/byte (host)\n",
+        frames, clk.stats().framingErrors, frames ? ns / frames : 0.0, ns / clean.size());
+    if (frames != ref.size()) ok = false;
+
+    // Casuale, poi il flusso pulito
+    std::vector<uint8_t> noise(BENCH_PARSER_NOISE);
+    for (uint8_t& b : noise) b = benchNext();
+    LD2420Parser rnd;
+    c0 = std::chrono::steady_clock::now();
+    uint32_t spurious = benchParse(rnd, noise.data(), noise.size(), nullptr);
+    c1 = std::chrono::steady_clock::now();
+    ns = std::chrono::duration<double, std::nano>(c1 - c0).count();
+
+    std::vector<BenchFrameAt> got, want;
+    benchParse(rnd, clean.data(), clean.size(), &got);
+    for (size_t i = 0; i < ref.size(); i++) {
+        if ((i ? ref[i - 1].end : 0) >= BENCH_PARSER_RESYNC) want.push_back(ref[i]);
+    }
+    uint32_t kept = benchMatched(want, got);
+    uint32_t lost = ref.size() - benchMatched(ref, got);
+    printf("Casuale:       %.1f MB, %.2f ns/byte, %u frame spuri, %u errori di framing\n",
+        noise.size() / 1048576.0, ns / noise.size(), spurious, rnd.stats().framingErrors);
+    printf("  poi pulito:  %u frame persi, riallineamento %s\n",
+        lost, kept == want.size() ? "ok" : "ERRORE");
+    if (kept != want.size()) ok = false;
+
+    // Corrotto: frame troncati o alterati
+    std::vector<uint8_t>      bad;
+    std::vector<BenchFrameAt> intact;
+    size_t   lastDamage = 0;
+    bool     damaged    = false;
+    uint32_t truncated = 0, flipped = 0;
+    want.clear();
+    bad.reserve(clean.size());
+    for (size_t i = 0; i < ref.size(); i++) {
+        size_t from = i ? ref[i - 1].end : 0;
+        size_t len  = ref[i].end - from;
+        size_t out  = bad.size();
+        uint32_t r  = benchNext() % 16;
+        if (r == 0) {
+            bad.insert(bad.end(), clean.begin() + from, clean.begin() + from + benchNext() % len);
+            truncated++;
+        } else {
+            bad.insert(bad.end(), clean.begin() + from, clean.begin() + ref[i].end);
+            if (r == 1) {
+                bad[out + benchNext() % len] ^= 1 + benchNext() % 255;
+                flipped++;
+            }
+        }
+        if (r <= 1) {
+            lastDamage = out;
+            damaged    = true;
+            continue;
+        }
+        intact.push_back({bad.size(), ref[i].key});
+        if (!damaged || out - lastDamage >= BENCH_PARSER_RESYNC) want.push_back(intact.back());
+    }
+    LD2420Parser cor;
+    got.clear();
+    benchParse(cor, bad.data(), bad.size(), &got);
+
+    kept = benchMatched(want, got);
+    lost = intact.size() - benchMatched(intact, got);
+    printf("Corrotto:      %u troncati, %u alterati, %u errori di framing\n",
+        truncated, flipped, cor.stats().framingErrors);
+    printf("  integri:     %zu, persi %u (%.2f per danno), riallineamento %s\n",
+        intact.size(), lost, (double)lost / (truncated + flipped),
+        kept == want.size() ? "ok" : "ERRORE");
+    if (kept != want.size()) ok = false;
+
+    if (!ok) printf("ERRORE: criteri non rispettati\n");
+    return ok ? 0 : 1;
+}
+
+// ============================================================
+// main()
+// ============================================================
+int main(int argc, char** argv) {
+    bool        arm     = false;
+    bool        quiet   = false;
+    bool        replay  = false;
+    bool        benchParser = false;
+    bool        benchFilter = false;
+    bool        benchAlarm = false;
+    bool        benchDetector = false;
+    bool        benchTracker = false;
+    bool        benchFusion = false;
+    bool        benchZones = false;
+    bool        benchTelemetry = false;
+    bool        benchBatch = false;
+    std::vector<const char*> paths;
+    const char* recPath = nullptr;
+    const char* path    = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if      (!strcmp(argv[i], "--arm"))    arm    = true;
+        else if (!strcmp(argv[i], "--quiet"))  quiet  = true;
+        else if (!strcmp(argv[i], "--replay")) replay = true;
+        else if (!strcmp(argv[i], "--bench-parser")) benchParser = true;
+        else if (!strcmp(argv[i], "--bench-filter")) benchFilter = true;
+        else if (!strcmp(argv[i], "--bench-alarm")) benchAlarm = true;
+        else if (!strcmp(argv[i], "--bench-detector")) benchDetector = true;
+        else if (!strcmp(argv[i], "--bench-tracker")) benchTracker = true;
+        else if (!strcmp(argv[i], "--bench-fusion")) benchFusion = true;
+        else if (!strcmp(argv[i], "--bench-zones")) benchZones = true;
+        else if (!strcmp(argv[i], "--bench-telemetry")) benchTelemetry = true;
+        else if (!strcmp(argv[i], "--bench-batch")) benchBatch = true;
+        else if (!strcmp(argv[i], "--record") && i + 1 < argc) recPath = argv[++i];
+        else                                   paths.push_back(path = argv[i]);
+    }
+
+    if (benchTelemetry) {
+        halNativeUseVirtualClock(true);
+        halNativeSetLogEnabled(false);
+        configMgr.begin();
+        return runBenchTelemetry();
+    }
+    if (benchZones) {
+        halNativeSetLogEnabled(false);
+        configMgr.begin();
+        return runBenchZones();
+    }
+    if (benchFusion) {
+        halNativeUseVirtualClock(true);
+        halNativeSetLogEnabled(false);
+        configMgr.begin();
+        return runBenchFusion();
+    }
+    if (benchTracker) {
+        halNativeSetLogEnabled(false);
+        configMgr.begin();
+        return runBenchTracker();
+    }
+    if (benchDetector) {
+        halNativeUseVirtualClock(true);
+        halNativeSetLogEnabled(false);
+        configMgr.begin();
+        return runBenchDetector(paths);
+    }
+    if (benchBatch) {
+        FILE* trace = path ? fopen(path, "rb") : nullptr;
+        if (path && !trace) {
+            fprintf(stderr, "Impossibile aprire %s\n", path);
+            return 1;
+        }
+        halNativeSetLogEnabled(false);
+        configMgr.begin();
+        int rc = runBenchBatch(trace);
+        if (trace) fclose(trace);
+        return rc;
+    }
+    if (benchFilter) {
+        halNativeSetLogEnabled(false);
+        configMgr.begin();
+        return runBenchFilter();
+    }
+    if (benchParser) {
+        FILE* capture = path ? fopen(path, "rb") : nullptr;
+        if (path && !capture) {
+            fprintf(stderr, "Impossibile aprire %s\n", path);
+            return 1;
+        }
+        halNativeSetLogEnabled(false);
+        int rc = runBenchParser(capture);
+        if (capture) fclose(capture);
+        return rc;
+    }
+    if (benchAlarm) {
+        FILE* trace = path ? fopen(path, "rb") : nullptr;
+        if (path && !trace) {
+            fprintf(stderr, "Impossibile aprire %s\n", path);
+            return 1;
+        }
+        halNativeUseVirtualClock(true);
+        halNativeSetLogEnabled(false);     // log e printf falserebbero i tempi
+        configMgr.begin();
+        int rc = runBenchAlarm(trace);
+        if (trace) fclose(trace);
+        return rc;
+    }
+
+    FILE* in = path ? fopen(path, "rb") : stdin;
+    if (!in) {
+        fprintf(stderr, "Impossibile aprire %s\n", path);
+        return 1;
+    }
+    FILE* rec = nullptr;
+    if (recPath && !(rec = fopen(recPath, "wb"))) {
+        fprintf(stderr, "Impossibile creare %s\n", recPath);
+        return 1;
+    }
+
+    halNativeUseVirtualClock(true);
+    halNativeSetLogEnabled(!quiet);
+    configMgr.begin();
+
+    int rc = replay ? runReplay(in, arm) : runCapture(in, arm, rec);
+
+    if (in != stdin) fclose(in);
+    if (rec) fclose(rec);
+    return rc;
+}
+
+#endif // !ARDUINO && !PIO_UNIT_TESTING
@@ -0,0 +1,545 @@
+// ============================================================
+// AutoGuard - Client MQTT 3.1.1 asincrono - Implementazione
+// ============================================================
+#include "mqtt_async.h"
+#include <string.h>
+
+// Tipi pacchetto (nibble alto del primo byte)
+#define PKT_CONNECT     0x10
+#define PKT_CONNACK     0x20
+#define PKT_PUBLISH     0x30
+#define PKT_PUBACK      0x40
+#define PKT_SUBSCRIBE   0x82    // flag riservati 0010
+#define PKT_SUBACK      0x90
+#define PKT_PINGREQ     0xC0
+#define PKT_PINGRESP    0xD0
+
+#define TX_MASK         (MQTT_TX_QUEUE_SIZE - 1)
+#define TOPIC_MAX       128
+
+enum { EVT_NONE = 0, EVT_CONNECTED, EVT_DISCONNECTED };
+
+static const char* const STATE_NAMES[] = {
+    "DISCONNECTED", "TCP_CONNECTING", "CONNECTING", "CONNECTED", "BACKOFF"
+};
+
+// Byte della lunghezza rimanente (varint 1..4 byte)
+static inline size_t varintLen(uint32_t v) {
+    return v < 128 ? 1 : v < 16384 ? 2 : v < 2097152 ? 3 : 4;
+}
+
+// ============================================================
+// Costruttore
+// ============================================================
+AsyncMqtt::AsyncMqtt() :
+    _host(nullptr),
+    _port(1883),
+    _clientId(""),
+    _user(nullptr),
+    _pass(nullptr),
+    _willTopic(nullptr),
+    _willPayload(nullptr),
+    _willQos(0),
+    _willRetain(false),
+    _keepAliveS(MQTT_KEEPALIVE_S),
+    _msgCb(nullptr),
+    _msgCtx(nullptr),
+    _connCb(nullptr),
+    _connCtx(nullptr),
+    _ackCb(nullptr),
+    _ackCtx(nullptr),
+    _state(MQTT_STATE_DISCONNECTED),
+    _stateStart(0),
+    _retryDelay(0),
+    _lastTx(0),
+    _lastRx(0),
+    _pingPending(false),
+    _packetId(0),
+    _backoff(MQTT_BACKOFF_MIN_MS, MQTT_BACKOFF_MAX_MS, MQTT_BACKOFF_JITTER_PCT),
+    _tcpEvent(EVT_NONE),
+    _rxOverrun(false),
+    _txHead(0),
+    _txTail(0),
+    _txWrite(0),
+    _txRemaining(0),
+    _rxType(0),
+    _rxLen(0),
+    _rxPos(0),
+    _rxLenShift(0),
+    _rxStage(0)
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+// ============================================================
+// Configurazione
+// ============================================================
+void AsyncMqtt::setServer(const char* host, uint16_t port) {
+    _host = host;
+    _port = port;
+}
+
+void AsyncMqtt::setCredentials(const char* clientId, const char* user, const char* pass) {
+    _clientId = clientId;
+    _user     = (user && *user) ? user : nullptr;
+    _pass     = (pass && *pass) ? pass : nullptr;
+}
+
+void AsyncMqtt::setWill(const char* topic, const char* payload, uint8_t qos, bool retain) {
+    _willTopic   = topic;
+    _willPayload = payload;
+    _willQos     = qos > 2 ? 2 : qos;
+    _willRetain  = retain;
+}
+
+void AsyncMqtt::setKeepAlive(uint16_t seconds) {
+    _keepAliveS = seconds;
+}
+
+void AsyncMqtt::onMessage(MqttMessageCb cb, void* ctx) {
+    _msgCb  = cb;
+    _msgCtx = ctx;
+}
+
+void AsyncMqtt::onConnect(MqttConnectCb cb, void* ctx) {
+    _connCb  = cb;
+    _connCtx = ctx;
+}
+
+void AsyncMqtt::onAck(MqttAckCb cb, void* ctx) {
+    _ackCb  = cb;
+    _ackCtx = ctx;
+}
+
+// ============================================================
+// begin()
+// ============================================================
+void AsyncMqtt::begin() {
+    _backoff.seed((uint32_t)halMicros() ^ 0x5A5A5A5A);
+    _tcp.onEvent(_onTcpEvent, this);
+    _tcp.onData(_onTcpData, this);
+    halLog.printf("[MQTT] Broker: %s:%u\n", _host, (unsigned)_port);
+}
+
+// ------------------------------------------------------------
+// Callback TCP (task AsyncTCP): solo flag atomico e ring SPSC
+// ------------------------------------------------------------
+void AsyncMqtt::_onTcpEvent(HalTcpEvent evt, void* ctx) {
+    AsyncMqtt* self = static_cast<AsyncMqtt*>(ctx);
+    self->_tcpEvent.store(evt == HAL_TCP_EVT_CONNECTED ? EVT_CONNECTED : EVT_DISCONNECTED,
+                          std::memory_order_release);
+}
+
+// Ring pieno: il resto del segmento è perso e il framing MQTT non
+// è più recuperabile. Si scarta tutto fino alla chiusura in update()
+void AsyncMqtt::_onTcpData(const uint8_t* data, size_t len, void* ctx) {
+    AsyncMqtt* self = static_cast<AsyncMqtt*>(ctx);
+    if (self->_rxOverrun.load(std::memory_order_acquire)) return;
+    for (size_t i = 0; i < len; i++) {
+        if (!self->_rx.push(data[i])) {
+            self->_rxOverrun.store(true, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+// ============================================================
+// update() - Macchina a stati, mai bloccante
+// ============================================================
+void AsyncMqtt::update() {
+    uint8_t  evt = _tcpEvent.exchange(EVT_NONE, std::memory_order_acq_rel);
+    uint32_t now = halMillis();
+
+    switch (_state) {
+        case MQTT_STATE_DISCONNECTED:
+            if (halWifiIsConnected()) _startAttempt();
+            break;
+
+        case MQTT_STATE_BACKOFF:
+            if (now - _stateStart >= _retryDelay) {
+                if (halWifiIsConnected()) _startAttempt();
+                else _state = MQTT_STATE_DISCONNECTED;
+            }
+            break;
+
+        case MQTT_STATE_TCP_CONNECTING:
+            if (evt == EVT_CONNECTED) {
+                _resetSession();
+                _sendConnect();
+                _state = MQTT_STATE_CONNECTING;
+            } else if (evt == EVT_DISCONNECTED) {
+                _fail("Connessione TCP rifiutata");
+            } else if (now - _stateStart > MQTT_CONNECT_TIMEOUT_MS) {
+                _fail("Timeout TCP");
+            }
+            break;
+
+        case MQTT_STATE_CONNECTING:
+            if (evt == EVT_DISCONNECTED) { _fail("Chiuso prima del CONNACK"); break; }
+            if (_rxOverrun.load(std::memory_order_acquire)) { _fail("Ring RX pieno"); break; }
+            _processRx();
+            if (_state == MQTT_STATE_CONNECTING &&
+                now - _stateStart > MQTT_CONNECT_TIMEOUT_MS) {
+                _fail("Timeout CONNACK");
+            }
+            break;
+
+        case MQTT_STATE_CONNECTED: {
+            if (evt == EVT_DISCONNECTED) { _fail("Link perso"); break; }
+            if (_rxOverrun.load(std::memory_order_acquire)) { _fail("Ring RX pieno"); break; }
+            _processRx();
+            if (_state != MQTT_STATE_CONNECTED || _keepAliveS == 0) break;
+
+            uint32_t keepMs = (uint32_t)_keepAliveS * 1000;
+            if (now - _lastRx > keepMs + keepMs / 2) {
+                _fail("Keepalive scaduto");
+                break;
+            }
+            // PINGREQ anche con TX continuo: serve traffico in arrivo
+            if (!_pingPending && (now - _lastTx >= keepMs / 2 || now - _lastRx >= keepMs / 2) &&
+                _reserve(2)) {
+                _putByte(PKT_PINGREQ);
+                _putByte(0);
+                _commit();
+                _pingPending = true;
+            }
+            break;
+        }
+    }
+
+    if (_state == MQTT_STATE_CONNECTING || _state == MQTT_STATE_CONNECTED) {
+        _flushTx();
+    }
+}
+
+// ============================================================
+// Tentativi e backoff (backoff.h)
+// ============================================================
+void AsyncMqtt::_startAttempt() {
+    _state      = MQTT_STATE_TCP_CONNECTING;
+    _stateStart = halMillis();
+    if (!_tcp.connect(_host, _port)) _fail("Connect TCP non avviato");
+}
+
+void AsyncMqtt::_fail(const char* reason) {
+    _tcp.close();
+    _stats.failures++;
+    _retryDelay = _backoff.next();
+    _state      = MQTT_STATE_BACKOFF;
+    _stateStart = halMillis();
+    _txTail     = _txHead = _txWrite;
+    _txRemaining = 0;
+    halLog.printf("[MQTT] %s, nuovo tentativo tra %lums\n", reason, (unsigned long)_retryDelay);
+}
+
+void AsyncMqtt::_resetSession() {
+    uint8_t b;
+    while (_rx.pop(b)) {}
+    _rxOverrun.store(false, std::memory_order_release);
+    _rxStage     = 0;
+    _txHead      = _txTail = _txWrite = 0;
+    _txRemaining = 0;
+    _pingPending = false;
+    _lastTx      = _lastRx = _stateStart = halMillis();
+}
+
+// ------------------------------------------------------------
+// CONNECT (unico pacchetto accodato prima del CONNACK)
+// ------------------------------------------------------------
+void AsyncMqtt::_sendConnect() {
+    uint8_t flags = 0x02;   // clean session
+    uint32_t rem  = 10 + 2 + strlen(_clientId);
+
+    if (_willTopic) {
+        flags |= 0x04 | (_willQos << 3) | (_willRetain ? 0x20 : 0);
+        rem   += 2 + strlen(_willTopic) + 2 + strlen(_willPayload);
+    }
+    if (_user) { flags |= 0x80; rem += 2 + strlen(_user); }
+    if (_pass) { flags |= 0x40; rem += 2 + strlen(_pass); }
+
+    if (!_reserve(1 + varintLen(rem) + rem)) return;
+
+    static const uint8_t PROTO[] = { 0, 4, 'M', 'Q', 'T', 'T', 4 };
+    _putFixedHeader(PKT_CONNECT, rem);
+    _put(PROTO, sizeof(PROTO));
+    _putByte(flags);
+    _putU16(_keepAliveS);
+    _putString(_clientId);
+    if (_willTopic) {
+        _putString(_willTopic);
+        _putString(_willPayload);
+    }
+    if (_user) _putString(_user);
+    if (_pass) _putString(_pass);
+    _commit();
+}
+
+// ============================================================
+// RX - Decodifica incrementale dal ring
+// ============================================================
+void AsyncMqtt::_processRx() {
+    uint8_t b;
+    while (_rx.pop(b)) {
+        switch (_rxStage) {
+            case 0:
+                _rxType     = b;
+                _rxLen      = 0;
+                _rxLenShift = 0;
+                _rxStage    = 1;
+                break;
+
+            case 1:
+                _rxLen |= (uint32_t)(b & 0x7F) << _rxLenShift;
+                _rxLenShift += 7;
+                if (b & 0x80) {
+                    if (_rxLenShift >= 28) { _fail("Lunghezza pacchetto non valida"); return; }
+                    break;
+                }
+                _rxPos   = 0;
+                _rxStage = 2;
+                if (_rxLen == 0) {
+                    _rxStage = 0;
+                    _handlePacket();
+                }
+                break;
+
+            default:
+                // Corpo oltre MQTT_RX_MAX_PACKET: scartato
+                if (_rxPos < MQTT_RX_MAX_PACKET) _rxBuf[_rxPos] = b;
+                if (++_rxPos == _rxLen) {
+                    _rxStage = 0;
+                    if (_rxLen <= MQTT_RX_MAX_PACKET) _handlePacket();
+                    else _stats.rxOversized++;
+                }
+                break;
+        }
+        if (_state != MQTT_STATE_CONNECTING && _state != MQTT_STATE_CONNECTED) return;
+    }
+}
+
+void AsyncMqtt::_handlePacket() {
+    _lastRx = halMillis();
+
+    switch (_rxType & 0xF0) {
+        case PKT_CONNACK: {
+            if (_state != MQTT_STATE_CONNECTING) break;
+            uint8_t rc = _rxLen >= 2 ? _rxBuf[1] : 0xFF;
+            if (rc != 0) {
+                halLog.printf("[MQTT] Connessione rifiutata rc=%u\n", (unsigned)rc);
+                _fail("CONNACK negativo");
+                break;
+            }
+            _state = MQTT_STATE_CONNECTED;
+            _backoff.reset();
+            _stats.connects++;
+            halLog.printf("[MQTT] Connesso dopo %lums\n",
+                (unsigned long)(_lastRx - _stateStart));
+            if (_connCb) _connCb(_connCtx);
+            break;
+        }
+
+        case PKT_PUBLISH: {
+            if (_rxLen < 2) break;
+            uint8_t  qos = (_rxType >> 1) & 0x03;
+            uint16_t tl  = ((uint16_t)_rxBuf[0] << 8) | _rxBuf[1];
+            uint32_t pos = 2 + tl + (qos ? 2 : 0);
+            if (pos > _rxLen || tl >= TOPIC_MAX) break;
+
+            char topic[TOPIC_MAX];
+            memcpy(topic, _rxBuf + 2, tl);
+            topic[tl] = '\0';
+
+            // QoS 1 dal broker: PUBACK (la sottoscrizione è QoS 0)
+            if (qos == 1 && _reserve(4)) {
+                _putByte(PKT_PUBACK);
+                _putByte(2);
+                _put(_rxBuf + 2 + tl, 2);
+                _commit();
+            }
+            if (_msgCb) _msgCb(topic, _rxBuf + pos, _rxLen - pos, _msgCtx);
+            break;
+        }
+
+        case PKT_PUBACK:
+            if (_rxLen >= 2 && _ackCb) {
+                _ackCb(((uint16_t)_rxBuf[0] << 8) | _rxBuf[1], _ackCtx);
+            }
+            break;
+
+        case PKT_PINGRESP:
+            _pingPending = false;
+            break;
+
+        case PKT_SUBACK:
+            if (_rxLen >= 3 && _rxBuf[2] == 0x80) {
+                halLog.println("[MQTT] Sottoscrizione rifiutata dal broker");
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+// ============================================================
+// Publish / Subscribe
+// ============================================================
+bool AsyncMqtt::publish(const char* topic, const char* payload, bool retain) {
+    return publish(topic, (const uint8_t*)payload, strlen(payload), retain);
+}
+
+bool AsyncMqtt::publish(const char* topic, const uint8_t* payload, size_t len, bool retain) {
+    if (!beginPublish(topic, len, retain)) return false;
+    write(payload, len);
+    return endPublish();
+}
+
+uint16_t AsyncMqtt::publishQos1(const char* topic, const uint8_t* payload, size_t len, bool retain) {
+    uint16_t id = _nextPacketId();
+    if (!_beginPublish(topic, len, retain, id)) return 0;
+    write(payload, len);
+    return endPublish() ? id : 0;
+}
+
+bool AsyncMqtt::beginPublish(const char* topic, size_t len, bool retain) {
+    return _beginPublish(topic, len, retain, 0);
+}
+
+// packetId != 0 -> QoS 1
+bool AsyncMqtt::_beginPublish(const char* topic, size_t len, bool retain, uint16_t packetId) {
+    size_t   tl  = strlen(topic);
+    uint32_t rem = 2 + tl + (packetId ? 2 : 0) + len;
+
+    if (!connected() || _txRemaining || !_reserve(1 + varintLen(rem) + rem)) {
+        _stats.dropped++;
+        return false;
+    }
+    _putFixedHeader(PKT_PUBLISH | (packetId ? 0x02 : 0) | (retain ? 0x01 : 0), rem);
+    _putString(topic);
+    if (packetId) _putU16(packetId);
+    _txRemaining = len;
+    return true;
+}
+
+size_t AsyncMqtt::write(const uint8_t* buf, size_t len) {
+    if (len > _txRemaining) len = _txRemaining;
+    _put(buf, len);
+    _txRemaining -= len;
+    return len;
+}
+
+bool AsyncMqtt::endPublish() {
+    if (_txWrite == _txHead) return false;    // nessun beginPublish valido
+    if (_txRemaining) {
+        // Payload incompleto: il messaggio non viene spedito
+        _txWrite     = _txHead;
+        _txRemaining = 0;
+        _stats.dropped++;
+        return false;
+    }
+    _commit();
+    _stats.published++;
+    _flushTx();
+    return true;
+}
+
+bool AsyncMqtt::subscribe(const char* topic) {
+    size_t   tl  = strlen(topic);
+    uint32_t rem = 2 + 2 + tl + 1;
+
+    if (!connected() || _txRemaining || !_reserve(1 + varintLen(rem) + rem)) return false;
+
+    _putFixedHeader(PKT_SUBSCRIBE, rem);
+    _putU16(_nextPacketId());
+    _putString(topic);
+    _putByte(0);    // QoS 0
+    _commit();
+    _flushTx();
+    return true;
+}
+
+uint16_t AsyncMqtt::_nextPacketId() {
+    if (++_packetId == 0) _packetId = 1;
+    return _packetId;
+}
+
+// ============================================================
+// Coda TX
+// ============================================================
+bool AsyncMqtt::_reserve(size_t len) {
+    return MQTT_TX_QUEUE_SIZE - (_txWrite - _txTail) >= len;
+}
+
+void AsyncMqtt::_put(const uint8_t* data, size_t len) {
+    uint32_t idx   = _txWrite & TX_MASK;
+    size_t   first = MQTT_TX_QUEUE_SIZE - idx;
+    if (first > len) first = len;
+
+    memcpy(_tx + idx, data, first);
+    memcpy(_tx, data + first, len - first);
+    _txWrite += len;
+}
+
+void AsyncMqtt::_putByte(uint8_t b) {
+    _tx[_txWrite++ & TX_MASK] = b;
+}
+
+void AsyncMqtt::_putU16(uint16_t v) {
+    _putByte(v >> 8);
+    _putByte(v & 0xFF);
+}
+
+void AsyncMqtt::_putString(const char* s) {
+    size_t len = strlen(s);
+    _putU16((uint16_t)len);
+    _put((const uint8_t*)s, len);
+}
+
+void AsyncMqtt::_putFixedHeader(uint8_t type, uint32_t remaining) {
+    _putByte(type);
+    do {
+        uint8_t b = remaining & 0x7F;
+        remaining >>= 7;
+        if (remaining) b |= 0x80;
+        _putByte(b);
+    } while (remaining);
+}
+
+void AsyncMqtt::_commit() {
+    _txHead = _txWrite;
+    uint32_t used = _txHead - _txTail;
+    if (used > _stats.txHighWater) _stats.txHighWater = used;
+}
+
+// ------------------------------------------------------------
+// _flushTx() - Segmenti contigui fino allo spazio TCP libero
+// ------------------------------------------------------------
+void AsyncMqtt::_flushTx() {
+    while (_txTail != _txHead) {
+        size_t space = _tcp.space();
+        if (space == 0) break;
+
+        uint32_t idx = _txTail & TX_MASK;
+        size_t   n   = _txHead - _txTail;
+        if (n > MQTT_TX_QUEUE_SIZE - idx) n = MQTT_TX_QUEUE_SIZE - idx;
+        if (n > space) n = space;
+
+        size_t w = _tcp.write(_tx + idx, n);
+        if (w == 0) break;
+        _txTail += w;
+        _lastTx  = halMillis();
+    }
+}
+
+// ============================================================
+// Stato
+// ============================================================
+MqttStats AsyncMqtt::getStats() const {
+    MqttStats s  = _stats;
+    s.rxOverruns = _rx.overruns();
+    return s;
+}
+
+const char* AsyncMqtt::getStateName() const {
+    return STATE_NAMES[_state];
+}
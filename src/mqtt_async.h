@@ -0,0 +1,202 @@
+// ============================================================
+// AutoGuard - Client MQTT 3.1.1 asincrono
+// ============================================================
+// Trasporto non bloccante su HalTcpClient (AsyncTCP su ESP32):
+//   - connect TCP, CONNECT/CONNACK e keepalive gestiti da una
+//     macchina a stati avanzata da update(), mai in attesa
+//   - messaggi in uscita codificati in una coda circolare e
+//     trasmessi quando lo stack TCP ha spazio
+//   - byte in arrivo copiati dal task TCP in un ring SPSC e
+//     decodificati nel loop: le callback girano nel loop()
+//   - riconnessione con backoff esponenziale + jitter
+// Publish QoS 0 o 1 (PUBACK notificato, nessun reinvio: sessione
+// pulita, il reinvio spetta al chiamante), subscribe QoS 0, LWT
+// con QoS a scelta. Payload JSON serializzati direttamente nella
+// coda TX (publishJson(), json_writer.h).
+// Non dipende da Arduino: compilabile anche su host.
+// ============================================================
+#ifndef MQTT_ASYNC_H
+#define MQTT_ASYNC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "hal.h"
+#include "config.h"
+#include "backoff.h"
+#include "spsc_ring.h"
+#include "json_writer.h"
+
+enum MqttState {
+    MQTT_STATE_DISCONNECTED = 0,  // attesa rete
+    MQTT_STATE_TCP_CONNECTING,    // connect TCP in corso
+    MQTT_STATE_CONNECTING,        // CONNECT inviato, attesa CONNACK
+    MQTT_STATE_CONNECTED,
+    MQTT_STATE_BACKOFF            // attesa prima del prossimo tentativo
+};
+
+// Messaggio ricevuto (topic terminato da '\0', payload no)
+typedef void (*MqttMessageCb)(const char* topic, const uint8_t* payload,
+                              size_t len, void* ctx);
+
+// Sessione stabilita (CONNACK ok): sottoscrizioni, discovery...
+typedef void (*MqttConnectCb)(void* ctx);
+
+// PUBACK ricevuto per un publish QoS 1
+typedef void (*MqttAckCb)(uint16_t packetId, void* ctx);
+
+struct MqttStats {
+    uint32_t connects;        // sessioni stabilite
+    uint32_t failures;        // tentativi falliti / link persi
+    uint32_t published;       // messaggi accodati
+    uint32_t dropped;         // messaggi scartati (offline o coda piena)
+    uint32_t rxOverruns;      // segmenti RX troncati (ring pieno)
+    uint32_t rxOversized;     // pacchetti oltre MQTT_RX_MAX_PACKET
+    uint32_t txHighWater;     // massimo riempimento coda TX
+};
+
+class AsyncMqtt {
+public:
+    AsyncMqtt();
+
+    // Configurazione (prima di begin)
+    void setServer(const char* host, uint16_t port);
+    void setCredentials(const char* clientId, const char* user, const char* pass);
+    void setWill(const char* topic, const char* payload, uint8_t qos, bool retain);
+    void setKeepAlive(uint16_t seconds);
+    void onMessage(MqttMessageCb cb, void* ctx);
+    void onConnect(MqttConnectCb cb, void* ctx);
+    void onAck(MqttAckCb cb, void* ctx);
+
+    // Registra le callback TCP; la connessione parte da update()
+    void begin();
+
+    // Da chiamare nel loop: connessione, RX, TX, keepalive
+    void update();
+
+    bool connected() const { return _state == MQTT_STATE_CONNECTED; }
+    MqttState getState() const { return _state; }
+    const char* getStateName() const;
+    MqttStats getStats() const;
+    uint32_t queuedBytes() const { return _txHead - _txTail; }
+
+    // Publish QoS 0; false se non connesso o coda piena
+    bool publish(const char* topic, const char* payload, bool retain);
+    bool publish(const char* topic, const uint8_t* payload, size_t len, bool retain);
+
+    // Publish QoS 1: packet id, 0 se non accodato. Conferma via onAck()
+    uint16_t publishQos1(const char* topic, const uint8_t* payload, size_t len, bool retain);
+
+    // Publish a pezzi senza buffer intermedio (lunghezza nota)
+    bool   beginPublish(const char* topic, size_t len, bool retain);
+    size_t write(const uint8_t* buf, size_t len);
+    bool   endPublish();
+
+    // Publish QoS 0 di un JSON serializzato direttamente nella coda
+    // TX: render(JsonWriter&) è chiamata due volte, per misurare e
+    // per scrivere, e deve produrre gli stessi byte. Se la seconda
+    // passata non torna con la prima il messaggio non parte
+    template <typename Render>
+    bool publishJson(const char* topic, bool retain, Render render) {
+        JsonWriter count;
+        render(count);
+        if (!beginPublish(topic, count.length(), retain)) return false;
+        TxSink     sink(*this);
+        JsonWriter out(&sink);
+        render(out);
+        return endPublish();
+    }
+
+    // Sottoscrizione QoS 0
+    bool subscribe(const char* topic);
+
+private:
+    // Payload JSON verso write()
+    class TxSink : public JsonSink {
+    public:
+        explicit TxSink(AsyncMqtt& mqtt) : _mqtt(mqtt) {}
+        void write(const char* data, size_t len) override {
+            _mqtt.write((const uint8_t*)data, len);
+        }
+    private:
+        AsyncMqtt& _mqtt;
+    };
+
+    // Configurazione
+    const char*     _host;
+    uint16_t        _port;
+    const char*     _clientId;
+    const char*     _user;
+    const char*     _pass;
+    const char*     _willTopic;
+    const char*     _willPayload;
+    uint8_t         _willQos;
+    bool            _willRetain;
+    uint16_t        _keepAliveS;
+
+    MqttMessageCb   _msgCb;
+    void*           _msgCtx;
+    MqttConnectCb   _connCb;
+    void*           _connCtx;
+    MqttAckCb       _ackCb;
+    void*           _ackCtx;
+
+    // Connessione
+    HalTcpClient    _tcp;
+    MqttState       _state;
+    uint32_t        _stateStart;
+    uint32_t        _retryDelay;
+    uint32_t        _lastTx;        // ultimo invio (keepalive)
+    uint32_t        _lastRx;        // ultima ricezione
+    bool            _pingPending;
+    uint16_t        _packetId;
+    ExpBackoff      _backoff;
+    MqttStats       _stats;
+
+    // Ultimo evento TCP (scritto nel task TCP)
+    std::atomic<uint8_t> _tcpEvent;
+    // Ring RX pieno: flusso desincronizzato, sessione da chiudere
+    std::atomic<bool>    _rxOverrun;
+
+    static_assert((MQTT_TX_QUEUE_SIZE & (MQTT_TX_QUEUE_SIZE - 1)) == 0,
+                  "MQTT_TX_QUEUE_SIZE deve essere potenza di 2");
+
+    // Coda TX (solo loop): indici liberi, mascherati in uso
+    uint8_t         _tx[MQTT_TX_QUEUE_SIZE];
+    uint32_t        _txHead;        // fine dati committati
+    uint32_t        _txTail;        // prossimo byte da inviare
+    uint32_t        _txWrite;       // scrittura in corso (beginPublish)
+    size_t          _txRemaining;   // byte attesi prima di endPublish
+
+    // RX: task TCP -> loop
+    SpscRing<uint8_t, MQTT_RX_RING_SIZE> _rx;
+    uint8_t         _rxBuf[MQTT_RX_MAX_PACKET];
+    uint8_t         _rxType;
+    uint32_t        _rxLen;         // lunghezza rimanente dichiarata
+    uint32_t        _rxPos;
+    uint8_t         _rxLenShift;
+    uint8_t         _rxStage;       // 0=tipo 1=lunghezza 2=corpo
+
+    static void _onTcpEvent(HalTcpEvent evt, void* ctx);
+    static void _onTcpData(const uint8_t* data, size_t len, void* ctx);
+
+    void   _startAttempt();
+    void   _fail(const char* reason);
+    void   _sendConnect();
+    void   _processRx();
+    void   _handlePacket();
+    void   _flushTx();
+    void   _resetSession();
+    bool   _beginPublish(const char* topic, size_t len, bool retain, uint16_t packetId);
+    uint16_t _nextPacketId();
+
+    bool   _reserve(size_t len);
+    void   _put(const uint8_t* data, size_t len);
+    void   _putByte(uint8_t b);
+    void   _putU16(uint16_t v);
+    void   _putString(const char* s);
+    void   _putFixedHeader(uint8_t type, uint32_t remaining);
+    void   _commit();
+};
+
+#endif // MQTT_ASYNC_H
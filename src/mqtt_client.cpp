@@ -2,67 +2,145 @@
 // AutoGuard - MQTT Client - Implementazione
 // ============================================================
 #include "mqtt_client.h"
+#include <LittleFS.h>
 
-AutoGuardMQTT* AutoGuardMQTT::_instance = nullptr;
+// Chiave NVS: hash della discovery pubblicata
+#define KEY_DISCOVERY_HASH  "disc_hash"
+
+// Compattazione outbox: file nuovo, poi rename sul log
+#define OUTBOX_TMP_PATH     OUTBOX_FILE_PATH ".tmp"
 
 // ============================================================
 // Costruttore
 // ============================================================
-AutoGuardMQTT::AutoGuardMQTT(AlarmLogic& alarmSys, SensorLD2420& radar) :
-    _mqtt(_wifiClient),
+AutoGuardMQTT::AutoGuardMQTT(AlarmLogic& alarmSys, SensorLD2420& radar, RadarFusion& fusion) :
     _alarmSys(alarmSys),
     _radar(radar),
-    _lastPublish(0),
-    _lastReconnect(0)
-{
-    _instance = this;
-}
+    _fusion(fusion),
+    _lastMetrics(0),
+    _lastEnergySeq(0),
+    _eventOverflows(0)
+{}
 
 // ============================================================
-// begin()
+// begin() - Connessione gestita in background da AsyncMqtt
 // ============================================================
-bool AutoGuardMQTT::begin() {
+void AutoGuardMQTT::begin() {
     _mqtt.setServer(MQTT_BROKER, MQTT_PORT);
-    _mqtt.setCallback(_onMessage);
-    _mqtt.setKeepAlive(30);
-    _mqtt.setBufferSize(1024); // Discovery JSON è grande
-    Serial.printf("[MQTT] Broker: %s:%d\n", MQTT_BROKER, MQTT_PORT);
-    return _connect();
+    _mqtt.setCredentials(MQTT_CLIENT_ID, MQTT_USER, MQTT_PASS);
+    _mqtt.setWill(MQTT_TOPIC_STATUS,
+        "{\"state\":\"OFFLINE\",\"device\":\"" MQTT_CLIENT_ID "\"}", 1, true);
+    _mqtt.setKeepAlive(MQTT_KEEPALIVE_S);
+    _mqtt.onMessage(_onMessage, this);
+    _mqtt.onConnect(_onConnected, this);
+    _mqtt.onAck(_onAck, this);
+    _restoreOutbox();
+
+    HalKvStore prefs;
+    uint32_t   published = 0;
+    prefs.begin(NVS_NAMESPACE, true);
+    prefs.getBytes(KEY_DISCOVERY_HASH, &published, sizeof(published));
+    prefs.end();
+    _discovery.begin(published);
+    Serial.printf("[MQTT] Discovery %s (hash %08lx)\n",
+        _discovery.pending() ? "da pubblicare" : "già nel broker", (unsigned long)MQTT_DISCOVERY_HASH);
+
+    _mqtt.begin();
 }
 
 // ============================================================
-// _connect()
+// _onConnected() - Sessione stabilita (dal loop)
 // ============================================================
-bool AutoGuardMQTT::_connect() {
-    if (!WiFi.isConnected()) {
-        Serial.println("[MQTT] WiFi non disponibile");
-        return false;
-    }
+void AutoGuardMQTT::_onConnected(void* ctx) {
+    AutoGuardMQTT* self = static_cast<AutoGuardMQTT*>(ctx);
+
+    // Alert non confermati nella sessione precedente: ripubblicati
+    // per primi, prima della discovery
+    self->_outbox.rewind();
+    self->_outbox.drain(self->_mqtt, MQTT_TOPIC_ALERT);
+
+    self->_mqtt.subscribe(MQTT_TOPIC_CMD);
+    self->_mqtt.subscribe(MQTT_TOPIC_HA_STATUS);
+    Serial.printf("[MQTT] Subscribed: %s, %s\n", MQTT_TOPIC_CMD, MQTT_TOPIC_HA_STATUS);
+
+    // Discovery per Home Assistant: retained, già nel broker se
+    // invariata dall'ultima pubblicazione
+    self->_publishDiscovery();
+
+    // Pubblica stato iniziale
+    self->publishStatus();
+}
 
-    Serial.printf("[MQTT] Connessione a %s...\n", MQTT_BROKER);
+// ============================================================
+// _onAck() - PUBACK degli alert QoS 1
+// ============================================================
+void AutoGuardMQTT::_onAck(uint16_t packetId, void* ctx) {
+    AutoGuardMQTT* self = static_cast<AutoGuardMQTT*>(ctx);
+    self->_outbox.onAck(packetId);
 
-    String lwt = "{\"state\":\"OFFLINE\",\"device\":\"" MQTT_CLIENT_ID "\"}";
+#if OUTBOX_PERSIST
+    if (self->_outbox.needsCompact()) self->_compactOutbox();
+#endif
+}
 
-    bool ok = _mqtt.connect(
-        MQTT_CLIENT_ID, MQTT_USER, MQTT_PASS,
-        MQTT_TOPIC_STATUS, 1, true, lwt.c_str()
-    );
+// ============================================================
+// Outbox su LittleFS
+// ============================================================
+void AutoGuardMQTT::_restoreOutbox() {
+#if OUTBOX_PERSIST
+    _outbox.setLogSink(_outboxLogSink, this);
 
-    if (!ok) {
-        Serial.printf("[MQTT] ERRORE rc=%d\n", _mqtt.state());
-        return false;
+    // Compattazione interrotta: vale il log, il file nuovo si scarta
+    if (LittleFS.exists(OUTBOX_TMP_PATH)) LittleFS.remove(OUTBOX_TMP_PATH);
+
+    size_t fileLen  = 0;
+    bool   restored = true;
+    File   f        = LittleFS.open(OUTBOX_FILE_PATH, "r");
+    if (f) {
+        fileLen = f.size();
+        uint8_t* buf = (uint8_t*)malloc(fileLen ? fileLen : 1);
+        if (buf) {
+            _outbox.restore(buf, f.read(buf, fileLen));
+            free(buf);
+        } else {
+            restored = false;       // il log resta com'è per il prossimo avvio
+        }
+        f.close();
     }
 
-    Serial.println("[MQTT] Connesso!");
-    _mqtt.subscribe(MQTT_TOPIC_CMD);
-    Serial.printf("[MQTT] Subscribed: %s\n", MQTT_TOPIC_CMD);
+    // Voce troncata in coda (reset durante una scrittura) o log
+    // lungo: riscritto con i soli pendenti. Altrimenti si accoda
+    if (restored && (_outbox.logBytes() != fileLen || _outbox.needsCompact())) {
+        _compactOutbox();
+    } else {
+        _outboxFile = LittleFS.open(OUTBOX_FILE_PATH, "a");
+    }
+#endif
+}
 
-    // Pubblica Discovery per Home Assistant
-    _publishDiscovery();
+// Conferma + pendenti in un file nuovo, poi rename() sul log
+// (LittleFS sostituisce la destinazione in modo atomico): un reset
+// in qualsiasi momento lascia un log completo, vecchio o nuovo
+void AutoGuardMQTT::_compactOutbox() {
+    if (_outboxFile) _outboxFile.close();
+    _outboxFile = LittleFS.open(OUTBOX_TMP_PATH, "w");
+    if (_outboxFile) {
+        _outbox.compact();
+        _outboxFile.close();
+        if (!LittleFS.rename(OUTBOX_TMP_PATH, OUTBOX_FILE_PATH)) {
+            Serial.println("[MQTT] WARN: compattazione outbox fallita, log invariato");
+        }
+    }
+    _outboxFile = LittleFS.open(OUTBOX_FILE_PATH, "a");
+}
 
-    // Pubblica stato iniziale
-    publishStatus();
-    return true;
+// Una voce per evento o conferma: flush() la porta su flash
+// (fsync) senza riaprire il file
+void AutoGuardMQTT::_outboxLogSink(const uint8_t* entry, size_t len, void* ctx) {
+    File& f = static_cast<AutoGuardMQTT*>(ctx)->_outboxFile;
+    if (!f) return;
+    f.write(entry, len);
+    f.flush();
 }
 
 // ============================================================
@@ -71,195 +149,96 @@ bool AutoGuardMQTT::_connect() {
 void AutoGuardMQTT::update() {
     uint32_t now = millis();
 
-    if (!_mqtt.connected()) {
-        if (now - _lastReconnect > MQTT_RECONNECT_MS) {
-            _lastReconnect = now;
-            Serial.println("[MQTT] Riconnessione...");
-            _connect();
-        }
-        return;
+    // Connessione, keepalive, RX e TX: mai bloccante
+    _mqtt.update();
+
+    // Cambi di stato: tutti nell'outbox, anche offline
+    AlarmEvent ev;
+    bool       changed = false;
+    while (_alarmSys.readEvent(_eventCursor, ev)) {
+        _outbox.push(ev);
+        changed = true;
+    }
+    if (_eventCursor.overflows != _eventOverflows) {
+        Serial.printf("[MQTT] %lu transizioni perse (coda eventi piena)\n",
+            (unsigned long)(_eventCursor.overflows - _eventOverflows));
+        _eventOverflows = _eventCursor.overflows;
     }
+    if (changed) publishStatus();
 
-    _mqtt.loop();
+    if (!_mqtt.connected()) return;
+
+    _outbox.drain(_mqtt, MQTT_TOPIC_ALERT);
+    _publishDiscovery();
 
-    if (_alarmSys.hasNewEvent()) {
-        AlarmEvent ev = _alarmSys.getLastEvent();
-        _alarmSys.clearNewEvent();
-        publishStatus();
-        _publishAlert(ev);
+    // Campione radar: ai cambiamenti, con limiti e heartbeat
+    RadarData d = _fusion.getData();
+    if (_telemetry.due(d, _alarmSys.getState(), now) && _publishRadar(d)) {
+        _telemetry.sent(d, now);
     }
 
-    if (now - _lastPublish > MQTT_PUBLISH_MS) {
-        _lastPublish = now;
-        _publishRadar();
+    if (now - _lastMetrics > MQTT_METRICS_MS) {
+        _lastMetrics = now;
+        _publishMetrics();
     }
-}
 
-// ============================================================
-// _onMessage() - Comandi da HA o MQTT
-// ============================================================
-void AutoGuardMQTT::_onMessage(char* topic, byte* payload, unsigned int len) {
-    if (!_instance) return;
-
-    char buf[64] = {0};
-    size_t n = (len < sizeof(buf)-1) ? len : sizeof(buf)-1;
-    memcpy(buf, payload, n);
-    String msg = String(buf);
-    msg.trim();
-    msg.toLowerCase();
-
-    Serial.printf("[MQTT] Ricevuto [%s]: %s\n", topic, msg.c_str());
-
-    if      (msg == "arm")    { _instance->_alarmSys.arm();    _instance->publishStatus(); }
-    else if (msg == "disarm") { _instance->_alarmSys.disarm(); _instance->publishStatus(); }
-    else if (msg == "reset")  { _instance->_alarmSys.reset();  _instance->publishStatus(); }
-    else if (msg == "status") { _instance->publishStatus(); }
-    else { Serial.printf("[MQTT] Comando sconosciuto: %s\n", msg.c_str()); }
-}
+    // Storico radar: batch in coda, dal più vecchio
+    _publishRadarBatches();
 
-// ============================================================
-// _publishDiscovery() - Registra entità in Home Assistant
-// ============================================================
-void AutoGuardMQTT::_publishDiscovery() {
-    Serial.println("[MQTT] Pubblicazione MQTT Discovery...");
-
-    // 1. Sensor: Stato sistema
-    _publishDiscoverySensor(
-        "stato", "Stato",
-        MQTT_TOPIC_STATUS, "{{ value_json.state }}",
-        nullptr, nullptr
-    );
-
-    // 2. Sensor: Distanza radar
-    _publishDiscoverySensor(
-        "distanza", "Distanza Radar",
-        MQTT_TOPIC_SENSOR, "{{ value_json.distance }}",
-        "cm", "distance"
-    );
-
-    // 3. Binary sensor: Presenza
-    _publishDiscoveryBinarySensor(
-        "presenza", "Presenza Rilevata",
-        MQTT_TOPIC_SENSOR, "{{ value_json.detected }}",
-        "motion", "True", "False"
-    );
-
-    // 4. Binary sensor: Allarme attivo
-    _publishDiscoveryBinarySensor(
-        "allarme", "Allarme",
-        MQTT_TOPIC_STATUS, "{{ value_json.state }}",
-        "safety", "ALARM", "DISARMED"
-    );
-
-    // 5. Button: Arm
-    _publishDiscoveryButton("arm_btn", "Arma", MQTT_TOPIC_CMD, "arm");
-
-    // 6. Button: Disarm
-    _publishDiscoveryButton("disarm_btn", "Disarma", MQTT_TOPIC_CMD, "disarm");
-
-    // 7. Button: Reset
-    _publishDiscoveryButton("reset_btn", "Reset Allarme", MQTT_TOPIC_CMD, "reset");
-
-    Serial.println("[MQTT] Discovery completata!");
+    // Nuovo batch energie completo (solo in modalità engineering)
+    if (_radar.energyBatch().lastSeq() != _lastEnergySeq) {
+        _publishEnergyBatch();
+    }
 }
 
 // ============================================================
-// _publishDiscoverySensor()
+// _onMessage() - Comandi da HA o MQTT
 // ============================================================
-void AutoGuardMQTT::_publishDiscoverySensor(
-    const char* id, const char* name,
-    const char* stateTopic, const char* valueTemplate,
-    const char* unit, const char* devClass)
-{
-    // Topic: homeassistant/sensor/autoguard_001_stato/config
-    char topic[128];
-    snprintf(topic, sizeof(topic), "%s/sensor/%s_%s/config",
-        MQTT_DISCOVERY_PREFIX, MQTT_DEVICE_ID, id);
-
-    JsonDocument doc;
-    doc["name"]           = name;
-    doc["unique_id"]      = String(MQTT_DEVICE_ID) + "_" + id;
-    doc["state_topic"]    = stateTopic;
-    doc["value_template"] = valueTemplate;
-    if (unit)    doc["unit_of_measurement"] = unit;
-    if (devClass) doc["device_class"]       = devClass;
-
-    // Device info (raggruppa tutte le entità sotto un dispositivo)
-    JsonObject dev = doc["device"].to<JsonObject>();
-    dev["identifiers"][0]  = MQTT_DEVICE_ID;
-    dev["name"]            = MQTT_DEVICE_NAME;
-    dev["model"]           = MQTT_DEVICE_MODEL;
-    dev["manufacturer"]    = MQTT_DEVICE_MANUFACTURER;
-    dev["sw_version"]      = FIRMWARE_VERSION;
-
-    String json;
-    serializeJson(doc, json);
-    bool ok = _mqtt.publish(topic, json.c_str(), true); // retain=true
-    Serial.printf("[MQTT] Discovery sensor '%s': %s\n", id, ok ? "OK" : "FAIL");
-}
+void AutoGuardMQTT::_onMessage(const char* topic, const uint8_t* payload, size_t len, void* ctx) {
+    AutoGuardMQTT* self = static_cast<AutoGuardMQTT*>(ctx);
 
-// ============================================================
-// _publishDiscoveryBinarySensor()
-// ============================================================
-void AutoGuardMQTT::_publishDiscoveryBinarySensor(
-    const char* id, const char* name,
-    const char* stateTopic, const char* valueTemplate,
-    const char* devClass, const char* payloadOn, const char* payloadOff)
-{
-    char topic[128];
-    snprintf(topic, sizeof(topic), "%s/binary_sensor/%s_%s/config",
-        MQTT_DISCOVERY_PREFIX, MQTT_DEVICE_ID, id);
-
-    JsonDocument doc;
-    doc["name"]           = name;
-    doc["unique_id"]      = String(MQTT_DEVICE_ID) + "_" + id;
-    doc["state_topic"]    = stateTopic;
-    doc["value_template"] = valueTemplate;
-    doc["payload_on"]     = payloadOn;
-    doc["payload_off"]    = payloadOff;
-    if (devClass) doc["device_class"] = devClass;
-
-    JsonObject dev = doc["device"].to<JsonObject>();
-    dev["identifiers"][0]  = MQTT_DEVICE_ID;
-    dev["name"]            = MQTT_DEVICE_NAME;
-    dev["model"]           = MQTT_DEVICE_MODEL;
-    dev["manufacturer"]    = MQTT_DEVICE_MANUFACTURER;
-    dev["sw_version"]      = FIRMWARE_VERSION;
-
-    String json;
-    serializeJson(doc, json);
-    bool ok = _mqtt.publish(topic, json.c_str(), true);
-    Serial.printf("[MQTT] Discovery binary_sensor '%s': %s\n", id, ok ? "OK" : "FAIL");
+    // Birth di Home Assistant: discovery ripubblicata dal loop
+    if (self->_discovery.onMessage(topic, payload, len)) {
+        if (self->_discovery.pending()) Serial.println("[MQTT] Home Assistant online: discovery da ripubblicare");
+        return;
+    }
+
+    // Comando in minuscolo senza spazi ai bordi, su buffer fisso
+    char   msg[64];
+    size_t n = 0;
+    while (len && isspace(payload[0]))       { payload++; len--; }
+    while (len && isspace(payload[len - 1])) { len--; }
+    for (; n < len && n < sizeof(msg) - 1; n++) msg[n] = tolower(payload[n]);
+    msg[n] = '\0';
+
+    Serial.printf("[MQTT] Ricevuto [%s]: %s\n", topic, msg);
+
+    if      (!strcmp(msg, "arm"))    { self->_alarmSys.arm();    self->publishStatus(); }
+    else if (!strcmp(msg, "disarm")) { self->_alarmSys.disarm(); self->publishStatus(); }
+    else if (!strcmp(msg, "reset"))  { self->_alarmSys.reset();  self->publishStatus(); }
+    else if (!strcmp(msg, "status")) { self->publishStatus(); }
+    else { Serial.printf("[MQTT] Comando sconosciuto: %s\n", msg); }
 }
 
 // ============================================================
-// _publishDiscoveryButton()
+// _publishDiscovery() - Registra entità in Home Assistant
 // ============================================================
-void AutoGuardMQTT::_publishDiscoveryButton(
-    const char* id, const char* name,
-    const char* cmdTopic, const char* payload)
-{
-    char topic[128];
-    snprintf(topic, sizeof(topic), "%s/button/%s_%s/config",
-        MQTT_DISCOVERY_PREFIX, MQTT_DEVICE_ID, id);
-
-    JsonDocument doc;
-    doc["name"]             = name;
-    doc["unique_id"]        = String(MQTT_DEVICE_ID) + "_" + id;
-    doc["command_topic"]    = cmdTopic;
-    doc["payload_press"]    = payload;
-
-    JsonObject dev = doc["device"].to<JsonObject>();
-    dev["identifiers"][0]  = MQTT_DEVICE_ID;
-    dev["name"]            = MQTT_DEVICE_NAME;
-    dev["model"]           = MQTT_DEVICE_MODEL;
-    dev["manufacturer"]    = MQTT_DEVICE_MANUFACTURER;
-    dev["sw_version"]      = FIRMWARE_VERSION;
-
-    String json;
-    serializeJson(doc, json);
-    bool ok = _mqtt.publish(topic, json.c_str(), true);
-    Serial.printf("[MQTT] Discovery button '%s': %s\n", id, ok ? "OK" : "FAIL");
+// Messaggi costanti in flash (mqtt_discovery.cpp): copiati nella
+// coda TX, ripresi al giro dopo se non c'è spazio
+void AutoGuardMQTT::_publishDiscovery() {
+    if (!_discovery.pending()) return;
+    if (!_discovery.publish(_mqtt)) return;
+
+    // Hash salvato solo se cambiato (il birth di HA non scrive in flash)
+    HalKvStore prefs;
+    uint32_t   published = 0;
+    prefs.begin(NVS_NAMESPACE, false);
+    prefs.getBytes(KEY_DISCOVERY_HASH, &published, sizeof(published));
+    if (published != MQTT_DISCOVERY_HASH) {
+        prefs.putBytes(KEY_DISCOVERY_HASH, &MQTT_DISCOVERY_HASH, sizeof(MQTT_DISCOVERY_HASH));
+    }
+    prefs.end();
+    Serial.printf("[MQTT] Discovery completata (%d entità)\n", MQTT_DISCOVERY_COUNT);
 }
 
 // ============================================================
@@ -267,83 +246,66 @@ void AutoGuardMQTT::_publishDiscoveryButton(
 // ============================================================
 void AutoGuardMQTT::publishStatus() {
     if (!_mqtt.connected()) return;
-    String json = _buildStatusJson();
-    bool ok = _mqtt.publish(MQTT_TOPIC_STATUS, json.c_str(), true);
+
+    // Valori letti una volta: il rendering gira due volte
+    MqttStatusInfo s;
+    IPAddress      ip = WiFi.localIP();
+    s.state    = _alarmSys.getStateName();
+    s.stateId  = (int)_alarmSys.getState();
+    s.uptimeS  = millis() / 1000;
+    s.freeHeap = ESP.getFreeHeap();
+    s.rssi     = WiFi.RSSI();
+    s.radar    = _fusion.getData();
+    s.telemetry = _telemetry.stats();
+    snprintf(s.ip, sizeof(s.ip), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+
+    bool ok = _mqtt.publishJson(MQTT_TOPIC_STATUS, true,
+        [&s](JsonWriter& j) { mqttStatusJson(j, s); });
     Serial.printf("[MQTT] Status publish %s\n", ok ? "OK" : "FAIL");
 }
 
 // ============================================================
 // _publishRadar()
 // ============================================================
-void AutoGuardMQTT::_publishRadar() {
-    if (!_mqtt.connected()) return;
-    String json = _buildRadarJson();
-    _mqtt.publish(MQTT_TOPIC_SENSOR, json.c_str(), false);
+bool AutoGuardMQTT::_publishRadar(const RadarData& d) {
+    return _mqtt.publishJson(MQTT_TOPIC_SENSOR, false, [&d](JsonWriter& j) { mqttRadarJson(j, d); });
 }
 
 // ============================================================
-// _publishAlert()
+// _publishEnergyBatch() - Batch binario energie per gate
 // ============================================================
-void AutoGuardMQTT::_publishAlert(const AlarmEvent& ev) {
-    if (!_mqtt.connected()) return;
+// Segnato come inviato solo se accodato: con coda TX piena o
+// link giù si ritenta al giro dopo
+void AutoGuardMQTT::_publishEnergyBatch() {
+    uint8_t  buf[ENERGY_BATCH_MAX_LEN];
+    uint16_t seq = 0;
+    size_t   len = _radar.energyBatch().copyLast(buf, sizeof(buf), &seq);
+    if (len == 0) return;
 
-    JsonDocument doc;
-    doc["event"]      = "state_change";
-    doc["state"]      = _alarmSys.getStateName();
-    doc["prev_state"] = ev.prevState;
-    doc["zone"]       = (int)ev.zone;
-    doc["distance"]   = ev.distance_cm;
-    doc["timestamp"]  = ev.timestamp;
-    doc["uptime_s"]   = millis() / 1000;
-
-    String json;
-    serializeJson(doc, json);
-    bool ok = _mqtt.publish(MQTT_TOPIC_ALERT, json.c_str(), false);
-    Serial.printf("[MQTT] Alert publish %s: %s\n", ok ? "OK" : "FAIL", json.c_str());
+    if (_mqtt.publish(MQTT_TOPIC_ENERGY, buf, len, false)) _lastEnergySeq = seq;
 }
 
 // ============================================================
-// _buildStatusJson()
+// _publishRadarBatches() - Storico radar (radar_batch.h)
 // ============================================================
-String AutoGuardMQTT::_buildStatusJson() {
-    JsonDocument doc;
-    RadarData d = _radar.getData();
-
-    doc["state"]     = _alarmSys.getStateName();
-    doc["state_id"]  = (int)_alarmSys.getState();
-    doc["device"]    = MQTT_CLIENT_ID;
-    doc["fw"]        = FIRMWARE_VERSION;
-    doc["uptime_s"]  = millis() / 1000;
-    doc["free_heap"] = ESP.getFreeHeap();
-    doc["ip"]        = WiFi.localIP().toString();
-    doc["rssi"]      = WiFi.RSSI();
-
-    JsonObject radar = doc["radar"].to<JsonObject>();
-    radar["detected"] = d.detected;
-    radar["distance"] = d.filtered_dist;
-    radar["zone"]     = (int)d.zone;
-
-    String out;
-    serializeJson(doc, out);
-    return out;
+// Restano in coda se la coda TX è piena: ripresi al giro dopo
+void AutoGuardMQTT::_publishRadarBatches() {
+    size_t         len;
+    const uint8_t* batch;
+    while ((batch = radarBatcher.front(&len)) != nullptr &&
+           _mqtt.publish(MQTT_TOPIC_BATCH, batch, len, false)) {
+        radarBatcher.pop();
+    }
 }
 
 // ============================================================
-// _buildRadarJson()
+// _publishMetrics() - Latenze loop() (dal loop: stabili tra le
+// due passate)
 // ============================================================
-String AutoGuardMQTT::_buildRadarJson() {
-    JsonDocument doc;
-    RadarData d = _radar.getData();
-
-    doc["detected"]  = d.detected;
-    doc["distance"]  = d.filtered_dist;
-    doc["raw_dist"]  = d.distance_cm;
-    doc["zone"]      = (int)d.zone;
-    doc["timestamp"] = d.timestamp;
-
-    String out;
-    serializeJson(doc, out);
-    return out;
+void AutoGuardMQTT::_publishMetrics() {
+#if LOOP_METRICS
+    _mqtt.publishJson(MQTT_TOPIC_METRICS, false, [](JsonWriter& j) { loopMetrics.toJson(j); });
+#endif
 }
 
 // ============================================================
@@ -6,52 +6,61 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <PubSubClient.h>
-#include <ArduinoJson.h>
+#include <FS.h>
 #include "config.h"
+#include "mqtt_async.h"
+#include "mqtt_payloads.h"
+#include "mqtt_discovery.h"
+#include "telemetry_scheduler.h"
+#include "alert_outbox.h"
 #include "alarm_logic.h"
 #include "sensor_ld2420.h"
+#include "radar_fusion.h"
+#include "loop_metrics.h"
+#include "radar_batch.h"
 
 class AutoGuardMQTT {
 public:
-    AutoGuardMQTT(AlarmLogic& alarmSys, SensorLD2420& radar);
+    AutoGuardMQTT(AlarmLogic& alarmSys, SensorLD2420& radar, RadarFusion& fusion);
 
-    bool begin();
+    void begin();
     void update();
     void publishStatus();
     bool isConnected();
 
+    const TelemetryStats& telemetryStats() const { return _telemetry.stats(); }
+
 private:
-    WiFiClient      _wifiClient;
-    PubSubClient    _mqtt;
+    AsyncMqtt       _mqtt;
+    AlertOutbox     _outbox;
+    MqttDiscovery   _discovery;
+    TelemetryScheduler _telemetry;  // quando pubblicare il campione radar
     AlarmLogic&     _alarmSys;
-    SensorLD2420&   _radar;
+    SensorLD2420&   _radar;         // principale: batch energie
+    RadarFusion&    _fusion;        // campioni fusi
 
-    uint32_t _lastPublish;
-    uint32_t _lastReconnect;
+    uint32_t _lastMetrics;
+    uint16_t _lastEnergySeq;
+    EventCursor _eventCursor;      // transizioni lette dall'outbox
+    uint32_t    _eventOverflows;
+    File        _outboxFile;        // log outbox aperto in append
 
-    bool _connect();
+    static void _onConnected(void* ctx);
+    static void _onAck(uint16_t packetId, void* ctx);
 
-    // Discovery
+    // Discovery (solo se cambiata o su richiesta di HA)
     void _publishDiscovery();
-    void _publishDiscoverySensor(const char* id, const char* name,
-                                  const char* stateTopic, const char* valueTemplate,
-                                  const char* unit, const char* devClass);
-    void _publishDiscoveryBinarySensor(const char* id, const char* name,
-                                        const char* stateTopic, const char* valueTemplate,
-                                        const char* devClass, const char* payloadOn,
-                                        const char* payloadOff);
-    void _publishDiscoveryButton(const char* id, const char* name,
-                                  const char* cmdTopic, const char* payload);
 
     // Helpers
-    static void _onMessage(char* topic, byte* payload, unsigned int len);
-    static AutoGuardMQTT* _instance;
+    static void _onMessage(const char* topic, const uint8_t* payload, size_t len, void* ctx);
 
-    void _publishRadar();
-    void _publishAlert(const AlarmEvent& ev);
-    String _buildStatusJson();
-    String _buildRadarJson();
+    bool _publishRadar(const RadarData& d);
+    void _publishEnergyBatch();
+    void _publishRadarBatches();
+    void _publishMetrics();
+    void _restoreOutbox();
+    void _compactOutbox();
+    static void _outboxLogSink(const uint8_t* entry, size_t len, void* ctx);
 };
 
 #endif // MQTT_CLIENT_H
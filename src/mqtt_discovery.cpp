@@ -0,0 +1,95 @@
+// ============================================================
+// AutoGuard - Discovery Home Assistant - Implementazione
+// ============================================================
+#include "mqtt_discovery.h"
+#include <string.h>
+
+// ============================================================
+// Messaggi generati in compilazione
+// ============================================================
+// Le macro finiscono nel JSON senza escape: niente '"' né '\'
+static constexpr bool jsonSafe(const char* s) {
+    for (; *s; s++) if (*s == '"' || *s == '\\') return false;
+    return true;
+}
+
+static_assert(jsonSafe(MQTT_DEVICE_ID) && jsonSafe(MQTT_DEVICE_NAME) &&
+              jsonSafe(MQTT_DEVICE_MODEL) && jsonSafe(MQTT_DEVICE_MANUFACTURER) &&
+              jsonSafe(FIRMWARE_VERSION),
+              "Le macro MQTT_DEVICE_* non possono contenere '\"' o '\\'");
+
+// homeassistant/sensor/autoguard_001_stato/config
+#define DISC_TOPIC(component, id) \
+    MQTT_DISCOVERY_PREFIX "/" component "/" MQTT_DEVICE_ID "_" id "/config"
+
+#define DISC_HEAD(id, name) \
+    "{\"name\":\"" name "\",\"unique_id\":\"" MQTT_DEVICE_ID "_" id "\""
+
+// Device info (raggruppa tutte le entità sotto un dispositivo)
+#define DISC_DEVICE \
+    ",\"device\":{\"identifiers\":[\"" MQTT_DEVICE_ID "\"]," \
+    "\"name\":\"" MQTT_DEVICE_NAME "\"," \
+    "\"model\":\"" MQTT_DEVICE_MODEL "\"," \
+    "\"manufacturer\":\"" MQTT_DEVICE_MANUFACTURER "\"," \
+    "\"sw_version\":\"" FIRMWARE_VERSION "\"}}"
+
+#define DISC_STATE(topic, tpl) \
+    ",\"state_topic\":\"" topic "\",\"value_template\":\"{{ value_json." tpl " }}\""
+
+#define DISC_BUTTON(id, name, cmd) { \
+    DISC_TOPIC("button", id), \
+    DISC_HEAD(id, name) ",\"command_topic\":\"" MQTT_TOPIC_CMD "\",\"payload_press\":\"" cmd "\"" DISC_DEVICE }
+
+constexpr MqttDiscoveryMsg MQTT_DISCOVERY[MQTT_DISCOVERY_COUNT] = {
+    { DISC_TOPIC("sensor", "stato"),
+      DISC_HEAD("stato", "Stato") DISC_STATE(MQTT_TOPIC_STATUS, "state") DISC_DEVICE },
+    { DISC_TOPIC("sensor", "distanza"),
+      DISC_HEAD("distanza", "Distanza Radar") DISC_STATE(MQTT_TOPIC_SENSOR, "distance")
+      ",\"unit_of_measurement\":\"cm\",\"device_class\":\"distance\"" DISC_DEVICE },
+    { DISC_TOPIC("binary_sensor", "presenza"),
+      DISC_HEAD("presenza", "Presenza Rilevata") DISC_STATE(MQTT_TOPIC_SENSOR, "detected")
+      ",\"device_class\":\"motion\",\"payload_on\":\"True\",\"payload_off\":\"False\"" DISC_DEVICE },
+    { DISC_TOPIC("binary_sensor", "allarme"),
+      DISC_HEAD("allarme", "Allarme") DISC_STATE(MQTT_TOPIC_STATUS, "state")
+      ",\"device_class\":\"safety\",\"payload_on\":\"ALARM\",\"payload_off\":\"DISARMED\"" DISC_DEVICE },
+    DISC_BUTTON("arm_btn",    "Arma",          "arm"),
+    DISC_BUTTON("disarm_btn", "Disarma",       "disarm"),
+    DISC_BUTTON("reset_btn",  "Reset Allarme", "reset")
+};
+
+// FNV-1a su topic e payload di tutti i messaggi
+static constexpr uint32_t discoveryHash() {
+    uint32_t h = 2166136261u;
+    for (const MqttDiscoveryMsg& m : MQTT_DISCOVERY) {
+        for (const char* s = m.topic;   *s; s++) h = (h ^ (uint8_t)*s) * 16777619u;
+        for (const char* s = m.payload; *s; s++) h = (h ^ (uint8_t)*s) * 16777619u;
+        h = (h ^ 0xFF) * 16777619u;
+    }
+    return h ? h : 1;           // 0 = mai pubblicato
+}
+
+constexpr uint32_t MQTT_DISCOVERY_HASH = discoveryHash();
+
+// ============================================================
+// Politica di pubblicazione
+// ============================================================
+void MqttDiscovery::begin(uint32_t publishedHash) {
+    _next = publishedHash == MQTT_DISCOVERY_HASH ? MQTT_DISCOVERY_COUNT : 0;
+}
+
+bool MqttDiscovery::onMessage(const char* topic, const uint8_t* payload, size_t len) {
+    if (strcmp(topic, MQTT_TOPIC_HA_STATUS)) return false;
+    if (len == 6 && !memcmp(payload, "online", 6)) _next = 0;
+    return true;
+}
+
+bool MqttDiscovery::publish(AsyncMqtt& mqtt) {
+    if (!pending()) return false;
+    while (_next < MQTT_DISCOVERY_COUNT &&
+           mqtt.publish(MQTT_DISCOVERY[_next].topic, MQTT_DISCOVERY[_next].payload, true)) {
+        _next++;
+    }
+    if (pending()) return false;
+    _rounds++;
+    return true;
+}
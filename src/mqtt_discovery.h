@@ -0,0 +1,62 @@
+// ============================================================
+// AutoGuard - Discovery Home Assistant
+// ============================================================
+// I messaggi di discovery dipendono solo dalle macro di config.h:
+// topic e payload sono concatenati dal preprocessore in stringhe
+// costanti (flash), nessun rendering a runtime. Un hash FNV-1a
+// calcolato in compilazione identifica l'insieme: cambia con la
+// versione firmware (sw_version) e con le macro del dispositivo.
+//
+// Messaggi retained, ripubblicati solo se:
+//   - l'hash differisce da quello salvato dopo l'ultima
+//     pubblicazione completa (primo avvio, firmware nuovo)
+//   - Home Assistant annuncia "online" su MQTT_TOPIC_HA_STATUS
+//     (riavvio di HA o del broker)
+// Una riconnessione normale non ripubblica nulla: il broker li ha
+// già. La pubblicazione riprende dal primo messaggio non accodato
+// (coda TX piena, link perso a metà).
+// Non dipende da Arduino: compilabile anche su host.
+// ============================================================
+#ifndef MQTT_DISCOVERY_H
+#define MQTT_DISCOVERY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+#include "mqtt_async.h"
+
+#define MQTT_DISCOVERY_COUNT    7
+
+struct MqttDiscoveryMsg {
+    const char* topic;
+    const char* payload;
+};
+
+extern const MqttDiscoveryMsg MQTT_DISCOVERY[MQTT_DISCOVERY_COUNT];
+extern const uint32_t         MQTT_DISCOVERY_HASH;
+
+class MqttDiscovery {
+public:
+    MqttDiscovery() : _next(MQTT_DISCOVERY_COUNT), _rounds(0) {}
+
+    // Hash dell'ultima pubblicazione completa (0 = mai)
+    void begin(uint32_t publishedHash);
+
+    // Messaggio ricevuto: true se era sul topic di stato di Home
+    // Assistant ("online" = discovery da ripubblicare)
+    bool onMessage(const char* topic, const uint8_t* payload, size_t len);
+
+    bool     pending() const { return _next < MQTT_DISCOVERY_COUNT; }
+    uint32_t rounds() const  { return _rounds; }
+
+    // Accoda i messaggi mancanti (dal loop, da connessi). true
+    // quando l'insieme è appena stato completato: il chiamante
+    // salva MQTT_DISCOVERY_HASH
+    bool publish(AsyncMqtt& mqtt);
+
+private:
+    uint8_t  _next;             // prossimo messaggio (COUNT = nessuno)
+    uint32_t _rounds;           // pubblicazioni complete
+};
+
+#endif // MQTT_DISCOVERY_H
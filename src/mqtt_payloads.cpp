@@ -0,0 +1,50 @@
+// ============================================================
+// AutoGuard - Payload JSON MQTT - Implementazione
+// ============================================================
+#include "mqtt_payloads.h"
+
+// ============================================================
+// Stato del sistema
+// ============================================================
+void mqttStatusJson(JsonWriter& j, const MqttStatusInfo& s) {
+    j.beginObject()
+     .field("state", s.state)
+     .field("state_id", s.stateId)
+     .field("device", MQTT_CLIENT_ID)
+     .field("fw", FIRMWARE_VERSION)
+     .field("uptime_s", s.uptimeS)
+     .field("free_heap", s.freeHeap)
+     .field("ip", s.ip)
+     .field("rssi", s.rssi)
+     .beginObject("radar")
+        .field("detected", s.radar.detected)
+        .field("distance", s.radar.filtered_dist)
+        .field("zone", (int)s.radar.zone)
+     .endObject()
+     .beginObject("telemetry")
+        .field("sent", s.telemetry.sent)
+        .field("changes", s.telemetry.changes)
+        .field("heartbeats", s.telemetry.heartbeats)
+        .field("suppressed", s.telemetry.filtered + s.telemetry.coalesced)
+        .field("filtered", s.telemetry.filtered)
+        .field("coalesced", s.telemetry.coalesced)
+     .endObject()
+     .endObject();
+}
+
+// ============================================================
+// Campione radar
+// ============================================================
+void mqttRadarJson(JsonWriter& j, const RadarData& d) {
+    j.beginObject()
+     .field("detected", d.detected)
+     .field("distance", d.filtered_dist)
+     .field("raw_dist", d.distance_cm)
+     .field("zone", (int)d.zone)
+     .field("velocity", d.velocity)
+     .field("accel", d.accel)
+     .field("trajectory", (int)d.trajectory)
+     .field("sensor", (int)d.sensor)
+     .field("timestamp", d.timestamp)
+     .endObject();
+}
@@ -0,0 +1,37 @@
+// ============================================================
+// AutoGuard - Payload JSON MQTT
+// ============================================================
+// Rendering dei messaggi MQTT variabili (stato, campione radar)
+// su JsonWriter, da pubblicare con
+// AsyncMqtt::publishJson(): i byte finiscono direttamente nella
+// coda TX, senza documenti né String.
+// I dati variabili sono letti prima in una struttura: il
+// rendering viene chiamato due volte e deve dare gli stessi byte.
+// La discovery Home Assistant è costante: mqtt_discovery.h.
+// Non dipende da Arduino: compilabile anche su host.
+// ============================================================
+#ifndef MQTT_PAYLOADS_H
+#define MQTT_PAYLOADS_H
+
+#include <stdint.h>
+#include "config.h"
+#include "json_writer.h"
+#include "radar_types.h"
+#include "telemetry_scheduler.h"
+
+// Stato del sistema (MQTT_TOPIC_STATUS)
+struct MqttStatusInfo {
+    const char* state;
+    int         stateId;
+    uint32_t    uptimeS;
+    uint32_t    freeHeap;
+    char        ip[16];         // "a.b.c.d"
+    int         rssi;
+    RadarData   radar;
+    TelemetryStats telemetry;
+};
+
+void mqttStatusJson(JsonWriter& j, const MqttStatusInfo& s);
+void mqttRadarJson(JsonWriter& j, const RadarData& d);
+
+#endif // MQTT_PAYLOADS_H
@@ -0,0 +1,207 @@
+// ============================================================
+// AutoGuard - Profilo rumore di fondo - Implementazione
+// ============================================================
+#include "noise_profile.h"
+#include <math.h>
+#include <string.h>
+
+// Istanza globale
+NoiseProfile noiseProfile;
+
+// Chiave NVS e formato blob
+#define KEY_NOISE_PROFILE   "noise_prof"
+#define NOISE_BLOB_VERSION  1
+
+struct NoiseBlob {
+    uint8_t  version;
+    uint8_t  gates;
+    uint16_t reserved;
+    uint32_t learned;
+    uint32_t count[LD2420_GATE_COUNT];
+    float    mean[LD2420_GATE_COUNT];
+    float    m2[LD2420_GATE_COUNT];
+};
+
+// Gate adiacenti considerati intorno alla distanza rilevata
+#define NOISE_GATE_SPAN     1
+// Frame energie più vecchi di così non vengono usati
+#define NOISE_MAX_AGE_MS    500
+
+// ============================================================
+// Costruttore
+// ============================================================
+NoiseProfile::NoiseProfile() :
+    _request(REQ_NONE),
+    _learning(false),
+    _valid(false),
+    _learned(0),
+    _suppressed(0)
+{
+    _clear();
+    memset(&_last, 0, sizeof(_last));
+}
+
+void NoiseProfile::_clear() {
+    for (int g = 0; g < LD2420_GATE_COUNT; g++) {
+        _count[g] = 0;
+        _mean[g]  = 0.0f;
+        _m2[g]    = 0.0f;
+    }
+    _learned = 0;
+}
+
+// ============================================================
+// begin() - Carica profilo da NVS
+// ============================================================
+void NoiseProfile::begin() {
+    if (_load()) {
+        _valid = true;
+        halLog.printf("[NOISE] Profilo caricato da NVS (%lu frame)\n", (unsigned long)_learned);
+    } else {
+        halLog.println("[NOISE] Nessun profilo salvato - soglie adattive disattive");
+    }
+}
+
+// ============================================================
+// Comandi
+// ============================================================
+void NoiseProfile::startLearning() {
+    _request = REQ_START;
+}
+
+void NoiseProfile::reset() {
+    _valid    = false;     // soglie disattivate subito
+    _learning = false;
+    _request  = REQ_RESET;
+}
+
+// ============================================================
+// observe() - Aggiornamento incrementale (Welford)
+// ============================================================
+void NoiseProfile::observe(const RadarGateEnergy& e, bool learnAllowed) {
+    _last = e;
+
+    uint8_t req = _request.exchange(REQ_NONE);
+    if (req == REQ_RESET) {
+        _clear();
+        HalKvStore prefs;
+        prefs.begin(NVS_NAMESPACE, false);
+        prefs.remove(KEY_NOISE_PROFILE);
+        prefs.end();
+        halLog.println("[NOISE] Profilo azzerato");
+    } else if (req == REQ_START) {
+        _clear();
+        _valid    = false;
+        _learning = true;
+        halLog.printf("[NOISE] Apprendimento avviato (%d frame)\n", NOISE_LEARN_FRAMES);
+    }
+
+    if (!_learning || !learnAllowed) return;
+
+    for (int g = 0; g < LD2420_GATE_COUNT; g++) {
+        float x     = e.energy[g];
+        _count[g]++;
+        float delta = x - _mean[g];
+        _mean[g]   += delta / _count[g];
+        _m2[g]     += delta * (x - _mean[g]);
+    }
+
+    if (++_learned >= NOISE_LEARN_FRAMES) {
+        _learning = false;
+        _valid    = true;
+        _save();
+        halLog.printf("[NOISE] Apprendimento completato (%lu frame), profilo salvato\n", (unsigned long)_learned);
+    }
+}
+
+// ============================================================
+// confirms() - Soglia adattiva sui gate intorno alla distanza
+// ============================================================
+bool NoiseProfile::confirms(const RadarData& data) {
+    if (!_valid || !data.detected) return true;
+    if (data.sensor != 0) return true;      // profilo del solo sensore principale
+    if (data.timestamp - _last.timestamp > NOISE_MAX_AGE_MS) return true;
+
+    int gate = data.distance_cm / LD2420_GATE_CM;
+    int from = gate - NOISE_GATE_SPAN < 0 ? 0 : gate - NOISE_GATE_SPAN;
+    int to   = gate + NOISE_GATE_SPAN >= LD2420_GATE_COUNT ? LD2420_GATE_COUNT - 1 : gate + NOISE_GATE_SPAN;
+
+    for (int g = from; g <= to; g++) {
+        if (_last.energy[g] > getThreshold(g)) return true;
+    }
+
+    _suppressed++;
+    return false;
+}
+
+// ============================================================
+// Getters
+// ============================================================
+bool NoiseProfile::isLearning() {
+    return _learning;
+}
+
+bool NoiseProfile::isValid() {
+    return _valid;
+}
+
+uint32_t NoiseProfile::getLearnedSamples() {
+    return _learned;
+}
+
+uint32_t NoiseProfile::getSuppressed() {
+    return _suppressed;
+}
+
+float NoiseProfile::getMean(int gate) {
+    return _mean[gate];
+}
+
+float NoiseProfile::getStdDev(int gate) {
+    return _count[gate] > 1 ? sqrtf(_m2[gate] / (_count[gate] - 1)) : 0.0f;
+}
+
+float NoiseProfile::getThreshold(int gate) {
+    float k = configMgr.get().noiseSigmaX10 / 10.0f;
+    return _mean[gate] + k * getStdDev(gate) + NOISE_MIN_MARGIN;
+}
+
+// ============================================================
+// Persistenza NVS
+// ============================================================
+bool NoiseProfile::_save() {
+    NoiseBlob blob;
+    blob.version  = NOISE_BLOB_VERSION;
+    blob.gates    = LD2420_GATE_COUNT;
+    blob.reserved = 0;
+    blob.learned  = _learned;
+    memcpy(blob.count, _count, sizeof(blob.count));
+    memcpy(blob.mean,  _mean,  sizeof(blob.mean));
+    memcpy(blob.m2,    _m2,    sizeof(blob.m2));
+
+    HalKvStore prefs;
+    prefs.begin(NVS_NAMESPACE, false);
+    size_t n = prefs.putBytes(KEY_NOISE_PROFILE, &blob, sizeof(blob));
+    prefs.end();
+    return n == sizeof(blob);
+}
+
+bool NoiseProfile::_load() {
+    NoiseBlob blob;
+
+    HalKvStore prefs;
+    prefs.begin(NVS_NAMESPACE, true);
+    size_t n = prefs.getBytes(KEY_NOISE_PROFILE, &blob, sizeof(blob));
+    prefs.end();
+
+    if (n != sizeof(blob) || blob.version != NOISE_BLOB_VERSION ||
+        blob.gates != LD2420_GATE_COUNT) {
+        return false;
+    }
+
+    _learned = blob.learned;
+    memcpy(_count, blob.count, sizeof(_count));
+    memcpy(_mean,  blob.mean,  sizeof(_mean));
+    memcpy(_m2,    blob.m2,    sizeof(_m2));
+    return true;
+}
@@ -0,0 +1,74 @@
+// ============================================================
+// AutoGuard - Profilo rumore di fondo per gate
+// ============================================================
+// Apprende media e varianza dell'energia per ogni range gate
+// (Welford, memoria fissa) mentre il sistema è ARMED senza
+// alert. La soglia adattiva di un gate è:
+//     media + k * deviazione standard   (k = noiseSigmaX10 / 10)
+// Una detection è confermata solo se l'energia dei gate intorno
+// alla distanza rilevata supera la soglia.
+// Con più radar il profilo è del sensore principale (#0): le
+// detection degli altri sensori passano senza verifica.
+// ============================================================
+#ifndef NOISE_PROFILE_H
+#define NOISE_PROFILE_H
+
+#include "hal.h"
+#include <atomic>
+#include "config.h"
+#include "config_manager.h"
+#include "radar_types.h"
+
+class NoiseProfile {
+public:
+    NoiseProfile();
+
+    // Carica il profilo salvato in NVS
+    void begin();
+
+    // Comandi (da qualsiasi task, applicati al prossimo frame)
+    void startLearning();
+    void reset();
+
+    // Alimenta il profilo con un frame energie (solo dal loop).
+    // learnAllowed = sistema ARMED senza alert in corso
+    void observe(const RadarGateEnergy& e, bool learnAllowed);
+
+    // true se la detection supera il rumore di fondo
+    // (sempre true se il profilo non è valido o i dati sono vecchi)
+    bool confirms(const RadarData& data);
+
+    // Stato calibrazione
+    bool     isLearning();
+    bool     isValid();
+    uint32_t getLearnedSamples();
+    uint32_t getSuppressed();       // detection scartate come rumore
+
+    // Statistiche per gate
+    float getMean(int gate);
+    float getStdDev(int gate);
+    float getThreshold(int gate);
+
+private:
+    enum Request : uint8_t { REQ_NONE = 0, REQ_START = 1, REQ_RESET = 2 };
+
+    // Statistiche Welford per gate
+    uint32_t _count[LD2420_GATE_COUNT];
+    float    _mean[LD2420_GATE_COUNT];
+    float    _m2[LD2420_GATE_COUNT];
+
+    RadarGateEnergy       _last;            // ultimo frame osservato
+    std::atomic<uint8_t>  _request;
+    std::atomic<bool>     _learning;
+    std::atomic<bool>     _valid;
+    uint32_t              _learned;         // frame appresi
+    uint32_t              _suppressed;
+
+    void _clear();
+    bool _save();
+    bool _load();
+};
+
+extern NoiseProfile noiseProfile;
+
+#endif // NOISE_PROFILE_H
@@ -0,0 +1,111 @@
+// ============================================================
+// AutoGuard - Risparmio energetico - Implementazione
+// ============================================================
+#include "power_manager.h"
+#include <string.h>
+
+static_assert(POWER_IDLE_MAX_MS > 0 && POWER_IDLE_MAX_MS < RADAR_UPDATE_MS,
+              "POWER_IDLE_MAX_MS: sotto il periodo di campionamento");
+static_assert(POWER_IDLE_DISARMED_MS >= POWER_IDLE_MAX_MS,
+              "POWER_IDLE_DISARMED_MS: almeno POWER_IDLE_MAX_MS");
+
+PowerManager powerMgr;
+
+static const char* const MODE_NAMES[] = { "off", "dfs", "light_sleep" };
+
+// ============================================================
+// Costruttore
+// ============================================================
+PowerManager::PowerManager() :
+    _count(0),
+    _mode(HAL_POWER_NONE),
+    _low(false),
+    _started(false),
+    _wakeUs(0)
+{
+    memset(_sensors, 0, sizeof(_sensors));
+    memset(_sleepUs, 0, sizeof(_sleepUs));
+    memset(_awakeUs, 0, sizeof(_awakeUs));
+}
+
+bool PowerManager::attach(SensorLD2420& sensor) {
+    if (_count >= FUSION_MAX_SENSORS) return false;
+    _sensors[_count++] = &sensor;
+    return true;
+}
+
+// ============================================================
+// begin() - Power management + notifica campioni al loop
+// ============================================================
+void PowerManager::begin() {
+#if POWER_SAVE
+    _mode = halPowerInit(POWER_CPU_MAX_MHZ, POWER_CPU_MIN_MHZ, POWER_LIGHT_SLEEP);
+
+    HalTaskHandle self = halTaskCurrent();
+    for (uint8_t i = 0; i < _count; i++) _sensors[i]->setConsumer(self);
+#endif
+    halLog.printf("[POWER] Risparmio energetico: %s\n", modeName());
+
+    _wakeUs = halMicros();
+}
+
+// ============================================================
+// _apply() - Profilo radar/sleep dello stato
+// ============================================================
+void PowerManager::_apply(bool low) {
+    _low = low;
+
+    // Sensori senza task: il loop li svuota a ogni risveglio
+    for (uint8_t i = 0; i < _count; i++) {
+        _sensors[i]->setPollInterval(low ? RADAR_IDLE_POLL_MS : 0);
+        _sensors[i]->setWakeOnRx(low);
+    }
+    bool sleep = low && _mode == HAL_POWER_LIGHT_SLEEP;
+    halPowerAllowSleep(sleep);
+
+    halLog.printf("[POWER] Profilo %s%s\n", low ? "disarmato" : "attivo",
+        sleep ? " (light sleep)" : "");
+}
+
+// ============================================================
+// idle() - Fine iterazione del loop
+// ============================================================
+void PowerManager::idle(AlarmState state, uint32_t msToDeadline) {
+    uint8_t  s   = state % POWER_STATES;
+    uint64_t now = halMicros();
+
+    _awakeUs[s] += now - _wakeUs;
+    _wakeUs      = now;
+
+#if POWER_SAVE
+    bool low = (state == STATE_DISARMED);
+    if (!_started || low != _low) {
+        _apply(low);
+        _started = true;
+    }
+
+    // Scadenza già passata: il loop la gestisce subito
+    uint32_t wait = low ? POWER_IDLE_DISARMED_MS : POWER_IDLE_MAX_MS;
+    if (msToDeadline < wait) wait = msToDeadline;
+    if (wait == 0) return;
+
+    halPowerHoldCpu(false);
+    halTaskWait(wait);
+    halPowerHoldCpu(true);
+
+    _wakeUs      = halMicros();
+    _sleepUs[s] += _wakeUs - now;
+#else
+    (void)msToDeadline;
+#endif
+}
+
+const char* PowerManager::modeName() const {
+    return MODE_NAMES[_mode];
+}
+
+uint8_t PowerManager::sleepPct(AlarmState s) const {
+    uint64_t sleep = _sleepUs[s % POWER_STATES];
+    uint64_t total = sleep + _awakeUs[s % POWER_STATES];
+    return total ? (uint8_t)(sleep * 100 / total) : 0;
+}
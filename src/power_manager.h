@@ -0,0 +1,76 @@
+// ============================================================
+// AutoGuard - Risparmio energetico (DFS + light sleep)
+// ============================================================
+// Al termine di ogni iterazione di loop() il power manager
+// blocca il loop finché non arriva un campione (notifica dal
+// task radar) o scade il limite dello stato:
+//   - DISARMED: light sleep automatico consentito, radar a
+//     intervalli (RADAR_IDLE_POLL_MS) con risveglio da attività
+//     RX sulla UART; attesa fino a POWER_IDLE_DISARMED_MS
+//   - altri stati: radar a ogni frame, light sleep vietato (il
+//     risveglio da UART perde i primi byte del frame); attesa
+//     fino a POWER_IDLE_MAX_MS e mai oltre la prossima scadenza
+//     della state machine
+// Durante l'attesa il loop rilascia il lock di frequenza: il
+// power management di ESP-IDF scala la CPU a POWER_CPU_MIN_MHZ
+// (o entra in light sleep, se consentito). Il WiFi resta in
+// modem sleep: si sveglia ai beacon DTIM.
+//
+// Misura per stato il tempo del loop in attesa (CPU libera di
+// dormire) e al lavoro. Scrittore: solo loop(); i lettori (web)
+// leggono senza lock (valori statistici).
+// Non dipende da Arduino.
+// ============================================================
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "config.h"
+#include "alarm_logic.h"
+#include "sensor_ld2420.h"
+#include "radar_fusion.h"
+
+#define POWER_STATES    (STATE_COOLDOWN + 1)
+
+class PowerManager {
+public:
+    PowerManager();
+
+    // Sensori da riconfigurare al cambio di stato (prima di begin)
+    bool attach(SensorLD2420& sensor);
+
+    // Configura DFS/light sleep e registra il loop come consumatore
+    // dei campioni radar. Da chiamare dal task del loop
+    void begin();
+
+    // Fine iterazione: applica il profilo dello stato e attende
+    // il prossimo campione, al più fino alla scadenza
+    void idle(AlarmState state, uint32_t msToDeadline);
+
+    HalPowerMode mode() const { return _mode; }
+    const char*  modeName() const;      // "off", "dfs", "light_sleep"
+
+    // Tempo in attesa / al lavoro per stato (ms, dall'avvio)
+    uint32_t sleepMs(AlarmState s) const { return (uint32_t)(_sleepUs[s % POWER_STATES] / 1000); }
+    uint32_t awakeMs(AlarmState s) const { return (uint32_t)(_awakeUs[s % POWER_STATES] / 1000); }
+
+    // Percentuale in attesa per stato (0 se mai visitato)
+    uint8_t sleepPct(AlarmState s) const;
+
+private:
+    SensorLD2420* _sensors[FUSION_MAX_SENSORS];
+    uint8_t       _count;
+    HalPowerMode  _mode;
+    bool          _low;             // profilo DISARMED applicato
+    bool          _started;
+    uint64_t      _wakeUs;          // fine dell'ultima attesa
+    uint64_t      _sleepUs[POWER_STATES];
+    uint64_t      _awakeUs[POWER_STATES];
+
+    void _apply(bool low);
+};
+
+extern PowerManager powerMgr;
+
+#endif // POWER_MANAGER_H
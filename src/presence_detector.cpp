@@ -0,0 +1,136 @@
+// ============================================================
+// AutoGuard - Rilevatore intrusione - Implementazione
+// ============================================================
+#include "presence_detector.h"
+
+#define Q30_ONE         (1UL << 30)
+#define LN2_Q30         744261118UL     // ln(2) * 2^30
+
+// ============================================================
+// DetectorParams
+// ============================================================
+DetectorParams DetectorParams::fromConfig(const AutoGuardConfig& cfg) {
+    DetectorParams p;
+    p.mode              = (cfg.detectorMode >= 0 && cfg.detectorMode < DETECTOR_MODE_COUNT)
+                          ? cfg.detectorMode : DETECTOR_COUNTER;
+    p.detectionsToAlert = cfg.detectionsToAlert;
+    p.threshold         = cfg.evidenceThreshold > 0 ? cfg.evidenceThreshold : 1;
+    p.halfLifeMs        = cfg.evidenceHalfLifeMs;
+    p.dwellMs           = cfg.evidenceDwellMs;
+    p.approachPct       = cfg.evidenceApproachPct;
+
+    p.zoneEnabled[ZONE_NONE]     = false;
+    p.zoneEnabled[ZONE_CRITICAL] = cfg.alarmZoneCritical;
+    p.zoneEnabled[ZONE_MEDIUM]   = cfg.alarmZoneMedium;
+    p.zoneEnabled[ZONE_FAR]      = cfg.alarmZoneFar;
+
+    p.weight[ZONE_NONE]     = 0;
+    p.weight[ZONE_CRITICAL] = cfg.evidenceWeightCritical;
+    p.weight[ZONE_MEDIUM]   = cfg.evidenceWeightMedium;
+    p.weight[ZONE_FAR]      = cfg.evidenceWeightFar;
+    return p;
+}
+
+// ============================================================
+// CounterDetector
+// ============================================================
+bool CounterDetector::feed(const RadarData& d, const DetectorParams& p) {
+    if (d.zone == ZONE_CRITICAL && p.zoneEnabled[ZONE_CRITICAL]) {
+        return true;
+    }
+    if (d.zone == ZONE_MEDIUM && p.zoneEnabled[ZONE_MEDIUM]) {
+        if (++_countMedium >= p.detectionsToAlert) {
+            _countMedium = 0;
+            return true;
+        }
+    } else if (d.zone == ZONE_FAR && p.zoneEnabled[ZONE_FAR]) {
+        if (++_countFar >= p.detectionsToAlert) {
+            _countFar = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================
+// EvidenceDetector
+// ============================================================
+void EvidenceDetector::configure(const DetectorParams& p) {
+    _halfLifeMs = p.halfLifeMs < EVIDENCE_HALF_LIFE_MIN_MS ? EVIDENCE_HALF_LIFE_MIN_MS : p.halfLifeMs;
+
+    // exp(-x) con x = ln2 / halfLife: serie al secondo ordine,
+    // errore trascurabile con halfLife >= EVIDENCE_HALF_LIFE_MIN_MS
+    uint32_t x = LN2_Q30 / _halfLifeMs;
+    _decayQ30  = Q30_ONE - x + (uint32_t)(((uint64_t)x * x) >> 31);
+}
+
+void EvidenceDetector::reset() {
+    _scoreQ8      = 0;
+    _lastMs       = 0;
+    _dwellStartMs = 0;
+    _primed       = false;
+}
+
+// score * 2^(-dt/halfLife): dimezzamenti interi con shift, resto
+// con potenza per quadrati del fattore per ms (al più ~20 passi)
+uint32_t EvidenceDetector::_decay(uint32_t scoreQ8, uint32_t dtMs) const {
+    uint32_t halves = dtMs / _halfLifeMs;
+    if (halves >= 32) return 0;
+    scoreQ8 >>= halves;
+
+    uint32_t rem = dtMs % _halfLifeMs;
+    uint64_t f   = Q30_ONE;
+    uint64_t b   = _decayQ30;
+    while (rem) {
+        if (rem & 1) f = (f * b) >> 30;
+        b = (b * b) >> 30;
+        rem >>= 1;
+    }
+    return (uint32_t)(((uint64_t)scoreQ8 * f) >> 30);
+}
+
+bool EvidenceDetector::feed(const RadarData& d, uint32_t now, const DetectorParams& p) {
+    uint32_t dt = _primed ? now - _lastMs : 0;
+    _scoreQ8 = _decay(_scoreQ8, dt);
+
+    // Presenza continua: un buco oltre EVIDENCE_GAP_MS riparte da zero
+    if (!_primed || dt > EVIDENCE_GAP_MS) _dwellStartMs = now;
+    _lastMs   = now;
+    _primed   = true;
+
+    if (d.zone > ZONE_FAR || !p.zoneEnabled[d.zone] || p.weight[d.zone] <= 0) return false;
+
+    // Permanenza: peso da x1 a x2 in dwellMs
+    uint32_t dwellPct = 100;
+    if (p.dwellMs > 0) {
+        uint32_t dwell = now - _dwellStartMs;
+        if (dwell > (uint32_t)p.dwellMs) dwell = p.dwellMs;
+        dwellPct += dwell * 100 / p.dwellMs;
+    }
+
+    // Andamento: avvicinamento (velocità del tracker < 0) aumenta il peso
+    int32_t approach = -d.velocity;
+    if (approach >  EVIDENCE_APPROACH_FULL_CMS) approach =  EVIDENCE_APPROACH_FULL_CMS;
+    if (approach < -EVIDENCE_APPROACH_FULL_CMS) approach = -EVIDENCE_APPROACH_FULL_CMS;
+    int32_t trendPct = 100 + p.approachPct * approach / EVIDENCE_APPROACH_FULL_CMS;
+    if (trendPct < 0) trendPct = 0;
+
+    uint64_t add = ((uint64_t)p.weight[d.zone] << 8) * dwellPct * (uint32_t)trendPct / 10000;
+    uint64_t sum = _scoreQ8 + add;
+    _scoreQ8 = sum > UINT32_MAX ? UINT32_MAX : (uint32_t)sum;
+
+    if (_scoreQ8 >= ((uint32_t)p.threshold << 8)) {
+        _scoreQ8 = 0;
+        return true;
+    }
+    return false;
+}
+
+// ============================================================
+// PresenceDetector
+// ============================================================
+void PresenceDetector::configure(const DetectorParams& p) {
+    if (p.mode != _params.mode) reset();
+    _params = p;
+    _evidence.configure(p);
+}
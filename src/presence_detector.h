@@ -0,0 +1,121 @@
+// ============================================================
+// AutoGuard - Rilevatore intrusione (stadio prima dell'alert)
+// ============================================================
+// Decide quando una serie di campioni radar (già confermati dal
+// profilo rumore e sopra la distanza minima) giustifica un alert.
+// Due stadi selezionabili da configurazione:
+//   - contatori: N rilevamenti per zona, mai azzerati tra un
+//     rilevamento e l'altro (comportamento storico)
+//   - evidenza: punteggio che decade nel tempo (dimezzamento
+//     configurabile), incrementato a ogni campione con un peso
+//     per zona, moltiplicato per la permanenza continua e per
+//     la velocità radiale stimata dal tracker (avvicinamento)
+// O(1) per campione, memoria fissa, solo aritmetica intera
+// (ESP32-C6 senza FPU). Non dipende da Arduino.
+// ============================================================
+#ifndef PRESENCE_DETECTOR_H
+#define PRESENCE_DETECTOR_H
+
+#include <stdint.h>
+#include "config.h"
+#include "config_manager.h"
+#include "radar_types.h"
+
+// Stadi selezionabili da configurazione
+enum DetectorMode {
+    DETECTOR_COUNTER  = 0,      // N rilevamenti per zona
+    DETECTOR_EVIDENCE = 1,      // punteggio con decadimento
+    DETECTOR_MODE_COUNT
+};
+
+// Parametri ricavati da AutoGuardConfig
+struct DetectorParams {
+    int  mode;                  // DetectorMode
+    int  detectionsToAlert;     // contatori
+    bool zoneEnabled[4];        // per RadarZone (alarmZoneCritical/Medium/Far)
+    int  threshold;             // evidenza: punti per alert
+    int  halfLifeMs;            // evidenza: dimezzamento punteggio
+    int  weight[4];             // evidenza: punti per campione, per RadarZone
+    int  dwellMs;               // evidenza: permanenza che raddoppia il peso
+    int  approachPct;           // evidenza: +/- peso a piena velocità radiale
+
+    static DetectorParams fromConfig(const AutoGuardConfig& cfg);
+};
+
+// ------------------------------------------------------------
+// Contatori per zona (MEDIUM/FAR), CRITICAL immediato
+// ------------------------------------------------------------
+class CounterDetector {
+public:
+    CounterDetector() { reset(); }
+
+    bool feed(const RadarData& d, const DetectorParams& p);
+    void reset() { _countMedium = _countFar = 0; }
+
+    uint32_t score() const { return _countMedium > _countFar ? _countMedium : _countFar; }
+
+private:
+    int _countMedium;
+    int _countFar;
+};
+
+// ------------------------------------------------------------
+// Evidenza con decadimento esponenziale
+// ------------------------------------------------------------
+class EvidenceDetector {
+public:
+    EvidenceDetector() : _decayQ30(1UL << 30), _halfLifeMs(1) { reset(); }
+
+    // Precalcola il fattore di decadimento per ms
+    void configure(const DetectorParams& p);
+
+    bool feed(const RadarData& d, uint32_t now, const DetectorParams& p);
+    void reset();
+
+    // Punteggio all'ultimo campione (punti interi)
+    uint32_t score() const { return _scoreQ8 >> 8; }
+
+private:
+    uint32_t _decayQ30;         // 2^(-1/halfLife) per ms, Q30
+    uint32_t _halfLifeMs;
+    uint32_t _scoreQ8;
+    uint32_t _lastMs;           // ultimo campione ricevuto
+    uint32_t _dwellStartMs;     // inizio presenza continua
+    bool     _primed;
+
+    uint32_t _decay(uint32_t scoreQ8, uint32_t dtMs) const;
+};
+
+// ------------------------------------------------------------
+// PresenceDetector - stadio scelto a runtime
+// ------------------------------------------------------------
+class PresenceDetector {
+public:
+    PresenceDetector() : _params() { _params.mode = DETECTOR_COUNTER; }
+
+    // Applica i parametri; lo stato si azzera se cambia modalità
+    void configure(const DetectorParams& p);
+
+    // Campione con presenza confermata: true = alert
+    bool feed(const RadarData& d, uint32_t now) {
+        if (_params.mode == DETECTOR_EVIDENCE) return _evidence.feed(d, now, _params);
+        return _counter.feed(d, _params);
+    }
+
+    void reset() {
+        _counter.reset();
+        _evidence.reset();
+    }
+
+    int      mode()  const { return _params.mode; }
+    uint32_t score() const {
+        return _params.mode == DETECTOR_EVIDENCE ? _evidence.score() : _counter.score();
+    }
+
+private:
+    DetectorParams   _params;
+    CounterDetector  _counter;
+    EvidenceDetector _evidence;
+};
+
+#endif // PRESENCE_DETECTOR_H
@@ -0,0 +1,241 @@
+// ============================================================
+// AutoGuard - Batch binari storico radar - Implementazione
+// ============================================================
+#include "radar_batch.h"
+#include <string.h>
+
+RadarBatcher radarBatcher;
+
+#define SLOTS           (RADAR_BATCH_QUEUE + 1)
+#define ZONE_SHIFT      1
+#define TRAJ_SHIFT      3
+#define SENSOR_SHIFT    5
+#define FIELD_MASK      0x03
+#define FLAG_ZONE_ID    0x80
+
+static inline void put16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static inline void put32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static inline uint16_t get16(const uint8_t* p) {
+    return p[0] | ((uint16_t)p[1] << 8);
+}
+
+static inline uint32_t get32(const uint8_t* p) {
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline size_t putVarint(uint8_t* p, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Legge un varint entro end; false se troncato
+static bool getVarint(const uint8_t* buf, size_t& pos, size_t end, uint32_t& out) {
+    out = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= end) return false;
+        uint8_t b = buf[pos++];
+        out |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// ============================================================
+// RadarBatcher
+// ============================================================
+RadarBatcher::RadarBatcher() :
+    _head(0),
+    _count(0),
+    _n(0),
+    _used(0),
+    _seq(0),
+    _baseMs(0),
+    _prevTs(0),
+    _prevDist(0),
+    _prevVel(0),
+    _prevZoneId(0),
+    _samples(0),
+    _dropped(0),
+    _bytes(0)
+{
+    memset(_len, 0, sizeof(_len));
+}
+
+// ------------------------------------------------------------
+// add() - Codifica delta di un campione
+// ------------------------------------------------------------
+bool RadarBatcher::add(const RadarData& d) {
+    if (_n == 0) _open(d.timestamp);
+
+    uint8_t* b = _buf[(_head + _count) % SLOTS];
+    uint8_t* p = b + _used;
+    uint8_t  flags = (d.detected ? 1 : 0) |
+                     (((uint8_t)d.zone       & FIELD_MASK) << ZONE_SHIFT) |
+                     (((uint8_t)d.trajectory & FIELD_MASK) << TRAJ_SHIFT) |
+                     ((d.sensor              & FIELD_MASK) << SENSOR_SHIFT);
+    size_t   n = 1;
+    if (d.zone_id != _prevZoneId) {
+        flags |= FLAG_ZONE_ID;
+        p[n++] = d.zone_id;
+    }
+    p[0] = flags;
+    n += putVarint(p + n, d.timestamp - _prevTs);
+    n += putVarint(p + n, zigzag(d.distance_cm - _prevDist));
+    n += putVarint(p + n, zigzag(d.filtered_dist - d.distance_cm));
+    n += putVarint(p + n, zigzag(d.velocity - _prevVel));
+
+    _used += n;
+    _n++;
+    _samples++;
+    _prevTs     = d.timestamp;
+    _prevDist   = d.distance_cm;
+    _prevVel    = d.velocity;
+    _prevZoneId = d.zone_id;
+
+    if (_n < RADAR_BATCH_SAMPLES) return false;
+    _close();
+    return true;
+}
+
+void RadarBatcher::flush() {
+    if (_n) _close();
+}
+
+void RadarBatcher::_open(uint32_t ts) {
+    _used       = RADAR_BATCH_HEADER_LEN;
+    _baseMs     = ts;
+    _prevTs     = ts;
+    _prevDist   = 0;
+    _prevVel    = 0;
+    _prevZoneId = 0;
+}
+
+// Header e passaggio in coda; a coda piena si perde il più vecchio
+void RadarBatcher::_close() {
+    uint8_t  slot = (_head + _count) % SLOTS;
+    uint8_t* h    = _buf[slot];
+    h[0] = RADAR_BATCH_MAGIC0;
+    h[1] = RADAR_BATCH_MAGIC1;
+    h[2] = RADAR_BATCH_VERSION;
+    h[3] = _n;
+    put16(h + 4, ++_seq);
+    put16(h + 6, 0);
+    put32(h + 8, _baseMs);
+    _len[slot] = _used;
+    _bytes += _used;
+    _n = 0;
+
+    if (_count == RADAR_BATCH_QUEUE) {
+        _head = (_head + 1) % SLOTS;
+        _count--;
+        _dropped++;
+    }
+    _count++;
+}
+
+const uint8_t* RadarBatcher::front(size_t* len) const {
+    if (_count == 0) return nullptr;
+    if (len) *len = _len[_head];
+    return _buf[_head];
+}
+
+void RadarBatcher::pop() {
+    if (_count == 0) return;
+    _head = (_head + 1) % SLOTS;
+    _count--;
+}
+
+// ============================================================
+// RadarBatchReader
+// ============================================================
+RadarBatchReader::RadarBatchReader() :
+    _buf(nullptr),
+    _len(0),
+    _pos(0),
+    _seq(0),
+    _baseMs(0),
+    _count(0),
+    _left(0),
+    _prevTs(0),
+    _prevDist(0),
+    _prevVel(0),
+    _prevZoneId(0)
+{}
+
+bool RadarBatchReader::open(const uint8_t* buf, size_t len) {
+    _left = 0;
+    if (!buf || len < RADAR_BATCH_HEADER_LEN ||
+        buf[0] != RADAR_BATCH_MAGIC0 || buf[1] != RADAR_BATCH_MAGIC1 ||
+        buf[2] != RADAR_BATCH_VERSION) {
+        return false;
+    }
+    _buf        = buf;
+    _len        = len;
+    _pos        = RADAR_BATCH_HEADER_LEN;
+    _count      = buf[3];
+    _left       = _count;
+    _seq        = get16(buf + 4);
+    _baseMs     = get32(buf + 8);
+    _prevTs     = _baseMs;
+    _prevDist   = 0;
+    _prevVel    = 0;
+    _prevZoneId = 0;
+    return true;
+}
+
+bool RadarBatchReader::next(RadarData& out) {
+    if (_left == 0 || _pos >= _len) return false;
+
+    uint8_t flags = _buf[_pos++];
+    if (flags & FLAG_ZONE_ID) {
+        if (_pos >= _len) { _left = 0; return false; }
+        _prevZoneId = _buf[_pos++];
+    }
+    uint32_t dt, dDist, dFilt, dVel;
+    if (!getVarint(_buf, _pos, _len, dt) ||
+        !getVarint(_buf, _pos, _len, dDist) ||
+        !getVarint(_buf, _pos, _len, dFilt) ||
+        !getVarint(_buf, _pos, _len, dVel)) {
+        _left = 0;
+        return false;
+    }
+    _prevTs   += dt;
+    _prevDist += unzigzag(dDist);
+    _prevVel  += unzigzag(dVel);
+    _left--;
+
+    memset(&out, 0, sizeof(out));
+    out.detected      = flags & 1;
+    out.zone          = (RadarZone)((flags >> ZONE_SHIFT) & FIELD_MASK);
+    out.trajectory    = (RadarTrajectory)((flags >> TRAJ_SHIFT) & FIELD_MASK);
+    out.sensor        = (flags >> SENSOR_SHIFT) & FIELD_MASK;
+    out.zone_id       = _prevZoneId;
+    out.distance_cm   = _prevDist;
+    out.filtered_dist = _prevDist + unzigzag(dFilt);
+    out.velocity      = _prevVel;
+    out.timestamp     = _prevTs;
+    return true;
+}
@@ -0,0 +1,131 @@
+// ============================================================
+// AutoGuard - Batch binari storico radar
+// ============================================================
+// Tutti i campioni fusi dei periodi ARMED/ALERT/ALARM, raccolti
+// in batch di RADAR_BATCH_SAMPLES per MQTT_TOPIC_BATCH.
+// Formato (little-endian), versione 1:
+//   header 12 byte:
+//     [0..1]  magic 'A' 'R'
+//     [2]     versione (1)
+//     [3]     numero campioni nel batch
+//     [4..5]  sequenza batch (u16)
+//     [6..7]  riservato
+//     [8..11] timestamp base (ms, u32) = primo campione
+//   campioni a lunghezza variabile:
+//     flags    u8      bit0 = detected, bit1..2 = zona,
+//                      bit3..4 = traiettoria, bit5..6 = sensore,
+//                      bit7 = segue zone_id
+//     zone_id  u8      solo se cambiato dal campione precedente
+//     dt       varint  ms dal campione precedente
+//     dDist    zigzag  distance_cm - precedente
+//     dFilt    zigzag  filtered_dist - distance_cm
+//     dVel     zigzag  velocity - precedente
+// Ogni batch è decodificabile da solo (precedente = base, 0cm,
+// 0cm/s, zona 0). Accelerazione e permanenza non sono inviate:
+// si ricavano dalla serie. Un campione tipico occupa 5 byte
+// contro ~150 del JSON di MQTT_TOPIC_SENSOR.
+//
+// Coda di RADAR_BATCH_QUEUE batch completi in attesa di invio:
+// offline si scartano i più vecchi. Solo dal loop (scrittura e
+// invio), nessuna sincronizzazione.
+// Non dipende da Arduino: compilabile anche su host (decoder).
+// ============================================================
+#ifndef RADAR_BATCH_H
+#define RADAR_BATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+#include "radar_types.h"
+
+#define RADAR_BATCH_MAGIC0       'A'
+#define RADAR_BATCH_MAGIC1       'R'
+#define RADAR_BATCH_VERSION      1
+#define RADAR_BATCH_HEADER_LEN   12
+#define RADAR_BATCH_SAMPLE_MAX   22      // flags + zone_id + 4 varint da 5 byte
+#define RADAR_BATCH_MAX_LEN      (RADAR_BATCH_HEADER_LEN + RADAR_BATCH_SAMPLES * RADAR_BATCH_SAMPLE_MAX)
+
+static_assert(RADAR_BATCH_SAMPLES <= 255, "RADAR_BATCH_SAMPLES: massimo 255 campioni");
+
+// ------------------------------------------------------------
+// RadarBatcher - codifica e coda (solo loop)
+// ------------------------------------------------------------
+class RadarBatcher {
+public:
+    RadarBatcher();
+
+    // Aggiunge un campione; true se ha completato un batch
+    bool add(const RadarData& d);
+
+    // Chiude il batch parziale (uscita dagli stati registrati)
+    void flush();
+
+    // Batch completo più vecchio; nullptr se la coda è vuota
+    const uint8_t* front(size_t* len) const;
+
+    // Rimuove il batch restituito da front() (inviato)
+    void pop();
+
+    uint8_t  queued() const  { return _count; }
+    uint32_t samples() const { return _samples; }
+    uint32_t dropped() const { return _dropped; }   // batch scartati a coda piena
+    uint32_t bytes() const   { return _bytes; }     // byte codificati (header inclusi)
+
+private:
+    uint8_t   _buf[RADAR_BATCH_QUEUE + 1][RADAR_BATCH_MAX_LEN];
+    uint16_t  _len[RADAR_BATCH_QUEUE + 1];
+    uint8_t   _head;            // batch più vecchio in coda
+    uint8_t   _count;           // batch completi in coda (lo slot dopo è in scrittura)
+    uint8_t   _n;               // campioni nel batch corrente
+    uint16_t  _used;
+    uint16_t  _seq;
+    uint32_t  _baseMs;
+
+    uint32_t  _prevTs;
+    int32_t   _prevDist;
+    int32_t   _prevVel;
+    uint8_t   _prevZoneId;
+
+    uint32_t  _samples;
+    uint32_t  _dropped;
+    uint32_t  _bytes;
+
+    void _open(uint32_t ts);
+    void _close();
+};
+
+// ------------------------------------------------------------
+// RadarBatchReader - decoder (backend, bench su host)
+// ------------------------------------------------------------
+class RadarBatchReader {
+public:
+    RadarBatchReader();
+
+    // false se header non valido
+    bool open(const uint8_t* buf, size_t len);
+
+    uint16_t seq() const    { return _seq; }
+    uint32_t baseMs() const { return _baseMs; }
+    uint8_t  count() const  { return _count; }
+
+    // Prossimo campione; false a fine batch o se troncato
+    bool next(RadarData& out);
+
+private:
+    const uint8_t* _buf;
+    size_t    _len;
+    size_t    _pos;
+    uint16_t  _seq;
+    uint32_t  _baseMs;
+    uint8_t   _count;
+    uint8_t   _left;
+
+    uint32_t  _prevTs;
+    int32_t   _prevDist;
+    int32_t   _prevVel;
+    uint8_t   _prevZoneId;
+};
+
+extern RadarBatcher radarBatcher;
+
+#endif // RADAR_BATCH_H
@@ -0,0 +1,277 @@
+// ============================================================
+// AutoGuard - Pipeline filtri distanza radar
+// ============================================================
+// Stadi a costo costante per campione, solo aritmetica intera
+// (ESP32-C6 senza FPU). Ogni stadio espone:
+//     int  apply(int value);
+//     void reset();
+// e può essere concatenato a compile-time con FilterChain<...>.
+// RadarFilter sceglie la catena a runtime (AutoGuardConfig).
+// Non dipende da Arduino: compilabile anche su host.
+// ============================================================
+#ifndef RADAR_FILTER_H
+#define RADAR_FILTER_H
+
+#include <stdint.h>
+#include "config.h"
+
+// Modalità filtro selezionabili da configurazione
+enum FilterMode {
+    FILTER_AVERAGE       = 0,   // media mobile (boxcar)
+    FILTER_MEDIAN        = 1,   // mediana mobile (reiezione spike)
+    FILTER_EMA           = 2,   // esponenziale
+    FILTER_KALMAN        = 3,   // Kalman 1-D
+    FILTER_MEDIAN_EMA    = 4,   // mediana -> esponenziale
+    FILTER_MEDIAN_KALMAN = 5,   // mediana -> Kalman
+    FILTER_MODE_COUNT
+};
+
+// ------------------------------------------------------------
+// Media mobile con somma corrente - O(1)
+// ------------------------------------------------------------
+template <int N>
+class MovingAverageFilter {
+    static_assert(N > 0, "MovingAverageFilter: N > 0");
+public:
+    MovingAverageFilter() { reset(); }
+
+    int apply(int value) {
+        if (_count == N) {
+            _sum -= _buf[_idx];
+        } else {
+            _count++;
+        }
+        _buf[_idx] = value;
+        _sum += value;
+        _idx = (_idx + 1) % N;
+        return (int)(_sum / _count);
+    }
+
+    void reset() {
+        _idx   = 0;
+        _count = 0;
+        _sum   = 0;
+    }
+
+private:
+    int     _buf[N];
+    int     _idx;
+    int     _count;
+    int32_t _sum;
+};
+
+// ------------------------------------------------------------
+// Mediana mobile su finestra fissa - O(N) con N piccolo costante
+// (un inserimento + una rimozione nell'array ordinato)
+// ------------------------------------------------------------
+template <int N>
+class MedianFilter {
+    static_assert(N > 0 && (N % 2) == 1, "MedianFilter: N dispari");
+public:
+    MedianFilter() { reset(); }
+
+    int apply(int value) {
+        if (_count == N) {
+            _remove(_buf[_idx]);
+        } else {
+            _count++;
+        }
+        _buf[_idx] = value;
+        _idx = (_idx + 1) % N;
+        _insert(value);
+        return _sorted[(_count - 1) / 2];
+    }
+
+    void reset() {
+        _idx   = 0;
+        _count = 0;
+    }
+
+private:
+    int _buf[N];        // finestra in ordine di arrivo
+    int _sorted[N];     // finestra ordinata
+    int _idx;
+    int _count;
+
+    // _sorted contiene _count-1 elementi validi
+    void _insert(int value) {
+        int i = _count - 1;
+        while (i > 0 && _sorted[i - 1] > value) {
+            _sorted[i] = _sorted[i - 1];
+            i--;
+        }
+        _sorted[i] = value;
+    }
+
+    // _sorted contiene N elementi validi, ne restano N-1
+    void _remove(int value) {
+        int i = 0;
+        while (i < N - 1 && _sorted[i] != value) i++;
+        for (; i < N - 1; i++) _sorted[i] = _sorted[i + 1];
+    }
+};
+
+// ------------------------------------------------------------
+// Filtro esponenziale - y += alpha * (x - y), alpha in Q8
+// ------------------------------------------------------------
+class ExpFilter {
+public:
+    ExpFilter() : _alphaQ8(77), _y(0), _primed(false) {}
+
+    // alpha in percentuale (1-100)
+    void setAlphaPct(int pct) {
+        if (pct < 1)   pct = 1;
+        if (pct > 100) pct = 100;
+        _alphaQ8 = (pct * 256 + 50) / 100;
+    }
+
+    int apply(int value) {
+        int32_t x = (int32_t)value << 8;
+        if (!_primed) {
+            _y      = x;
+            _primed = true;
+        } else {
+            _y += ((x - _y) * _alphaQ8) / 256;
+        }
+        return (int)((_y + 128) >> 8);
+    }
+
+    void reset() { _primed = false; }
+
+private:
+    int32_t _alphaQ8;
+    int32_t _y;         // stato in Q8
+    bool    _primed;
+};
+
+// ------------------------------------------------------------
+// Kalman 1-D (modello a posizione costante) in virgola fissa
+// q = rumore di processo, r = rumore di misura (cm^2)
+// ------------------------------------------------------------
+class Kalman1D {
+public:
+    Kalman1D() : _q(4), _r(100), _x(0), _p(0), _primed(false) {}
+
+    // Oltre FILTER_KALMAN_MAX _p + (_r << 8) esce da int32
+    void setNoise(int q, int r) {
+        _q = q < 1 ? 1 : q > FILTER_KALMAN_MAX ? FILTER_KALMAN_MAX : q;
+        _r = r < 1 ? 1 : r > FILTER_KALMAN_MAX ? FILTER_KALMAN_MAX : r;
+    }
+
+    int apply(int value) {
+        int32_t z = (int32_t)value << 8;
+        if (!_primed) {
+            _x      = z;
+            _p      = _r << 8;
+            _primed = true;
+            return value;
+        }
+
+        // Predizione
+        _p += _q << 8;
+
+        // Guadagno K in Q16
+        int64_t k = ((int64_t)_p << 16) / (_p + (_r << 8));
+
+        // Correzione
+        _x += (int32_t)((k * (z - _x)) >> 16);
+        _p  = (int32_t)(((65536 - k) * _p) >> 16);
+
+        return (int)((_x + 128) >> 8);
+    }
+
+    void reset() { _primed = false; }
+
+private:
+    int32_t _q;
+    int32_t _r;
+    int32_t _x;         // stima in Q8
+    int32_t _p;         // covarianza in Q8
+    bool    _primed;
+};
+
+// ------------------------------------------------------------
+// FilterChain<Stadi...> - composizione a compile-time
+// ------------------------------------------------------------
+template <typename... Stages>
+class FilterChain;
+
+template <>
+class FilterChain<> {
+public:
+    int  apply(int value) { return value; }
+    void reset() {}
+};
+
+template <typename First, typename... Rest>
+class FilterChain<First, Rest...> {
+public:
+    int apply(int value) { return _rest.apply(_first.apply(value)); }
+
+    void reset() {
+        _first.reset();
+        _rest.reset();
+    }
+
+    First&                head() { return _first; }
+    FilterChain<Rest...>& tail() { return _rest; }
+
+private:
+    First                _first;
+    FilterChain<Rest...> _rest;
+};
+
+// ------------------------------------------------------------
+// RadarFilter - catena selezionata a runtime
+// ------------------------------------------------------------
+template <int AVG_N, int MEDIAN_N>
+class RadarFilter {
+public:
+    RadarFilter() : _mode(FILTER_AVERAGE) {}
+
+    // Applica i parametri; la catena viene resettata se cambia modalità
+    void configure(int mode, int emaAlphaPct, int kalmanQ, int kalmanR) {
+        if (mode < 0 || mode >= FILTER_MODE_COUNT) mode = FILTER_AVERAGE;
+        if (mode != _mode) {
+            _mode = mode;
+            reset();
+        }
+        _ema.head().setAlphaPct(emaAlphaPct);
+        _medianEma.tail().head().setAlphaPct(emaAlphaPct);
+        _kalman.head().setNoise(kalmanQ, kalmanR);
+        _medianKalman.tail().head().setNoise(kalmanQ, kalmanR);
+    }
+
+    int apply(int value) {
+        switch (_mode) {
+            case FILTER_MEDIAN:        return _median.apply(value);
+            case FILTER_EMA:           return _ema.apply(value);
+            case FILTER_KALMAN:        return _kalman.apply(value);
+            case FILTER_MEDIAN_EMA:    return _medianEma.apply(value);
+            case FILTER_MEDIAN_KALMAN: return _medianKalman.apply(value);
+            default:                   return _average.apply(value);
+        }
+    }
+
+    void reset() {
+        _average.reset();
+        _median.reset();
+        _ema.reset();
+        _kalman.reset();
+        _medianEma.reset();
+        _medianKalman.reset();
+    }
+
+    int mode() const { return _mode; }
+
+private:
+    int _mode;
+    FilterChain<MovingAverageFilter<AVG_N>>         _average;
+    FilterChain<MedianFilter<MEDIAN_N>>             _median;
+    FilterChain<ExpFilter>                          _ema;
+    FilterChain<Kalman1D>                           _kalman;
+    FilterChain<MedianFilter<MEDIAN_N>, ExpFilter>  _medianEma;
+    FilterChain<MedianFilter<MEDIAN_N>, Kalman1D>   _medianKalman;
+};
+
+#endif // RADAR_FILTER_H
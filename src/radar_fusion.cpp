@@ -0,0 +1,145 @@
+// ============================================================
+// AutoGuard - Fusione multi-radar - Implementazione
+// ============================================================
+#include "radar_fusion.h"
+#include <string.h>
+
+static_assert(FUSION_ALIGN_MS > 0 && FUSION_ALIGN_MS < RADAR_UPDATE_MS,
+              "FUSION_ALIGN_MS: sotto il periodo di campionamento");
+
+// ============================================================
+// Costruttore
+// ============================================================
+RadarFusion::RadarFusion() :
+    _count(0),
+    _headMask(0),
+    _frameMask(0),
+    _frameStart(0),
+    _frameEnd(0),
+    _frames(0),
+    _partial(0)
+{
+    memset(_src, 0, sizeof(_src));
+    memset(_head, 0, sizeof(_head));
+    memset(_frame, 0, sizeof(_frame));
+    memset(_latest, 0, sizeof(_latest));
+    memset(_zoneMask, 0, sizeof(_zoneMask));
+    memset(&_data, 0, sizeof(_data));
+}
+
+// ============================================================
+// addSource() - Registra una sorgente
+// ============================================================
+bool RadarFusion::addSource(RadarSource* src) {
+    if (!src || _count >= FUSION_MAX_SENSORS) return false;
+    _latest[_count].sensor = _count;
+    _src[_count++]         = src;
+    return true;
+}
+
+void RadarFusion::update() {
+    for (uint8_t i = 0; i < _count; i++) _src[i]->update();
+}
+
+RadarData RadarFusion::getData() {
+    return _data;
+}
+
+bool RadarFusion::isReady() {
+    return _readyMask() != 0;
+}
+
+// Sensori attesi in ogni frame: un sensore assente non rallenta gli altri
+uint8_t RadarFusion::_readyMask() {
+    uint8_t m = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_src[i]->isReady()) m |= 1 << i;
+    }
+    return m;
+}
+
+// ============================================================
+// readSample() - Fusione per timestamp e chiusura del frame
+// ============================================================
+bool RadarFusion::readSample(RadarData& out) {
+    uint8_t ready = _readyMask();
+
+    for (;;) {
+        // Tutti i sensori pronti hanno contribuito
+        if (_frameMask && (_frameMask & ready) == ready) break;
+
+        for (uint8_t i = 0; i < _count; i++) {
+            uint8_t bit = 1 << i;
+            if (!(_headMask & bit) && _src[i]->readSample(_head[i])) _headMask |= bit;
+        }
+
+        if (!_headMask) {
+            // Code vuote: il ritardatario ha tempo fino a fine finestra
+            if (_frameMask && (int32_t)(halMillis() - _frameStart) > FUSION_ALIGN_MS) break;
+            return false;
+        }
+
+        // Il campione più vecchio tra quelli in attesa
+        uint8_t i = 0xFF;
+        for (uint8_t k = 0; k < _count; k++) {
+            if (!(_headMask & (1 << k))) continue;
+            if (i == 0xFF || (int32_t)(_head[k].timestamp - _head[i].timestamp) < 0) i = k;
+        }
+        uint8_t          bit = 1 << i;
+        const RadarData& s   = _head[i];
+
+        // Secondo campione dello stesso sensore o frame più ampio
+        // della finestra (anche all'indietro: consegna in ritardo):
+        // resta in attesa e apre il prossimo frame
+        if (_frameMask) {
+            if (_frameMask & bit) break;
+            if ((int32_t)(s.timestamp - _frameStart) > FUSION_ALIGN_MS) break;
+            if ((int32_t)(_frameEnd - s.timestamp) > FUSION_ALIGN_MS) break;
+            if ((int32_t)(s.timestamp - _frameStart) < 0) _frameStart = s.timestamp;
+            if ((int32_t)(s.timestamp - _frameEnd) > 0)   _frameEnd   = s.timestamp;
+        } else {
+            _frameStart = _frameEnd = s.timestamp;
+        }
+        _frame[i]        = s;
+        _frame[i].sensor = i;
+        _frameMask      |= bit;
+        _headMask       &= ~bit;
+    }
+
+    if ((_frameMask & ready) != ready) _partial++;
+    _close();
+    out = _data;
+    return true;
+}
+
+// ============================================================
+// _close() - Campione fuso dal frame
+// ============================================================
+void RadarFusion::_close() {
+    uint8_t best  = 0xFF;
+    uint8_t first = 0xFF;
+
+    memset(_zoneMask, 0, sizeof(_zoneMask));
+    for (uint8_t i = 0; i < _count; i++) {
+        uint8_t bit = 1 << i;
+        if (!(_frameMask & bit)) continue;
+
+        const RadarData& s = _frame[i];
+        _latest[i] = s;
+        if (first == 0xFF) first = i;
+        if (!s.detected) continue;
+
+        _zoneMask[s.zone & 3] |= bit;
+        if (best == 0xFF || s.filtered_dist < _frame[best].filtered_dist) best = i;
+    }
+
+    // Nessuna presenza: campione vuoto del primo sensore del frame
+    RadarData out = _frame[best != 0xFF ? best : first];
+
+    // Timestamp del contributo più recente, mai all'indietro
+    out.timestamp = (_frames && (int32_t)(_frameEnd - _data.timestamp) < 0) ? _data.timestamp : _frameEnd;
+
+    _data      = out;
+    _frameMask = 0;
+    _frames++;
+}
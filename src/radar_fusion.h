@@ -0,0 +1,91 @@
+// ============================================================
+// AutoGuard - Fusione multi-radar
+// ============================================================
+// Unisce i flussi di più sorgenti (un LD2420 per lato del
+// veicolo) in un unico flusso per la state machine:
+//   - fusione per timestamp: tra i campioni in attesa delle
+//     sorgenti si prende sempre il più vecchio
+//   - frame: al più un campione per sensore, tutti entro
+//     FUSION_ALIGN_MS tra loro. Il frame si chiude quando tutti
+//     i sensori pronti hanno contribuito, quando un sensore
+//     invia il campione successivo o alla scadenza della finestra
+//     (sensore in ritardo o muto)
+//   - campione fuso: presenza se almeno un sensore la rileva,
+//     distanza, zona e traccia del bersaglio più vicino
+// Un campione fuso per frame: con più sensori il ritmo verso
+// AlarmLogic resta quello di un sensore solo (i contatori del
+// rilevatore non accelerano). Con un solo sensore il flusso è
+// identico a quello del driver.
+// Memoria fissa, nessuna allocazione. Non dipende da Arduino.
+// ============================================================
+#ifndef RADAR_FUSION_H
+#define RADAR_FUSION_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "config.h"
+#include "radar_types.h"
+#include "radar_source.h"
+
+#define FUSION_MAX_SENSORS  3
+
+static_assert(RADAR_COUNT >= 1 && RADAR_COUNT <= FUSION_MAX_SENSORS,
+              "RADAR_COUNT: da 1 a FUSION_MAX_SENSORS");
+
+class RadarFusion : public RadarSource {
+public:
+    RadarFusion();
+
+    // Registra la prossima sorgente (indice sensore = ordine di
+    // registrazione). false oltre FUSION_MAX_SENSORS
+    bool addSource(RadarSource* src);
+
+    // Avanza tutte le sorgenti (no-op per quelle con task)
+    void update() override;
+
+    // Prossimo campione fuso; false se nessun frame è completo
+    bool readSample(RadarData& out) override;
+
+    // Ultimo campione fuso
+    RadarData getData() override;
+
+    // true se almeno una sorgente è pronta
+    bool isReady() override;
+
+    // ---- Quadro presenze per sensore e zona ----
+    uint8_t          count() const { return _count; }
+    const RadarData& sensorData(uint8_t i) const { return _latest[i < FUSION_MAX_SENSORS ? i : 0]; }
+
+    // Bit i = sensore i con presenza in zona z nell'ultimo frame
+    uint8_t zoneMask(RadarZone z) const { return _zoneMask[z & 3]; }
+
+    // Statistiche
+    uint32_t frames()  const { return _frames; }
+    uint32_t partial() const { return _partial; }   // chiusi senza tutti i sensori
+
+private:
+    RadarSource* _src[FUSION_MAX_SENSORS];
+    uint8_t      _count;
+
+    // Campione estratto ma non ancora fuso, per sorgente
+    RadarData    _head[FUSION_MAX_SENSORS];
+    uint8_t      _headMask;
+
+    // Frame in costruzione
+    RadarData    _frame[FUSION_MAX_SENSORS];
+    uint8_t      _frameMask;
+    uint32_t     _frameStart;                   // campione più vecchio
+    uint32_t     _frameEnd;                     // campione più recente
+
+    RadarData    _latest[FUSION_MAX_SENSORS];   // ultimo campione fuso per sensore
+    uint8_t      _zoneMask[4];
+    RadarData    _data;                         // ultimo campione fuso
+    uint32_t     _frames;
+    uint32_t     _partial;
+
+    uint8_t _readyMask();
+    bool    _add(uint8_t i, const RadarData& s);
+    void    _close();
+};
+
+#endif // RADAR_FUSION_H
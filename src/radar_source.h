@@ -0,0 +1,30 @@
+// ============================================================
+// AutoGuard - Sorgente campioni radar
+// ============================================================
+// Interfaccia comune tra il driver reale (SensorLD2420) e le
+// sorgenti simulate (TraceReplay): il consumatore (loop, host)
+// estrae campioni senza sapere da dove arrivano.
+// ============================================================
+#ifndef RADAR_SOURCE_H
+#define RADAR_SOURCE_H
+
+#include "radar_types.h"
+
+class RadarSource {
+public:
+    virtual ~RadarSource() {}
+
+    // Avanza la sorgente (polling); no-op se alimentata altrove
+    virtual void update() = 0;
+
+    // Estrae il prossimo campione; false se non disponibile
+    virtual bool readSample(RadarData& out) = 0;
+
+    // Ultimo campione estratto
+    virtual RadarData getData() = 0;
+
+    // true se la sorgente è pronta
+    virtual bool isReady() = 0;
+};
+
+#endif // RADAR_SOURCE_H
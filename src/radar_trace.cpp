@@ -0,0 +1,383 @@
+// ============================================================
+// AutoGuard - Trace radar - Implementazione
+// ============================================================
+#include "radar_trace.h"
+#include <string.h>
+#include "zone_map.h"
+
+TraceRecorder traceRecorder;
+
+#define ZONE_SHIFT      1
+#define ZONE_MASK       0x03
+#define ZONE_ID_SHIFT   3
+#define ZONE_ID_MASK    0x0F
+
+static_assert(ZONE_MAP_MAX <= ZONE_ID_MASK, "zone_id: 4 bit nei flags");
+
+static inline void put16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static inline void put32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static inline uint16_t get16(const uint8_t* p) {
+    return p[0] | ((uint16_t)p[1] << 8);
+}
+
+static inline uint32_t get32(const uint8_t* p) {
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline size_t putVarint(uint8_t* p, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Legge un varint entro end; false se troncato
+static bool getVarint(const uint8_t* buf, size_t& pos, size_t end, uint32_t& out) {
+    out = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= end) return false;
+        uint8_t b = buf[pos++];
+        out |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// ============================================================
+// TraceRecorder
+// ============================================================
+TraceRecorder::TraceRecorder() :
+    _used(0),
+    _count(0),
+    _current(0),
+    _filled(0),
+    _prevTs(0),
+    _prevDist(0),
+    _samples(0),
+    _cfgVersion(0),
+    _sink(nullptr),
+    _sinkCtx(nullptr),
+    _gen(0)
+{
+    memset(&_cfg, 0, sizeof(_cfg));
+}
+
+void TraceRecorder::syncConfig() {
+    uint32_t version = configMgr.version();
+    if (version == _cfgVersion) return;
+    _gen.fetch_add(1, std::memory_order_acq_rel);
+    _cfg        = configMgr.get();
+    _cfgVersion = version;
+    _gen.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void TraceRecorder::setBlockSink(TraceBlockSink sink, void* ctx) {
+    _sink    = sink;
+    _sinkCtx = ctx;
+}
+
+// ============================================================
+// record() - Codifica delta di un campione
+// ============================================================
+void TraceRecorder::record(const RadarData& data) {
+    syncConfig();
+    _gen.fetch_add(1, std::memory_order_acq_rel);
+
+    if (_used == 0) _openBlock(data.timestamp);
+
+    uint8_t  tmp[TRACE_SAMPLE_MAX_LEN];
+    size_t   n;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        n = 0;
+        tmp[n++] = (data.detected ? 1 : 0) | (((uint8_t)data.zone & ZONE_MASK) << ZONE_SHIFT) |
+                   ((data.zone_id & ZONE_ID_MASK) << ZONE_ID_SHIFT);
+        n += putVarint(tmp + n, data.timestamp - _prevTs);
+        n += putVarint(tmp + n, zigzag(data.distance_cm - _prevDist));
+        n += putVarint(tmp + n, zigzag(data.filtered_dist - data.distance_cm));
+
+        if (_used + n <= TRACE_BLOCK_SIZE) break;
+
+        // Blocco pieno: nuovo blocco con riferimenti azzerati
+        _closeBlock();
+        _openBlock(data.timestamp);
+    }
+
+    uint8_t* block = _blocks[_current];
+    memcpy(block + _used, tmp, n);
+    _used += n;
+    _count++;
+    put16(block, _used);
+    put16(block + 2, _count);
+
+    _prevTs   = data.timestamp;
+    _prevDist = data.distance_cm;
+    _samples++;
+
+    _gen.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void TraceRecorder::_openBlock(uint32_t ts) {
+    uint8_t* block = _blocks[_current];
+    memset(block, 0, TRACE_BLOCK_SIZE);
+    put32(block + 4, ts);
+    _used     = TRACE_BLOCK_HEADER_LEN;
+    _count    = 0;
+    _prevTs   = ts;
+    _prevDist = 0;
+    put16(block, _used);
+}
+
+void TraceRecorder::_closeBlock() {
+    if (_sink) _sink(_blocks[_current], TRACE_BLOCK_SIZE, _sinkCtx);
+
+    _current = (_current + 1) % TRACE_RAM_BLOCKS;
+    if (_filled < TRACE_RAM_BLOCKS - 1) _filled++;
+    _used = 0;
+}
+
+void TraceRecorder::flush() {
+    if (_used <= TRACE_BLOCK_HEADER_LEN) return;
+    _gen.fetch_add(1, std::memory_order_acq_rel);
+    _closeBlock();
+    _gen.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void TraceRecorder::clear() {
+    _gen.fetch_add(1, std::memory_order_acq_rel);
+    _used    = 0;
+    _filled  = 0;
+    _samples = 0;
+    _gen.fetch_add(1, std::memory_order_acq_rel);
+}
+
+uint32_t TraceRecorder::bytesUsed() const {
+    return (uint32_t)_filled * TRACE_BLOCK_SIZE + _used;
+}
+
+// ============================================================
+// writeHeader() - Header + snapshot config campo per campo
+// ============================================================
+size_t TraceRecorder::writeHeader(uint8_t* dst, size_t cap) {
+    size_t len = TRACE_HEADER_LEN + TRACE_CONFIG_LEN;
+    if (cap < len) return 0;
+
+    memset(dst, 0, TRACE_HEADER_LEN);
+    memcpy(dst, TRACE_MAGIC, 4);
+    dst[4] = TRACE_VERSION;
+    put16(dst + 6, TRACE_CONFIG_COUNT);
+    put32(dst + 8, TRACE_BLOCK_SIZE);
+
+    uint8_t* p = dst + TRACE_HEADER_LEN;
+#define PUT_FIELD(name)  put32(p, (uint32_t)(int32_t)_cfg.name); p += 4;
+    TRACE_CONFIG_FIELDS(PUT_FIELD)
+#undef PUT_FIELD
+    return len;
+}
+
+// ============================================================
+// copy() - Trace completa sotto seqlock
+// ============================================================
+size_t TraceRecorder::copy(uint8_t* dst, size_t cap) {
+    for (int attempt = 0; attempt < 4; attempt++) {
+        uint32_t g1 = _gen.load(std::memory_order_acquire);
+        if (g1 & 1) continue;
+
+        size_t len = writeHeader(dst, cap);
+        if (len == 0) return 0;
+
+        // Blocchi chiusi dal più vecchio, poi quello corrente troncato
+        uint8_t filled = _filled;
+        uint8_t first  = (_current + TRACE_RAM_BLOCKS - filled) % TRACE_RAM_BLOCKS;
+        bool    fits   = true;
+        for (uint8_t i = 0; i < filled && fits; i++) {
+            if (len + TRACE_BLOCK_SIZE > cap) { fits = false; break; }
+            memcpy(dst + len, _blocks[(first + i) % TRACE_RAM_BLOCKS], TRACE_BLOCK_SIZE);
+            len += TRACE_BLOCK_SIZE;
+        }
+        uint16_t used = _used;
+        if (fits && used > TRACE_BLOCK_HEADER_LEN) {
+            if (len + used > cap) {
+                fits = false;
+            } else {
+                memcpy(dst + len, _blocks[_current], used);
+                len += used;
+            }
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_gen.load(std::memory_order_relaxed) == g1) {
+            return fits ? len : 0;
+        }
+    }
+    return 0;
+}
+
+// ============================================================
+// TraceReader
+// ============================================================
+TraceReader::TraceReader() :
+    _buf(nullptr),
+    _len(0),
+    _blockSize(0),
+    _blockPos(0),
+    _pos(0),
+    _blockEnd(0),
+    _left(0),
+    _version(0),
+    _prevTs(0),
+    _prevDist(0),
+    _zoneTracking(false),
+    _zoneId(0),
+    _zoneSince(0),
+    _badBlocks(0),
+    _cfgValid(false)
+{
+    memset(&_cfg, 0, sizeof(_cfg));
+}
+
+bool TraceReader::open(const uint8_t* buf, size_t len) {
+    _buf       = buf;
+    _len       = 0;
+    _left      = 0;
+    _badBlocks = 0;
+    _cfgValid  = false;
+    _zoneTracking = false;
+
+    if (len < TRACE_HEADER_LEN || memcmp(buf, TRACE_MAGIC, 4) != 0 ||
+        buf[4] < 1 || buf[4] > TRACE_VERSION) {
+        return false;
+    }
+    _version = buf[4];
+
+    // Versione 1: lunghezza in byte di una struct copiata così com'era
+    uint16_t fields = get16(buf + 6);
+    size_t   cfgLen = _version == 1 ? fields : 4 * (size_t)fields;
+    _blockSize      = get32(buf + 8);
+    if (_blockSize <= TRACE_BLOCK_HEADER_LEN || TRACE_HEADER_LEN + cfgLen > len) {
+        return false;
+    }
+
+    if (_version >= 2) {
+        ConfigManager::loadDefaults(_cfg);
+        const uint8_t* p = buf + TRACE_HEADER_LEN;
+        uint16_t       i = 0;
+#define GET_FIELD(name)  if (i++ < fields) { _cfg.name = (decltype(_cfg.name))(int32_t)get32(p); p += 4; }
+        TRACE_CONFIG_FIELDS(GET_FIELD)
+#undef GET_FIELD
+        _cfgValid = true;
+    }
+
+    _len      = len;
+    _blockPos = TRACE_HEADER_LEN + cfgLen;
+    _pos      = _blockPos;
+    _blockEnd = _blockPos;
+    return true;
+}
+
+// Posiziona il lettore sul prossimo blocco non vuoto
+bool TraceReader::_enterBlock() {
+    while (_blockPos + TRACE_BLOCK_HEADER_LEN <= _len) {
+        const uint8_t* b    = _buf + _blockPos;
+        uint16_t       used = get16(b);
+        uint16_t       cnt  = get16(b + 2);
+        size_t         at   = _blockPos;
+
+        _blockPos += _blockSize;
+
+        if (used < TRACE_BLOCK_HEADER_LEN || used > _blockSize || at + used > _len) {
+            _badBlocks++;
+            continue;
+        }
+        if (cnt == 0) continue;
+
+        _pos      = at + TRACE_BLOCK_HEADER_LEN;
+        _blockEnd = at + used;
+        _left     = cnt;
+        _prevTs   = get32(b + 4);
+        _prevDist = 0;
+        return true;
+    }
+    return false;
+}
+
+bool TraceReader::next(RadarData& out) {
+    while (true) {
+        if (_left == 0 && !_enterBlock()) return false;
+
+        uint32_t dt, dDist, dFilt;
+        if (_pos >= _blockEnd) {
+            _badBlocks++;
+            _left = 0;
+            continue;
+        }
+        uint8_t flags = _buf[_pos++];
+        if (!getVarint(_buf, _pos, _blockEnd, dt) ||
+            !getVarint(_buf, _pos, _blockEnd, dDist) ||
+            !getVarint(_buf, _pos, _blockEnd, dFilt)) {
+            _badBlocks++;
+            _left = 0;
+            continue;
+        }
+
+        _prevTs   += dt;
+        _prevDist += unzigzag(dDist);
+        _left--;
+
+        out.detected      = flags & 1;
+        out.zone          = (RadarZone)((flags >> ZONE_SHIFT) & ZONE_MASK);
+        out.distance_cm   = _prevDist;
+        out.filtered_dist = _prevDist + unzigzag(dFilt);
+        out.timestamp     = _prevTs;
+        out.velocity      = 0;
+        out.accel         = 0;
+        out.trajectory    = TRAJ_NONE;
+        out.sensor        = 0;
+        out.zone_id       = _version == 1 ? (out.detected ? out.zone : 0)
+                                          : (flags >> ZONE_ID_SHIFT) & ZONE_ID_MASK;
+
+        // Permanenza continua: azzerata senza presenza o al cambio di zona
+        if (!out.detected) {
+            _zoneTracking = false;
+            out.zone_ms   = 0;
+        } else {
+            if (!_zoneTracking || out.zone_id != _zoneId) {
+                _zoneTracking = true;
+                _zoneId       = out.zone_id;
+                _zoneSince    = _prevTs;
+            }
+            out.zone_ms = _prevTs - _zoneSince;
+        }
+        return true;
+    }
+}
+
+// ============================================================
+// TraceReplay
+// ============================================================
+bool TraceReplay::readSample(RadarData& out) {
+    if (!_reader.next(_data)) return false;
+    _tracker.apply(_data);
+    out = _data;
+    return true;
+}
@@ -0,0 +1,199 @@
+// ============================================================
+// AutoGuard - Trace radar (registrazione + replay)
+// ============================================================
+// Formato binario compatto (little-endian), versione 2:
+//   header 16 byte + snapshot config:
+//     [0..3]   magic 'A' 'G' 'T' 'R'
+//     [4]      versione (2)
+//     [5]      riservato
+//     [6..7]   numero di campi config (u16)
+//     [8..11]  dimensione blocco (byte, u32)
+//     [12..15] riservato
+//     [16..]   config al momento della registrazione: un i32 per
+//              campo nell'ordine di TRACE_CONFIG_FIELDS, senza
+//              dipendere da layout, padding o dimensione di bool.
+//              I campi assenti (trace più vecchie) prendono i
+//              default di config.h, quelli in più sono ignorati
+//   blocchi di TRACE_BLOCK_SIZE byte, dal più vecchio:
+//     [0..1]   byte usati nel blocco (header incluso)
+//     [2..3]   numero campioni
+//     [4..7]   timestamp base (ms)
+//     [8..]    campioni a lunghezza variabile:
+//                flags    u8      bit0 = detected, bit1..2 = zona,
+//                                 bit3..6 = zone_id
+//                dt       varint  ms dal campione precedente
+//                dDist    zigzag  distance_cm - precedente
+//                dFilt    zigzag  filtered_dist - distance_cm
+// Ogni blocco è decodificabile da solo (precedente = base, 0cm):
+// il ring RAM scarta blocchi interi senza rompere la decodifica.
+// La permanenza in zona (zone_ms) si ricava dai cambi di zone_id.
+// Versione 1 (snapshot = copia binaria della struct): campioni
+// letti, config ignorata, zone_id = classe della zona.
+// Velocità, traiettoria e sensore di origine non sono
+// registrati: il replay ricalcola velocità e traiettoria con lo
+// stesso tracker del sensore. Con più radar la trace contiene il
+// flusso fuso (radar_fusion.h).
+// Un campione tipico occupa 4 byte.
+// Non dipende da Arduino: compilabile anche su host.
+// ============================================================
+#ifndef RADAR_TRACE_H
+#define RADAR_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "config.h"
+#include "config_manager.h"
+#include "radar_types.h"
+#include "radar_source.h"
+#include "radar_tracker.h"
+
+#define TRACE_MAGIC             "AGTR"
+#define TRACE_VERSION           2
+#define TRACE_HEADER_LEN        16
+#define TRACE_BLOCK_HEADER_LEN  8
+#define TRACE_SAMPLE_MAX_LEN    16      // flags + 3 varint da 5 byte
+
+// Campi della config nell'header: solo aggiunte in coda, mai
+// riordinare o rimuovere (le trace registrate restano leggibili)
+#define TRACE_CONFIG_FIELDS(F) \
+    F(zoneCriticalMax)        F(zoneMediumMax)          F(zoneFarMax) \
+    F(zoneHystEnterCm)        F(zoneHystExitCm)         F(armingDelayMs) \
+    F(preAlarmMs)             F(alarmDurationMs)        F(cooldownMs) \
+    F(detectionsToAlert)      F(radarMinDist)           F(radarMaxDist) \
+    F(alarmMinDist)           F(alarmZoneCritical)      F(alarmZoneMedium) \
+    F(alarmZoneFar)           F(filterMode)             F(filterEmaAlpha) \
+    F(filterKalmanQ)          F(filterKalmanR)          F(engineeringMode) \
+    F(noiseSigmaX10)          F(detectorMode)           F(evidenceThreshold) \
+    F(evidenceHalfLifeMs)     F(evidenceWeightCritical) F(evidenceWeightMedium) \
+    F(evidenceWeightFar)      F(evidenceDwellMs)        F(evidenceApproachPct) \
+    F(approachEscalate)       F(approachLeadMs)
+
+#define TRACE_CONFIG_ONE(name)  + 1
+#define TRACE_CONFIG_COUNT      (0 TRACE_CONFIG_FIELDS(TRACE_CONFIG_ONE))
+#define TRACE_CONFIG_LEN        (4 * TRACE_CONFIG_COUNT)
+#define TRACE_MAX_LEN           (TRACE_HEADER_LEN + TRACE_CONFIG_LEN + \
+                                 TRACE_RAM_BLOCKS * TRACE_BLOCK_SIZE)
+
+// Callback blocco completato (es. scrittura su file)
+typedef void (*TraceBlockSink)(const uint8_t* block, size_t len, void* ctx);
+
+// ------------------------------------------------------------
+// TraceRecorder - ring RAM di blocchi (scrittore: loop)
+// ------------------------------------------------------------
+// Il seqlock ammette un solo scrittore: anche lo snapshot config
+// dell'header è aggiornato dal loop (record() confronta
+// configMgr.version()), mai dal task che salva la config.
+class TraceRecorder {
+public:
+    TraceRecorder();
+
+    // Copia la config corrente per l'header se è cambiata (solo
+    // dal loop; record() lo fa da sé)
+    void syncConfig();
+
+    // Registra un campione (solo dal loop)
+    void record(const RadarData& data);
+
+    // Chiude il blocco corrente (passato al sink se impostato)
+    void flush();
+
+    // Svuota il ring
+    void clear();
+
+    // Blocchi completati anche verso un sink (es. file su host)
+    void setBlockSink(TraceBlockSink sink, void* ctx);
+
+    // Header + snapshot config in dst; restituisce la lunghezza
+    size_t writeHeader(uint8_t* dst, size_t cap);
+
+    // Copia consistente dell'intera trace (da qualsiasi task).
+    // Restituisce la lunghezza, 0 se cap insufficiente o contesa.
+    size_t copy(uint8_t* dst, size_t cap);
+
+    // Statistiche
+    uint32_t samples() const { return _samples; }
+    uint32_t bytesUsed() const;
+
+private:
+    uint8_t          _blocks[TRACE_RAM_BLOCKS][TRACE_BLOCK_SIZE];
+    uint16_t         _used;          // byte usati nel blocco corrente
+    uint16_t         _count;         // campioni nel blocco corrente
+    uint8_t          _current;       // blocco in scrittura
+    uint8_t          _filled;        // blocchi validi nel ring
+    uint32_t         _prevTs;
+    int32_t          _prevDist;
+    uint32_t         _samples;
+    AutoGuardConfig  _cfg;
+    uint32_t         _cfgVersion;    // versione di _cfg (0 = nessuna)
+    TraceBlockSink   _sink;
+    void*            _sinkCtx;
+
+    std::atomic<uint32_t> _gen;      // seqlock (dispari = scrittura)
+
+    void _openBlock(uint32_t ts);
+    void _closeBlock();
+};
+
+// ------------------------------------------------------------
+// TraceReader - decodifica una trace in memoria
+// ------------------------------------------------------------
+class TraceReader {
+public:
+    TraceReader();
+
+    // false se header non valido
+    bool open(const uint8_t* buf, size_t len);
+
+    // Snapshot config; nullptr se assente (trace versione 1)
+    const AutoGuardConfig* config() const { return _cfgValid ? &_cfg : nullptr; }
+
+    // Prossimo campione; false a fine trace
+    bool next(RadarData& out);
+
+    // Blocchi corrotti saltati
+    uint32_t badBlocks() const { return _badBlocks; }
+
+private:
+    const uint8_t*   _buf;
+    size_t           _len;
+    size_t           _blockSize;
+    size_t           _blockPos;      // offset prossimo blocco
+    size_t           _pos;           // offset nel buffer
+    size_t           _blockEnd;
+    uint16_t         _left;          // campioni rimasti nel blocco
+    uint8_t          _version;
+    uint32_t         _prevTs;
+    int32_t          _prevDist;
+    bool             _zoneTracking;  // permanenza come in ZoneMap
+    uint8_t          _zoneId;
+    uint32_t         _zoneSince;
+    uint32_t         _badBlocks;
+    AutoGuardConfig  _cfg;
+    bool             _cfgValid;
+
+    bool _enterBlock();
+};
+
+// ------------------------------------------------------------
+// TraceReplay - sorgente radar da trace registrata
+// ------------------------------------------------------------
+class TraceReplay : public RadarSource {
+public:
+    bool open(const uint8_t* buf, size_t len) { return _reader.open(buf, len); }
+    const AutoGuardConfig* config() const { return _reader.config(); }
+
+    void update() override {}
+    bool readSample(RadarData& out) override;
+    RadarData getData() override { return _data; }
+    bool isReady() override { return true; }
+
+private:
+    TraceReader  _reader;
+    RadarTracker _tracker;
+    RadarData    _data = {};
+};
+
+extern TraceRecorder traceRecorder;
+
+#endif // RADAR_TRACE_H
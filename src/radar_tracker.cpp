@@ -0,0 +1,197 @@
+// ============================================================
+// AutoGuard - Tracker radiale - Implementazione
+// ============================================================
+#include "radar_tracker.h"
+
+static_assert(TRACKER_ALPHA > 0 && TRACKER_ALPHA <= 1000, "TRACKER_ALPHA in millesimi");
+static_assert(TRACKER_GAP_MS <= 60000, "TRACKER_GAP_MS: overflow Q8");
+
+// Limite dello stato interno (cm, cm/s, cm/s^2): solo contro
+// l'overflow, le uscite sono saturate a TRACKER_*_MAX
+#define STATE_MAX       100000
+
+// Oltre, i guadagni a memoria crescente sono sotto quelli fissi
+#define GROW_SAMPLES    250
+
+// Predizione affidabile per il controllo dei salti
+#define GATE_SAMPLES    8
+
+static inline int32_t clampQ8(int64_t v, int32_t max) {
+    int64_t lim = (int64_t)max << 8;
+    if (v >  lim) return (int32_t)lim;
+    if (v < -lim) return (int32_t)-lim;
+    return (int32_t)v;
+}
+
+static inline int roundQ8(int32_t v) {
+    return v >= 0 ? (v + 128) >> 8 : -((-v + 128) >> 8);
+}
+
+// ============================================================
+// reset()
+// ============================================================
+void RadarTracker::reset() {
+    _x          = 0;
+    _v          = 0;
+    _a          = 0;
+    _lastMs     = 0;
+    _startMs    = 0;
+    _approachMs = 0;
+    _anchorX    = 0;
+    _anchorMs   = 0;
+    _moveMs     = 0;
+    _samples    = 0;
+    _traj       = TRAJ_NONE;
+}
+
+void RadarTracker::_start(int32_t zQ8, uint32_t now) {
+    reset();
+    _x        = zQ8;
+    _anchorX  = zQ8;
+    _lastMs   = now;
+    _startMs  = now;
+    _anchorMs = now;
+    _samples = 1;
+}
+
+// ============================================================
+// _gains() - Guadagni in millesimi
+// ============================================================
+// Traccia giovane: memoria crescente (minimi quadrati su tutti i
+// campioni della traccia, esatto su moto uniformemente
+// accelerato); poi i guadagni fissi TRACKER_ALPHA/BETA/GAMMA.
+// Evita il transitorio della velocità da due soli campioni.
+void RadarTracker::_gains(int32_t& alpha, int32_t& beta, int32_t& gamma) const {
+    uint32_t n  = _samples;                     // campioni già nella traccia
+    uint32_t dn = n * (n + 1) * (n + 2);
+
+    alpha = (int32_t)(3000 * (3 * n * n - 3 * n + 2) / dn);
+    beta  = (int32_t)(18000 * (2 * n - 1) / dn);
+    gamma = (int32_t)(30000 / dn);
+
+    if (alpha < TRACKER_ALPHA) alpha = TRACKER_ALPHA;
+    if (beta  < TRACKER_BETA)  beta  = TRACKER_BETA;
+    if (gamma < TRACKER_GAMMA) gamma = TRACKER_GAMMA;
+}
+
+// ============================================================
+// apply() - Predizione + correzione a passo variabile
+// ============================================================
+void RadarTracker::apply(RadarData& d) {
+    uint32_t now = d.timestamp;
+
+    if (!d.detected) {
+        // Buchi brevi: la traccia resta in attesa del prossimo campione
+        if (_samples && now - _lastMs > TRACKER_GAP_MS) reset();
+        d.velocity   = 0;
+        d.accel      = 0;
+        d.trajectory = TRAJ_NONE;
+        return;
+    }
+
+    int32_t  z  = (int32_t)d.distance_cm << 8;
+    uint32_t dt = now - _lastMs;
+
+    if (!_samples || dt > TRACKER_GAP_MS) {
+        _start(z, now);
+    } else if (dt > 0) {
+        // Predizione
+        int64_t dt2 = (int64_t)dt * dt;
+        int32_t xp  = _x + (int32_t)(((int64_t)_v * dt) / 1000 + ((int64_t)_a * dt2) / 2000000);
+        int32_t vp  = _v + (int32_t)(((int64_t)_a * dt) / 1000);
+        int32_t r   = z - xp;
+
+        if (_samples >= GATE_SAMPLES &&
+            (r > (TRACKER_GATE_CM << 8) || r < -(TRACKER_GATE_CM << 8))) {
+            // Salto incompatibile con la traccia: nuovo bersaglio
+            _start(z, now);
+        } else {
+            int32_t alpha, beta, gamma;
+            _gains(alpha, beta, gamma);
+            _x = xp + (int32_t)(((int64_t)r * alpha) / 1000);
+            _v = clampQ8(vp + ((int64_t)r * beta) / dt, STATE_MAX);
+            _a = clampQ8(_a + ((int64_t)r * gamma * 2000) / dt2, STATE_MAX);
+            if (_samples < GROW_SAMPLES) _samples++;
+        }
+        _lastMs = now;
+        _classify(dt, now);
+    }
+
+    d.velocity   = roundQ8(clampQ8(_v, TRACKER_SPEED_MAX_CMS));
+    d.accel      = roundQ8(clampQ8(_a, TRACKER_ACCEL_MAX_CMS2));
+    d.trajectory = _traj;
+}
+
+// ============================================================
+// _classify() - Traiettoria dalla velocità stimata
+// ============================================================
+void RadarTracker::_classify(uint32_t dt, uint32_t now) {
+    int32_t v = _v >> 8;
+
+    // Isteresi: l'avvicinamento si interrompe sopra metà soglia
+    if (v <= -TRACKER_APPROACH_CMS)          _approachMs += dt;
+    else if (v > -TRACKER_APPROACH_CMS / 2)  _approachMs  = 0;
+
+    // Sosta: posizione entro +/-TRACKER_LOITER_CM dall'ancora
+    int32_t drift = _x - _anchorX;
+    if (drift > (TRACKER_LOITER_CM << 8) || drift < -(TRACKER_LOITER_CM << 8)) {
+        _anchorX  = _x;
+        _anchorMs = now;
+    }
+
+    // Isteresi: il movimento si interrompe sotto metà soglia
+    int32_t speed = v < 0 ? -v : v;
+    if (speed >= TRACKER_MOVE_CMS)         _moveMs += dt;
+    else if (speed < TRACKER_MOVE_CMS / 2) _moveMs  = 0;
+
+    if (now - _startMs < TRACKER_MIN_TRACK_MS) {
+        _traj = TRAJ_NONE;
+    } else if (_approachMs >= TRACKER_APPROACH_MS) {
+        _traj = TRAJ_APPROACHING;
+    } else if (now - _anchorMs >= TRACKER_LOITER_MS) {
+        _traj = TRAJ_LOITERING;
+    } else if (_moveMs >= TRACKER_PASS_MS && _approachMs == 0) {
+        _traj = TRAJ_PASSING;
+    } else if (_traj == TRAJ_APPROACHING && _approachMs == 0) {
+        _traj = TRAJ_NONE;
+    }
+    // altrimenti resta la classe precedente (movimenti brevi)
+}
+
+// ============================================================
+// predictMin() - Distanza minima su traiettoria rettilinea
+// ============================================================
+// Bersaglio a velocità costante nel piano: r(t)^2 = r^2 +
+// 2 r r' t + v^2 t^2, con v^2 = r r'' + r'^2 (la componente
+// tangenziale non può essere negativa: r'' >= 0). Avvicinamento
+// diretto: r'' = 0, minimo a distanza nulla; passaggio laterale:
+// r'' > 0, minimo alla distanza di passaggio.
+static uint32_t isqrt64(uint64_t n) {
+    uint64_t r   = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > n) bit >>= 2;
+    while (bit) {
+        if (n >= r + bit) {
+            n -= r + bit;
+            r  = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+int RadarTracker::predictMin(const RadarData& d, uint32_t horizonMs) {
+    int64_t r  = d.filtered_dist;
+    int64_t rv = r * d.velocity;                                // r r'
+    int64_t v2 = r * (d.accel > 0 ? d.accel : 0) + (int64_t)d.velocity * d.velocity;
+    if (rv >= 0 || v2 <= 0) return (int)r;                     // non si avvicina
+
+    // Istante del minimo (ms), limitato all'orizzonte
+    int64_t t = -rv * 1000 / v2;
+    if (t > (int64_t)horizonMs) t = horizonMs;
+
+    int64_t r2 = r * r + 2 * rv * t / 1000 + v2 * t * t / 1000000;
+    return r2 > 0 ? (int)isqrt64((uint64_t)r2) : 0;
+}
@@ -0,0 +1,67 @@
+// ============================================================
+// AutoGuard - Tracker radiale (velocità e traiettoria)
+// ============================================================
+// Filtro alfa-beta-gamma sulla distanza grezza (la pipeline
+// filtri riparte a ogni campione vuoto: il suo ritardo sfalsa le
+// differenze): stima posizione, velocità radiale e accelerazione
+// del bersaglio con passo variabile (timestamp dei campioni).
+// Su ogni campione classifica la traiettoria:
+//   - avvicinamento: velocità sotto -TRACKER_APPROACH_CMS per
+//     almeno TRACKER_APPROACH_MS
+//   - sosta: posizione entro +/-TRACKER_LOITER_CM per almeno
+//     TRACKER_LOITER_MS (piccoli spostamenti sul posto)
+//   - transito: |velocità| sopra TRACKER_MOVE_CMS per almeno
+//     TRACKER_PASS_MS senza avvicinamento (passaggio laterale,
+//     allontanamento)
+// Un salto oltre TRACKER_GATE_CM o un'assenza oltre
+// TRACKER_GAP_MS apre una nuova traccia.
+// Stato in Q8 (cm, cm/s, cm/s^2), guadagni in millesimi: solo
+// aritmetica intera (ESP32-C6 senza FPU). Non dipende da Arduino.
+// ============================================================
+#ifndef RADAR_TRACKER_H
+#define RADAR_TRACKER_H
+
+#include <stdint.h>
+#include "config.h"
+#include "radar_types.h"
+
+class RadarTracker {
+public:
+    RadarTracker() { reset(); }
+
+    // Aggiorna la traccia e completa velocity/accel/trajectory
+    // del campione (detected, distance_cm, timestamp)
+    void apply(RadarData& d);
+
+    void reset();
+
+    // Distanza minima prevista entro horizonMs (traiettoria
+    // rettilinea a velocità costante, da velocità e accelerazione
+    // radiali del campione)
+    static int predictMin(const RadarData& d, uint32_t horizonMs);
+
+    // Avvicinamento sostenuto che porta entro distCm in horizonMs
+    static bool reaches(const RadarData& d, int distCm, uint32_t horizonMs) {
+        return d.detected && d.trajectory == TRAJ_APPROACHING &&
+               predictMin(d, horizonMs) <= distCm;
+    }
+
+private:
+    int32_t         _x;             // posizione, cm Q8
+    int32_t         _v;             // velocità, cm/s Q8 (<0 = avvicinamento)
+    int32_t         _a;             // accelerazione, cm/s^2 Q8
+    uint32_t        _lastMs;        // ultimo campione con presenza
+    uint32_t        _startMs;       // inizio traccia
+    uint32_t        _approachMs;    // tempo in avvicinamento
+    int32_t         _anchorX;       // inizio della sosta, cm Q8
+    uint32_t        _anchorMs;
+    uint32_t        _moveMs;        // tempo in movimento
+    uint8_t         _samples;       // campioni nella traccia (saturato)
+    RadarTrajectory _traj;
+
+    void _start(int32_t zQ8, uint32_t now);
+    void _gains(int32_t& alpha, int32_t& beta, int32_t& gamma) const;
+    void _classify(uint32_t dt, uint32_t now);
+};
+
+#endif // RADAR_TRACKER_H
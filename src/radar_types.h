@@ -0,0 +1,54 @@
+// ============================================================
+// AutoGuard - Tipi dati radar
+// ============================================================
+#ifndef RADAR_TYPES_H
+#define RADAR_TYPES_H
+
+#include <stdint.h>
+#include "ld2420_protocol.h"
+
+// Zone di rilevamento
+enum RadarZone {
+    ZONE_NONE     = 0,  // nessun rilevamento
+    ZONE_CRITICAL = 1,  // 0-100cm:   dentro/sopra auto
+    ZONE_MEDIUM   = 2,  // 100-250cm: intorno auto
+    ZONE_FAR      = 3   // 250-400cm: nei pressi auto
+};
+
+// Traiettoria del bersaglio (radar_tracker.h)
+enum RadarTrajectory {
+    TRAJ_NONE        = 0,   // nessuna traccia o non ancora classificata
+    TRAJ_APPROACHING = 1,   // avvicinamento sostenuto
+    TRAJ_LOITERING   = 2,   // sosta sul posto
+    TRAJ_PASSING     = 3    // transito o allontanamento
+};
+
+// Dati restituiti dal sensore
+struct RadarData {
+    bool      detected;       // presenza rilevata
+    int       distance_cm;    // distanza in cm
+    RadarZone zone;           // zona rilevamento
+    int       filtered_dist;  // distanza filtrata (pipeline filtri)
+    uint32_t  timestamp;      // millis() lettura
+    int       velocity;       // velocità radiale cm/s (<0 = avvicinamento)
+    int       accel;          // accelerazione radiale cm/s^2
+    RadarTrajectory trajectory;
+    uint8_t   sensor;         // sensore di origine (radar_fusion.h)
+    uint8_t   zone_id;        // zona della mappa (zone_map.h), 0 = fuori
+    uint32_t  zone_ms;        // permanenza continua nella zona
+};
+
+// Energie per range gate (modalità engineering LD2420)
+// Layout fisso: 40 byte, nessun padding
+struct RadarGateEnergy {
+    uint32_t  timestamp;                    // millis() lettura
+    uint16_t  distance_cm;                  // distanza riportata dal sensore
+    uint8_t   presence;                     // 1 = presenza
+    uint8_t   reserved;
+    uint16_t  energy[LD2420_GATE_COUNT];    // energia gate 0..15 (70cm/gate)
+};
+
+static_assert(sizeof(RadarGateEnergy) == 8 + 2 * LD2420_GATE_COUNT,
+              "RadarGateEnergy: layout non compatto");
+
+#endif // RADAR_TYPES_H
@@ -2,110 +2,360 @@
 // AutoGuard - Driver HLK-LD2420 - Implementazione
 // ============================================================
 #include "sensor_ld2420.h"
+#include <string.h>
+
+// UART e pin per indice sensore
+struct RadarPort {
+    uint8_t     uart;
+    int8_t      rxPin;
+    int8_t      txPin;
+    const char* taskName;
+};
+
+static const RadarPort RADAR_PORTS[] = {
+    { RADAR_UART,  RADAR_RX_PIN,  RADAR_TX_PIN,  "radar"  },
+    { RADAR2_UART, RADAR2_RX_PIN, RADAR2_TX_PIN, "radar2" },
+    { RADAR3_UART, RADAR3_RX_PIN, RADAR3_TX_PIN, "radar3" },
+};
+
+static const RadarPort& radarPort(uint8_t id) {
+    return RADAR_PORTS[id < sizeof(RADAR_PORTS) / sizeof(RADAR_PORTS[0]) ? id : 0];
+}
 
 // ============================================================
 // Costruttore
 // ============================================================
-SensorLD2420::SensorLD2420() :
-    _radarSerial(1),
+SensorLD2420::SensorLD2420(uint8_t id) :
+    _id(id),
+    _radarSerial(radarPort(id).uart),
     _ready(false),
+    _task(nullptr),
+    _consumer(nullptr),
+    _pollMs(0),
+    _requestedMode(-1),
+    _engineering(false),
     _consecutiveDetections(0),
     _lastPrintedDist(-1),
     _lastDetected(false),
-    _filterIdx(0),
-    _filterFull(false)
+    _lastAckCmd(0),
+    _lastAckStatus(0),
+    _configVersion(0)
 {
-    // Inizializza buffer filtro a zero
-    for (int i = 0; i < FILTER_SIZE; i++) {
-        _filterBuf[i] = 0;
-    }
-
     // Inizializza struttura dati
     _data.detected      = false;
     _data.distance_cm   = 0;
     _data.zone          = ZONE_NONE;
     _data.filtered_dist = 0;
     _data.timestamp     = 0;
+    _data.velocity      = 0;
+    _data.accel         = 0;
+    _data.trajectory    = TRAJ_NONE;
+    _data.sensor        = id;
+    _data.zone_id       = 0;
+    _data.zone_ms       = 0;
+    _sample             = _data;
+    memset(&_energy, 0, sizeof(_energy));
 }
 
 // ============================================================
 // begin() - Inizializza sensore
 // ============================================================
 bool SensorLD2420::begin() {
-    Serial.println("[RADAR] Inizializzazione HLK-LD2420...");
-    Serial.printf("[RADAR] RX=GPIO%d TX=GPIO%d BAUD=%d\n",
-        RADAR_RX_PIN, RADAR_TX_PIN, RADAR_BAUD);
+    const RadarPort& port = radarPort(_id);
+
+    halLog.printf("[RADAR] Inizializzazione HLK-LD2420 #%u...\n", _id);
+    halLog.printf("[RADAR] UART%u RX=GPIO%d TX=GPIO%d BAUD=%d\n",
+        port.uart, port.rxPin, port.txPin, RADAR_BAUD);
 
-    // Inizializza UART1 con i pin configurati
-    _radarSerial.begin(RADAR_BAUD, SERIAL_8N1, RADAR_RX_PIN, RADAR_TX_PIN);
-    delay(100);
+    // Inizializza la UART del sensore con i pin configurati
+    _radarSerial.begin(RADAR_BAUD, port.rxPin, port.txPin, RADAR_UART_RX_BUFFER);
+    halDelay(100);
 
-    // Inizializza libreria LD2420
-    if (!_radar.begin(_radarSerial)) {
-        Serial.println("[RADAR] ERRORE: sensore non risponde!");
+    uint8_t  frame[LD2420_CMD_MAX_LEN];
+    uint8_t  ver[2] = {LD2420_PROTOCOL_VER & 0xFF, LD2420_PROTOCOL_VER >> 8};
+    size_t   len;
+
+    // Entra in modalità configurazione: se non risponde il sensore è assente
+    len = ld2420BuildCommand(frame, LD2420_CMD_ENABLE_CONF, ver, sizeof(ver));
+    if (!_sendCommand(frame, len, LD2420_CMD_ENABLE_CONF)) {
+        halLog.println("[RADAR] ERRORE: sensore non risponde!");
         _ready = false;
         return false;
     }
 
-    // Configura range di rilevamento
-    _radar.setDistanceRange(configMgr.get().radarMinDist, configMgr.get().radarMaxDist);
+    // Configura range di rilevamento (in range gate da LD2420_GATE_CM)
+    const AutoGuardConfig& cfg = configMgr.get();
+    int minGate = cfg.radarMinDist / LD2420_GATE_CM;
+    int maxGate = (cfg.radarMaxDist + LD2420_GATE_CM - 1) / LD2420_GATE_CM;
+    if (maxGate > LD2420_GATE_COUNT - 1) maxGate = LD2420_GATE_COUNT - 1;
+
+    len = ld2420BuildWriteReg(frame, LD2420_CMD_WRITE_ABD, LD2420_REG_MIN_GATE, minGate);
+    _sendCommand(frame, len, LD2420_CMD_WRITE_ABD);
+    len = ld2420BuildWriteReg(frame, LD2420_CMD_WRITE_ABD, LD2420_REG_MAX_GATE, maxGate);
+    _sendCommand(frame, len, LD2420_CMD_WRITE_ABD);
 
-    // Configura intervallo aggiornamento
-    _radar.setUpdateInterval(RADAR_UPDATE_MS);
+    // Modalità report: normale o engineering (energie per gate).
+    // Profilo rumore e batch energie: solo sensore principale
+    _writeSystemMode(_id == 0 && cfg.engineeringMode);
+
+    // Torna in modalità report
+    len = ld2420BuildCommand(frame, LD2420_CMD_DISABLE_CONF, nullptr, 0);
+    _sendCommand(frame, len, LD2420_CMD_DISABLE_CONF);
 
     _ready = true;
-    Serial.println("[RADAR] Inizializzazione OK!");
-    Serial.printf("[RADAR] Range: %dcm - %dcm\n",
-        configMgr.get().radarMinDist, configMgr.get().radarMaxDist);
+    halLog.println("[RADAR] Inizializzazione OK!");
+    halLog.printf("[RADAR] Range: %dcm - %dcm (gate %d-%d)\n",
+        cfg.radarMinDist, cfg.radarMaxDist,
+        minGate, maxGate);
+    halLog.printf("[RADAR] Modalita: %s\n", _engineering.load() ? "ENGINEERING" : "NORMALE");
+
+    return true;
+}
+
+// ============================================================
+// _writeSystemMode() - Imposta modalità report (in config mode)
+// ============================================================
+bool SensorLD2420::_writeSystemMode(bool engineering) {
+    uint8_t frame[LD2420_CMD_MAX_LEN];
+    size_t  len = ld2420BuildWriteReg(frame, LD2420_CMD_WRITE_SYS, LD2420_REG_SYS_MODE,
+        engineering ? LD2420_MODE_ENGINEERING : LD2420_MODE_NORMAL);
 
+    if (!_sendCommand(frame, len, LD2420_CMD_WRITE_SYS)) return false;
+    _engineering.store(engineering);
     return true;
 }
 
 // ============================================================
-// update() - Aggiorna letture (chiamare nel loop)
+// setEngineeringMode() - Richiesta cambio modalità (qualsiasi task)
+// ============================================================
+void SensorLD2420::setEngineeringMode(bool enable) {
+    _requestedMode.store(enable ? 1 : 0);
+    halTaskNotify(_task);
+}
+
+bool SensorLD2420::isEngineeringMode() {
+    return _engineering.load();
+}
+
+// ============================================================
+// _applyModeRequest() - Applica la richiesta (task proprietario UART)
+// ============================================================
+void SensorLD2420::_applyModeRequest() {
+    int8_t req = _requestedMode.exchange(-1);
+    if (req < 0 || (req == 1) == _engineering.load()) return;
+
+    uint8_t frame[LD2420_CMD_MAX_LEN];
+    uint8_t ver[2] = {LD2420_PROTOCOL_VER & 0xFF, LD2420_PROTOCOL_VER >> 8};
+    size_t  len;
+
+    len = ld2420BuildCommand(frame, LD2420_CMD_ENABLE_CONF, ver, sizeof(ver));
+    if (!_sendCommand(frame, len, LD2420_CMD_ENABLE_CONF)) return;
+
+    bool ok = _writeSystemMode(req == 1);
+
+    len = ld2420BuildCommand(frame, LD2420_CMD_DISABLE_CONF, nullptr, 0);
+    _sendCommand(frame, len, LD2420_CMD_DISABLE_CONF);
+
+    halLog.printf("[RADAR] Modalita %s %s\n",
+        req == 1 ? "ENGINEERING" : "NORMALE", ok ? "attiva" : "FALLITA");
+}
+
+// ============================================================
+// _sendCommand() - Invia un comando e attende l'ACK
+// ============================================================
+// Solo dal proprietario della UART: begin() prima del task, poi
+// il task radar (o update() senza task) via _applyModeRequest().
+// Blocca fino a RADAR_ACK_TIMEOUT_MS: mai dal loop col task attivo
+bool SensorLD2420::_sendCommand(const uint8_t* frame, size_t len, uint16_t cmd) {
+    _lastAckCmd    = 0;
+    _lastAckStatus = 0xFFFF;
+    _radarSerial.write(frame, len);
+
+    uint32_t start = halMillis();
+    while (halMillis() - start < RADAR_ACK_TIMEOUT_MS) {
+        _processBytes();
+        if (_lastAckCmd == (cmd | 0x0100)) {
+            return _lastAckStatus == 0;
+        }
+        halDelay(5);
+    }
+    halLog.printf("[RADAR] Timeout ACK comando 0x%04X\n", cmd);
+    return false;
+}
+
+// ============================================================
+// startTask() - Avvia task di acquisizione dedicato
+// ============================================================
+bool SensorLD2420::startTask() {
+    if (!_ready || _task) return false;
+
+    bool ok = halTaskCreate(_taskEntry, radarPort(_id).taskName, RADAR_TASK_STACK, this,
+                            RADAR_TASK_PRIORITY, RADAR_TASK_CORE, &_task);
+
+    if (!ok) {
+        halLog.println("[RADAR] ERRORE: creazione task fallita");
+        _task = nullptr;
+        return false;
+    }
+
+    // Byte in arrivo (FIFO piena o timeout RX) -> sveglia il task
+    _radarSerial.onReceive(_onUartRx, this);
+
+    halLog.printf("[RADAR] Task #%u avviato (prio=%d core=%d coda=%d)\n",
+        _id, RADAR_TASK_PRIORITY, RADAR_TASK_CORE, RADAR_RING_SIZE);
+    return true;
+}
+
+void SensorLD2420::_taskEntry(void* arg) {
+    static_cast<SensorLD2420*>(arg)->_taskLoop();
+}
+
+void SensorLD2420::_onUartRx(void* arg) {
+    SensorLD2420* self = static_cast<SensorLD2420*>(arg);
+    if (!self->_pollMs.load(std::memory_order_relaxed)) halTaskNotify(self->_task);
+}
+
+// ============================================================
+// setPollInterval() - Ritmo di acquisizione (qualsiasi task)
+// ============================================================
+void SensorLD2420::setPollInterval(uint32_t ms) {
+    if (_pollMs.exchange(ms) == ms) return;
+    halTaskNotify(_task);       // il task riparte con la nuova attesa
+    halLog.printf("[RADAR] #%u Acquisizione %s\n", _id, ms ? "a intervalli" : "a ogni frame");
+}
+
+// ============================================================
+// _taskLoop() - Ciclo del task, guidato dagli eventi UART
+// ============================================================
+void SensorLD2420::_taskLoop() {
+    for (;;) {
+        // Attende la notifica di onReceive (timeout di sicurezza)
+        // o, a intervalli, il prossimo svuotamento della UART
+        uint32_t poll = _pollMs.load(std::memory_order_relaxed);
+        halTaskWait(poll ? poll : RADAR_UPDATE_MS * 2);
+        _applyModeRequest();
+        _processBytes();
+
+        // Campioni pronti: sveglia il loop se è in attesa
+        if (_consumer && _ring.size()) halTaskNotify(_consumer);
+    }
+}
+
+// ============================================================
+// update() - Acquisizione nel loop (fallback senza task)
 // ============================================================
 void SensorLD2420::update() {
-    if (!_ready) return;
+    if (!_ready || _task) return;
+    _applyModeRequest();
+    _processBytes();
+}
 
-    // Aggiorna libreria
-    _radar.update();
+// ============================================================
+// _processBytes() - Svuota la UART nel parser
+// ============================================================
+void SensorLD2420::_processBytes() {
+    uint8_t buf[RADAR_RX_CHUNK];
+    int     avail;
 
-    bool nowDetected = _radar.isDetecting();
-    int  rawDist     = _radar.getDistance();
+    while ((avail = _radarSerial.available()) > 0) {
+        size_t n = _radarSerial.read(buf,
+            (size_t)avail < sizeof(buf) ? (size_t)avail : sizeof(buf));
+
+        // Il parser decodifica direttamente dal blocco letto
+        size_t off = 0;
+        while (off < n) {
+            off += _parser.feed(buf + off, n - off, _frame);
+            if (_frame.type != LD2420_FRAME_NONE) {
+                _onFrame(_frame);
+            }
+        }
+    }
+}
+
+// ============================================================
+// _onFrame() - Frame completo dal parser
+// ============================================================
+void SensorLD2420::_onFrame(const LD2420Frame& frame) {
+    switch (frame.type) {
+        case LD2420_FRAME_ENGINEERING: {
+            RadarGateEnergy e;
+            e.timestamp   = halMillis();
+            e.distance_cm = frame.distance_cm;
+            e.presence    = frame.presence ? 1 : 0;
+            e.reserved    = 0;
+            memcpy(e.energy, frame.energy, sizeof(e.energy));
+            _energyRing.push(e);
+            _pushSample(frame.presence, frame.distance_cm);
+            break;
+        }
+        case LD2420_FRAME_REPORT:
+            _pushSample(frame.presence, frame.distance_cm);
+            break;
+        case LD2420_FRAME_ACK:
+            _lastAckCmd    = frame.ackCmd;
+            _lastAckStatus = frame.ackStatus;
+            break;
+        default:
+            break;
+    }
+}
+
+// ============================================================
+// _pushSample() - Costruisce e accoda un campione (produttore)
+// ============================================================
+void SensorLD2420::_pushSample(bool nowDetected, int rawDist) {
+    _syncConfig();
 
     if (nowDetected) {
-        // Applica filtro media mobile
+        // Applica pipeline filtri
         int filteredDist = _applyFilter(rawDist);
 
         // Aggiorna struttura dati
-        _data.detected      = true;
-        _data.distance_cm   = rawDist;
-        _data.filtered_dist = filteredDist;
-        _data.zone          = _getZone(filteredDist);
-        _data.timestamp     = millis();
+        _sample.detected      = true;
+        _sample.distance_cm   = rawDist;
+        _sample.filtered_dist = filteredDist;
+        _sample.timestamp     = halMillis();
+        _zones.apply(_sample);
+        _tracker.apply(_sample);
 
-        // Incrementa contatore rilevamenti consecutivi
-        _consecutiveDetections++;
+        // Incrementa contatore rilevamenti consecutivi (RMW: un
+        // reset concorrente dal loop non va perso)
+        _consecutiveDetections.fetch_add(1, std::memory_order_relaxed);
 
 #if DEBUG_MODE
-        if (_data.filtered_dist != _lastPrintedDist || _data.detected != _lastDetected) {
+        if (_sample.filtered_dist != _lastPrintedDist || _sample.detected != _lastDetected) {
             _printData();
-            _lastPrintedDist = _data.filtered_dist;
-            _lastDetected    = _data.detected;
+            _lastPrintedDist = _sample.filtered_dist;
+            _lastDetected    = _sample.detected;
         }
 #endif
 
     } else {
         // Nessun rilevamento
-        _data.detected      = false;
-        _data.distance_cm   = 0;
-        _data.filtered_dist = 0;
-        _data.zone          = ZONE_NONE;
-        _data.timestamp     = millis();
-
-        // Reset contatore
-        _consecutiveDetections = 0;
+        _sample.detected      = false;
+        _sample.distance_cm   = 0;
+        _sample.filtered_dist = 0;
+        _sample.timestamp     = halMillis();
+        _zones.apply(_sample);
+
+        // Reset contatore e filtro: il prossimo bersaglio riparte da zero.
+        // Il tracker tollera buchi fino a TRACKER_GAP_MS
+        _consecutiveDetections.store(0, std::memory_order_relaxed);
+        _filter.reset();
+        _tracker.apply(_sample);
     }
+
+    // Coda piena: il campione viene scartato e contato come overrun
+    _ring.push(_sample);
+}
+
+// ============================================================
+// readSample() - Estrae un campione dalla coda (consumatore)
+// ============================================================
+bool SensorLD2420::readSample(RadarData& out) {
+    if (!_ring.pop(out)) return false;
+    _data = out;
+    return true;
 }
 
 // ============================================================
@@ -126,51 +376,81 @@ bool SensorLD2420::isReady() {
 // getConsecutiveDetections() - Rilevamenti consecutivi
 // ============================================================
 int SensorLD2420::getConsecutiveDetections() {
-    return _consecutiveDetections;
+    return _consecutiveDetections.load(std::memory_order_relaxed);
 }
 
 // ============================================================
 // resetDetections() - Reset contatore
 // ============================================================
 void SensorLD2420::resetDetections() {
-    _consecutiveDetections = 0;
+    _consecutiveDetections.exchange(0, std::memory_order_relaxed);
 }
 
 // ============================================================
-// _getZone() - Determina zona da distanza
+// readEnergy() - Estrae un frame energie e lo accoda nel batch
 // ============================================================
-RadarZone SensorLD2420::_getZone(int distance_cm) {
-    if (distance_cm <= 0) {
-        return ZONE_NONE;
-    } else if (distance_cm <= configMgr.get().zoneCriticalMax) {
-        return ZONE_CRITICAL;
-    } else if (distance_cm <= configMgr.get().zoneMediumMax) {
-        return ZONE_MEDIUM;
-    } else if (distance_cm <= ZONE_FAR_MAX) {
-        return ZONE_FAR;
-    }
-    return ZONE_NONE;
+bool SensorLD2420::readEnergy(RadarGateEnergy& out) {
+    if (!_energyRing.pop(out)) return false;
+    _energy = out;
+    _energyBatch.add(out);
+    return true;
+}
+
+RadarGateEnergy SensorLD2420::getEnergy() {
+    return _energy;
+}
+
+EnergyBatcher& SensorLD2420::energyBatch() {
+    return _energyBatch;
 }
 
 // ============================================================
-// _applyFilter() - Media mobile su FILTER_SIZE campioni
+// Statistiche coda
 // ============================================================
-int SensorLD2420::_applyFilter(int newValue) {
-    _filterBuf[_filterIdx] = newValue;
-    _filterIdx = (_filterIdx + 1) % FILTER_SIZE;
+uint32_t SensorLD2420::getOverruns() {
+    return _ring.overruns();
+}
 
-    if (!_filterFull && _filterIdx == 0) {
-        _filterFull = true;
-    }
+uint32_t SensorLD2420::getQueueHighWater() {
+    return _ring.highWater();
+}
 
-    int sum   = 0;
-    int count = _filterFull ? FILTER_SIZE : _filterIdx;
+uint32_t SensorLD2420::getQueueDepth() {
+    return _ring.size();
+}
 
-    for (int i = 0; i < count; i++) {
-        sum += _filterBuf[i];
-    }
+const LD2420ParserStats& SensorLD2420::getParserStats() {
+    return _parser.stats();
+}
 
-    return (count > 0) ? (sum / count) : 0;
+// ============================================================
+// _applyFilter() - Pipeline filtri (costo costante per campione)
+// ============================================================
+int SensorLD2420::_applyFilter(int newValue) {
+    return _filter.apply(newValue);
+}
+
+// ============================================================
+// _syncConfig() - Stato derivato dalla config (lato task)
+// ============================================================
+// Un confronto per campione; filtri e tabella zone si ricalcolano
+// solo quando il web pubblica un nuovo snapshot
+void SensorLD2420::_syncConfig() {
+    uint32_t version = configMgr.version();
+    if (version == _configVersion) return;
+
+    const AutoGuardConfig& cfg = configMgr.get();
+    _filter.configure(cfg.filterMode, cfg.filterEmaAlpha,
+                      cfg.filterKalmanQ, cfg.filterKalmanR);
+    const ZoneDef zones[] = {
+        {cfg.zoneCriticalMax, ZONE_CRITICAL},
+        {cfg.zoneMediumMax,   ZONE_MEDIUM},
+        {cfg.zoneFarMax,      ZONE_FAR}
+    };
+    if (!_zones.build(zones, 3, cfg.zoneHystEnterCm, cfg.zoneHystExitCm)) {
+        halLog.printf("[RADAR] #%u Zone non valide, tabella invariata\n", _id);
+    }
+    _configVersion = version;
 }
 
 // ============================================================
@@ -179,9 +459,15 @@ int SensorLD2420::_applyFilter(int newValue) {
 void SensorLD2420::_printData() {
     const char* zoneNames[] = {"NONE", "CRITICAL", "MEDIUM", "FAR"};
 
-    Serial.printf("[RADAR] Dist:%dcm Filter:%dcm Zone:%s Consec:%d\n",
-        _data.distance_cm,
-        _data.filtered_dist,
-        zoneNames[_data.zone],
-        _consecutiveDetections);
+    const char* trajNames[] = {"--", "AVVICINA", "SOSTA", "TRANSITO"};
+
+    halLog.printf("[RADAR] #%u Dist:%dcm Filter:%dcm Zone:%s (%lums) Vel:%dcm/s Traj:%s Consec:%d\n",
+        _id,
+        _sample.distance_cm,
+        _sample.filtered_dist,
+        zoneNames[_sample.zone],
+        (unsigned long)_sample.zone_ms,
+        _sample.velocity,
+        trajNames[_sample.trajectory & 3],
+        _consecutiveDetections.load(std::memory_order_relaxed));
 }
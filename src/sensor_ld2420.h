@@ -4,43 +4,44 @@
 #ifndef SENSOR_LD2420_H
 #define SENSOR_LD2420_H
 
-#include <Arduino.h>
-#include <LD2420.h>
+#include "hal.h"
 #include "config.h"
 #include "config_manager.h"
+#include "spsc_ring.h"
+#include "ld2420_protocol.h"
+#include "radar_types.h"
+#include "radar_source.h"
+#include "radar_filter.h"
+#include "radar_tracker.h"
+#include "zone_map.h"
+#include "energy_batch.h"
 
-// Zone di rilevamento
-enum RadarZone {
-    ZONE_NONE     = 0,  // nessun rilevamento
-    ZONE_CRITICAL = 1,  // 0-100cm:   dentro/sopra auto
-    ZONE_MEDIUM   = 2,  // 100-250cm: intorno auto
-    ZONE_FAR      = 3   // 250-400cm: nei pressi auto
-};
-
-// Dati restituiti dal sensore
-struct RadarData {
-    bool      detected;       // presenza rilevata
-    int       distance_cm;    // distanza in cm
-    RadarZone zone;           // zona rilevamento
-    int       filtered_dist;  // distanza filtrata (media mobile)
-    uint32_t  timestamp;      // millis() lettura
-};
-
-class SensorLD2420 {
+class SensorLD2420 : public RadarSource {
 public:
-    SensorLD2420();
+    // id = indice del sensore (0..RADAR_COUNT-1): UART e pin da
+    // RADAR_UART/RADAR_*_PIN, RADAR2_*, RADAR3_*
+    explicit SensorLD2420(uint8_t id = 0);
 
-    // Inizializza sensore su Serial1 (GPIO4/5)
+    // Inizializza il sensore sulla propria UART
     bool begin();
 
-    // Da chiamare nel loop() - aggiorna letture
-    void update();
+    uint8_t id() const { return _id; }
+
+    // Avvia il task FreeRTOS di acquisizione (dopo begin())
+    bool startTask();
+
+    // Da chiamare nel loop() solo se il task non è attivo
+    void update() override;
 
-    // Restituisce gli ultimi dati letti
-    RadarData getData();
+    // Estrae il prossimo campione dalla coda (consumatore: loop)
+    // false se la coda è vuota
+    bool readSample(RadarData& out) override;
+
+    // Restituisce l'ultimo campione estratto dalla coda
+    RadarData getData() override;
 
     // true se il sensore è inizializzato correttamente
-    bool isReady();
+    bool isReady() override;
 
     // Conta rilevamenti consecutivi (per confermare presenza)
     int getConsecutiveDetections();
@@ -48,23 +49,92 @@ public:
     // Reset contatore rilevamenti
     void resetDetections();
 
+    // Statistiche coda campioni
+    uint32_t getOverruns();        // campioni persi (coda piena)
+    uint32_t getQueueHighWater();  // massimo riempimento coda
+    uint32_t getQueueDepth();      // campioni in attesa
+
+    // Statistiche parser UART (frame, errori framing, resync)
+    const LD2420ParserStats& getParserStats();
+
+    // Modalità engineering (energie per gate), applicata dal task radar
+    void setEngineeringMode(bool enable);
+    bool isEngineeringMode();
+
+    // Estrae il prossimo frame energie (consumatore: loop) e lo
+    // accoda nel batch binario per MQTT/HTTP
+    bool readEnergy(RadarGateEnergy& out);
+
+    // Ultimo frame energie estratto
+    RadarGateEnergy getEnergy();
+
+    // Batch binari delle energie per gate
+    EnergyBatcher& energyBatch();
+
+    // Ritmo di acquisizione (qualsiasi task): 0 = a ogni frame
+    // (evento UART), altrimenti UART svuotata ogni ms millisecondi
+    // (i byte attendono nel buffer del driver)
+    void setPollInterval(uint32_t ms);
+    uint32_t getPollInterval() const { return _pollMs.load(std::memory_order_relaxed); }
+
+    // Attività RX sveglia dal light sleep
+    void setWakeOnRx(bool enable) { if (_ready) _radarSerial.wakeOnRx(enable); }
+
+    // Task da svegliare quando ci sono campioni in coda (prima di startTask())
+    void setConsumer(HalTaskHandle task) { _consumer = task; }
+
+    // Zone e permanenza per zona (scritte dal task radar, valori
+    // statistici per il web)
+    const ZoneMap& zoneMap() const { return _zones; }
+
 private:
-    HardwareSerial  _radarSerial;
-    LD2420          _radar;
+    uint8_t         _id;
+    HalUart         _radarSerial;
+    LD2420Parser    _parser;
+    LD2420Frame     _frame;         // frame in decodifica (lato task)
     bool            _ready;
-    RadarData       _data;
-    int             _consecutiveDetections;
+    RadarData       _data;          // ultimo campione consumato (lato loop)
+    RadarData       _sample;        // campione in costruzione (lato task)
+    HalTaskHandle   _task;
+    HalTaskHandle   _consumer;      // loop, svegliato a campioni in coda
+    std::atomic<uint32_t> _pollMs;  // 0 = guidato dagli eventi UART
+
+    // Coda task radar -> loop
+    SpscRing<RadarData, RADAR_RING_SIZE> _ring;
+
+    // Modalità engineering: coda frame energie + batch binari
+    SpscRing<RadarGateEnergy, RADAR_ENERGY_RING_SIZE> _energyRing;
+    RadarGateEnergy     _energy;        // ultimo frame consumato (lato loop)
+    EnergyBatcher       _energyBatch;
+    std::atomic<int8_t> _requestedMode; // -1 = nessuna richiesta
+    std::atomic<bool>   _engineering;   // scritto dal proprietario UART, letto ovunque
+
+    std::atomic<int>    _consecutiveDetections; // task radar, letto/azzerato da loop e web
     int             _lastPrintedDist;
     bool            _lastDetected;
+    uint16_t        _lastAckCmd;
+    uint16_t        _lastAckStatus;
+
+    // Pipeline filtri distanza e tabella zone (da config, ricostruite
+    // a ogni nuova versione dello snapshot; lato task)
+    RadarFilter<FILTER_AVG_SIZE, FILTER_MEDIAN_SIZE> _filter;
+    uint32_t        _configVersion;
+    ZoneMap         _zones;
 
-    // Filtro media mobile
-    static const int FILTER_SIZE = 5;
-    int  _filterBuf[FILTER_SIZE];
-    int  _filterIdx;
-    bool _filterFull;
+    // Velocità radiale e traiettoria (sulla distanza grezza)
+    RadarTracker    _tracker;
 
     // Metodi interni
-    RadarZone  _getZone(int distance_cm);
+    static void _taskEntry(void* arg);
+    static void _onUartRx(void* arg);
+    void       _taskLoop();
+    void       _processBytes();
+    void       _onFrame(const LD2420Frame& frame);
+    void       _pushSample(bool detected, int rawDist);
+    void       _syncConfig();
+    bool       _sendCommand(const uint8_t* frame, size_t len, uint16_t cmd);
+    bool       _writeSystemMode(bool engineering);
+    void       _applyModeRequest();
     int        _applyFilter(int newValue);
     void       _printData();
 };
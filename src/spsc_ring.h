@@ -0,0 +1,72 @@
+// ============================================================
+// AutoGuard - Ring buffer lock-free SPSC
+// ============================================================
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Coda a capacità fissa per UN produttore e UN consumatore.
+// Nessun lock: solo indici atomici acquire/release.
+// N deve essere una potenza di 2.
+template <typename T, uint32_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing: N deve essere potenza di 2");
+
+public:
+    SpscRing() : _head(0), _tail(0), _overruns(0), _highWater(0) {}
+
+    // Produttore - false se la coda è piena (elemento scartato)
+    bool push(const T& item) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        uint32_t used = head - tail;
+
+        if (used >= N) {
+            _overruns.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        _buf[head & (N - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+
+        // High-water mark (scritto solo dal produttore)
+        if (used + 1 > _highWater.load(std::memory_order_relaxed)) {
+            _highWater.store(used + 1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // Consumatore - false se la coda è vuota
+    bool pop(T& out) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t head = _head.load(std::memory_order_acquire);
+        if (head == tail) return false;
+
+        out = _buf[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Elementi in coda (indicativo se letto dall'altro lato)
+    uint32_t size() const {
+        return _head.load(std::memory_order_acquire) -
+               _tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr uint32_t capacity() { return N; }
+
+    // Statistiche
+    uint32_t overruns()  const { return _overruns.load(std::memory_order_relaxed); }
+    uint32_t highWater() const { return _highWater.load(std::memory_order_relaxed); }
+
+private:
+    T                     _buf[N];
+    std::atomic<uint32_t> _head;        // scritto dal produttore
+    std::atomic<uint32_t> _tail;        // scritto dal consumatore
+    std::atomic<uint32_t> _overruns;    // push rifiutati (coda piena)
+    std::atomic<uint32_t> _highWater;   // massimo riempimento osservato
+};
+
+#endif // SPSC_RING_H
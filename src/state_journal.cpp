@@ -0,0 +1,232 @@
+// ============================================================
+// AutoGuard - Journal dello stato allarme - Implementazione
+// ============================================================
+#include "state_journal.h"
+#include <string.h>
+
+#define HEADER_MAGIC    "AGJ1"
+#define RECORD_TAG      0xA5
+
+// Letture del segmento a blocchi (stack del loop)
+#define SCAN_CHUNK      256
+
+static_assert(JOURNAL_SEGMENT_SIZE % JOURNAL_RECORD_LEN == 0, "JOURNAL_SEGMENT_SIZE");
+static_assert(SCAN_CHUNK % JOURNAL_RECORD_LEN == 0, "SCAN_CHUNK");
+
+StateJournal stateJournal;
+
+// CRC-32 (IEEE 802.3), tabella a 4 bit
+static uint32_t crc32(const uint8_t* p, size_t len) {
+    static const uint32_t T[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+        0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    uint32_t c = 0xFFFFFFFF;
+    while (len--) {
+        c ^= *p++;
+        c = (c >> 4) ^ T[c & 15];
+        c = (c >> 4) ^ T[c & 15];
+    }
+    return ~c;
+}
+
+static inline void put32(uint8_t* p, uint32_t v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static inline uint32_t get32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool erased(const uint8_t* p, size_t len) {
+    for (size_t i = 0; i < len; i++) if (p[i] != 0xFF) return false;
+    return true;
+}
+
+// ============================================================
+// Costruttore
+// ============================================================
+StateJournal::StateJournal() :
+    _ready(false),
+    _segments(0),
+    _active(0),
+    _generation(0),
+    _slot(0),
+    _seq(0),
+    _hasState(false),
+    _state(STATE_DISARMED),
+    _rotations(0),
+    _torn(0),
+    _scanUs(0)
+{}
+
+// ============================================================
+// begin() - Intestazioni, poi il segmento più recente
+// ============================================================
+bool StateJournal::begin(const char* label) {
+    uint64_t t0 = halMicros();
+
+#if JOURNAL_ENABLE
+    if (!_flash.begin(label)) {
+        halLog.printf("[JOURNAL] Partizione '%s' assente - stato non persistente\n", label);
+        return false;
+    }
+    uint32_t n = _flash.size() / JOURNAL_SEGMENT_SIZE;
+    if (n > JOURNAL_MAX_SEGMENTS) n = JOURNAL_MAX_SEGMENTS;
+    if (n < 2) {
+        halLog.printf("[JOURNAL] Partizione '%s' troppo piccola\n", label);
+        return false;
+    }
+    _segments = n;
+
+    uint32_t gen[JOURNAL_MAX_SEGMENTS];
+    bool     valid[JOURNAL_MAX_SEGMENTS];
+    int      best = -1;
+    for (uint8_t s = 0; s < _segments; s++) {
+        valid[s] = _readHeader(s, gen[s]);
+        if (valid[s] && (best < 0 || (int32_t)(gen[s] - gen[best]) > 0)) best = s;
+    }
+
+    if (best < 0) {
+        // Partizione vergine: la prima scrittura apre il segmento 0
+        _active     = _segments - 1;
+        _generation = 0;
+        _slot       = JOURNAL_RECORDS;
+    } else {
+        _active     = best;
+        _generation = gen[best];
+        bool found  = _scan(_active, true);
+
+        // Segmento appena aperto (o solo record a metà): vale il
+        // precedente, se è della generazione prima
+        for (uint8_t k = 1; !found && k < _segments; k++) {
+            uint8_t s = (_active + _segments - k) % _segments;
+            if (!valid[s] || gen[s] != _generation - k) break;
+            found = _scan(s, false);
+        }
+    }
+    _ready  = true;
+    _scanUs = (uint32_t)(halMicros() - t0);
+
+    if (_hasState) {
+        halLog.printf("[JOURNAL] Ultimo stato: %s (record %lu, %lu us)\n",
+            AlarmLogic::getStateName(_state), (unsigned long)_seq, (unsigned long)_scanUs);
+    } else {
+        halLog.printf("[JOURNAL] Vuoto (%u segmenti)\n", _segments);
+    }
+    if (_torn) halLog.printf("[JOURNAL] WARN: %lu record incompleti ignorati\n", (unsigned long)_torn);
+#else
+    (void)label;
+    _scanUs = (uint32_t)(halMicros() - t0);
+#endif
+    return _ready;
+}
+
+bool StateJournal::_readHeader(uint8_t seg, uint32_t& generation) {
+    uint8_t h[JOURNAL_RECORD_LEN];
+    if (!_flash.read((uint32_t)seg * JOURNAL_SEGMENT_SIZE, h, sizeof(h))) return false;
+    if (memcmp(h, HEADER_MAGIC, 4) != 0 || get32(h + 12) != crc32(h, 12)) return false;
+    generation = get32(h + 4);
+    return true;
+}
+
+// ============================================================
+// _scan() - Ultimo record valido del segmento
+// ============================================================
+// Nel segmento attivo fissa anche il prossimo slot: dopo
+// l'ultimo slot scritto, valido o no
+bool StateJournal::_scan(uint8_t seg, bool active) {
+    uint8_t  buf[SCAN_CHUNK];
+    uint32_t base  = (uint32_t)seg * JOURNAL_SEGMENT_SIZE + JOURNAL_RECORD_LEN;
+    int      used  = -1;
+    bool     found = false;
+
+    for (uint16_t first = 0; first < JOURNAL_RECORDS; first += SCAN_CHUNK / JOURNAL_RECORD_LEN) {
+        uint16_t count = JOURNAL_RECORDS - first;
+        if (count > SCAN_CHUNK / JOURNAL_RECORD_LEN) count = SCAN_CHUNK / JOURNAL_RECORD_LEN;
+        if (!_flash.read(base + first * JOURNAL_RECORD_LEN, buf, count * JOURNAL_RECORD_LEN)) break;
+
+        for (uint16_t i = 0; i < count; i++) {
+            const uint8_t* r = buf + i * JOURNAL_RECORD_LEN;
+            if (erased(r, JOURNAL_RECORD_LEN)) continue;
+            used = first + i;
+            if (r[0] != RECORD_TAG || r[1] > STATE_COOLDOWN || get32(r + 12) != crc32(r, 12)) {
+                _torn++;
+                continue;
+            }
+            _state    = (AlarmState)r[1];
+            _seq      = get32(r + 4);
+            _hasState = true;
+            found     = true;
+        }
+    }
+    if (active) _slot = used + 1;
+    return found;
+}
+
+bool StateJournal::lastState(AlarmState& out) const {
+    if (!_hasState) return false;
+    out = _state;
+    return true;
+}
+
+// ============================================================
+// append() / drain() - Scrittura dal loop
+// ============================================================
+void StateJournal::drain(const AlarmLogic& alarm) {
+    AlarmEvent ev;
+    while (alarm.readEvent(_cursor, ev)) {
+        if (_ready) append(ev.state, ev.prevState, ev.timestamp);
+    }
+}
+
+bool StateJournal::append(AlarmState state, AlarmState prevState, uint32_t timestamp) {
+    if (!_ready) return false;
+    if (_slot >= JOURNAL_RECORDS && !_rotate()) return false;
+
+    uint8_t r[JOURNAL_RECORD_LEN];
+    r[0] = RECORD_TAG;
+    r[1] = (uint8_t)state;
+    r[2] = (uint8_t)prevState;
+    r[3] = 0xFF;
+    put32(r + 4, _seq + 1);
+    put32(r + 8, timestamp);
+    put32(r + 12, crc32(r, 12));
+
+    // Lo slot è consumato anche se la scrittura fallisce a metà
+    uint32_t off = (uint32_t)_active * JOURNAL_SEGMENT_SIZE + (_slot + 1) * JOURNAL_RECORD_LEN;
+    _slot++;
+    if (!_flash.write(off, r, sizeof(r))) {
+        halLog.println("[JOURNAL] ERRORE: scrittura record fallita");
+        return false;
+    }
+    _seq++;
+    _state    = state;
+    _hasState = true;
+    return true;
+}
+
+// ============================================================
+// _rotate() - Cancella il segmento più vecchio e lo apre
+// ============================================================
+bool StateJournal::_rotate() {
+    uint8_t  next = (_active + 1) % _segments;
+    uint32_t off  = (uint32_t)next * JOURNAL_SEGMENT_SIZE;
+
+    uint8_t h[JOURNAL_RECORD_LEN];
+    memcpy(h, HEADER_MAGIC, 4);
+    put32(h + 4, _generation + 1);
+    memset(h + 8, 0xFF, 4);
+    put32(h + 12, crc32(h, 12));
+
+    if (!_flash.erase(off, JOURNAL_SEGMENT_SIZE) || !_flash.write(off, h, sizeof(h))) {
+        halLog.printf("[JOURNAL] ERRORE: rotazione sul segmento %u fallita\n", next);
+        return false;
+    }
+    _active = next;
+    _generation++;
+    _slot = 0;
+    _rotations++;
+    return true;
+}
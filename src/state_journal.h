@@ -0,0 +1,89 @@
+// ============================================================
+// AutoGuard - Journal dello stato allarme (flash grezza)
+// ============================================================
+// Ogni transizione della state machine viene accodata come
+// record da 16 byte in una partizione dati dedicata, divisa in
+// segmenti da un settore (HAL_FLASH_SECTOR) usati a rotazione:
+// a segmento pieno si cancella il successivo, il più vecchio.
+// Le cancellazioni si distribuiscono su tutta la partizione.
+//
+// Segmento: intestazione + record, scritti solo in coda
+//   intestazione [0..3] "AGJ1"  [4..7] generazione (cresce a
+//                ogni rotazione)  [8..11] 0xFF  [12..15] CRC32
+//   record       [0] 0xA5  [1] stato  [2] stato precedente
+//                [3] 0xFF  [4..7] sequenza (monotona anche tra
+//                riavvii)  [8..11] halMillis() della transizione
+//                [12..15] CRC32 dei byte 0..11
+//
+// All'avvio begin() legge le sole intestazioni, poi il segmento
+// con generazione più alta: l'ultimo record valido è lo stato
+// da ripristinare. Un taglio di alimentazione lascia al più un
+// record (o un'intestazione) a metà: CRC errato, viene saltato
+// e non viene più riscritto; vale il record precedente, anche
+// nel segmento precedente. Le scritture ripartono dal primo
+// slot cancellato.
+//
+// Scrittore: solo loop() (drain()). Una scrittura costa un
+// record; la rotazione cancella un settore (decine di ms, ogni
+// JOURNAL_RECORDS transizioni). Non dipende da Arduino.
+// ============================================================
+#ifndef STATE_JOURNAL_H
+#define STATE_JOURNAL_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "config.h"
+#include "alarm_logic.h"
+
+#define JOURNAL_RECORD_LEN      16
+#define JOURNAL_SEGMENT_SIZE    HAL_FLASH_SECTOR
+#define JOURNAL_RECORDS         (JOURNAL_SEGMENT_SIZE / JOURNAL_RECORD_LEN - 1)
+#define JOURNAL_MAX_SEGMENTS    64
+
+class StateJournal {
+public:
+    StateJournal();
+
+    // Apre la partizione e recupera l'ultimo stato; false se la
+    // partizione manca (journal disattivato)
+    bool begin(const char* label = JOURNAL_PARTITION);
+
+    // Stato registrato prima del riavvio (false = nessuno)
+    bool lastState(AlarmState& out) const;
+
+    // Accoda le transizioni nuove (cursore proprio, solo dal loop)
+    void drain(const AlarmLogic& alarm);
+
+    // Accoda una transizione; false se la scrittura fallisce
+    bool append(AlarmState state, AlarmState prevState, uint32_t timestamp);
+
+    bool     isReady()   const { return _ready; }
+    uint32_t sequence()  const { return _seq; }        // ultimo record
+    uint32_t segments()  const { return _segments; }
+    uint32_t rotations() const { return _rotations; }  // cancellazioni dall'avvio
+    uint32_t torn()      const { return _torn; }       // record invalidi trovati
+    uint32_t scanUs()    const { return _scanUs; }     // durata del recupero
+
+private:
+    HalFlashPartition _flash;
+    bool        _ready;
+    uint8_t     _segments;
+    uint8_t     _active;        // segmento in scrittura
+    uint32_t    _generation;    // del segmento attivo
+    uint16_t    _slot;          // prossimo record libero nel segmento
+    uint32_t    _seq;
+    bool        _hasState;
+    AlarmState  _state;
+    uint32_t    _rotations;
+    uint32_t    _torn;
+    uint32_t    _scanUs;
+    EventCursor _cursor;
+
+    bool _readHeader(uint8_t seg, uint32_t& generation);
+    bool _scan(uint8_t seg, bool active);
+    bool _rotate();
+};
+
+extern StateJournal stateJournal;
+
+#endif // STATE_JOURNAL_H
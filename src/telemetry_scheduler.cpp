@@ -0,0 +1,90 @@
+// ============================================================
+// AutoGuard - Scheduler telemetria radar - Implementazione
+// ============================================================
+#include "telemetry_scheduler.h"
+#include <string.h>
+
+#define TELEM_BUCKET_CAP    ((uint32_t)TELEM_BUCKET_BURST * TELEM_BUCKET_REFILL_MS)
+
+static const TelemetryPolicy POLICIES[STATE_COOLDOWN + 1] = {
+    TELEM_POLICY_DISARMED,
+    TELEM_POLICY_ARMING,
+    TELEM_POLICY_ARMED,
+    TELEM_POLICY_ALERT,
+    TELEM_POLICY_ALARM,
+    TELEM_POLICY_COOLDOWN
+};
+
+TelemetryScheduler::TelemetryScheduler() :
+    _hasSent(false),
+    _pending(false),
+    _lastDetected(false),
+    _lastZoneId(0),
+    _lastDist(0),
+    _lastSentMs(0),
+    _sampleTs(0),
+    _tokens(TELEM_BUCKET_CAP),
+    _tokenMs(0)
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+const TelemetryPolicy& TelemetryScheduler::policy(AlarmState state) {
+    return POLICIES[state <= STATE_COOLDOWN ? state : STATE_DISARMED];
+}
+
+// ============================================================
+// due() - Cambiamento, heartbeat e limiti
+// ============================================================
+bool TelemetryScheduler::due(const RadarData& d, AlarmState state, uint32_t now) {
+    const TelemetryPolicy& p = policy(state);
+    _refill(now);
+
+    if (d.timestamp != _sampleTs) {
+        _sampleTs = d.timestamp;
+        if (!_hasSent || _changed(d, p)) {
+            if (_pending) _stats.coalesced++;   // accorpato nello stesso invio
+            _pending = true;
+        } else if (d.detected && d.filtered_dist != _lastDist) {
+            _stats.filtered++;
+        }
+    }
+
+    uint32_t since = now - _lastSentMs;
+    if (!_pending && (!_hasSent || since < p.heartbeatMs)) return false;
+    if (_hasSent && since < p.minIntervalMs) return false;
+    return _tokens >= TELEM_BUCKET_REFILL_MS;
+}
+
+bool TelemetryScheduler::_changed(const RadarData& d, const TelemetryPolicy& p) const {
+    if (d.detected != _lastDetected || d.zone_id != _lastZoneId) return true;
+    if (!d.detected) return false;
+    int delta = d.filtered_dist - _lastDist;
+    return (delta < 0 ? -delta : delta) >= p.deadbandCm;
+}
+
+// Token bucket in ms: un token = TELEM_BUCKET_REFILL_MS
+void TelemetryScheduler::_refill(uint32_t now) {
+    uint32_t add = now - _tokenMs;
+    _tokenMs = now;
+    _tokens  = (TELEM_BUCKET_CAP - _tokens <= add) ? TELEM_BUCKET_CAP : _tokens + add;
+}
+
+// ============================================================
+// sent() - Campione pubblicato
+// ============================================================
+void TelemetryScheduler::sent(const RadarData& d, uint32_t now) {
+    _refill(now);
+    _tokens -= _tokens >= TELEM_BUCKET_REFILL_MS ? TELEM_BUCKET_REFILL_MS : _tokens;
+
+    _stats.sent++;
+    if (_pending) _stats.changes++;
+    else          _stats.heartbeats++;
+
+    _hasSent      = true;
+    _pending      = false;
+    _lastDetected = d.detected;
+    _lastZoneId   = d.zone_id;
+    _lastDist     = d.filtered_dist;
+    _lastSentMs   = now;
+}
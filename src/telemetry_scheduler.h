@@ -0,0 +1,75 @@
+// ============================================================
+// AutoGuard - Scheduler telemetria radar
+// ============================================================
+// Decide quando pubblicare il campione radar (MQTT_TOPIC_SENSOR)
+// invece di un timer fisso:
+//   - subito se cambiano presenza o zona, o se la distanza si
+//     sposta oltre la banda morta rispetto all'ultimo invio
+//   - mai prima dell'intervallo minimo dal precedente invio e
+//     solo con un token disponibile (raffiche limitate a
+//     TELEM_BUCKET_BURST, poi un invio ogni TELEM_BUCKET_REFILL_MS)
+//   - heartbeat lento se non cambia nulla
+// Un cambiamento bloccato dai limiti resta in attesa (anche se
+// il bersaglio torna com'era) e parte appena consentito con il
+// campione più recente; i cambiamenti intermedi sono accorpati.
+// Banda, intervallo e heartbeat dipendono dallo stato
+// dell'allarme (TELEM_POLICY_*): fitti in ALERT/ALARM, radi a
+// disarmato.
+// Non dipende da Arduino.
+// ============================================================
+#ifndef TELEMETRY_SCHEDULER_H
+#define TELEMETRY_SCHEDULER_H
+
+#include <stdint.h>
+#include "config.h"
+#include "radar_types.h"
+#include "alarm_logic.h"
+
+struct TelemetryPolicy {
+    uint16_t deadbandCm;        // variazione distanza che forza un invio
+    uint16_t minIntervalMs;     // distanza minima tra due invii
+    uint32_t heartbeatMs;       // invio anche senza cambiamenti
+};
+
+struct TelemetryStats {
+    uint32_t sent;              // messaggi pubblicati
+    uint32_t changes;           // di cui per cambiamento
+    uint32_t heartbeats;        // di cui heartbeat
+    uint32_t filtered;          // campioni soppressi: variazione entro la banda
+    uint32_t coalesced;         // campioni soppressi: cambiamento accorpato
+                                // in un invio già in attesa (intervallo o token)
+};
+
+class TelemetryScheduler {
+public:
+    TelemetryScheduler();
+
+    // true se il campione va pubblicato ora. Da chiamare a ogni
+    // giro: valuta i campioni nuovi (timestamp diverso) e lo
+    // scorrere del tempo per heartbeat e limiti
+    bool due(const RadarData& d, AlarmState state, uint32_t now);
+
+    // Pubblicazione riuscita di d (consuma un token)
+    void sent(const RadarData& d, uint32_t now);
+
+    const TelemetryStats& stats() const { return _stats; }
+
+    static const TelemetryPolicy& policy(AlarmState state);
+
+private:
+    bool           _hasSent;
+    bool           _pending;        // cambiamento non ancora pubblicato
+    bool           _lastDetected;   // ultimo campione pubblicato
+    uint8_t        _lastZoneId;
+    int            _lastDist;
+    uint32_t       _lastSentMs;
+    uint32_t       _sampleTs;       // ultimo campione valutato
+    uint32_t       _tokens;         // in ms di ricarica
+    uint32_t       _tokenMs;
+    TelemetryStats _stats;
+
+    bool _changed(const RadarData& d, const TelemetryPolicy& p) const;
+    void _refill(uint32_t now);
+};
+
+#endif // TELEMETRY_SCHEDULER_H
@@ -2,129 +2,357 @@
 // AutoGuard - Web Server + Dashboard - Implementazione
 // ============================================================
 #include "web_server.h"
+#include "web_assets.h"
+#if TRACE_SAVE_ON_ALARM
+  #include <LittleFS.h>
+#endif
 
-AutoGuardWeb::AutoGuardWeb(AlarmLogic& alarmSys, SensorLD2420& radar) :
+// ============================================================
+// Risposte JSON a flusso
+// ============================================================
+// Il JSON viene scritto direttamente nel buffer della risposta
+// (AsyncResponseStream, dimensionato a WEB_JSON_BUFFER): nessun
+// documento ArduinoJson né String intermedia
+class PrintSink : public JsonSink {
+public:
+    explicit PrintSink(Print& out) : _out(out) {}
+    void write(const char* data, size_t len) override { _out.write((const uint8_t*)data, len); }
+private:
+    Print& _out;
+};
+
+template <typename Render>
+static void sendJson(AsyncWebServerRequest* req, Render render) {
+    AsyncResponseStream* res = req->beginResponseStream("application/json", WEB_JSON_BUFFER);
+    res->addHeader("Cache-Control", "no-store");
+    PrintSink  sink(*res);
+    JsonWriter j(&sink);
+    render(j);
+    req->send(res);
+}
+
+// ============================================================
+// Pagine statiche (web/ -> scripts/build_web.py -> web_assets.h)
+// ============================================================
+// Inviate dalla flash così come sono, già compresse: nessuna
+// copia in RAM né String. L'ETag cambia solo con il contenuto;
+// il browser rivalida a ogni apertura (no-cache) e riceve 304
+// senza corpo se ha già la versione giusta
+
+// If-None-Match (RFC 9110 13.1.2): "*" oppure lista di ETag
+// separati da virgola, confronto debole (W/"x" vale "x")
+static bool etagMatches(const char* header, const char* etag) {
+    size_t      elen = strlen(etag);
+    const char* p    = header;
+    for (;;) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        if (!*p) return false;
+        if (*p == '*') return true;
+        if (p[0] == 'W' && p[1] == '/') p += 2;
+
+        const char* end = p;
+        if (*p == '"') {
+            end = strchr(p + 1, '"');
+            end = end ? end + 1 : p + strlen(p);
+        } else {
+            while (*end && *end != ',') end++;
+        }
+        if ((size_t)(end - p) == elen && !memcmp(p, etag, elen)) return true;
+        p = end;
+    }
+}
+
+static void sendAsset(AsyncWebServerRequest* req, const WebAsset& asset) {
+    const AsyncWebHeader* match = req->getHeader("If-None-Match");
+    if (match && etagMatches(match->value().c_str(), asset.etag)) {
+        AsyncWebServerResponse* res = req->beginResponse(304);
+        res->addHeader("ETag", asset.etag);
+        res->addHeader("Cache-Control", "no-cache");
+        req->send(res);
+        return;
+    }
+    AsyncWebServerResponse* res = req->beginResponse(200, asset.type, asset.data, asset.len);
+    res->addHeader("Content-Encoding", "gzip");
+    res->addHeader("ETag", asset.etag);
+    res->addHeader("Cache-Control", "no-cache");
+    req->send(res);
+}
+
+// ============================================================
+// POST /api/config - Campi presenti applicati sulla config corrente
+// ============================================================
+// Ogni campo numerico è controllato prima di save(), insieme
+// all'ordine di zone e portata: un valore fuori intervallo (tempo
+// negativo, Kalman enorme, zone invertite) rifiuta l'intera
+// richiesta e la config salvata resta quella precedente
+static void applyConfig(AsyncWebServerRequest* req, const uint8_t* data, size_t len) {
+    JsonDocument doc;
+    DeserializationError err = deserializeJson(doc, data, len);
+    if (err) {
+        req->send(400, "application/json", "{\"error\":\"JSON invalido\"}");
+        return;
+    }
+    AutoGuardConfig cfg = configMgr.get();
+    if (doc["alarmZoneCritical"].is<bool>()) cfg.alarmZoneCritical = doc["alarmZoneCritical"];
+    if (doc["alarmZoneMedium"].is<bool>())   cfg.alarmZoneMedium   = doc["alarmZoneMedium"];
+    if (doc["alarmZoneFar"].is<bool>())      cfg.alarmZoneFar      = doc["alarmZoneFar"];
+    if (doc["engineeringMode"].is<bool>())  cfg.engineeringMode   = doc["engineeringMode"];
+    if (doc["approachEscalate"].is<bool>()) cfg.approachEscalate  = doc["approachEscalate"];
+
+    // Campi con intervallo: assente = invariato
+    const struct { const char* key; int lo; int hi; int* field; } ranged[] = {
+        {"zoneCriticalMax",        1, ZONE_MAP_CM,              &cfg.zoneCriticalMax},
+        {"zoneMediumMax",          1, ZONE_MAP_CM,              &cfg.zoneMediumMax},
+        {"zoneFarMax",             1, ZONE_MAP_CM,              &cfg.zoneFarMax},
+        {"zoneHystEnterCm",        0, 100,                      &cfg.zoneHystEnterCm},
+        {"zoneHystExitCm",         0, 100,                      &cfg.zoneHystExitCm},
+        {"armingDelayMs",          0, ALARM_TIMING_MAX_MS,      &cfg.armingDelayMs},
+        {"preAlarmMs",             0, ALARM_TIMING_MAX_MS,      &cfg.preAlarmMs},
+        {"alarmDurationMs",        0, ALARM_TIMING_MAX_MS,      &cfg.alarmDurationMs},
+        {"cooldownMs",             0, ALARM_TIMING_MAX_MS,      &cfg.cooldownMs},
+        {"detectionsToAlert",      1, 1000,                     &cfg.detectionsToAlert},
+        {"radarMinDist",           0, ZONE_MAP_CM,              &cfg.radarMinDist},
+        {"radarMaxDist",           1, ZONE_MAP_CM,              &cfg.radarMaxDist},
+        {"alarmMinDist",           0, ZONE_MAP_CM,              &cfg.alarmMinDist},
+        {"filterMode",             0, FILTER_MODE_COUNT - 1,    &cfg.filterMode},
+        {"filterEmaAlpha",         1, 100,                      &cfg.filterEmaAlpha},
+        {"filterKalmanQ",          1, FILTER_KALMAN_MAX,        &cfg.filterKalmanQ},
+        {"filterKalmanR",          1, FILTER_KALMAN_MAX,        &cfg.filterKalmanR},
+        {"noiseSigmaX10",          1, 100,                      &cfg.noiseSigmaX10},
+        {"detectorMode",           0, DETECTOR_MODE_COUNT - 1,  &cfg.detectorMode},
+        {"evidenceThreshold",      1, 100000,                   &cfg.evidenceThreshold},
+        {"evidenceHalfLifeMs",     EVIDENCE_HALF_LIFE_MIN_MS, 600000, &cfg.evidenceHalfLifeMs},
+        {"evidenceWeightCritical", 0, 10000,                    &cfg.evidenceWeightCritical},
+        {"evidenceWeightMedium",   0, 10000,                    &cfg.evidenceWeightMedium},
+        {"evidenceWeightFar",      0, 10000,                    &cfg.evidenceWeightFar},
+        {"evidenceDwellMs",        0, 600000,                   &cfg.evidenceDwellMs},
+        {"evidenceApproachPct",    0, 100,                      &cfg.evidenceApproachPct},
+        {"approachLeadMs",         0, 10000,                    &cfg.approachLeadMs},
+    };
+    for (const auto& r : ranged) {
+        if (!doc[r.key].is<int>()) continue;
+        int v = doc[r.key];
+        if (v < r.lo || v > r.hi) {
+            char msg[96];
+            snprintf(msg, sizeof(msg), "{\"error\":\"%s fuori intervallo %d..%d\"}",
+                r.key, r.lo, r.hi);
+            req->send(400, "application/json", msg);
+            return;
+        }
+        *r.field = v;
+    }
+
+    // Ordine sul risultato (campi nuovi + invariati): ZoneMap::build()
+    // rifiuterebbe zone non crescenti
+    if (!(cfg.zoneCriticalMax < cfg.zoneMediumMax && cfg.zoneMediumMax < cfg.zoneFarMax)) {
+        req->send(400, "application/json",
+            "{\"error\":\"zone: zoneCriticalMax < zoneMediumMax < zoneFarMax\"}");
+        return;
+    }
+    if (cfg.radarMinDist >= cfg.radarMaxDist) {
+        req->send(400, "application/json", "{\"error\":\"radarMinDist < radarMaxDist\"}");
+        return;
+    }
+
+    configMgr.save(cfg);    // state machine e radar leggono la nuova versione
+    req->send(200, "application/json", "{\"ok\":true}");
+}
+
+AutoGuardWeb::AutoGuardWeb(AlarmLogic& alarmSys, SensorLD2420& radar, RadarFusion& fusion) :
     _server(WEB_SERVER_PORT),
     _alarmSys(alarmSys),
     _radar(radar),
+    _fusion(fusion),
     _wifiConnected(false)
 {}
 
 bool AutoGuardWeb::begin() {
-    if (!_connectWiFi()) return false;
+    // Connessione in background: il server risponde appena c'è IP
+    _wifi.begin(WIFI_SSID, WIFI_PASSWORD, WIFI_HOSTNAME);
     _setupRoutes();
     _server.begin();
-    Serial.printf("[WEB] Server avviato su http://%s\n",
-        WiFi.localIP().toString().c_str());
+    Serial.printf("[WEB] Server avviato sulla porta %d\n", WEB_SERVER_PORT);
     return true;
 }
 
 void AutoGuardWeb::update() {
-    if (WiFi.status() != WL_CONNECTED) {
-        if (_wifiConnected) {
-            Serial.println("[WEB] WiFi disconnesso! Riconnessione...");
-            _wifiConnected = false;
-        }
-        _connectWiFi();
-    }
-}
+    _wifi.update();
 
-bool AutoGuardWeb::_connectWiFi() {
-    Serial.printf("[WEB] Connessione a WiFi: %s\n", WIFI_SSID);
-    WiFi.mode(WIFI_STA);
-    WiFi.setHostname(WIFI_HOSTNAME);
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-    uint32_t start = millis();
-    while (WiFi.status() != WL_CONNECTED) {
-        if (millis() - start > WIFI_TIMEOUT_MS) {
-            Serial.println("[WEB] ERRORE: WiFi timeout!");
-            return false;
+    bool connected = _wifi.isConnected();
+    if (connected != _wifiConnected) {
+        _wifiConnected = connected;
+        if (connected) {
+            Serial.printf("[WEB] WiFi connesso! IP: %s\n",
+                WiFi.localIP().toString().c_str());
+        } else {
+            Serial.println("[WEB] WiFi disconnesso!");
         }
-        delay(500);
-        Serial.print(".");
     }
-    Serial.println();
-    Serial.printf("[WEB] WiFi connesso! IP: %s\n",
-        WiFi.localIP().toString().c_str());
-    Serial.printf("[WEB] RSSI: %d dBm\n", WiFi.RSSI());
-    _wifiConnected = true;
-    return true;
 }
 
 void AutoGuardWeb::_setupRoutes() {
-    _server.on("/", HTTP_GET, [this](AsyncWebServerRequest* req) {
-        req->send(200, "text/html", _buildDashboardHtml());
+    _server.on(WEB_ASSET_DASHBOARD.path, HTTP_GET, [](AsyncWebServerRequest* req) {
+        sendAsset(req, WEB_ASSET_DASHBOARD);
     });
 
     _server.on("/api/status", HTTP_GET, [this](AsyncWebServerRequest* req) {
-        req->send(200, "application/json", _buildStatusJson());
+        sendJson(req, [this](JsonWriter& j) { _writeStatusJson(j); });
+    });
+
+    // Transizioni con sequenza > since (il cursore è del browser)
+    _server.on("/api/events", HTTP_GET, [this](AsyncWebServerRequest* req) {
+        EventCursor cursor;
+        if (req->hasParam("since")) {
+            cursor.next = req->getParam("since")->value().toInt() + 1;
+        }
+        sendJson(req, [this, &cursor](JsonWriter& j) { _writeEventsJson(j, cursor); });
+    });
+
+    // Ultimo batch binario energie per gate (formato in energy_batch.h)
+    _server.on("/api/radar/energy", HTTP_GET, [this](AsyncWebServerRequest* req) {
+        uint8_t buf[ENERGY_BATCH_MAX_LEN];
+        size_t  len = _radar.energyBatch().copyLast(buf, sizeof(buf));
+        if (len == 0) {
+            req->send(204);
+            return;
+        }
+        AsyncResponseStream* res = req->beginResponseStream("application/octet-stream");
+        res->addHeader("Cache-Control", "no-store");
+        res->write(buf, len);
+        req->send(res);
+    });
+
+    // Trace campioni radar in RAM (formato in radar_trace.h)
+    _server.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest* req) {
+        uint8_t* buf = (uint8_t*)malloc(TRACE_MAX_LEN);
+        size_t   len = buf ? traceRecorder.copy(buf, TRACE_MAX_LEN) : 0;
+        if (len == 0) {
+            free(buf);
+            req->send(503, "application/json", "{\"error\":\"trace non disponibile\"}");
+            return;
+        }
+        AsyncResponseStream* res = req->beginResponseStream("application/octet-stream");
+        res->addHeader("Cache-Control", "no-store");
+        res->addHeader("Content-Disposition", "attachment; filename=\"autoguard.agt\"");
+        res->write(buf, len);
+        free(buf);
+        req->send(res);
+    });
+
+#if TRACE_SAVE_ON_ALARM
+    // Trace salvata all'ultimo scatto allarme
+    _server.on("/api/trace/alarm", HTTP_GET, [](AsyncWebServerRequest* req) {
+        if (!LittleFS.exists(TRACE_FILE_PATH)) {
+            req->send(404, "application/json", "{\"error\":\"nessuna trace allarme\"}");
+            return;
+        }
+        req->send(LittleFS, TRACE_FILE_PATH, "application/octet-stream", true);
     });
+#endif
+
+#if LOOP_METRICS
+    // Latenze per stadio di loop() (istogrammi in loop_metrics.h)
+    _server.on("/api/metrics", HTTP_GET, [](AsyncWebServerRequest* req) {
+        sendJson(req, [](JsonWriter& j) { loopMetrics.toJson(j); });
+    });
+
+    _server.on("/api/metrics/reset", HTTP_POST, [](AsyncWebServerRequest* req) {
+        loopMetrics.reset();
+        req->send(200, "application/json", "{\"ok\":true,\"cmd\":\"metrics_reset\"}");
+    });
+#endif
 
     _server.on("/api/arm", HTTP_POST, [this](AsyncWebServerRequest* req) {
-        _alarmSys.arm();
+        if (!_alarmSys.post(ALARM_CMD_ARM)) {
+            req->send(503, "application/json", "{\"error\":\"coda comandi piena\"}");
+            return;
+        }
         req->send(200, "application/json", "{\"ok\":true,\"cmd\":\"arm\"}");
     });
 
     _server.on("/api/disarm", HTTP_POST, [this](AsyncWebServerRequest* req) {
-        _alarmSys.disarm();
+        if (!_alarmSys.post(ALARM_CMD_DISARM)) {
+            req->send(503, "application/json", "{\"error\":\"coda comandi piena\"}");
+            return;
+        }
         req->send(200, "application/json", "{\"ok\":true,\"cmd\":\"disarm\"}");
     });
 
     _server.on("/api/reset", HTTP_POST, [this](AsyncWebServerRequest* req) {
-        _alarmSys.reset();
+        if (!_alarmSys.post(ALARM_CMD_RESET)) {
+            req->send(503, "application/json", "{\"error\":\"coda comandi piena\"}");
+            return;
+        }
         req->send(200, "application/json", "{\"ok\":true,\"cmd\":\"reset\"}");
     });
 
-    _server.on("/api/config", HTTP_GET, [this](AsyncWebServerRequest* req) {
-        AutoGuardConfig cfg = configMgr.get();
-        JsonDocument doc;
-        doc["zoneCriticalMax"]   = cfg.zoneCriticalMax;
-        doc["zoneMediumMax"]     = cfg.zoneMediumMax;
-        doc["zoneFarMax"]        = cfg.zoneFarMax;
-        doc["armingDelayMs"]     = cfg.armingDelayMs;
-        doc["preAlarmMs"]        = cfg.preAlarmMs;
-        doc["alarmDurationMs"]   = cfg.alarmDurationMs;
-        doc["cooldownMs"]        = cfg.cooldownMs;
-        doc["detectionsToAlert"] = cfg.detectionsToAlert;
-        doc["radarMinDist"]      = cfg.radarMinDist;
-        doc["radarMaxDist"]      = cfg.radarMaxDist;
-        doc["alarmMinDist"]      = cfg.alarmMinDist;
-        doc["alarmZoneCritical"] = cfg.alarmZoneCritical;
-        doc["alarmZoneMedium"]   = cfg.alarmZoneMedium;
-        doc["alarmZoneFar"]      = cfg.alarmZoneFar;
-        String json;
-        serializeJson(doc, json);
-        req->send(200, "application/json", json);
+    _server.on("/api/config", HTTP_GET, [](AsyncWebServerRequest* req) {
+        sendJson(req, [](JsonWriter& j) {
+            const AutoGuardConfig& cfg = configMgr.get();
+            j.beginObject()
+             .field("zoneCriticalMax",        cfg.zoneCriticalMax)
+             .field("zoneMediumMax",          cfg.zoneMediumMax)
+             .field("zoneFarMax",             cfg.zoneFarMax)
+             .field("zoneHystEnterCm",        cfg.zoneHystEnterCm)
+             .field("zoneHystExitCm",         cfg.zoneHystExitCm)
+             .field("armingDelayMs",          cfg.armingDelayMs)
+             .field("preAlarmMs",             cfg.preAlarmMs)
+             .field("alarmDurationMs",        cfg.alarmDurationMs)
+             .field("cooldownMs",             cfg.cooldownMs)
+             .field("detectionsToAlert",      cfg.detectionsToAlert)
+             .field("radarMinDist",           cfg.radarMinDist)
+             .field("radarMaxDist",           cfg.radarMaxDist)
+             .field("alarmMinDist",           cfg.alarmMinDist)
+             .field("alarmZoneCritical",      cfg.alarmZoneCritical)
+             .field("alarmZoneMedium",        cfg.alarmZoneMedium)
+             .field("alarmZoneFar",           cfg.alarmZoneFar)
+             .field("filterMode",             cfg.filterMode)
+             .field("filterEmaAlpha",         cfg.filterEmaAlpha)
+             .field("filterKalmanQ",          cfg.filterKalmanQ)
+             .field("filterKalmanR",          cfg.filterKalmanR)
+             .field("engineeringMode",        cfg.engineeringMode)
+             .field("noiseSigmaX10",          cfg.noiseSigmaX10)
+             .field("detectorMode",           cfg.detectorMode)
+             .field("evidenceThreshold",      cfg.evidenceThreshold)
+             .field("evidenceHalfLifeMs",     cfg.evidenceHalfLifeMs)
+             .field("evidenceWeightCritical", cfg.evidenceWeightCritical)
+             .field("evidenceWeightMedium",   cfg.evidenceWeightMedium)
+             .field("evidenceWeightFar",      cfg.evidenceWeightFar)
+             .field("evidenceDwellMs",        cfg.evidenceDwellMs)
+             .field("evidenceApproachPct",    cfg.evidenceApproachPct)
+             .field("approachEscalate",       cfg.approachEscalate)
+             .field("approachLeadMs",         cfg.approachLeadMs)
+             .endObject();
+        });
     });
 
+    // Corpo a pezzi (index/total): accumulato in _tempObject (liberato
+    // con la richiesta) e applicato all'ultimo pezzo, che risponde.
+    // Senza corpo l'handler dei dati non gira: risponde onRequest
+    // (con corpo rifiutato, 413/503, la risposta è già partita)
     _server.on("/api/config", HTTP_POST,
-        [](AsyncWebServerRequest* req) {},
+        [](AsyncWebServerRequest* req) {
+            if (!req->_tempObject && req->contentLength() == 0) {
+                req->send(400, "application/json", "{\"error\":\"corpo mancante\"}");
+            }
+        },
         nullptr,
-        [this](AsyncWebServerRequest* req, uint8_t* data, size_t len,
-               size_t index, size_t total) {
-            JsonDocument doc;
-            DeserializationError err = deserializeJson(doc, data, len);
-            if (err) {
-                req->send(400, "application/json", "{\"error\":\"JSON invalido\"}");
-                return;
+        [](AsyncWebServerRequest* req, uint8_t* data, size_t len,
+           size_t index, size_t total) {
+            if (index == 0) {
+                if (total > WEB_CONFIG_BODY_MAX) {
+                    req->send(413, "application/json", "{\"error\":\"corpo troppo grande\"}");
+                    return;
+                }
+                req->_tempObject = malloc(total ? total : 1);
+                if (!req->_tempObject) {
+                    req->send(503, "application/json", "{\"error\":\"memoria esaurita\"}");
+                    return;
+                }
             }
-            AutoGuardConfig cfg = configMgr.get();
-            if (doc["zoneCriticalMax"].is<int>())  cfg.zoneCriticalMax   = doc["zoneCriticalMax"];
-            if (doc["zoneMediumMax"].is<int>())     cfg.zoneMediumMax     = doc["zoneMediumMax"];
-            if (doc["zoneFarMax"].is<int>())        cfg.zoneFarMax        = doc["zoneFarMax"];
-            if (doc["armingDelayMs"].is<int>())     cfg.armingDelayMs     = doc["armingDelayMs"];
-            if (doc["preAlarmMs"].is<int>())        cfg.preAlarmMs        = doc["preAlarmMs"];
-            if (doc["alarmDurationMs"].is<int>())   cfg.alarmDurationMs   = doc["alarmDurationMs"];
-            if (doc["cooldownMs"].is<int>())        cfg.cooldownMs        = doc["cooldownMs"];
-            if (doc["detectionsToAlert"].is<int>()) cfg.detectionsToAlert = doc["detectionsToAlert"];
-            if (doc["radarMinDist"].is<int>())      cfg.radarMinDist      = doc["radarMinDist"];
-            if (doc["radarMaxDist"].is<int>())      cfg.radarMaxDist      = doc["radarMaxDist"];
-            if (doc["alarmMinDist"].is<int>())      cfg.alarmMinDist      = doc["alarmMinDist"];
-            if (doc["alarmZoneCritical"].is<bool>()) cfg.alarmZoneCritical = doc["alarmZoneCritical"];
-            if (doc["alarmZoneMedium"].is<bool>())   cfg.alarmZoneMedium   = doc["alarmZoneMedium"];
-            if (doc["alarmZoneFar"].is<bool>())      cfg.alarmZoneFar      = doc["alarmZoneFar"];
-            configMgr.save(cfg);
-            req->send(200, "application/json", "{\"ok\":true}");
+            if (!req->_tempObject || index + len > total) return;
+            memcpy((uint8_t*)req->_tempObject + index, data, len);
+            if (index + len == total) applyConfig(req, (const uint8_t*)req->_tempObject, total);
         }
     );
 
@@ -133,8 +361,27 @@ void AutoGuardWeb::_setupRoutes() {
         req->send(200, "application/json", "{\"ok\":true}");
     });
 
-    _server.on("/config", HTTP_GET, [this](AsyncWebServerRequest* req) {
-        req->send(200, "text/html", _buildConfigHtml());
+    // Calibrazione rumore di fondo (soglie adattive per gate)
+    _server.on("/api/calibration", HTTP_GET, [](AsyncWebServerRequest* req) {
+        sendJson(req, [](JsonWriter& j) { _writeCalibrationJson(j); });
+    });
+
+    _server.on("/api/calibration/start", HTTP_POST, [this](AsyncWebServerRequest* req) {
+        if (!_radar.isEngineeringMode()) {
+            req->send(409, "application/json", "{\"error\":\"modalita engineering non attiva\"}");
+            return;
+        }
+        noiseProfile.startLearning();
+        req->send(200, "application/json", "{\"ok\":true,\"cmd\":\"calibration_start\"}");
+    });
+
+    _server.on("/api/calibration/reset", HTTP_POST, [](AsyncWebServerRequest* req) {
+        noiseProfile.reset();
+        req->send(200, "application/json", "{\"ok\":true,\"cmd\":\"calibration_reset\"}");
+    });
+
+    _server.on(WEB_ASSET_CONFIG.path, HTTP_GET, [](AsyncWebServerRequest* req) {
+        sendAsset(req, WEB_ASSET_CONFIG);
     });
 
     _server.onNotFound([](AsyncWebServerRequest* req) {
@@ -142,328 +389,152 @@ void AutoGuardWeb::_setupRoutes() {
     });
 }
 
-String AutoGuardWeb::_buildStatusJson() {
-    JsonDocument doc;
-    RadarData radarData = _radar.getData();
-    doc["state"]        = _alarmSys.getStateName();
-    doc["state_id"]     = (int)_alarmSys.getState();
-    doc["elapsed_ms"]   = _alarmSys.getStateElapsedMs();
-    doc["arming_ms"]    = _alarmSys.getArmingCountdown();
-    doc["alarm_ms"]     = _alarmSys.getAlarmElapsedMs();
-    JsonObject radar = doc["radar"].to<JsonObject>();
-    radar["detected"]   = radarData.detected;
-    radar["distance"]   = radarData.filtered_dist;
-    radar["zone"]       = (int)radarData.zone;
-    radar["raw_dist"]   = radarData.distance_cm;
-    JsonObject wifi = doc["wifi"].to<JsonObject>();
-    wifi["ssid"]        = WiFi.SSID();
-    wifi["ip"]          = WiFi.localIP().toString();
-    wifi["rssi"]        = WiFi.RSSI();
-    doc["uptime_s"]     = millis() / 1000;
-    doc["free_heap"]    = ESP.getFreeHeap();
-    doc["fw_version"]   = FW_VERSION;
-    String out;
-    serializeJson(doc, out);
-    return out;
-}
+void AutoGuardWeb::_writeStatusJson(JsonWriter& j) {
+    RadarData radarData = _fusion.getData();
+    IPAddress ip = WiFi.localIP();
+    char      ipStr[16];
+    snprintf(ipStr, sizeof(ipStr), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
 
-bool AutoGuardWeb::isConnected() {
-    return _wifiConnected && WiFi.status() == WL_CONNECTED;
-}
+    j.beginObject()
+     .field("state",      _alarmSys.getStateName())
+     .field("state_id",   (int)_alarmSys.getState())
+     .field("elapsed_ms", _alarmSys.getStateElapsedMs())
+     .field("arming_ms",  _alarmSys.getArmingCountdown())
+     .field("alarm_ms",   _alarmSys.getAlarmElapsedMs())
+     .field("event_seq",  _alarmSys.lastEventSeq())
+     .field("evidence",   _alarmSys.getEvidence());
 
-String AutoGuardWeb::getIP() {
-    return WiFi.localIP().toString();
-}
+    j.beginObject("radar")
+     .field("detected",   radarData.detected)
+     .field("distance",   radarData.filtered_dist)
+     .field("zone",       (int)radarData.zone)
+     .field("raw_dist",   radarData.distance_cm)
+     .field("velocity",   radarData.velocity)
+     .field("trajectory", (int)radarData.trajectory)
+     .field("sensor",     (int)radarData.sensor)
+     .field("zone_id",    (int)radarData.zone_id)
+     .field("zone_ms",    radarData.zone_ms);
+    j.beginArray("sensors");
+    for (uint8_t i = 0; i < _fusion.count(); i++) {
+        const RadarData& sd = _fusion.sensorData(i);
+        j.beginObject()
+         .field("detected", sd.detected)
+         .field("distance", sd.filtered_dist)
+         .field("zone",     (int)sd.zone)
+         .field("zone_ms",  sd.zone_ms)
+         .field("age_ms",   radarData.timestamp - sd.timestamp)
+         .endObject();
+    }
+    j.endArray();
+    j.field("fusion_partial", _fusion.partial());
+    const ZoneMap& zm = _radar.zoneMap();
+    j.beginArray("dwell");
+    for (uint8_t i = 0; i < zm.count(); i++) {
+        j.beginObject()
+         .field("zone",     (int)zm.zone(i).cls)
+         .field("max_cm",   zm.zone(i).maxCm)
+         .field("dwell_ms", zm.dwellMs(i + 1))
+         .endObject();
+    }
+    j.endArray();
+    const LD2420ParserStats& ps = _radar.getParserStats();
+    j.field("overruns",       _radar.getOverruns())
+     .field("queue_hwm",      _radar.getQueueHighWater())
+     .field("frames",         ps.reportFrames + ps.engineeringFrames)
+     .field("framing_err",    ps.framingErrors)
+     .field("resync",         ps.resyncBytes)
+     .field("engineering",    _radar.isEngineeringMode())
+     .field("noise_valid",    noiseProfile.isValid())
+     .field("trace_samples",  traceRecorder.samples())
+     .field("noise_learning", noiseProfile.isLearning())
+     .endObject();
 
-// ============================================================
-// _buildDashboardHtml()
-// ============================================================
-String AutoGuardWeb::_buildDashboardHtml() {
-    return R"rawhtml(
-<!DOCTYPE html>
-<html lang="it">
-<head>
-<meta charset="UTF-8">
-<meta name="viewport" content="width=device-width, initial-scale=1.0">
-<title>AutoGuard - Antifurto Auto</title>
-<style>
-  * { margin:0; padding:0; box-sizing:border-box; }
-  body { font-family:-apple-system,BlinkMacSystemFont,"Segoe UI",sans-serif; background:#0f172a; color:#e2e8f0; min-height:100vh; padding:20px; }
-  .header { text-align:center; padding:30px 0 20px; }
-  .header h1 { font-size:2em; color:#f1f5f9; }
-  .header p { color:#94a3b8; margin-top:5px; }
-  .nav { text-align:center; margin-bottom:20px; }
-  .nav a { color:#60a5fa; text-decoration:none; margin:0 10px; font-size:0.9em; }
-  .nav a:hover { color:#93c5fd; }
-  .grid { display:grid; grid-template-columns:repeat(auto-fit,minmax(280px,1fr)); gap:20px; max-width:1000px; margin:0 auto; }
-  .card { background:#1e293b; border-radius:16px; padding:25px; border:1px solid #334155; }
-  .card h2 { font-size:0.85em; text-transform:uppercase; letter-spacing:1px; color:#64748b; margin-bottom:15px; }
-  .state-badge { display:inline-block; padding:8px 20px; border-radius:50px; font-size:1.3em; font-weight:700; letter-spacing:1px; margin-bottom:10px; }
-  .state-DISARMED  { background:#1e3a5f; color:#60a5fa; }
-  .state-ARMING    { background:#3b2f00; color:#fbbf24; }
-  .state-ARMED     { background:#14432a; color:#34d399; }
-  .state-ALERT     { background:#3b1f00; color:#fb923c; }
-  .state-ALARM     { background:#4b0000; color:#f87171; animation:pulse 0.5s infinite; }
-  .state-COOLDOWN  { background:#2d1b69; color:#a78bfa; }
-  @keyframes pulse { 0%,100%{opacity:1} 50%{opacity:0.5} }
-  .elapsed { color:#64748b; font-size:0.9em; margin-top:5px; }
-  .radar-value { font-size:3em; font-weight:700; color:#f1f5f9; margin:10px 0; }
-  .radar-unit { font-size:0.4em; color:#64748b; }
-  .zone-bar { height:8px; border-radius:4px; background:#334155; margin:10px 0; overflow:hidden; }
-  .zone-fill { height:100%; border-radius:4px; transition:width 0.3s,background 0.3s; }
-  .zone-label { font-size:0.85em; color:#94a3b8; }
-  .btn-group { display:flex; gap:10px; flex-wrap:wrap; }
-  .btn { flex:1; padding:14px; border:none; border-radius:10px; font-size:1em; font-weight:600; cursor:pointer; transition:all 0.2s; min-width:80px; }
-  .btn:hover { transform:translateY(-2px); opacity:0.9; }
-  .btn-arm    { background:#059669; color:white; }
-  .btn-disarm { background:#2563eb; color:white; }
-  .btn-reset  { background:#d97706; color:white; }
-  .info-row { display:flex; justify-content:space-between; padding:8px 0; border-bottom:1px solid #334155; font-size:0.9em; }
-  .info-row:last-child { border-bottom:none; }
-  .info-label { color:#64748b; }
-  .info-value { color:#e2e8f0; font-weight:500; }
-  .dot { display:inline-block; width:12px; height:12px; border-radius:50%; margin-right:6px; }
-  .dot-on  { background:#22c55e; box-shadow:0 0 8px #22c55e; }
-  .dot-off { background:#374151; }
-  .footer { text-align:center; margin-top:30px; color:#475569; font-size:0.8em; }
-  .config-link { text-align:center; margin-top:15px; }
-  .config-link a { color:#60a5fa; text-decoration:none; font-size:0.85em; }
-</style>
-</head>
-<body>
-<div class="header">
-  <h1>AutoGuard</h1>
-  <p>Antifurto Auto ESP32-C6 + HLK-LD2420</p>
-</div>
-<div class="nav">
-  <a href="/">Dashboard</a>
-  <a href="/config">⚙️ Configurazione</a>
-</div>
-<div class="grid">
-  <div class="card">
-    <h2>Stato Sistema</h2>
-    <div class="state-badge state-DISARMED" id="stateBadge">DISARMED</div>
-    <div class="elapsed" id="stateElapsed">0s nello stato corrente</div>
-    <div id="armingInfo" style="display:none;margin-top:10px;color:#fbbf24;">
-      Armamento in <span id="armingCountdown">5</span>s...
-    </div>
-  </div>
-  <div class="card">
-    <h2>Sensore Radar</h2>
-    <div><span class="dot dot-off" id="detDot"></span><span id="detLabel" style="color:#94a3b8;">Nessuna presenza</span></div>
-    <div class="radar-value"><span id="radarDist">--</span><span class="radar-unit">cm</span></div>
-    <div class="zone-bar"><div class="zone-fill" id="zoneFill" style="width:0%;background:#334155;"></div></div>
-    <div class="zone-label" id="zoneLabel">Zona: --</div>
-  </div>
-  <div class="card">
-    <h2>Controlli</h2>
-    <div class="btn-group">
-      <button class="btn btn-arm"    onclick="sendCmd('arm')">ARM</button>
-      <button class="btn btn-disarm" onclick="sendCmd('disarm')">DISARM</button>
-      <button class="btn btn-reset"  onclick="sendCmd('reset')">RESET</button>
-    </div>
-    <div id="cmdFeedback" style="margin-top:12px;font-size:0.85em;color:#64748b;"></div>
-  </div>
-  <div class="card">
-    <h2>Info Sistema</h2>
-    <div class="info-row"><span class="info-label">IP</span><span class="info-value" id="infoIP">--</span></div>
-    <div class="info-row"><span class="info-label">WiFi RSSI</span><span class="info-value" id="infoRSSI">-- dBm</span></div>
-    <div class="info-row"><span class="info-label">Uptime</span><span class="info-value" id="infoUptime">--</span></div>
-    <div class="info-row"><span class="info-label">RAM libera</span><span class="info-value" id="infoHeap">-- KB</span></div>
-    <div class="info-row"><span class="info-label">Firmware</span><span class="info-value" id="infoFW">--</span></div>
-  </div>
-</div>
-<div class="config-link"><a href="/config">⚙️ Configura zone e timing</a></div>
-<div class="footer">AutoGuard v1.0.0 &mdash; Aggiornamento ogni 2s</div>
-<script>
-const zoneNames  = ["--","CRITICA","MEDIA","LONTANA"];
-const zoneColors = ["#334155","#ef4444","#f97316","#eab308"];
-const zonePct    = [0,100,60,30];
-async function fetchStatus() {
-  try {
-    const r = await fetch("/api/status");
-    const d = await r.json();
-    const badge = document.getElementById("stateBadge");
-    badge.textContent = d.state;
-    badge.className = "state-badge state-" + d.state;
-    document.getElementById("stateElapsed").textContent = Math.floor(d.elapsed_ms/1000) + "s nello stato corrente";
-    const armInfo = document.getElementById("armingInfo");
-    if (d.state === "ARMING" && d.arming_ms > 0) {
-      armInfo.style.display = "block";
-      document.getElementById("armingCountdown").textContent = Math.ceil(d.arming_ms/1000);
-    } else { armInfo.style.display = "none"; }
-    const det = d.radar.detected;
-    document.getElementById("detDot").className = "dot " + (det ? "dot-on" : "dot-off");
-    document.getElementById("detLabel").textContent = det ? "Presenza rilevata!" : "Nessuna presenza";
-    document.getElementById("detLabel").style.color = det ? "#22c55e" : "#94a3b8";
-    document.getElementById("radarDist").textContent = det ? d.radar.distance : "--";
-    const zone = d.radar.zone;
-    document.getElementById("zoneFill").style.width = zonePct[zone] + "%";
-    document.getElementById("zoneFill").style.background = zoneColors[zone];
-    document.getElementById("zoneLabel").textContent = "Zona: " + zoneNames[zone];
-    document.getElementById("infoIP").textContent    = d.wifi.ip;
-    document.getElementById("infoRSSI").textContent  = d.wifi.rssi + " dBm";
-    document.getElementById("infoUptime").textContent = formatUptime(d.uptime_s);
-    document.getElementById("infoHeap").textContent  = Math.round(d.free_heap/1024) + " KB";
-    document.getElementById("infoFW").textContent    = d.fw_version;
-  } catch(e) { console.error("Errore:", e); }
-}
-function formatUptime(s) {
-  return Math.floor(s/3600) + "h " + Math.floor((s%3600)/60) + "m " + (s%60) + "s";
-}
-async function sendCmd(cmd) {
-  const fb = document.getElementById("cmdFeedback");
-  try {
-    fb.textContent = "Invio " + cmd.toUpperCase() + "...";
-    await fetch("/api/" + cmd, {method:"POST"});
-    fb.textContent = "Comando " + cmd.toUpperCase() + " inviato!";
-    fb.style.color = "#34d399";
-    fetchStatus();
-  } catch(e) { fb.textContent = "Errore!"; fb.style.color = "#f87171"; }
-}
-setInterval(fetchStatus, 2000);
-fetchStatus();
-</script>
-</body>
-</html>
-)rawhtml";
-}
+    j.beginObject("wifi")
+     .field("ssid",        WIFI_SSID)
+     .field("ip",          ipStr)
+     .field("rssi",        WiFi.RSSI())
+     .field("link",        _wifi.getStateName())
+     .field("attempts",    _wifi.getAttempts())
+     .field("disconnects", _wifi.getDisconnects())
+     .field("retry_ms",    _wifi.getRetryInMs())
+     .endObject();
 
-// ============================================================
-// _buildConfigHtml()
-// ============================================================
-String AutoGuardWeb::_buildConfigHtml() {
-    return R"rawhtml(
-<!DOCTYPE html>
-<html lang="it">
-<head>
-<meta charset="UTF-8">
-<meta name="viewport" content="width=device-width, initial-scale=1.0">
-<title>AutoGuard - Configurazione</title>
-<style>
-  * { margin:0; padding:0; box-sizing:border-box; }
-  body { font-family:-apple-system,BlinkMacSystemFont,"Segoe UI",sans-serif; background:#0f172a; color:#e2e8f0; min-height:100vh; padding:20px; }
-  .header { text-align:center; padding:30px 0 20px; }
-  .header h1 { font-size:2em; color:#f1f5f9; }
-  .header p  { color:#94a3b8; margin-top:5px; }
-  .back { display:inline-block; margin-bottom:20px; color:#60a5fa; text-decoration:none; font-size:0.9em; }
-  .grid { display:grid; grid-template-columns:repeat(auto-fit,minmax(300px,1fr)); gap:20px; max-width:900px; margin:0 auto; }
-  .card { background:#1e293b; border-radius:16px; padding:25px; border:1px solid #334155; }
-  .card h2 { font-size:0.85em; text-transform:uppercase; letter-spacing:1px; color:#64748b; margin-bottom:15px; }
-  .field { margin-bottom:15px; }
-  .field label { display:block; font-size:0.85em; color:#94a3b8; margin-bottom:5px; }
-  .field input { width:100%; padding:10px 12px; background:#0f172a; border:1px solid #334155; border-radius:8px; color:#e2e8f0; font-size:1em; }
-  .field input:focus { outline:none; border-color:#60a5fa; }
-  .field .unit { font-size:0.75em; color:#475569; margin-top:3px; }
-  .btn-group { display:flex; gap:10px; margin-top:20px; }
-  .btn { flex:1; padding:12px; border:none; border-radius:10px; font-size:0.95em; font-weight:600; cursor:pointer; transition:all 0.2s; }
-  .btn:hover { transform:translateY(-2px); opacity:0.9; }
-  .btn-save  { background:#059669; color:white; }
-  .btn-reset { background:#dc2626; color:white; }
-  .btn-dash  { background:#2563eb; color:white; }
-  #feedback { max-width:900px; margin:15px auto 0; padding:12px 20px; border-radius:10px; text-align:center; display:none; }
-  .fb-ok  { background:#064e3b; color:#34d399; }
-  .fb-err { background:#450a0a; color:#f87171; }
-</style>
-</head>
-<body>
-<div class="header"><h1>⚙️ Configurazione</h1><p>Parametri salvati in memoria flash (NVS)</p></div>
-<div style="max-width:900px;margin:0 auto;"><a class="back" href="/">← Dashboard</a></div>
-<div id="feedback"></div>
-<div class="grid">
-  <div class="card">
-    <h2>📡 Zone Radar</h2>
-    <div class="field"><label>Zona CRITICA (max cm)</label><input type="number" id="zoneCriticalMax" min="20" max="400"><div class="unit">default: 100cm</div></div>
-    <div class="field"><label>Zona MEDIA (max cm)</label><input type="number" id="zoneMediumMax" min="20" max="400"><div class="unit">default: 250cm</div></div>
-    <div class="field"><label>Zona LONTANA (max cm)</label><input type="number" id="zoneFarMax" min="20" max="800"><div class="unit">default: 400cm</div></div>
-    <div class="field"><label>Distanza minima radar (cm)</label><input type="number" id="radarMinDist" min="10" max="100"><div class="unit">default: 20cm</div></div>
-    <div class="field"><label>Distanza massima radar (cm)</label><input type="number" id="radarMaxDist" min="100" max="800"><div class="unit">default: 400cm</div></div>
-  </div>
-  <div class="card">
-    <h2>⏱️ Timing Allarme</h2>
-    <div class="field"><label>Ritardo armamento (ms)</label><input type="number" id="armingDelayMs" min="1000" max="30000" step="1000"><div class="unit">default: 5000ms</div></div>
-    <div class="field"><label>Pre-allarme (ms)</label><input type="number" id="preAlarmMs" min="500" max="10000" step="500"><div class="unit">default: 3000ms</div></div>
-    <div class="field"><label>Durata allarme (ms)</label><input type="number" id="alarmDurationMs" min="5000" max="120000" step="1000"><div class="unit">default: 30000ms</div></div>
-    <div class="field"><label>Cooldown (ms)</label><input type="number" id="cooldownMs" min="1000" max="60000" step="1000"><div class="unit">default: 10000ms</div></div>
-    <div class="field"><label>Rilevamenti per alert</label><input type="number" id="detectionsToAlert" min="1" max="50"><div class="unit">default: 5</div></div>
-  </div>
-  <div class="card">
-    <h2>🚨 Soglie Allarme</h2>
-    <div class="field"><label>Distanza minima allarme (cm)</label><input type="number" id="alarmMinDist" min="0" max="200"><div class="unit">ignora rilevamenti sotto questa distanza (default: 30cm)</div></div>
-    <div class="field"><label style="display:flex;align-items:center;gap:10px;"><input type="checkbox" id="alarmZoneCritical" style="width:auto;"> Abilita zona CRITICA</label><div class="unit">zona 0 - CRITICAL_MAX cm (default: attiva)</div></div>
-    <div class="field"><label style="display:flex;align-items:center;gap:10px;"><input type="checkbox" id="alarmZoneMedium" style="width:auto;"> Abilita zona MEDIA</label><div class="unit">zona CRITICAL_MAX - MEDIUM_MAX cm (default: attiva)</div></div>
-    <div class="field"><label style="display:flex;align-items:center;gap:10px;"><input type="checkbox" id="alarmZoneFar" style="width:auto;"> Abilita zona LONTANA</label><div class="unit">zona MEDIUM_MAX - FAR_MAX cm (default: disattiva)</div></div>
-  </div>
-</div>
-<div style="max-width:900px;margin:20px auto;">
-  <div class="btn-group">
-    <button class="btn btn-save"  onclick="saveConfig()">💾 Salva</button>
-    <button class="btn btn-reset" onclick="resetConfig()">🔄 Reset Default</button>
-    <button class="btn btn-dash"  onclick="location.href='/'">🏠 Dashboard</button>
-  </div>
-</div>
-<script>
-async function loadConfig() {
-  try {
-    const r = await fetch("/api/config");
-    const d = await r.json();
-    document.getElementById("zoneCriticalMax").value   = d.zoneCriticalMax;
-    document.getElementById("zoneMediumMax").value     = d.zoneMediumMax;
-    document.getElementById("zoneFarMax").value        = d.zoneFarMax;
-    document.getElementById("armingDelayMs").value     = d.armingDelayMs;
-    document.getElementById("preAlarmMs").value        = d.preAlarmMs;
-    document.getElementById("alarmDurationMs").value   = d.alarmDurationMs;
-    document.getElementById("cooldownMs").value        = d.cooldownMs;
-    document.getElementById("detectionsToAlert").value = d.detectionsToAlert;
-    document.getElementById("radarMinDist").value      = d.radarMinDist;
-    document.getElementById("radarMaxDist").value      = d.radarMaxDist;
-    document.getElementById("alarmMinDist").value      = d.alarmMinDist;
-    document.getElementById("alarmZoneCritical").checked = d.alarmZoneCritical;
-    document.getElementById("alarmZoneMedium").checked   = d.alarmZoneMedium;
-    document.getElementById("alarmZoneFar").checked      = d.alarmZoneFar;
-  } catch(e) { showFeedback("Errore caricamento!", false); }
+    // Tempo del loop in attesa (CPU libera: DFS/light sleep) e al
+    // lavoro, per stato
+    j.beginObject("power")
+     .field("mode", powerMgr.modeName())
+     .beginArray("states");
+    for (int st = 0; st < POWER_STATES; st++) {
+        j.beginObject()
+         .field("state",     AlarmLogic::getStateName((AlarmState)st))
+         .field("awake_ms",  powerMgr.awakeMs((AlarmState)st))
+         .field("sleep_ms",  powerMgr.sleepMs((AlarmState)st))
+         .field("sleep_pct", (int)powerMgr.sleepPct((AlarmState)st))
+         .endObject();
+    }
+    j.endArray().endObject();
+
+    j.beginObject("journal")
+     .field("ready",      stateJournal.isReady())
+     .field("records",    stateJournal.sequence())
+     .field("rotations",  stateJournal.rotations())
+     .field("torn",       stateJournal.torn())
+     .field("recover_us", stateJournal.scanUs())
+     .endObject();
+
+    j.field("uptime_s",   millis() / 1000)
+     .field("free_heap",  ESP.getFreeHeap())
+     .field("heap_min",   ESP.getMinFreeHeap())
+     .field("fw_version", FW_VERSION)
+     .endObject();
 }
-async function saveConfig() {
-  const cfg = {
-    zoneCriticalMax:   parseInt(document.getElementById("zoneCriticalMax").value),
-    zoneMediumMax:     parseInt(document.getElementById("zoneMediumMax").value),
-    zoneFarMax:        parseInt(document.getElementById("zoneFarMax").value),
-    armingDelayMs:     parseInt(document.getElementById("armingDelayMs").value),
-    preAlarmMs:        parseInt(document.getElementById("preAlarmMs").value),
-    alarmDurationMs:   parseInt(document.getElementById("alarmDurationMs").value),
-    cooldownMs:        parseInt(document.getElementById("cooldownMs").value),
-    detectionsToAlert: parseInt(document.getElementById("detectionsToAlert").value),
-    radarMinDist:      parseInt(document.getElementById("radarMinDist").value),
-    radarMaxDist:      parseInt(document.getElementById("radarMaxDist").value),
-    alarmMinDist:      parseInt(document.getElementById("alarmMinDist").value),
-    alarmZoneCritical: document.getElementById("alarmZoneCritical").checked,
-    alarmZoneMedium:   document.getElementById("alarmZoneMedium").checked,
-    alarmZoneFar:      document.getElementById("alarmZoneFar").checked,
-  };
-  try {
-    const r = await fetch("/api/config", {method:"POST", headers:{"Content-Type":"application/json"}, body:JSON.stringify(cfg)});
-    const d = await r.json();
-    showFeedback(d.ok ? "✅ Configurazione salvata!" : "❌ Errore!", d.ok);
-  } catch(e) { showFeedback("❌ Errore connessione!", false); }
+
+void AutoGuardWeb::_writeEventsJson(JsonWriter& j, EventCursor& cursor) {
+    AlarmEvent ev;
+    int        n = 0;
+    j.beginObject().beginArray("events");
+    while (n < WEB_EVENTS_MAX && _alarmSys.readEvent(cursor, ev)) {
+        j.beginObject()
+         .field("seq",        ev.seq)
+         .field("state",      AlarmLogic::getStateName(ev.state))
+         .field("prev_state", AlarmLogic::getStateName(ev.prevState))
+         .field("zone",       (int)ev.zone)
+         .field("distance",   ev.distance_cm)
+         .field("timestamp",  ev.timestamp)
+         .endObject();
+        n++;
+    }
+    j.endArray()
+     .field("next",      cursor.next - 1)     // since per la richiesta successiva
+     .field("overflows", cursor.overflows)
+     .field("uptime_ms", millis())
+     .endObject();
 }
-async function resetConfig() {
-  if (!confirm("Reset ai valori di default?")) return;
-  try {
-    await fetch("/api/config/reset", {method:"POST"});
-    showFeedback("🔄 Reset eseguito!", true);
-    loadConfig();
-  } catch(e) { showFeedback("❌ Errore!", false); }
+
+void AutoGuardWeb::_writeCalibrationJson(JsonWriter& j) {
+    j.beginObject()
+     .field("learning",   noiseProfile.isLearning())
+     .field("valid",      noiseProfile.isValid())
+     .field("frames",     noiseProfile.getLearnedSamples())
+     .field("target",     NOISE_LEARN_FRAMES)
+     .field("suppressed", noiseProfile.getSuppressed())
+     .field("sigma_x10",  configMgr.get().noiseSigmaX10)
+     .field("gate_cm",    LD2420_GATE_CM)
+     .beginArray("gates");
+    for (int g = 0; g < LD2420_GATE_COUNT; g++) {
+        j.beginObject()
+         .field("mean",      noiseProfile.getMean(g))
+         .field("std",       noiseProfile.getStdDev(g))
+         .field("threshold", noiseProfile.getThreshold(g))
+         .endObject();
+    }
+    j.endArray().endObject();
 }
-function showFeedback(msg, ok) {
-  const fb = document.getElementById("feedback");
-  fb.textContent = msg;
-  fb.className = ok ? "fb-ok" : "fb-err";
-  fb.style.display = "block";
-  setTimeout(() => fb.style.display = "none", 3000);
+
+bool AutoGuardWeb::isConnected() {
+    return _wifi.isConnected();
 }
-loadConfig();
-</script>
-</body>
-</html>
-)rawhtml";
+
+String AutoGuardWeb::getIP() {
+    return WiFi.localIP().toString();
 }
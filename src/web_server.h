@@ -11,16 +11,26 @@
 #include "config.h"
 #include "alarm_logic.h"
 #include "sensor_ld2420.h"
+#include "radar_fusion.h"
 #include "config_manager.h"
+#include "noise_profile.h"
+#include "radar_trace.h"
+#include "loop_metrics.h"
+#include "wifi_link.h"
+#include "power_manager.h"
+#include "state_journal.h"
+#include "json_writer.h"
 
 class AutoGuardWeb {
 public:
-    AutoGuardWeb(AlarmLogic& alarmSys, SensorLD2420& radar);
+    // radar = sensore principale (energie, modalità engineering),
+    // fusion = flusso fuso e quadro presenze per sensore
+    AutoGuardWeb(AlarmLogic& alarmSys, SensorLD2420& radar, RadarFusion& fusion);
 
-    // Inizializza WiFi e web server
+    // Avvia WiFi (non bloccante) e web server
     bool begin();
 
-    // Da chiamare nel loop
+    // Da chiamare nel loop: avanza la riconnessione WiFi
     void update();
 
     // true se WiFi connesso
@@ -33,20 +43,21 @@ private:
     AsyncWebServer  _server;
     AlarmLogic&     _alarmSys;
     SensorLD2420&   _radar;
+    RadarFusion&    _fusion;
+    WifiLink        _wifi;
     bool            _wifiConnected;
 
-    // Setup WiFi
-    bool _connectWiFi();
-
     // Setup routes
     void _setupRoutes();
 
-    // Genera JSON stato sistema
-    String _buildStatusJson();
+    // JSON stato sistema
+    void _writeStatusJson(JsonWriter& j);
+
+    // JSON transizioni dal cursore (avanzato)
+    void _writeEventsJson(JsonWriter& j, EventCursor& cursor);
 
-    // Genera HTML dashboard
-    String _buildDashboardHtml();
-    String _buildConfigHtml();
+    // JSON profilo rumore di fondo
+    static void _writeCalibrationJson(JsonWriter& j);
 };
 
 #endif // WEB_SERVER_H
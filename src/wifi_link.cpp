@@ -0,0 +1,107 @@
+// ============================================================
+// AutoGuard - Link WiFi non bloccante - Implementazione
+// ============================================================
+#include "wifi_link.h"
+
+static const char* const STATE_NAMES[] = {
+    "IDLE", "CONNECTING", "CONNECTED", "BACKOFF"
+};
+
+// ============================================================
+// Costruttore
+// ============================================================
+WifiLink::WifiLink() :
+    _ssid(nullptr),
+    _pass(nullptr),
+    _state(WIFI_LINK_IDLE),
+    _stateStart(0),
+    _retryDelay(0),
+    _backoff(WIFI_BACKOFF_MIN_MS, WIFI_BACKOFF_MAX_MS, WIFI_BACKOFF_JITTER_PCT),
+    _attempts(0),
+    _disconnects(0),
+    _event(EVT_NONE)
+{}
+
+// ============================================================
+// begin() - Registra eventi e avvia il primo tentativo
+// ============================================================
+void WifiLink::begin(const char* ssid, const char* pass, const char* hostname) {
+    _ssid = ssid;
+    _pass = pass;
+    _backoff.seed((uint32_t)halMicros());
+
+    halWifiInit(hostname, _onEvent, this);
+    halLog.printf("[WIFI] Connessione a %s...\n", _ssid);
+    _startAttempt();
+}
+
+void WifiLink::_onEvent(HalWifiEvent evt, void* ctx) {
+    WifiLink* self = static_cast<WifiLink*>(ctx);
+    self->_event.store(evt == HAL_WIFI_EVT_CONNECTED ? EVT_CONNECTED : EVT_DISCONNECTED,
+                       std::memory_order_release);
+}
+
+// ============================================================
+// update() - Transizioni, mai bloccante
+// ============================================================
+void WifiLink::update() {
+    uint8_t  evt = _event.exchange(EVT_NONE, std::memory_order_acq_rel);
+    uint32_t now = halMillis();
+
+    switch (_state) {
+        case WIFI_LINK_CONNECTING:
+            if (evt == EVT_CONNECTED) {
+                _state     = WIFI_LINK_CONNECTED;
+                _backoff.reset();
+                halLog.printf("[WIFI] Connesso dopo %lums (RSSI %d dBm)\n",
+                    (unsigned long)(now - _stateStart), halWifiRssi());
+            } else if (evt == EVT_DISCONNECTED || now - _stateStart > WIFI_TIMEOUT_MS) {
+                halLog.printf("[WIFI] Tentativo %lu fallito\n", (unsigned long)_attempts);
+                halWifiDisconnect();
+                _scheduleRetry();
+            }
+            break;
+
+        case WIFI_LINK_CONNECTED:
+            if (evt == EVT_DISCONNECTED) {
+                _disconnects++;
+                halLog.println("[WIFI] Link perso, riconnessione in background");
+                _scheduleRetry();
+            }
+            break;
+
+        case WIFI_LINK_BACKOFF:
+            if (now - _stateStart >= _retryDelay) _startAttempt();
+            break;
+
+        default:
+            break;
+    }
+}
+
+// ============================================================
+// Tentativi e backoff (backoff.h)
+// ============================================================
+void WifiLink::_startAttempt() {
+    _attempts++;
+    _state      = WIFI_LINK_CONNECTING;
+    _stateStart = halMillis();
+    halWifiConnect(_ssid, _pass);
+}
+
+void WifiLink::_scheduleRetry() {
+    _retryDelay = _backoff.next();
+    _state      = WIFI_LINK_BACKOFF;
+    _stateStart = halMillis();
+    halLog.printf("[WIFI] Nuovo tentativo tra %lums\n", (unsigned long)_retryDelay);
+}
+
+uint32_t WifiLink::getRetryInMs() const {
+    if (_state != WIFI_LINK_BACKOFF) return 0;
+    uint32_t elapsed = halMillis() - _stateStart;
+    return elapsed >= _retryDelay ? 0 : _retryDelay - elapsed;
+}
+
+const char* WifiLink::getStateName() const {
+    return STATE_NAMES[_state];
+}
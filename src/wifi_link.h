@@ -0,0 +1,73 @@
+// ============================================================
+// AutoGuard - Link WiFi non bloccante
+// ============================================================
+// Macchina a stati guidata dagli eventi del driver WiFi:
+//
+//   IDLE -> CONNECTING --(GOT_IP)--> CONNECTED
+//              |  ^                      |
+//   (fallito/  |  | (scaduto backoff)    | (disconnesso)
+//    timeout)  v  |                      |
+//             BACKOFF <------------------+
+//
+// Il backoff raddoppia a ogni fallimento (WIFI_BACKOFF_MIN_MS ..
+// WIFI_BACKOFF_MAX_MS) con jitter casuale, e torna al minimo a
+// connessione riuscita. update() è O(1) e non attende mai:
+// radar e state machine allarme restano attivi durante i blackout.
+// ============================================================
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include <stdint.h>
+#include <atomic>
+#include "hal.h"
+#include "config.h"
+#include "backoff.h"
+
+enum WifiLinkState {
+    WIFI_LINK_IDLE = 0,
+    WIFI_LINK_CONNECTING,
+    WIFI_LINK_CONNECTED,
+    WIFI_LINK_BACKOFF
+};
+
+class WifiLink {
+public:
+    WifiLink();
+
+    // Registra gli eventi e avvia il primo tentativo (non bloccante)
+    void begin(const char* ssid, const char* pass, const char* hostname);
+
+    // Da chiamare nel loop
+    void update();
+
+    bool          isConnected() const { return _state == WIFI_LINK_CONNECTED; }
+    WifiLinkState getState() const    { return _state; }
+    const char*   getStateName() const;
+
+    // Statistiche
+    uint32_t getAttempts() const    { return _attempts; }
+    uint32_t getDisconnects() const { return _disconnects; }
+    uint32_t getBackoffMs() const   { return _backoff.base(); }
+    uint32_t getRetryInMs() const;
+
+private:
+    enum : uint8_t { EVT_NONE = 0, EVT_CONNECTED, EVT_DISCONNECTED };
+
+    const char*     _ssid;
+    const char*     _pass;
+    WifiLinkState   _state;
+    uint32_t        _stateStart;    // inizio tentativo / backoff
+    uint32_t        _retryDelay;    // attesa corrente (con jitter)
+    ExpBackoff      _backoff;
+    uint32_t        _attempts;
+    uint32_t        _disconnects;
+
+    // Ultimo evento dal driver (scritto nel task WiFi)
+    std::atomic<uint8_t> _event;
+
+    static void _onEvent(HalWifiEvent evt, void* ctx);
+    void     _startAttempt();
+    void     _scheduleRetry();
+};
+
+#endif // WIFI_LINK_H
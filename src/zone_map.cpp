@@ -0,0 +1,106 @@
+// ============================================================
+// AutoGuard - Mappa distanza -> zona - Implementazione
+// ============================================================
+#include "zone_map.h"
+#include <string.h>
+
+// Bordi e banda di ingresso di una zona (solo in build())
+struct ZoneBounds {
+    int lo;
+    int hi;
+    int enter;
+};
+
+// Passaggio da cur a z (già oltre la banda di uscita dai bordi
+// di cur): oltre la banda di ingresso dal bordo di z da cui si
+// arriva (dall'esterno se z è più vicina)
+static bool zoneCrossed(const ZoneBounds* b, uint8_t cur, uint8_t z, int cm) {
+    if (!z) return true;
+    if (cur && b[z].lo > b[cur].hi) return cm >= b[z].lo + b[z].enter;
+    return cm <= b[z].hi - b[z].enter;
+}
+
+ZoneMap::ZoneMap() :
+    _count(0),
+    _cur(ZONE_MAP_IDLE),
+    _since(0),
+    _lastMs(0)
+{
+    memset(_next, 0, sizeof(_next));
+    memset(_dwell, 0, sizeof(_dwell));
+    for (uint8_t i = 0; i <= ZONE_MAP_MAX; i++) _cls[i] = ZONE_NONE;
+}
+
+// ============================================================
+// build() - Tabella di transizione con l'isteresi già applicata
+// ============================================================
+bool ZoneMap::build(const ZoneDef* zones, uint8_t count, int enterCm, int exitCm) {
+    if (count > ZONE_MAP_MAX || enterCm < 0 || exitCm < 0) return false;
+    for (uint8_t i = 0; i < count; i++) {
+        if (zones[i].maxCm <= (i ? zones[i - 1].maxCm : 0)) return false;
+    }
+
+    memcpy(_zones, zones, count * sizeof(ZoneDef));
+    _count = count;
+
+    ZoneBounds b[ZONE_MAP_MAX + 1] = {};
+    int lo = 1;
+    for (uint8_t i = 0; i < count; i++) {
+        int half = (zones[i].maxCm - lo) / 2;
+        b[i + 1].lo    = lo;
+        b[i + 1].hi    = zones[i].maxCm;
+        b[i + 1].enter = enterCm < half ? enterCm : half;
+        _cls[i + 1]    = zones[i].cls;
+        lo = zones[i].maxCm + 1;
+    }
+    for (uint8_t i = count + 1; i <= ZONE_MAP_MAX; i++) _cls[i] = ZONE_NONE;
+
+    // Nessuna zona seguita: zona che contiene la distanza
+    memset(_next, 0, sizeof(_next));
+    uint8_t* plain = _next[ZONE_MAP_IDLE];
+    for (int cm = 1; cm <= ZONE_MAP_CM + 1; cm++) {
+        for (uint8_t z = 1; z <= count; z++) {
+            if (cm >= b[z].lo && cm <= b[z].hi) { plain[cm] = z; break; }
+        }
+    }
+
+    // Da ogni zona: si resta entro la banda di uscita, altrimenti
+    // si passa alla zona della distanza se oltre la sua banda di
+    // ingresso
+    for (uint8_t cur = 0; cur <= count; cur++) {
+        uint8_t* row = _next[cur];
+        for (int cm = 0; cm <= ZONE_MAP_CM + 1; cm++) {
+            uint8_t z    = plain[cm];
+            bool    stay = cur && cm >= b[cur].lo - exitCm && cm <= b[cur].hi + exitCm;
+            row[cm] = (!stay && z != cur && zoneCrossed(b, cur, z, cm)) ? z : cur;
+        }
+    }
+    _cur = ZONE_MAP_IDLE;
+    return true;
+}
+
+// ============================================================
+// apply() - Zona del campione (un accesso alla tabella)
+// ============================================================
+void ZoneMap::apply(RadarData& d) {
+    if (!d.detected) {
+        _cur      = ZONE_MAP_IDLE;
+        d.zone    = ZONE_NONE;
+        d.zone_id = 0;
+        d.zone_ms = 0;
+        return;
+    }
+
+    int     cm   = d.filtered_dist;
+    int     col  = cm <= 0 ? 0 : (cm > ZONE_MAP_CM ? ZONE_MAP_CM + 1 : cm);
+    uint8_t prev = _cur;
+    uint8_t z    = _next[prev][col];
+
+    if (prev != ZONE_MAP_IDLE) _dwell[prev] += d.timestamp - _lastMs;
+    if (z != prev) _since = d.timestamp;
+    _cur      = z;
+    _lastMs   = d.timestamp;
+    d.zone    = _cls[z];
+    d.zone_id = z;
+    d.zone_ms = d.timestamp - _since;
+}
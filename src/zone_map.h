@@ -0,0 +1,79 @@
+// ============================================================
+// AutoGuard - Mappa distanza -> zona (tabella + isteresi)
+// ============================================================
+// Le zone (fino a ZONE_MAP_MAX, in ordine di distanza) hanno un
+// indice (1..n, 0 = fuori da tutte) e una classe RadarZone per la
+// state machine; più zone possono avere la stessa classe.
+//
+// Isteresi sul bordo attraversato:
+//   - uscita: si lascia la zona corrente solo oltre exitCm dai
+//     suoi bordi
+//   - ingresso: si entra nella nuova zona solo entro enterCm dal
+//     bordo da cui si arriva (al più metà della zona)
+// Un bersaglio fermo su un confine non alterna più le zone a
+// ogni frame. Il primo campione dopo un'assenza prende la zona
+// senza isteresi.
+//
+// build() compila tutto in una tabella di transizione [zona
+// corrente][cm] -> zona, con una voce per centimetro fino a
+// ZONE_MAP_CM (portata dell'LD2420) e una riga per "nessuna zona
+// seguita": per campione un solo accesso, nessun confronto con i
+// bordi. Distanze <= 0 valgono 0, oltre ZONE_MAP_CM valgono
+// ZONE_MAP_CM + 1. Circa 11 KB per mappa.
+//
+// Permanenza: per ogni zona il tempo totale dall'avvio e, nel
+// campione, il tempo continuo nella zona corrente.
+// Memoria fissa, la tabella si ricostruisce solo con build()
+// (nuova config). Non dipende da Arduino.
+// ============================================================
+#ifndef ZONE_MAP_H
+#define ZONE_MAP_H
+
+#include <stdint.h>
+#include "ld2420_protocol.h"
+#include "radar_types.h"
+
+#define ZONE_MAP_MAX    8
+#define ZONE_MAP_CM     (LD2420_GATE_COUNT * LD2420_GATE_CM)
+#define ZONE_MAP_IDLE   (ZONE_MAP_MAX + 1)  // riga: nessuna zona seguita
+
+struct ZoneDef {
+    int       maxCm;        // bordo esterno (la zona parte dal precedente)
+    RadarZone cls;          // classe per state machine e rilevatore
+};
+
+class ZoneMap {
+public:
+    ZoneMap();
+
+    // Compila la tabella. Zone con maxCm crescente, la prima parte
+    // da 1cm; false (tabella invariata) se non valide
+    bool build(const ZoneDef* zones, uint8_t count, int enterCm, int exitCm);
+
+    // Completa zone, zone_id e zone_ms del campione (detected,
+    // filtered_dist, timestamp) e aggiorna la permanenza
+    void apply(RadarData& d);
+
+    // Dimentica la zona corrente (i totali restano)
+    void reset() { _cur = ZONE_MAP_IDLE; }
+
+    uint8_t        count() const { return _count; }
+    const ZoneDef& zone(uint8_t i) const { return _zones[i < _count ? i : 0]; }   // indice i + 1
+    uint8_t        current() const { return _cur != ZONE_MAP_IDLE ? _cur : 0; }
+
+    // Tempo totale nella zona id (1..count, 0 = fuori), ms
+    uint32_t dwellMs(uint8_t id) const { return _dwell[id <= ZONE_MAP_MAX ? id : 0]; }
+
+private:
+    uint8_t   _next[ZONE_MAP_IDLE + 1][ZONE_MAP_CM + 2];   // [zona corrente][cm] -> zona
+    ZoneDef   _zones[ZONE_MAP_MAX];
+    RadarZone _cls[ZONE_MAP_MAX + 1];       // classe per indice (0 = ZONE_NONE)
+    uint8_t   _count;
+
+    uint8_t   _cur;                         // indice o ZONE_MAP_IDLE
+    uint32_t  _since;                       // ingresso nella zona corrente
+    uint32_t  _lastMs;
+    uint32_t  _dwell[ZONE_MAP_MAX + 1];
+};
+
+#endif // ZONE_MAP_H
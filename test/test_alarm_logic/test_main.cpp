@@ -0,0 +1,100 @@
+// ============================================================
+// AutoGuard - Test comandi AlarmLogic (host, [env:native])
+// ============================================================
+// Comandi dal web accodati per il loop: tutti eseguiti in
+// ordine al tick(), il loop in attesa svegliato da post(),
+// coda piena segnalata al chiamante; config salvata ricaricata
+// solo su notifica del listener.
+// ============================================================
+#include <unity.h>
+#include <stdint.h>
+#include "hal.h"
+#include "hal_native.h"
+#include "config.h"
+#include "config_manager.h"
+#include "alarm_logic.h"
+
+void setUp() {
+    halNativeUseVirtualClock(true);
+    halNativeSetLogEnabled(false);
+    configMgr.begin();
+}
+
+void tearDown() {}
+
+// ARM seguito da DISARM prima del tick: due transizioni, non
+// solo l'ultimo comando
+static void test_commands_run_in_order() {
+    AlarmLogic alarm;
+    alarm.begin();
+    uint32_t seq = alarm.lastEventSeq();
+
+    TEST_ASSERT_TRUE(alarm.post(ALARM_CMD_ARM));
+    TEST_ASSERT_TRUE(alarm.post(ALARM_CMD_DISARM));
+    alarm.tick();
+
+    TEST_ASSERT_EQUAL_UINT32(seq + 2, alarm.lastEventSeq());
+    TEST_ASSERT_EQUAL(STATE_DISARMED, alarm.getState());
+}
+
+// Il loop in attesa riparte subito, non al timeout
+static void test_post_wakes_loop() {
+    AlarmLogic alarm;
+    int loopTask = 0;
+    alarm.begin();
+    alarm.setConsumer(&loopTask);
+
+    uint32_t t0 = halMillis();
+    TEST_ASSERT_TRUE(alarm.post(ALARM_CMD_ARM));
+    halTaskWait(POWER_IDLE_DISARMED_MS);
+    TEST_ASSERT_EQUAL_UINT32(t0, halMillis());
+
+    alarm.tick();
+    TEST_ASSERT_EQUAL(STATE_ARMING, alarm.getState());
+}
+
+static void test_full_queue_rejects() {
+    AlarmLogic alarm;
+    alarm.begin();
+    for (uint32_t i = 0; i < ALARM_CMD_QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE(alarm.post(ALARM_CMD_RESET));
+    }
+    TEST_ASSERT_FALSE(alarm.post(ALARM_CMD_ARM));
+    TEST_ASSERT_EQUAL_UINT32(1, alarm.droppedCommands());
+
+    alarm.tick();
+    TEST_ASSERT_TRUE(alarm.post(ALARM_CMD_ARM));
+}
+
+// Nessun controllo di versione a ogni tick(): i nuovi tempi
+// valgono dopo configChanged()
+static void test_config_reload_on_notify() {
+    AlarmLogic alarm;
+    alarm.begin();
+
+    AutoGuardConfig cfg = configMgr.get();
+    cfg.armingDelayMs = 1234;
+    TEST_ASSERT_TRUE(configMgr.save(cfg));
+    alarm.tick();
+    alarm.arm();
+    TEST_ASSERT_EQUAL_UINT32(ARMING_DELAY_MS, alarm.msToDeadline());
+    alarm.disarm();
+
+    alarm.configChanged();
+    alarm.tick();
+    alarm.arm();
+    TEST_ASSERT_EQUAL_UINT32(1234, alarm.msToDeadline());
+
+    configMgr.resetDefaults();
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_commands_run_in_order);
+    RUN_TEST(test_post_wakes_loop);
+    RUN_TEST(test_full_queue_rejects);
+    RUN_TEST(test_config_reload_on_notify);
+    return UNITY_END();
+}
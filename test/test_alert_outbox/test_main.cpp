@@ -0,0 +1,322 @@
+// ============================================================
+// AutoGuard - Test AlertOutbox (host, [env:native])
+// ============================================================
+// Log su "file" in RAM con le stesse regole del firmware
+// (mqtt_client.cpp): voci accodate, compattazione in un file
+// temporaneo sostituito al log solo a scrittura completata.
+//   - restore(): coda ricostruita, voce troncata o corrotta in
+//     coda ignorata, checksum anche sul tipo di voce
+//   - prova di 20 minuti con broker finto: arma/disarma ogni 13s,
+//     broker irraggiungibile da 4 a 7 e da 11 a 13 minuti, muto
+//     da 9:00 (PUBACK persi), riavvio a 12 con mezza voce in coda
+//     e un secondo reset a metà compattazione. Ogni id deve
+//     arrivare al broker almeno una volta.
+// ============================================================
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "hal.h"
+#include "hal_native.h"
+#include "config.h"
+#include "config_manager.h"
+#include "alarm_logic.h"
+#include "wifi_link.h"
+#include "mqtt_async.h"
+#include "alert_outbox.h"
+
+#define OUTBOX_SIM_MS         (20UL * 60 * 1000)
+#define OUTBOX_SIM_REBOOT_MS  (12UL * 60 * 1000)
+
+// ------------------------------------------------------------
+// Log: file corrente e file temporaneo della compattazione
+// ------------------------------------------------------------
+static std::vector<uint8_t>  logFile;
+static std::vector<uint8_t>  tmpFile;
+static std::vector<uint8_t>* openFile = &logFile;
+
+static void logSink(const uint8_t* entry, size_t len, void* ctx) {
+    (void)ctx;
+    openFile->insert(openFile->end(), entry, entry + len);
+}
+
+// Con rename=false simula un reset prima della sostituzione
+static void compactLog(AlertOutbox& outbox, bool rename) {
+    tmpFile.clear();
+    openFile = &tmpFile;
+    outbox.compact();
+    openFile = &logFile;
+    if (rename) logFile.swap(tmpFile);
+}
+
+static AlarmEvent makeEvent(uint32_t seq, AlarmState st, AlarmState prev) {
+    AlarmEvent ev = {};
+    ev.seq         = seq;
+    ev.state       = st;
+    ev.prevState   = prev;
+    ev.zone        = ZONE_MEDIUM;
+    ev.distance_cm = 150 + (int)seq;
+    ev.timestamp   = 1000 * seq;
+    return ev;
+}
+
+void setUp() {
+    halNativeSetLogEnabled(false);
+    logFile.clear();
+    tmpFile.clear();
+    openFile = &logFile;
+}
+
+void tearDown() {}
+
+static void test_restore_rebuilds_pending_queue() {
+    AlertOutbox a;
+    a.setLogSink(logSink, nullptr);
+    for (uint32_t i = 1; i <= 3; i++) a.push(makeEvent(i, STATE_ALERT, STATE_ARMED));
+    TEST_ASSERT_EQUAL_UINT32(3 * OUTBOX_ENTRY_LEN, logFile.size());
+
+    AlertOutbox b;
+    TEST_ASSERT_EQUAL_UINT32(3, b.restore(logFile.data(), logFile.size()));
+    TEST_ASSERT_EQUAL_UINT32(3, b.pending());
+    TEST_ASSERT_EQUAL_UINT32(3, b.lastId());
+    TEST_ASSERT_EQUAL_UINT32(logFile.size(), b.logBytes());
+
+    // Gli id riprendono dopo l'ultimo registrato
+    TEST_ASSERT_EQUAL_UINT32(4, b.push(makeEvent(4, STATE_ALARM, STATE_ALERT)));
+}
+
+static void test_truncated_tail_is_ignored() {
+    AlertOutbox a;
+    a.setLogSink(logSink, nullptr);
+    a.push(makeEvent(1, STATE_ARMING, STATE_DISARMED));
+    a.push(makeEvent(2, STATE_ARMED, STATE_ARMING));
+    logFile.insert(logFile.end(), OUTBOX_ENTRY_LEN / 2, 'E');    // scrittura interrotta
+
+    AlertOutbox b;
+    TEST_ASSERT_EQUAL_UINT32(2, b.restore(logFile.data(), logFile.size()));
+    TEST_ASSERT_EQUAL_UINT32(2 * OUTBOX_ENTRY_LEN, b.logBytes());   // file da riscrivere
+}
+
+// Un evento diventato conferma ('E' -> 'A') non deve passare il
+// checksum: confermerebbe tutti gli id precedenti
+static void test_checksum_covers_entry_type() {
+    AlertOutbox a;
+    a.setLogSink(logSink, nullptr);
+    a.push(makeEvent(1, STATE_ALERT, STATE_ARMED));
+    a.push(makeEvent(2, STATE_ALARM, STATE_ALERT));
+    logFile[OUTBOX_ENTRY_LEN] = 'A';
+
+    AlertOutbox b;
+    TEST_ASSERT_EQUAL_UINT32(1, b.restore(logFile.data(), logFile.size()));
+    TEST_ASSERT_EQUAL_UINT32(1, b.pending());
+    TEST_ASSERT_EQUAL_UINT32(OUTBOX_ENTRY_LEN, b.logBytes());
+}
+
+// Reset a metà compattazione: il log resta quello completo
+static void test_interrupted_compaction_keeps_log() {
+    AlertOutbox a;
+    a.setLogSink(logSink, nullptr);
+    for (uint32_t i = 1; i <= 5; i++) a.push(makeEvent(i, STATE_ALERT, STATE_ARMED));
+    std::vector<uint8_t> before = logFile;
+
+    compactLog(a, false);
+    TEST_ASSERT_TRUE(logFile == before);
+
+    AlertOutbox b;
+    b.setLogSink(logSink, nullptr);
+    TEST_ASSERT_EQUAL_UINT32(5, b.restore(logFile.data(), logFile.size()));
+
+    // Compattazione completa: stessi pendenti, stessi id
+    compactLog(b, true);
+    AlertOutbox c;
+    TEST_ASSERT_EQUAL_UINT32(5, c.restore(logFile.data(), logFile.size()));
+    TEST_ASSERT_EQUAL_UINT32(5, c.lastId());
+    TEST_ASSERT_EQUAL_UINT32(logFile.size(), c.logBytes());
+}
+
+// ------------------------------------------------------------
+// Broker finto: CONNACK, SUBACK, PINGRESP, PUBACK; annota gli id
+// degli alert ricevuti
+// ------------------------------------------------------------
+struct SimBroker {
+    std::vector<uint8_t> in;
+    bool                 mute;
+    std::vector<uint8_t> alertSeen;
+    uint32_t             alertDup;
+};
+static SimBroker broker = {};
+
+static void brokerReply(const uint8_t* pkt, size_t len) {
+    if (!broker.mute) halNativeTcpDeliver(pkt, len);
+}
+
+static void brokerReceive(const uint8_t* data, size_t len) {
+    broker.in.insert(broker.in.end(), data, data + len);
+
+    while (broker.in.size() >= 2) {
+        uint32_t rem = 0, shift = 0;
+        size_t   pos = 1;
+        uint8_t  b;
+        do {
+            if (pos >= broker.in.size()) return;
+            b = broker.in[pos++];
+            rem |= (uint32_t)(b & 0x7F) << shift;
+            shift += 7;
+        } while (b & 0x80);
+        if (broker.in.size() < pos + rem) return;
+
+        const uint8_t* body = broker.in.data() + pos;
+        switch (broker.in[0] & 0xF0) {
+            case 0x10: {
+                static const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+                brokerReply(connack, sizeof(connack));
+                break;
+            }
+            case 0x80: {
+                uint8_t suback[] = { 0x90, 0x03, body[0], body[1], 0x00 };
+                brokerReply(suback, sizeof(suback));
+                break;
+            }
+            case 0xC0: {
+                static const uint8_t pingresp[] = { 0xD0, 0x00 };
+                brokerReply(pingresp, sizeof(pingresp));
+                break;
+            }
+            case 0x30: {
+                uint8_t  qos = (broker.in[0] >> 1) & 0x03;
+                uint16_t tl  = ((uint16_t)body[0] << 8) | body[1];
+                size_t   off = 2 + tl + (qos ? 2 : 0);
+                if (qos == 1) {
+                    uint8_t puback[] = { 0x40, 0x02, body[2 + tl], body[3 + tl] };
+                    brokerReply(puback, sizeof(puback));
+                }
+                // Payload alert: {"event":...,"id":N,...}
+                std::string topic((const char*)body + 2, tl);
+                std::string msg((const char*)body + off, rem - off);
+                size_t at = msg.find("\"id\":");
+                if (topic == MQTT_TOPIC_ALERT && at != std::string::npos) {
+                    uint32_t id = strtoul(msg.c_str() + at + 5, nullptr, 10);
+                    if (id >= broker.alertSeen.size()) broker.alertSeen.resize(id + 1, 0);
+                    if (broker.alertSeen[id]++) broker.alertDup++;
+                }
+                break;
+            }
+        }
+        broker.in.erase(broker.in.begin(), broker.in.begin() + pos + rem);
+    }
+}
+
+struct SimCtx {
+    AsyncMqtt*   mqtt;
+    AlertOutbox* outbox;
+};
+
+static void simOnConnect(void* ctx) {
+    SimCtx* c = static_cast<SimCtx*>(ctx);
+    c->outbox->rewind();
+    c->outbox->drain(*c->mqtt, MQTT_TOPIC_ALERT);
+}
+
+static void simOnAck(uint16_t packetId, void* ctx) {
+    SimCtx* c = static_cast<SimCtx*>(ctx);
+    c->outbox->onAck(packetId);
+    if (c->outbox->needsCompact()) compactLog(*c->outbox, true);
+}
+
+static void test_blackouts_and_reboot_lose_no_alert() {
+    WifiLink     link;
+    AsyncMqtt    mqtt;
+    AlarmLogic   alarm;
+    AlertOutbox* outbox = new AlertOutbox();
+    SimCtx       ctx    = { &mqtt, outbox };
+
+    halNativeUseVirtualClock(true);
+    configMgr.begin();
+    outbox->setLogSink(logSink, nullptr);
+    halNativeTcpSetServer(brokerReceive);
+    link.begin("sim", "sim", "autoguard");
+    mqtt.setServer(MQTT_BROKER, MQTT_PORT);
+    mqtt.setCredentials(MQTT_CLIENT_ID, MQTT_USER, MQTT_PASS);
+    mqtt.onConnect(simOnConnect, &ctx);
+    mqtt.onAck(simOnAck, &ctx);
+    mqtt.begin();
+    alarm.begin();
+
+    uint32_t    start      = halMillis();
+    uint32_t    maxBlockMs = 0;
+    uint32_t    restored   = 0;
+    uint32_t    reRestored = 0;
+    EventCursor cursor;
+
+    for (uint32_t t = 0; t < OUTBOX_SIM_MS; t++) {
+        halNativeSetMillis(start + t);
+        uint32_t sec = t / 1000;
+        halNativeTcpSetReachable(!((sec >= 240 && sec < 420) || (sec >= 660 && sec < 780)));
+        if (t == 240000 || t == 660000 || t == 560000) halNativeTcpDrop();
+        broker.mute = (sec >= 540 && sec < 560);
+
+        if (t == OUTBOX_SIM_REBOOT_MS) {
+            // Riavvio durante una scrittura: la RAM si perde, resta
+            // il log con mezza voce in coda
+            logFile.insert(logFile.end(), OUTBOX_ENTRY_LEN / 2, 0x45);
+            delete outbox;
+            outbox   = new AlertOutbox();
+            restored = outbox->restore(logFile.data(), logFile.size());
+
+            // Secondo reset a metà compattazione: il log è intatto
+            compactLog(*outbox, false);
+            delete outbox;
+            outbox     = new AlertOutbox();
+            ctx.outbox = outbox;
+            outbox->setLogSink(logSink, nullptr);
+            reRestored = outbox->restore(logFile.data(), logFile.size());
+            if (outbox->logBytes() != logFile.size()) compactLog(*outbox, true);
+        }
+
+        if (t % 13000 == 0) {
+            if (alarm.getState() == STATE_DISARMED) alarm.arm();
+            else alarm.disarm();
+        }
+
+        halNativeWifiTick();
+        halNativeTcpTick();
+
+        uint32_t v0 = halMillis();
+        link.update();
+        mqtt.update();
+        alarm.tick();
+        AlarmEvent ev;
+        while (alarm.readEvent(cursor, ev)) outbox->push(ev);
+        outbox->drain(mqtt, MQTT_TOPIC_ALERT);
+        uint32_t blockMs = halMillis() - v0;
+        if (blockMs > maxBlockMs) maxBlockMs = blockMs;
+    }
+
+    uint32_t missing = 0;
+    for (uint32_t id = 1; id <= outbox->lastId(); id++) {
+        if (id >= broker.alertSeen.size() || !broker.alertSeen[id]) missing++;
+    }
+
+    TEST_ASSERT_GREATER_THAN_UINT32(50, outbox->lastId());
+    TEST_ASSERT_EQUAL_UINT32(0, missing);
+    TEST_ASSERT_EQUAL_UINT32(0, outbox->pending());
+    TEST_ASSERT_EQUAL_UINT32(0, outbox->dropped());
+    TEST_ASSERT_GREATER_THAN_UINT32(0, restored);
+    TEST_ASSERT_EQUAL_UINT32(restored, reRestored);
+    TEST_ASSERT_LESS_THAN_UINT32(OUTBOX_LOG_MAX + OUTBOX_ENTRY_LEN, logFile.size());
+    TEST_ASSERT_EQUAL_UINT32(0, maxBlockMs);
+    delete outbox;
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_restore_rebuilds_pending_queue);
+    RUN_TEST(test_truncated_tail_is_ignored);
+    RUN_TEST(test_checksum_covers_entry_type);
+    RUN_TEST(test_interrupted_compaction_keeps_log);
+    RUN_TEST(test_blackouts_and_reboot_lose_no_alert);
+    return UNITY_END();
+}
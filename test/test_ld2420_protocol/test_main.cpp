@@ -0,0 +1,162 @@
+// ============================================================
+// AutoGuard - Test parser LD2420 (host, [env:native])
+// ============================================================
+// Frame testo e binari interi, riallineamento dopo byte spuri,
+// frame troncati mai emessi, header dentro un frame scartato.
+// Il volume (MB di rumore, ns/byte) resta nel bench:
+// main_native --bench-parser.
+// ============================================================
+#include <unity.h>
+#include <string.h>
+#include <vector>
+#include "ld2420_protocol.h"
+
+// Tutti i frame completati da un flusso
+static std::vector<LD2420Frame> parseAll(LD2420Parser& p, const uint8_t* buf, size_t len) {
+    std::vector<LD2420Frame> out;
+    while (len) {
+        LD2420Frame f;
+        size_t used = p.feed(buf, len, f);
+        buf += used;
+        len -= used;
+        if (f.type != LD2420_FRAME_NONE) out.push_back(f);
+    }
+    return out;
+}
+
+static std::vector<uint8_t> bytes(const char* s) {
+    return std::vector<uint8_t>(s, s + strlen(s));
+}
+
+void setUp() {}
+void tearDown() {}
+
+// "ON" non basta: la distanza arriva nella riga "Range"
+static void test_text_reports() {
+    LD2420Parser p;
+    std::vector<uint8_t> in = bytes("ON\r\nRange 123\r\nOFF\r\n");
+    std::vector<LD2420Frame> got = parseAll(p, in.data(), in.size());
+
+    TEST_ASSERT_EQUAL_UINT32(2, got.size());
+    TEST_ASSERT_EQUAL(LD2420_FRAME_REPORT, got[0].type);
+    TEST_ASSERT_TRUE(got[0].presence);
+    TEST_ASSERT_EQUAL_UINT16(123, got[0].distance_cm);
+    TEST_ASSERT_FALSE(got[1].presence);
+    TEST_ASSERT_EQUAL_UINT16(0, got[1].distance_cm);
+    TEST_ASSERT_EQUAL_UINT32(2, p.stats().reportFrames);
+    TEST_ASSERT_EQUAL_UINT32(0, p.stats().framingErrors);
+}
+
+// Il frame comando ha lo stesso formato di un ACK: ciò che
+// costruisce ld2420BuildCommand() il parser lo rilegge
+static void test_built_command_parses_back() {
+    uint8_t buf[LD2420_CMD_MAX_LEN];
+    uint8_t data[4] = { 0x00, 0x00, 0x02, 0x00 };
+    size_t  len = ld2420BuildCommand(buf, LD2420_CMD_ENABLE_CONF, data, sizeof(data));
+
+    LD2420Parser p;
+    std::vector<LD2420Frame> got = parseAll(p, buf, len);
+    TEST_ASSERT_EQUAL_UINT32(1, got.size());
+    TEST_ASSERT_EQUAL(LD2420_FRAME_ACK, got[0].type);
+    TEST_ASSERT_EQUAL_UINT16(LD2420_CMD_ENABLE_CONF, got[0].ackCmd);
+    TEST_ASSERT_EQUAL_UINT32(len, p.stats().bytesIn);
+    TEST_ASSERT_EQUAL_UINT32(0, p.stats().framingErrors);
+}
+
+static void test_resync_after_garbage() {
+    std::vector<uint8_t> in = { 0xFD, 0x00, 0xF4, 0xF3, 0x13, 'R', 'a', 0xFF };
+    std::vector<uint8_t> ok = bytes("Range 77\r\n");
+    in.insert(in.end(), ok.begin(), ok.end());
+
+    LD2420Parser p;
+    std::vector<LD2420Frame> got = parseAll(p, in.data(), in.size());
+    TEST_ASSERT_EQUAL_UINT32(1, got.size());
+    TEST_ASSERT_EQUAL_UINT16(77, got[0].distance_cm);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, p.stats().resyncBytes);
+}
+
+// Frame binario interrotto da un report: nessun ACK parziale
+static void test_truncated_frame_not_emitted() {
+    uint8_t buf[LD2420_CMD_MAX_LEN];
+    size_t  len = ld2420BuildWriteReg(buf, LD2420_CMD_WRITE_SYS,
+                                      LD2420_REG_SYS_MODE, LD2420_MODE_NORMAL);
+    std::vector<uint8_t> in(buf, buf + len - 3);
+    std::vector<uint8_t> ok = bytes("ON\r\n");
+    in.insert(in.end(), ok.begin(), ok.end());
+    in.insert(in.end(), buf, buf + len);
+
+    LD2420Parser p;
+    std::vector<LD2420Frame> got = parseAll(p, in.data(), in.size());
+    uint32_t acks = 0;
+    for (const LD2420Frame& f : got) {
+        if (f.type == LD2420_FRAME_ACK) acks++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, acks);
+    TEST_ASSERT_EQUAL(LD2420_FRAME_ACK, got.back().type);
+    TEST_ASSERT_EQUAL_UINT16(LD2420_CMD_WRITE_SYS, got.back().ackCmd);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, p.stats().framingErrors);
+}
+
+// Header vero subito dopo un header con lunghezza non valida:
+// dopo l'errore si riparte dai byte già letti, non dal successivo
+static void test_header_inside_bad_length() {
+    uint8_t buf[LD2420_CMD_MAX_LEN];
+    size_t  len = ld2420BuildWriteReg(buf, LD2420_CMD_WRITE_ABD, LD2420_REG_MAX_GATE, 12);
+    std::vector<uint8_t> in = { 0xFD, 0xFC, 0xFB, 0xFA };     // lunghezza = FD FC
+    in.insert(in.end(), buf, buf + len);
+
+    LD2420Parser p;
+    std::vector<LD2420Frame> got = parseAll(p, in.data(), in.size());
+    TEST_ASSERT_EQUAL_UINT32(1, got.size());
+    TEST_ASSERT_EQUAL(LD2420_FRAME_ACK, got[0].type);
+    TEST_ASSERT_EQUAL_UINT16(LD2420_CMD_WRITE_ABD, got[0].ackCmd);
+    TEST_ASSERT_EQUAL_UINT32(1, p.stats().framingErrors);
+}
+
+// Frame engineering troncato: il suo corpo dichiarato ingloba un
+// ACK intero, scoperto solo al footer mancante. Anche un byte alla
+// volta (il frame esce dai byte riesaminati)
+static void test_header_inside_aborted_body() {
+    uint8_t buf[LD2420_CMD_MAX_LEN];
+    size_t  len = ld2420BuildWriteReg(buf, LD2420_CMD_WRITE_SYS,
+                                      LD2420_REG_SYS_MODE, LD2420_MODE_ENGINEERING);
+    std::vector<uint8_t> in = { 0xF4, 0xF3, 0xF2, 0xF1, 1 + 2 + 2 * LD2420_GATE_COUNT, 0x00, 0x01, 0x20 };
+    in.insert(in.end(), buf, buf + len);
+    in.insert(in.end(), 24, 0x00);
+
+    for (int bytewise = 0; bytewise < 2; bytewise++) {
+        LD2420Parser p;
+        std::vector<LD2420Frame> got;
+        if (bytewise) {
+            LD2420Frame f;
+            for (size_t i = 0; i < in.size(); i++) {
+                size_t used = 0;
+                while (used == 0) {
+                    used = p.feed(&in[i], 1, f);
+                    if (f.type != LD2420_FRAME_NONE) got.push_back(f);
+                }
+            }
+        } else {
+            got = parseAll(p, in.data(), in.size());
+        }
+        TEST_ASSERT_EQUAL_UINT32(1, got.size());
+        TEST_ASSERT_EQUAL(LD2420_FRAME_ACK, got[0].type);
+        TEST_ASSERT_EQUAL_UINT16(LD2420_CMD_WRITE_SYS, got[0].ackCmd);
+        TEST_ASSERT_EQUAL_UINT32(0, p.stats().engineeringFrames);
+        TEST_ASSERT_EQUAL_UINT32(1, p.stats().framingErrors);
+        TEST_ASSERT_EQUAL_UINT32(in.size(), p.stats().bytesIn);
+    }
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_text_reports);
+    RUN_TEST(test_built_command_parses_back);
+    RUN_TEST(test_resync_after_garbage);
+    RUN_TEST(test_truncated_frame_not_emitted);
+    RUN_TEST(test_header_inside_bad_length);
+    RUN_TEST(test_header_inside_aborted_body);
+    return UNITY_END();
+}
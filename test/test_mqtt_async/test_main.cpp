@@ -0,0 +1,291 @@
+// ============================================================
+// AutoGuard - Test AsyncMqtt + discovery (host, [env:native])
+// ============================================================
+// Broker finto in-process (al posto di mosquitto): risponde a
+// CONNECT/SUBSCRIBE/PINGREQ/PUBLISH QoS 1, invia un comando ogni
+// 30s e controlla i payload ricevuti. Loop a 1ms virtuale per
+// 20 minuti con publish ogni secondo e:
+//   - link TCP interrotto a 3 minuti
+//   - broker irraggiungibile da 6 a 9 minuti
+//   - broker muto da 12 a 14 minuti (scadenza keepalive)
+//   - Home Assistant offline e di nuovo online a 16 minuti
+// Il loop non deve mai bloccare né allocare; la discovery parte
+// solo alla prima sessione e dopo il birth di HA. Poi il ring RX
+// viene saturato: la sessione deve chiudersi e ripartire pulita.
+// Client e WiFi sono gli stessi per tutti i test (la HAL host
+// tiene un solo client TCP e un solo callback WiFi).
+// ============================================================
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "hal.h"
+#include "hal_native.h"
+#include "config.h"
+#include "config_manager.h"
+#include "wifi_link.h"
+#include "mqtt_async.h"
+#include "mqtt_payloads.h"
+#include "mqtt_discovery.h"
+
+#define MQTT_SIM_MS          (20UL * 60 * 1000)
+#define MQTT_SIM_DROP_MS     (3UL * 60 * 1000)
+#define MQTT_SIM_DOWN_MS     (6UL * 60 * 1000)
+#define MQTT_SIM_UP_MS       (9UL * 60 * 1000)
+#define MQTT_SIM_MUTE_MS     (12UL * 60 * 1000)
+#define MQTT_SIM_UNMUTE_MS   (14UL * 60 * 1000)
+#define MQTT_SIM_HA_OFF_MS   (16UL * 60 * 1000)
+#define MQTT_SIM_HA_ON_MS    (16UL * 60 * 1000 + 5000)
+
+struct SimBroker {
+    std::vector<uint8_t> in;        // flusso dal client
+    bool                 mute;
+    uint32_t             connects;
+    uint32_t             publishes;
+    uint32_t             sensorMsgs; // campioni JSON ricevuti
+    uint32_t             sensorBad;  // campioni JSON malformati
+    uint32_t             discMsgs;   // config discovery ricevute
+    uint32_t             discBad;    // non retained o malformate
+    uint64_t             allocs;     // allocazioni del broker (non contano)
+};
+static SimBroker broker = {};
+
+static void brokerReply(const uint8_t* pkt, size_t len) {
+    if (!broker.mute) halNativeTcpDeliver(pkt, len);
+}
+
+static void brokerReceiveFrames(const uint8_t* data, size_t len) {
+    broker.in.insert(broker.in.end(), data, data + len);
+
+    // Pacchetti completi: tipo + lunghezza varint + corpo
+    while (broker.in.size() >= 2) {
+        uint32_t rem = 0, shift = 0;
+        size_t   pos = 1;
+        uint8_t  b;
+        do {
+            if (pos >= broker.in.size()) return;
+            b = broker.in[pos++];
+            rem |= (uint32_t)(b & 0x7F) << shift;
+            shift += 7;
+        } while (b & 0x80);
+        if (broker.in.size() < pos + rem) return;
+
+        const uint8_t* body = broker.in.data() + pos;
+        switch (broker.in[0] & 0xF0) {
+            case 0x10: {
+                static const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+                broker.connects++;
+                brokerReply(connack, sizeof(connack));
+                break;
+            }
+            case 0x80: {
+                uint8_t suback[] = { 0x90, 0x03, body[0], body[1], 0x00 };
+                brokerReply(suback, sizeof(suback));
+                break;
+            }
+            case 0xC0: {
+                static const uint8_t pingresp[] = { 0xD0, 0x00 };
+                brokerReply(pingresp, sizeof(pingresp));
+                break;
+            }
+            case 0x30: {
+                broker.publishes++;
+                uint8_t  qos = (broker.in[0] >> 1) & 0x03;
+                uint16_t tl  = ((uint16_t)body[0] << 8) | body[1];
+                size_t   off = 2 + tl + (qos ? 2 : 0);
+                if (qos == 1) {
+                    uint8_t puback[] = { 0x40, 0x02, body[2 + tl], body[3 + tl] };
+                    brokerReply(puback, sizeof(puback));
+                }
+                std::string topic((const char*)body + 2, tl);
+                std::string msg((const char*)body + off, rem - off);
+                if (topic == MQTT_TOPIC_SENSOR) {
+                    broker.sensorMsgs++;
+                    if (msg.compare(0, 12, "{\"detected\":") || msg.back() != '}' ||
+                        msg.find("\"timestamp\":") == std::string::npos) broker.sensorBad++;
+                }
+                if (!topic.compare(0, strlen(MQTT_DISCOVERY_PREFIX "/"), MQTT_DISCOVERY_PREFIX "/")) {
+                    broker.discMsgs++;
+                    if (!(broker.in[0] & 0x01) || msg.compare(0, 9, "{\"name\":\"") ||
+                        msg.find("\"unique_id\":\"" MQTT_DEVICE_ID "_") == std::string::npos ||
+                        msg.compare(msg.size() - 2, 2, "}}")) broker.discBad++;
+                }
+                break;
+            }
+        }
+        broker.in.erase(broker.in.begin(), broker.in.begin() + pos + rem);
+    }
+}
+
+static void brokerReceive(const uint8_t* data, size_t len) {
+    uint64_t a0 = halNativeAllocs();
+    brokerReceiveFrames(data, len);
+    broker.allocs += halNativeAllocs() - a0;
+}
+
+// PUBLISH QoS 0 verso il client (payload fino a ~120 byte)
+static size_t brokerPublishPacket(uint8_t* pkt, const char* topic, const char* cmd) {
+    size_t tl = strlen(topic), cl = strlen(cmd);
+    pkt[0] = 0x30;
+    pkt[1] = (uint8_t)(2 + tl + cl);
+    pkt[2] = 0;
+    pkt[3] = (uint8_t)tl;
+    memcpy(pkt + 4, topic, tl);
+    memcpy(pkt + 4 + tl, cmd, cl);
+    return 4 + tl + cl;
+}
+
+static void brokerSendCommand(const char* topic, const char* cmd) {
+    uint8_t pkt[128];
+    brokerReply(pkt, brokerPublishPacket(pkt, topic, cmd));
+}
+
+static WifiLink      wifi;
+static AsyncMqtt     mqtt;
+static MqttDiscovery discovery;
+static uint32_t      commands = 0;
+static uint32_t      start    = 0;
+static uint32_t      clockMs  = 0;    // ms virtuali dall'avvio della prova
+static MqttState     prevState;
+
+static void onMessage(const char* topic, const uint8_t* payload, size_t len, void* ctx) {
+    (void)ctx;
+    if (discovery.onMessage(topic, payload, len)) return;
+    if (!strcmp(topic, MQTT_TOPIC_CMD) && len == 6 && !memcmp(payload, "status", 6)) {
+        commands++;
+    }
+}
+
+static void onConnect(void* ctx) {
+    (void)ctx;
+    mqtt.subscribe(MQTT_TOPIC_CMD);
+    mqtt.subscribe(MQTT_TOPIC_HA_STATUS);
+    discovery.publish(mqtt);
+
+    MqttStatusInfo s = {};
+    s.state = "DISARMED";
+    strcpy(s.ip, "192.168.1.50");
+    mqtt.publishJson(MQTT_TOPIC_STATUS, true, [&s](JsonWriter& j) { mqttStatusJson(j, s); });
+}
+
+// Un'iterazione del loop: blocco (ms virtuali) e allocazioni
+static uint32_t loopStep(uint64_t& allocs) {
+    halNativeSetMillis(start + clockMs);
+    halNativeWifiTick();
+    halNativeTcpTick();
+
+    uint32_t v0 = halMillis();
+    uint64_t a0 = halNativeAllocs() - broker.allocs;
+    wifi.update();
+    mqtt.update();
+    if (mqtt.connected()) discovery.publish(mqtt);
+    if (clockMs % 1000 == 0) {
+        RadarData d = {};
+        d.timestamp = v0;
+        mqtt.publishJson(MQTT_TOPIC_SENSOR, false, [&d](JsonWriter& j) { mqttRadarJson(j, d); });
+    }
+    allocs += halNativeAllocs() - broker.allocs - a0;
+
+    // Nuovo socket: il broker riparte da un flusso vuoto
+    if (mqtt.getState() != prevState) {
+        if (mqtt.getState() == MQTT_STATE_TCP_CONNECTING) broker.in.clear();
+        prevState = mqtt.getState();
+    }
+    clockMs++;
+    return halMillis() - v0;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_unstable_broker_never_blocks_loop() {
+    uint32_t maxBlockMs = 0;
+    uint64_t allocs     = 0;
+
+    for (uint32_t t = 0; t < MQTT_SIM_MS; t++) {
+        if (t == MQTT_SIM_DROP_MS) halNativeTcpDrop();
+        if (t == MQTT_SIM_DOWN_MS) { halNativeTcpSetReachable(false); halNativeTcpDrop(); }
+        if (t == MQTT_SIM_UP_MS)   halNativeTcpSetReachable(true);
+        broker.mute = t >= MQTT_SIM_MUTE_MS && t < MQTT_SIM_UNMUTE_MS;
+        if (t % 30000 == 15000) brokerSendCommand(MQTT_TOPIC_CMD, "status");
+        if (t == MQTT_SIM_HA_OFF_MS) brokerSendCommand(MQTT_TOPIC_HA_STATUS, "offline");
+        if (t == MQTT_SIM_HA_ON_MS)  brokerSendCommand(MQTT_TOPIC_HA_STATUS, "online");
+
+        uint32_t blockMs = loopStep(allocs);
+        if (blockMs > maxBlockMs) maxBlockMs = blockMs;
+    }
+
+    MqttStats st = mqtt.getStats();
+    TEST_ASSERT_EQUAL_UINT32(0, maxBlockMs);
+    TEST_ASSERT_TRUE(mqtt.connected());
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)allocs);      // publish e callback senza heap
+    TEST_ASSERT_GREATER_THAN_UINT32(3, st.connects);   // riconnessioni dopo ogni guasto
+    TEST_ASSERT_GREATER_THAN_UINT32(0, commands);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, broker.sensorMsgs);
+    TEST_ASSERT_EQUAL_UINT32(0, broker.sensorBad);
+    TEST_ASSERT_EQUAL_UINT32(0, st.rxOverruns);
+}
+
+// Dipende dalla prova precedente: prima sessione + birth di HA
+static void test_discovery_on_first_session_and_birth_only() {
+    TEST_ASSERT_EQUAL_UINT32(2, discovery.rounds());
+    TEST_ASSERT_EQUAL_UINT32(2 * MQTT_DISCOVERY_COUNT, broker.discMsgs);
+    TEST_ASSERT_EQUAL_UINT32(0, broker.discBad);
+}
+
+// Più byte di MQTT_RX_RING_SIZE prima che il loop li legga: il
+// resto del segmento è perso, la sessione va chiusa (altrimenti
+// il parser riparte a metà pacchetto) e la successiva è pulita
+static void test_rx_overrun_closes_session() {
+    uint64_t allocs = 0;
+    while (!mqtt.connected()) loopStep(allocs);
+
+    static uint8_t burst[MQTT_RX_RING_SIZE + 256];
+    size_t n = 0;
+    while (n + 128 <= sizeof(burst)) {
+        n += brokerPublishPacket(burst + n, MQTT_TOPIC_CMD, "status");
+    }
+    uint32_t failures = mqtt.getStats().failures;
+    uint32_t before   = commands;
+    halNativeTcpDeliver(burst, n);
+    loopStep(allocs);
+
+    TEST_ASSERT_EQUAL(MQTT_STATE_BACKOFF, mqtt.getState());
+    TEST_ASSERT_EQUAL_UINT32(failures + 1, mqtt.getStats().failures);
+    TEST_ASSERT_EQUAL_UINT32(1, mqtt.getStats().rxOverruns);
+    TEST_ASSERT_EQUAL_UINT32(before, commands);    // nessun pacchetto a metà consegnato
+
+    // Nuova sessione: un comando arriva intero
+    for (uint32_t t = 0; t < 2 * MQTT_BACKOFF_MAX_MS && !mqtt.connected(); t++) loopStep(allocs);
+    TEST_ASSERT_TRUE(mqtt.connected());
+    brokerSendCommand(MQTT_TOPIC_CMD, "status");
+    loopStep(allocs);
+    TEST_ASSERT_EQUAL_UINT32(before + 1, commands);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    halNativeUseVirtualClock(true);
+    halNativeSetLogEnabled(false);
+    configMgr.begin();
+
+    halNativeTcpSetServer(brokerReceive);
+    wifi.begin("sim", "sim", "autoguard");
+    mqtt.setServer(MQTT_BROKER, MQTT_PORT);
+    mqtt.setCredentials(MQTT_CLIENT_ID, MQTT_USER, MQTT_PASS);
+    mqtt.setWill(MQTT_TOPIC_STATUS, "{\"state\":\"OFFLINE\"}", 1, true);
+    mqtt.onMessage(onMessage, nullptr);
+    mqtt.onConnect(onConnect, nullptr);
+    mqtt.begin();
+    discovery.begin(0);
+    start     = halMillis();
+    prevState = mqtt.getState();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_unstable_broker_never_blocks_loop);
+    RUN_TEST(test_discovery_on_first_session_and_birth_only);
+    RUN_TEST(test_rx_overrun_closes_session);
+    return UNITY_END();
+}
@@ -0,0 +1,54 @@
+// ============================================================
+// AutoGuard - Test payload JSON MQTT (host, [env:native])
+// ============================================================
+// Byte esatti del campione radar e dell'escape di JsonWriter:
+// Home Assistant e i consumatori leggono questi campi per nome.
+// ============================================================
+#include <unity.h>
+#include <string.h>
+#include "config.h"
+#include "json_writer.h"
+#include "mqtt_payloads.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void test_radar_sample_json() {
+    char           buf[512];
+    JsonBufferSink sink(buf, sizeof(buf));
+    JsonWriter     j(&sink);
+    RadarData      d = {};
+    d.detected      = true;
+    d.distance_cm   = 182;
+    d.filtered_dist = 180;
+    d.zone          = ZONE_MEDIUM;
+    d.velocity      = -45;
+    d.trajectory    = TRAJ_APPROACHING;
+    d.timestamp     = 4000000000u;
+    mqttRadarJson(j, d);
+
+    TEST_ASSERT_EQUAL_STRING("{\"detected\":true,\"distance\":180,\"raw_dist\":182,\"zone\":2,"
+                             "\"velocity\":-45,\"accel\":0,\"trajectory\":1,\"sensor\":0,"
+                             "\"timestamp\":4000000000}", buf);
+    TEST_ASSERT_EQUAL_UINT32(strlen(buf), j.length());
+}
+
+static void test_writer_escapes_and_rounds() {
+    char           buf[512];
+    JsonBufferSink sink(buf, sizeof(buf));
+    JsonWriter     j(&sink);
+    j.beginObject().field("s", "a\"b\\c\n\x01").field("f", -1.005, 2).field("g", 0.5, 0)
+     .beginArray("a").item(1).item(false).item((const char*)nullptr).endArray().endObject();
+
+    TEST_ASSERT_EQUAL_STRING("{\"s\":\"a\\\"b\\\\c\\n\\u0001\",\"f\":-1.00,\"g\":1,"
+                             "\"a\":[1,false,null]}", buf);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_radar_sample_json);
+    RUN_TEST(test_writer_escapes_and_rounds);
+    return UNITY_END();
+}
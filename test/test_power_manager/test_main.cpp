@@ -0,0 +1,138 @@
+// ============================================================
+// AutoGuard - Test PowerManager (host, [env:native])
+// ============================================================
+// Un'ora di loop() con il power manager: 15 minuti disarmato,
+// 25 armato, intrusione di 20s, disarmo dopo 10 minuti.
+// Campioni ogni RADAR_UPDATE_MS, consegnati al loop come dal task
+// radar: subito (notifica) o, ad acquisizione a intervalli, al
+// prossimo svuotamento della UART. Il lavoro di un'iterazione
+// costa tempo virtuale. Per stato: tempo in attesa, ritardo delle
+// scadenze della state machine e dei campioni.
+// ============================================================
+#include <unity.h>
+#include <stdint.h>
+#include "hal.h"
+#include "hal_native.h"
+#include "config.h"
+#include "config_manager.h"
+#include "sensor_ld2420.h"
+#include "alarm_logic.h"
+#include "power_manager.h"
+
+#define POWER_SIM_LOOP_US       200     // costo fisso di un'iterazione
+#define POWER_SIM_SAMPLE_US     100     // costo di un campione
+#define POWER_SIM_DEADLINE_MS   2       // ritardo massimo di una scadenza
+#define POWER_SIM_IDLE_PCT      90      // attesa minima senza presenze
+
+static SensorLD2420 radar;
+static AlarmLogic   alarmSys;
+
+static RadarData sample(uint32_t ts, bool detected, int dist) {
+    RadarData d = {};
+    d.timestamp = ts;
+    if (detected) {
+        d.detected      = true;
+        d.distance_cm   = dist;
+        d.filtered_dist = dist;
+        d.zone = dist <= ZONE_CRITICAL_MAX ? ZONE_CRITICAL :
+                 dist <= ZONE_MEDIUM_MAX   ? ZONE_MEDIUM   :
+                 dist <= ZONE_FAR_MAX      ? ZONE_FAR      : ZONE_NONE;
+    }
+    return d;
+}
+
+// Istante di consegna al loop del campione prodotto a "ts"
+static uint32_t deliveryAt(uint32_t ts) {
+    uint32_t poll = radar.getPollInterval();
+    return poll ? (ts + poll - 1) / poll * poll : ts;
+}
+
+void setUp() {
+    halNativeUseVirtualClock(true);
+    halNativeSetLogEnabled(false);
+    configMgr.begin();
+}
+
+void tearDown() {}
+
+static void test_idle_hour_with_intrusion() {
+    const uint32_t t0       = 1000;
+    const uint32_t armAt    = t0 + 15 * 60000;
+    const uint32_t intrAt   = armAt + 25 * 60000;
+    const uint32_t intrEnd  = intrAt + 20000;
+    const uint32_t disarmAt = intrAt + 10 * 60000;
+    const uint32_t endAt    = t0 + 60 * 60000;
+
+    halNativeSetMillis(t0);
+    alarmSys.begin();
+    powerMgr.attach(radar);
+    powerMgr.begin();
+
+    uint32_t nextTs  = t0 + RADAR_UPDATE_MS;    // prossimo campione prodotto
+    uint32_t dueMs   = UINT32_MAX;              // scadenza attesa dal loop
+    uint32_t maxLate = 0;
+    uint32_t maxSample[POWER_STATES] = {};
+    uint32_t visited = 0;
+    bool     armed = false, disarmed = false;
+
+    while (halMillis() < endAt) {
+        uint32_t   now = halMillis();
+        AlarmState st  = alarmSys.getState();
+
+        if (!armed && now >= armAt)       { alarmSys.arm();    armed    = true; }
+        if (!disarmed && now >= disarmAt) { alarmSys.disarm(); disarmed = true; }
+
+        // Campioni consegnati dal task radar entro "now"
+        while (deliveryAt(nextTs) <= now) {
+            bool intr = nextTs >= intrAt && nextTs < intrEnd;
+            alarmSys.onSample(sample(nextTs, intr, intr ? 120 : 0));
+            halNativeAdvanceUs(POWER_SIM_SAMPLE_US);
+            if (now - nextTs > maxSample[st]) maxSample[st] = now - nextTs;
+            nextTs += RADAR_UPDATE_MS;
+        }
+
+        // Scadenza attesa: gestita al primo tick dopo l'istante
+        if (dueMs != UINT32_MAX && (int32_t)(now - dueMs) >= 0) {
+            if (now - dueMs > maxLate) maxLate = now - dueMs;
+            dueMs = UINT32_MAX;
+        }
+        alarmSys.tick();
+        halNativeAdvanceUs(POWER_SIM_LOOP_US);
+
+        st = alarmSys.getState();
+        visited |= 1u << st;
+
+        uint32_t left = alarmSys.msToDeadline();
+        dueMs = left == UINT32_MAX ? UINT32_MAX : halMillis() + left;
+
+        // Notifica del task radar alla consegna del prossimo campione
+        halNativeScheduleWake((uint64_t)deliveryAt(nextTs) * 1000);
+        powerMgr.idle(st, left);
+    }
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(POWER_SIM_DEADLINE_MS, maxLate);
+
+    // Campioni in ritardo al più di un intervallo di attesa
+    for (int s = 0; s < POWER_STATES; s++) {
+        if (!(visited & (1u << s))) continue;
+        uint32_t limit = s == STATE_DISARMED ? RADAR_IDLE_POLL_MS + POWER_IDLE_DISARMED_MS
+                                             : POWER_IDLE_MAX_MS;
+        TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(limit, maxSample[s],
+            AlarmLogic::getStateName((AlarmState)s));
+    }
+
+    // Disarmato e armato senza presenze: CPU quasi sempre libera
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(POWER_SIM_IDLE_PCT, powerMgr.sleepPct(STATE_DISARMED));
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(POWER_SIM_IDLE_PCT, powerMgr.sleepPct(STATE_ARMED));
+
+    // L'intrusione deve scattare anche con il loop in attesa
+    TEST_ASSERT_TRUE(visited & (1u << STATE_ALARM));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_idle_hour_with_intrusion);
+    return UNITY_END();
+}
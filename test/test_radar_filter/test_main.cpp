@@ -0,0 +1,94 @@
+// ============================================================
+// AutoGuard - Test filtri distanza (host, [env:native])
+// ============================================================
+// Comportamento dei singoli stadi a valori noti: media esatta,
+// spike isolato scartato dalla mediana, convergenza di EMA e
+// Kalman, reset al cambio di modalità. Ritardo e rumore su
+// trace restano nel bench: main_native --bench-filter.
+// ============================================================
+#include <unity.h>
+#include "config.h"
+#include "radar_filter.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void test_moving_average_window() {
+    MovingAverageFilter<4> f;
+    TEST_ASSERT_EQUAL_INT(100, f.apply(100));
+    TEST_ASSERT_EQUAL_INT(150, f.apply(200));
+    f.apply(300);
+    TEST_ASSERT_EQUAL_INT(250, f.apply(400));     // 100..400
+    TEST_ASSERT_EQUAL_INT(350, f.apply(500));     // esce 100
+    f.reset();
+    TEST_ASSERT_EQUAL_INT(7, f.apply(7));
+}
+
+static void test_median_rejects_spike() {
+    MedianFilter<5> f;
+    int out = 0;
+    for (int i = 0; i < 5; i++) out = f.apply(150);
+    out = f.apply(600);
+    TEST_ASSERT_EQUAL_INT(150, out);
+    out = f.apply(0);
+    TEST_ASSERT_EQUAL_INT(150, out);
+
+    // Un salto che dura metà finestra + 1 passa
+    for (int i = 0; i < 3; i++) out = f.apply(300);
+    TEST_ASSERT_EQUAL_INT(300, out);
+}
+
+static void test_ema_and_kalman_converge() {
+    ExpFilter e;
+    Kalman1D  k;
+    e.setAlphaPct(FILTER_EMA_ALPHA);
+    k.setNoise(FILTER_KALMAN_Q, FILTER_KALMAN_R);
+    TEST_ASSERT_EQUAL_INT(100, e.apply(100));     // il primo campione inizializza
+    TEST_ASSERT_EQUAL_INT(100, k.apply(100));
+
+    int oe = 0, ok = 0;
+    for (int i = 0; i < 200; i++) {
+        oe = e.apply(250);
+        ok = k.apply(250);
+    }
+    TEST_ASSERT_INT_WITHIN(2, 250, oe);
+    TEST_ASSERT_INT_WITHIN(2, 250, ok);
+}
+
+// q e r oltre FILTER_KALMAN_MAX (valori salvati prima dei controlli
+// di /api/config) vengono limitati: niente overflow in Q8
+static void test_kalman_clamps_noise() {
+    Kalman1D k;
+    k.setNoise(2000000000, 2000000000);
+    k.apply(300);
+    int out = 0;
+    for (int i = 0; i < 50; i++) out = k.apply(300);
+    TEST_ASSERT_EQUAL_INT(300, out);
+}
+
+static void test_mode_change_resets_chain() {
+    RadarFilter<FILTER_AVG_SIZE, FILTER_MEDIAN_SIZE> f;
+    f.configure(FILTER_AVERAGE, FILTER_EMA_ALPHA, FILTER_KALMAN_Q, FILTER_KALMAN_R);
+    for (int i = 0; i < 10; i++) f.apply(400);
+
+    f.configure(FILTER_MEDIAN_EMA, FILTER_EMA_ALPHA, FILTER_KALMAN_Q, FILTER_KALMAN_R);
+    TEST_ASSERT_EQUAL_INT(FILTER_MEDIAN_EMA, f.mode());
+    TEST_ASSERT_EQUAL_INT(80, f.apply(80));
+
+    // Modalità fuori range: media
+    f.configure(FILTER_MODE_COUNT, FILTER_EMA_ALPHA, FILTER_KALMAN_Q, FILTER_KALMAN_R);
+    TEST_ASSERT_EQUAL_INT(FILTER_AVERAGE, f.mode());
+    TEST_ASSERT_EQUAL_INT(60, f.apply(60));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_moving_average_window);
+    RUN_TEST(test_median_rejects_spike);
+    RUN_TEST(test_ema_and_kalman_converge);
+    RUN_TEST(test_kalman_clamps_noise);
+    RUN_TEST(test_mode_change_resets_chain);
+    return UNITY_END();
+}
@@ -0,0 +1,147 @@
+// ============================================================
+// AutoGuard - Test StateJournal (host, [env:native])
+// ============================================================
+// Taglio di alimentazione a ogni byte scritto: transizioni
+// casuali fino a far girare due volte i segmenti. Prima di ogni
+// scrittura, per ogni byte che l'operazione tocca (cancellazione,
+// intestazione, record): immagine della flash, taglio dopo quel
+// byte, "riavvio". Lo stato recuperato deve essere il precedente
+// o il nuovo, il journal deve restare scrivibile e la sequenza
+// crescere.
+// ============================================================
+#include <unity.h>
+#include <string.h>
+#include <vector>
+#include "hal.h"
+#include "hal_native.h"
+#include "config_manager.h"
+#include "alarm_logic.h"
+#include "power_manager.h"
+#include "state_journal.h"
+
+#define JOURNAL_SIM_SEGMENTS    8
+#define JOURNAL_SIM_LABEL       "journal"
+
+static uint32_t rng = 0x51F15EED;
+static uint32_t rngNext() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+void setUp() {
+    halNativeSetLogEnabled(false);
+    configMgr.begin();
+    halNativeFlashCutAfter(-1);
+    halNativeFlashCreate(JOURNAL_SIM_LABEL, JOURNAL_SIM_SEGMENTS * JOURNAL_SEGMENT_SIZE);
+}
+
+void tearDown() {
+    halNativeFlashCutAfter(-1);
+}
+
+static void test_empty_partition_has_no_state() {
+    StateJournal j;
+    AlarmState   st;
+    TEST_ASSERT_TRUE(j.begin(JOURNAL_SIM_LABEL));
+    TEST_ASSERT_FALSE(j.lastState(st));
+    TEST_ASSERT_TRUE(j.append(STATE_ARMED, STATE_ARMING, 1000));
+
+    StateJournal k;
+    TEST_ASSERT_TRUE(k.begin(JOURNAL_SIM_LABEL));
+    TEST_ASSERT_TRUE(k.lastState(st));
+    TEST_ASSERT_EQUAL(STATE_ARMED, st);
+    TEST_ASSERT_EQUAL_UINT32(j.sequence(), k.sequence());
+}
+
+static void test_power_cut_at_every_byte() {
+    const uint32_t size  = JOURNAL_SIM_SEGMENTS * JOURNAL_SEGMENT_SIZE;
+    const uint32_t total = JOURNAL_SIM_SEGMENTS * JOURNAL_RECORDS * 2 + 100;
+
+    uint8_t* flash = halNativeFlashData(JOURNAL_SIM_LABEL, nullptr);
+    std::vector<uint8_t> before(size), after(size);
+
+    StateJournal ref;
+    TEST_ASSERT_TRUE(ref.begin(JOURNAL_SIM_LABEL));
+
+    uint32_t   cuts = 0, gotNew = 0;
+    AlarmState prev    = STATE_DISARMED;
+    bool       hasPrev = false;
+
+    for (uint32_t i = 0; i < total; i++) {
+        AlarmState st = i + 1 == total ? STATE_ARMED : (AlarmState)(rngNext() % POWER_STATES);
+
+        memcpy(before.data(), flash, size);
+        uint64_t b0 = halNativeFlashBytes();
+        TEST_ASSERT_TRUE(ref.append(st, prev, i));
+        uint32_t opBytes = (uint32_t)(halNativeFlashBytes() - b0);
+        memcpy(after.data(), flash, size);
+
+        for (uint32_t k = 0; k < opBytes; k++) {
+            memcpy(flash, before.data(), size);
+
+            StateJournal a;
+            a.begin(JOURNAL_SIM_LABEL);
+            halNativeFlashCutAfter(k);
+            a.append(st, prev, i);
+            halNativeFlashCutAfter(-1);     // riavvio
+
+            StateJournal b;
+            AlarmState   got;
+            b.begin(JOURNAL_SIM_LABEL);
+            bool has = b.lastState(got);
+            cuts++;
+            if (has && got == st && b.sequence() == a.sequence() + 1) {
+                gotNew++;
+            } else {
+                // Altrimenti deve restare lo stato precedente
+                TEST_ASSERT_EQUAL(hasPrev, has);
+                if (has) TEST_ASSERT_EQUAL(prev, got);
+                TEST_ASSERT_EQUAL_UINT32(a.sequence(), b.sequence());
+            }
+
+            // Dopo il taglio si continua a scrivere
+            AlarmState   next = (AlarmState)((st + 1) % POWER_STATES);
+            StateJournal c;
+            AlarmState   last;
+            TEST_ASSERT_TRUE(b.append(next, st, i));
+            TEST_ASSERT_TRUE(c.begin(JOURNAL_SIM_LABEL));
+            TEST_ASSERT_TRUE(c.lastState(last));
+            TEST_ASSERT_EQUAL(next, last);
+            TEST_ASSERT_EQUAL_UINT32(b.sequence(), c.sequence());
+        }
+
+        memcpy(flash, after.data(), size);
+        prev    = st;
+        hasPrev = true;
+    }
+
+    // Due giri completi dei segmenti, tagli su ogni byte scritto
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2 * JOURNAL_SIM_SEGMENTS, ref.rotations());
+    TEST_ASSERT_GREATER_THAN_UINT32(total, cuts);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, gotNew);
+}
+
+// Avvio del firmware: journal, poi la state machine
+static void test_alarm_restores_journaled_state() {
+    StateJournal w;
+    TEST_ASSERT_TRUE(w.begin(JOURNAL_SIM_LABEL));
+    TEST_ASSERT_TRUE(w.append(STATE_ARMING, STATE_DISARMED, 1000));
+    TEST_ASSERT_TRUE(w.append(STATE_ARMED, STATE_ARMING, 6000));
+
+    stateJournal.begin(JOURNAL_SIM_LABEL);
+    AlarmLogic alarm;
+    alarm.begin();
+    TEST_ASSERT_EQUAL(STATE_ARMED, alarm.getState());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_partition_has_no_state);
+    RUN_TEST(test_power_cut_at_every_byte);
+    RUN_TEST(test_alarm_restores_journaled_state);
+    return UNITY_END();
+}
@@ -0,0 +1,75 @@
+// ============================================================
+// AutoGuard - Test WifiLink (host, [env:native])
+// ============================================================
+// Loop a 1ms virtuale per 10 minuti: rete presente, blackout di
+// 5 minuti, poi rete di nuovo disponibile. Qualsiasi attesa dentro
+// update() farebbe avanzare l'orologio virtuale: il blocco massimo
+// misurato deve restare 0ms e il link deve tornare da solo.
+// ============================================================
+#include <unity.h>
+#include "hal.h"
+#include "hal_native.h"
+#include "config_manager.h"
+#include "alarm_logic.h"
+#include "wifi_link.h"
+
+#define WIFI_SIM_MS          (10UL * 60 * 1000)
+#define WIFI_SIM_DOWN_MS     (60UL * 1000)
+#define WIFI_SIM_UP_MS       (360UL * 1000)
+
+// Riconnessione entro il tetto del backoff (jitter incluso)
+#define WIFI_SIM_RECONNECT_MS  (WIFI_BACKOFF_MAX_MS * (100 + WIFI_BACKOFF_JITTER_PCT) / 100)
+
+void setUp() {
+    halNativeUseVirtualClock(true);
+    halNativeSetLogEnabled(false);
+    configMgr.begin();
+}
+
+void tearDown() {}
+
+static void test_blackout_never_blocks_and_recovers() {
+    WifiLink   link;
+    AlarmLogic alarm;
+    link.begin("sim", "sim", "autoguard");
+    alarm.begin();
+    alarm.arm();
+
+    uint32_t start      = halMillis();
+    uint32_t maxBlockMs = 0;
+    uint32_t upAgainMs  = 0;
+    bool     upAgain    = false;
+
+    for (uint32_t t = 0; t < WIFI_SIM_MS; t++) {
+        halNativeSetMillis(start + t);
+        halNativeWifiSetAvailable(t < WIFI_SIM_DOWN_MS || t >= WIFI_SIM_UP_MS);
+        halNativeWifiTick();
+
+        uint32_t v0 = halMillis();
+        link.update();
+        alarm.tick();
+        uint32_t blockMs = halMillis() - v0;
+        if (blockMs > maxBlockMs) maxBlockMs = blockMs;
+
+        if (!upAgain && t >= WIFI_SIM_UP_MS && link.isConnected()) {
+            upAgain   = true;
+            upAgainMs = t - WIFI_SIM_UP_MS;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, maxBlockMs);
+    TEST_ASSERT_TRUE(link.isConnected());
+    TEST_ASSERT_EQUAL_UINT32(1, link.getDisconnects());
+    TEST_ASSERT_EQUAL_UINT32(halNativeWifiAttempts(), link.getAttempts());
+    TEST_ASSERT_TRUE(upAgain);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(WIFI_SIM_RECONNECT_MS, upAgainMs);
+    TEST_ASSERT_EQUAL(STATE_ARMED, alarm.getState());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_blackout_never_blocks_and_recovers);
+    return UNITY_END();
+}
@@ -0,0 +1,148 @@
+// ============================================================
+// AutoGuard - Test ZoneMap (host, [env:native])
+// ============================================================
+// Zone di default (config.h): senza isteresi la tabella deve
+// coincidere con la catena di confronti; con isteresi un
+// bersaglio fermo su un confine non alterna le zone. Il costo
+// per campione resta nel bench: main_native --bench-zones.
+// ============================================================
+#include <unity.h>
+#include "config.h"
+#include "zone_map.h"
+
+#define ZONES_SIM_MS        60000
+#define ZONES_SIM_JITTER    6       // +/- cm attorno al confine
+
+static const ZoneDef zones[] = {
+    {ZONE_CRITICAL_MAX, ZONE_CRITICAL},
+    {ZONE_MEDIUM_MAX,   ZONE_MEDIUM},
+    {ZONE_FAR_MAX,      ZONE_FAR}
+};
+
+static uint32_t rng = 0x20250A11;
+static uint32_t rngNext() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static RadarZone chain(int cm) {
+    if (cm <= 0) return ZONE_NONE;
+    if (cm <= ZONE_CRITICAL_MAX) return ZONE_CRITICAL;
+    if (cm <= ZONE_MEDIUM_MAX) return ZONE_MEDIUM;
+    if (cm <= ZONE_FAR_MAX) return ZONE_FAR;
+    return ZONE_NONE;
+}
+
+static RadarData sample(uint32_t ts, bool detected, int cm) {
+    RadarData d = {};
+    d.timestamp     = ts;
+    d.detected      = detected;
+    d.distance_cm   = detected ? cm : 0;
+    d.filtered_dist = detected ? cm : 0;
+    return d;
+}
+
+// Zone cambiate in un minuto di campioni; la permanenza
+// accumulata deve coprire tutto il tempo con presenza
+static uint32_t zoneChanges(ZoneMap& map, int (*path)(uint32_t ts)) {
+    uint32_t  changes = 0, present = 0;
+    RadarZone last = ZONE_NONE;
+    for (uint32_t ts = 0; ts < ZONES_SIM_MS; ts += RADAR_UPDATE_MS) {
+        RadarData d = sample(ts, true, path(ts));
+        map.apply(d);
+        if (ts && d.zone != last) changes++;
+        if (ts) present += RADAR_UPDATE_MS;
+        last = d.zone;
+    }
+    uint32_t dwell = 0;
+    for (uint8_t z = 0; z <= map.count(); z++) dwell += map.dwellMs(z);
+    TEST_ASSERT_EQUAL_UINT32(present, dwell);
+    return changes;
+}
+
+static int jitter() {
+    return (int)(rngNext() % (2 * ZONES_SIM_JITTER + 1)) - ZONES_SIM_JITTER;
+}
+static int nearBorder(uint32_t ts)   { (void)ts; return ZONE_CRITICAL_MAX + jitter(); }
+static int mediumBorder(uint32_t ts) { (void)ts; return ZONE_MEDIUM_MAX + jitter(); }
+static int approach(uint32_t ts)     { return 300 - (int)(ts * 250 / ZONES_SIM_MS) + jitter(); }
+
+void setUp() {}
+void tearDown() {}
+
+static void test_rejects_unordered_zones() {
+    const ZoneDef bad[] = {{ZONE_MEDIUM_MAX, ZONE_MEDIUM}, {ZONE_CRITICAL_MAX, ZONE_CRITICAL}};
+    ZoneMap map;
+    TEST_ASSERT_TRUE(map.build(zones, 3, 0, 0));
+    TEST_ASSERT_FALSE(map.build(bad, 2, 0, 0));
+    TEST_ASSERT_EQUAL_UINT8(3, map.count());
+}
+
+// Senza isteresi: identica alla catena, anche a salti casuali
+static void test_matches_chain_without_hysteresis() {
+    ZoneMap map;
+    TEST_ASSERT_TRUE(map.build(zones, 3, 0, 0));
+    for (uint32_t i = 0; i < 200000; i++) {
+        bool det = rngNext() % 10 != 0;
+        int  cm  = (int)(rngNext() % (ZONE_MAP_CM + 200)) - 20;
+        RadarData d = sample(i * RADAR_UPDATE_MS, det, cm);
+        map.apply(d);
+        TEST_ASSERT_EQUAL(det ? chain(cm) : ZONE_NONE, d.zone);
+    }
+}
+
+// Fermo sul confine: al più un cambio; avvicinamento:
+// FAR -> MEDIUM -> CRITICAL
+static void test_hysteresis_stops_flapping() {
+    ZoneMap a, b, c;
+    TEST_ASSERT_TRUE(a.build(zones, 3, ZONE_HYST_ENTER_CM, ZONE_HYST_EXIT_CM));
+    TEST_ASSERT_TRUE(b.build(zones, 3, ZONE_HYST_ENTER_CM, ZONE_HYST_EXIT_CM));
+    TEST_ASSERT_TRUE(c.build(zones, 3, ZONE_HYST_ENTER_CM, ZONE_HYST_EXIT_CM));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(1, zoneChanges(a, nearBorder));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(1, zoneChanges(b, mediumBorder));
+    TEST_ASSERT_EQUAL_UINT32(2, zoneChanges(c, approach));
+}
+
+// Si lascia la zona solo oltre la banda di uscita, e solo se
+// si è anche oltre la banda di ingresso della nuova
+static void test_exit_band_keeps_zone() {
+    ZoneMap map;
+    TEST_ASSERT_TRUE(map.build(zones, 3, ZONE_HYST_ENTER_CM, ZONE_HYST_EXIT_CM));
+    const int lo = ZONE_CRITICAL_MAX + 1;       // bordo interno di MEDIUM
+
+    RadarData d = sample(0, true, (ZONE_CRITICAL_MAX + ZONE_MEDIUM_MAX) / 2);
+    map.apply(d);
+    TEST_ASSERT_EQUAL(ZONE_MEDIUM, d.zone);
+
+    d = sample(50, true, lo - ZONE_HYST_EXIT_CM);
+    map.apply(d);
+    TEST_ASSERT_EQUAL(ZONE_MEDIUM, d.zone);
+    TEST_ASSERT_EQUAL_UINT32(50, d.zone_ms);
+
+    d = sample(100, true, lo - ZONE_HYST_EXIT_CM - 1);
+    map.apply(d);
+    TEST_ASSERT_EQUAL(ZONE_CRITICAL, d.zone);
+    TEST_ASSERT_EQUAL_UINT8(1, d.zone_id);
+    TEST_ASSERT_EQUAL_UINT32(0, d.zone_ms);
+
+    // Dopo un'assenza la zona è quella della tabella
+    d = sample(150, false, 0);
+    map.apply(d);
+    TEST_ASSERT_EQUAL(ZONE_NONE, d.zone);
+    d = sample(200, true, ZONE_CRITICAL_MAX + 2);
+    map.apply(d);
+    TEST_ASSERT_EQUAL(ZONE_MEDIUM, d.zone);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_unordered_zones);
+    RUN_TEST(test_matches_chain_without_hysteresis);
+    RUN_TEST(test_hysteresis_stops_flapping);
+    RUN_TEST(test_exit_band_keeps_zone);
+    return UNITY_END();
+}